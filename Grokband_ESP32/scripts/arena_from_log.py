@@ -0,0 +1,31 @@
+"""
+Turns the "ARENA:" lines printed by a TFLITE_ARENA_MEASURE=1 build into
+src/tensor_arena_size.h, which sizes the tensor arena for normal builds.
+
+    pio run -e esp32pico -t upload -t monitor | tee boot.log   (with -DTFLITE_ARENA_MEASURE=1)
+    python scripts/arena_from_log.py boot.log
+
+Re-run whenever the model changes; the per-placement timing report in the same log
+shows whether TFLITE_ARENA_SPLIT is worth enabling.
+"""
+import os
+import sys
+
+OUT = os.path.join(os.path.dirname(__file__), "..", "src", "tensor_arena_size.h")
+
+
+def main():
+    src = open(sys.argv[1], errors="replace") if len(sys.argv) > 1 else sys.stdin
+    defines = [line.split("ARENA:", 1)[1].strip() for line in src if "ARENA: #define" in line]
+    if len(defines) < 2:
+        sys.exit("No ARENA: lines found; was the firmware built with -DTFLITE_ARENA_MEASURE=1?")
+    with open(OUT, "w") as f:
+        f.write("// Generated by scripts/arena_from_log.py from a TFLITE_ARENA_MEASURE run.\n")
+        f.write("#ifndef TENSOR_ARENA_SIZE_H\n#define TENSOR_ARENA_SIZE_H\n\n")
+        f.write("\n".join(defines[-2:]) + "\n")
+        f.write("\n#endif // TENSOR_ARENA_SIZE_H\n")
+    print(f"Wrote {os.path.normpath(OUT)}:\n  " + "\n  ".join(defines[-2:]))
+
+
+if __name__ == "__main__":
+    main()
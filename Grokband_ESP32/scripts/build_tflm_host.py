@@ -0,0 +1,85 @@
+"""
+PlatformIO post script for native_tflm: builds TFLM for the host from the esp-tflite-micro tree
+in lib_deps and links it into the test, so the model runs on x86 with the same reference
+kernels, OpTimingProfiler and OPPROF report as the band.
+
+The package is not built as a PlatformIO library (lib_ignore): its root holds examples and
+tests with their own main(). Only the interpreter, the reference kernels and what they need are
+compiled, into a static library, with the esp_nn/ kernel directory left out. Sources in that set
+that include ESP-IDF headers fail the build here with their names, since they are the platform
+hooks (logging, timer) that need a host version.
+
+Also defines TFLM_HOST_MODEL as the first model in custom_sign_model, the one the generated
+op resolver (scripts/gen_op_resolver.py) was built for. Runs as post: rather than pre: because
+PlatformIO installs lib_deps after the pre scripts.
+"""
+import glob
+import os
+import re
+import sys
+
+PACKAGE = "esp-tflite-micro"
+
+# Relative to the package root, PlatformIO src_filter syntax; '*' stays within a directory
+TFLM_SRC_FILTER = [
+    "-<*>",
+    "+<tensorflow/lite/micro/*.cc>",
+    "+<tensorflow/lite/micro/arena_allocator/*.cc>",
+    "+<tensorflow/lite/micro/memory_planner/*.cc>",
+    "+<tensorflow/lite/micro/tflite_bridge/*.cc>",
+    "+<tensorflow/lite/micro/kernels/*.cc>",
+    "+<tensorflow/lite/core/api/*.cc>",
+    "+<tensorflow/lite/core/c/*.cc>",
+    "+<tensorflow/lite/kernels/*.cc>",
+    "+<tensorflow/lite/kernels/internal/*.cc>",
+    "+<tensorflow/lite/kernels/internal/reference/*.cc>",
+    "+<tensorflow/lite/schema/*.cc>",
+    "-<**/*_test.cc>",
+]
+
+ESP_IDF_INCLUDE = re.compile(r'^\s*#\s*include\s*[<"](esp_|freertos/|sdkconfig)', re.MULTILINE)
+
+
+def selected_sources(root):
+    """The files TFLM_SRC_FILTER picks, for the ESP-IDF check"""
+    picked = set()
+    for rule in TFLM_SRC_FILTER:
+        pattern = rule[2:-1]
+        matches = {os.path.relpath(p, root) for p in glob.glob(os.path.join(root, pattern), recursive=True)}
+        if rule.startswith("+"):
+            picked |= matches
+        else:
+            picked -= matches
+    return sorted(p for p in picked if os.path.isfile(os.path.join(root, p)))
+
+
+def run_platformio(env):
+    root = os.path.join(env.subst("$PROJECT_LIBDEPS_DIR"), env.subst("$PIOENV"), PACKAGE)
+    if not os.path.isdir(os.path.join(root, "tensorflow", "lite", "micro")):
+        sys.stderr.write(f"build_tflm_host: no TFLM tree at {root} (lib_deps should fetch {PACKAGE})\n")
+        env.Exit(1)
+
+    sources = selected_sources(root)
+    esp_only = []
+    for path in sources:
+        with open(os.path.join(root, path), errors="replace") as f:
+            if ESP_IDF_INCLUDE.search(f.read()):
+                esp_only.append(path)
+    if esp_only:
+        sys.stderr.write("build_tflm_host: these TFLM sources include ESP-IDF headers and won't build "
+                         "on the host:\n  " + "\n  ".join(esp_only) + "\n"
+                         "Exclude them in TFLM_SRC_FILTER and add host versions to test/test_tflm_op_profile.\n")
+        env.Exit(1)
+
+    project_dir = env.subst("$PROJECT_DIR")
+    models = [p.strip() for p in env.GetProjectOption("custom_sign_model", "data/sign_model.tflite").split(",")]
+    model = os.path.join(project_dir, models[0]).replace("\\", "/")
+    env.Append(CPPDEFINES=[("TFLM_HOST_MODEL", env.StringifyMacro(model))])
+
+    lib = env.BuildLibrary(os.path.join("$BUILD_DIR", "tflm"), root, src_filter=TFLM_SRC_FILTER)
+    env.Prepend(LIBS=[lib])
+    print(f"build_tflm_host: {len(sources)} TFLM sources from {root}, model {models[0]}")
+
+
+Import("env")  # noqa: F821 (provided by PlatformIO/SCons)
+run_platformio(env)  # noqa: F821
@@ -0,0 +1,145 @@
+"""
+Picks per-class acceptance thresholds from a recorded score corpus and writes the calibration
+table the firmware loads next to the model (data/sign_model.calib, see score_postprocess.h).
+
+    python scripts/calibrate_thresholds.py corpus.csv --precision 0.95
+    python scripts/calibrate_thresholds.py corpus.csv --scale 0.00390625 --zero-point -128
+
+The corpus has one inferred frame per line: `label,s0,s1,...` with the true class index (-1 for
+frames with no sign) followed by the model's raw outputs, e.g. from running the .tflite over
+labelled clips. With --scale/--zero-point the outputs are quantized and are dequantized first.
+
+Each class first gets its calibration p = clamp(scale * s + offset, 0, 1): a least-squares line
+from its dequantized score s to "the frame really is this class", over the frames it wins. The
+firmware ranks on the raw outputs and applies thresholds and margins to p, and so does this
+script. Then, for each class, the lowest threshold whose accepted frames reach the target
+precision is kept (maximum recall at that precision); classes that can't reach it get the
+highest p seen. Precision/recall of plain argmax (what the band used to publish) and of the
+table are printed.
+"""
+import argparse
+import sys
+
+
+def load_corpus(path, scale, zero_point):
+    labels, rows = [], []
+    with open(path) as f:
+        for n, line in enumerate(f, 1):
+            line = line.split("#", 1)[0].strip()
+            if not line or line.startswith("label"):
+                continue
+            fields = line.split(",")
+            try:
+                labels.append(int(fields[0]))
+                rows.append([scale * (float(v) - zero_point) for v in fields[1:]])
+            except ValueError:
+                sys.exit(f"{path}:{n}: expected label,score,score,...")
+    if not rows or len({len(r) for r in rows}) != 1:
+        sys.exit(f"{path}: empty, or rows with different class counts")
+    return labels, rows
+
+
+def fit_calibration(c, labels, rows):
+    """(scale, offset) of class c; identity when its frames can't support a rising line."""
+    frames = [(r[c], 1.0 if y == c else 0.0) for y, r in zip(labels, rows) if argmax(r) == c]
+    if len(frames) < 2:
+        return 1.0, 0.0
+    n = len(frames)
+    mean_s = sum(s for s, _ in frames) / n
+    mean_y = sum(y for _, y in frames) / n
+    var = sum((s - mean_s) ** 2 for s, _ in frames)
+    cov = sum((s - mean_s) * (y - mean_y) for s, y in frames)
+    if var <= 0.0 or cov <= 0.0:
+        return 1.0, 0.0  # The firmware needs scale > 0 to keep the raw-domain early reject
+    scale = cov / var
+    return scale, mean_y - scale * mean_s
+
+
+def probability(calibration, score):
+    scale, offset = calibration
+    return min(1.0, max(0.0, scale * score + offset))
+
+
+def argmax(scores):
+    # First index wins ties, like ScorePostprocessor
+    return max(range(len(scores)), key=lambda c: (scores[c], -c))
+
+
+def decide(scores, calibrations, thresholds, margin):
+    # Ranked on the outputs, judged on calibrated probabilities (ScorePostprocessor::process)
+    order = sorted(range(len(scores)), key=lambda c: (-scores[c], c))
+    best = order[0]
+    p_best = probability(calibrations[best], scores[best])
+    runner_up = probability(calibrations[order[1]], scores[order[1]]) if len(order) > 1 else 0.0
+    if p_best < thresholds[best] or p_best - runner_up < margin:
+        return -1
+    return best
+
+
+def precision_recall(labels, predictions, num_classes):
+    stats = []
+    for c in range(num_classes):
+        tp = sum(1 for y, p in zip(labels, predictions) if p == c and y == c)
+        fp = sum(1 for y, p in zip(labels, predictions) if p == c and y != c)
+        fn = sum(1 for y, p in zip(labels, predictions) if p != c and y == c)
+        stats.append((tp / (tp + fp) if tp + fp else 1.0, tp / (tp + fn) if tp + fn else 1.0))
+    return stats
+
+
+def pick_threshold(c, labels, rows, calibrations, margin, precision):
+    # Frames c wins with the margin, most confident first
+    no_threshold = [0.0] * len(rows[0])
+    frames = [(probability(calibrations[c], r[c]), y == c) for y, r in zip(labels, rows)
+              if decide(r, calibrations, no_threshold, margin) == c]
+    frames.sort(reverse=True)
+    best, tp = None, 0
+    for i, (p, correct) in enumerate(frames, 1):
+        tp += correct
+        if tp / i >= precision:
+            best = p
+    if best is None:
+        return max((p for p, _ in frames), default=1.0)
+    return best
+
+
+def calibrate(labels, rows, margin, precision):
+    """Per-class (threshold, scale, offset) for the table."""
+    num_classes = len(rows[0])
+    calibrations = [fit_calibration(c, labels, rows) for c in range(num_classes)]
+    thresholds = [pick_threshold(c, labels, rows, calibrations, margin, precision) for c in range(num_classes)]
+    return thresholds, calibrations
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("corpus")
+    parser.add_argument("--precision", type=float, default=0.95, help="target precision per class")
+    parser.add_argument("--margin", type=float, default=0.1, help="lead over the runner-up, every class")
+    parser.add_argument("--scale", type=float, default=1.0, help="output quantization scale")
+    parser.add_argument("--zero-point", type=int, default=0, help="output quantization zero point")
+    parser.add_argument("-o", "--output", default="data/sign_model.calib")
+    args = parser.parse_args()
+
+    labels, rows = load_corpus(args.corpus, args.scale, args.zero_point)
+    num_classes = len(rows[0])
+    thresholds, calibrations = calibrate(labels, rows, args.margin, args.precision)
+
+    before = precision_recall(labels, [argmax(r) for r in rows], num_classes)
+    after = precision_recall(labels, [decide(r, calibrations, thresholds, args.margin) for r in rows], num_classes)
+    print(f"{'class':>5} {'scale':>7} {'offset':>7} {'threshold':>9} {'argmax P':>9} {'argmax R':>9} {'calib P':>8} {'calib R':>8}")
+    for c in range(num_classes):
+        scale, offset = calibrations[c]
+        print(f"{c:>5} {scale:>7.3f} {offset:>7.3f} {thresholds[c]:>9.3f} "
+              f"{before[c][0]:>9.3f} {before[c][1]:>9.3f} {after[c][0]:>8.3f} {after[c][1]:>8.3f}")
+
+    with open(args.output, "w") as f:
+        f.write(f"# Per-class calibration from {args.corpus}: precision >= {args.precision}, margin {args.margin}\n")
+        f.write("# class,threshold,margin,scale,offset\n")
+        for c in range(num_classes):
+            scale, offset = calibrations[c]
+            f.write(f"{c},{thresholds[c]:.4f},{args.margin:.4f},{scale:.6g},{offset:.6g}\n")
+    print(f"Wrote {args.output} ({len(rows)} frames, {num_classes} classes)")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,112 @@
+"""
+PlatformIO post script for native_esp_nn: checks the esp-nn and esp-tflite-micro trees the
+kernel suite compiles from before anything is built, so a bad pin or a moved file fails with
+a list of what is missing instead of an include error from one of the wrapper sources.
+
+For each git dependency in lib_deps it checks that the installed package was fetched at the
+tag written there (the `uri` PlatformIO records in the package's .piopm), and that the files
+the suite #includes exist at the paths it expects. Runs as post: rather than pre: because
+PlatformIO installs lib_deps after the pre scripts.
+
+Can also be run by hand: python scripts/check_esp_nn_deps.py <.pio/libdeps/native_esp_nn>
+"""
+import configparser
+import json
+import os
+import sys
+
+# Package directory name -> files the suite needs from it
+REQUIRED_FILES = {
+    "esp-nn": [
+        "include/esp_nn.h",
+        "src/common/common_functions.h",
+        "src/convolution/esp_nn_conv_ansi.c",
+        "src/convolution/esp_nn_conv_opt.c",
+        "src/convolution/esp_nn_depthwise_conv_ansi.c",
+        "src/convolution/esp_nn_depthwise_conv_opt.c",
+        "src/fully_connected/esp_nn_fully_connected_ansi.c",
+        "src/pooling/esp_nn_avg_pool_ansi.c",
+        "src/pooling/esp_nn_max_pool_ansi.c",
+    ],
+    "esp-tflite-micro": [
+        "tensorflow/lite/kernels/internal/common.h",
+        "tensorflow/lite/kernels/internal/types.h",
+        "tensorflow/lite/kernels/internal/reference/integer_ops/conv.h",
+        "tensorflow/lite/kernels/internal/reference/integer_ops/depthwise_conv.h",
+        "tensorflow/lite/kernels/internal/reference/integer_ops/fully_connected.h",
+        "tensorflow/lite/kernels/internal/reference/integer_ops/pooling.h",
+        "third_party/gemmlowp/fixedpoint/fixedpoint.h",
+        "third_party/ruy/ruy/profiler/instrumentation.h",
+    ],
+}
+
+
+def pinned_tags(lib_deps):
+    """`https://.../esp-nn.git#v1.0.2` -> {"esp-nn": "v1.0.2"}"""
+    if isinstance(lib_deps, str):
+        lib_deps = lib_deps.splitlines()
+    tags = {}
+    for dep in lib_deps:
+        dep = dep.split(";")[0].strip()
+        if "#" not in dep or "://" not in dep:
+            continue
+        url, tag = dep.rsplit("#", 1)
+        name = url.rstrip("/").rsplit("/", 1)[-1]
+        tags[name[:-4] if name.endswith(".git") else name] = tag
+    return tags
+
+
+def installed_tag(package_dir):
+    try:
+        with open(os.path.join(package_dir, ".piopm")) as f:
+            uri = (json.load(f).get("spec") or {}).get("uri") or ""
+    except (OSError, ValueError):
+        return None
+    return uri.rsplit("#", 1)[1] if "#" in uri else None
+
+
+def check(libdeps_dir, tags):
+    """Problems found, one line each; empty when everything is in place"""
+    problems = []
+    for name, files in REQUIRED_FILES.items():
+        package_dir = os.path.join(libdeps_dir, name)
+        if not os.path.isdir(package_dir):
+            problems.append(f"{name}: not installed in {libdeps_dir}")
+            continue
+        want = tags.get(name)
+        got = installed_tag(package_dir)
+        if want and got != want:
+            problems.append(f"{name}: lib_deps pins {want} but {got or 'an unknown ref'} is installed "
+                            f"(delete {package_dir} to refetch)")
+        problems += [f"{name}: missing {p}" for p in files if not os.path.isfile(os.path.join(package_dir, p))]
+    return problems
+
+
+def ini_lib_deps(ini_path, env_name="native_esp_nn"):
+    parser = configparser.ConfigParser(interpolation=None, inline_comment_prefixes=(";",))
+    parser.read(ini_path)
+    return parser.get(f"env:{env_name}", "lib_deps", fallback="")
+
+
+def run_platformio(env):
+    libdeps_dir = os.path.join(env.subst("$PROJECT_LIBDEPS_DIR"), env.subst("$PIOENV"))
+    tags = pinned_tags(env.GetProjectOption("lib_deps", []))
+    problems = check(libdeps_dir, tags)
+    if problems:
+        sys.stderr.write("check_esp_nn_deps:\n  " + "\n  ".join(problems) + "\n"
+                         "The kernel suite compiles these files directly; if a new tag moved them, "
+                         "update REQUIRED_FILES and the wrappers in test/test_esp_nn_kernels.\n")
+        env.Exit(1)
+    print("check_esp_nn_deps: " + ", ".join(f"{n} {t}" for n, t in sorted(tags.items())))
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        sys.exit(__doc__)
+    ini = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "platformio.ini")
+    found = check(sys.argv[1], pinned_tags(ini_lib_deps(ini)))
+    print("\n".join(found) or "ok")
+    sys.exit(1 if found else 0)
+else:
+    Import("env")  # noqa: F821 (provided by PlatformIO/SCons)
+    run_platformio(env)  # noqa: F821
@@ -0,0 +1,247 @@
+"""
+PlatformIO pre-build script: generates a MicroMutableOpResolver that registers exactly
+the operators used by the deployed .tflite model(s).
+
+The model path comes from `custom_sign_model` in platformio.ini, so each model variant
+gets its own env and its own resolver. The build fails if the model needs an operator
+we don't know how to register with TFLM.
+
+The model is a build input that is not checked in (data/ holds whatever the training side
+exported). Without it the build still goes through, with a warning, on a resolver that
+registers every operator in TFLM_OPS: the same footprint as TFLM's AllOpsResolver, and any
+model the firmware later loads that sticks to those ops runs. `custom_all_ops_resolver = yes`
+asks for that resolver on purpose; esp32pico_all_ops uses it so scripts/resolver_size_check.py
+can compare flash size against the model-specific one. The header always carries the full
+resolver too (SignModelAllOpsResolver), for the host AllocateTensors() comparison.
+
+Output: $BUILD_DIR/generated/sign_model_ops.h (added to the include path).
+Can also be run by hand: python scripts/gen_op_resolver.py <model.tflite> [out.h]
+"""
+import os
+import struct
+import sys
+
+# BuiltinOperator code -> (schema name, MicroMutableOpResolver method)
+# Only ops that TFLM can run are listed; anything else fails the build.
+TFLM_OPS = {
+    0: ("ADD", "AddAdd"),
+    1: ("AVERAGE_POOL_2D", "AddAveragePool2D"),
+    2: ("CONCATENATION", "AddConcatenation"),
+    3: ("CONV_2D", "AddConv2D"),
+    4: ("DEPTHWISE_CONV_2D", "AddDepthwiseConv2D"),
+    5: ("DEPTH_TO_SPACE", "AddDepthToSpace"),
+    6: ("DEQUANTIZE", "AddDequantize"),
+    8: ("FLOOR", "AddFloor"),
+    9: ("FULLY_CONNECTED", "AddFullyConnected"),
+    11: ("L2_NORMALIZATION", "AddL2Normalization"),
+    12: ("L2_POOL_2D", "AddL2Pool2D"),
+    14: ("LOGISTIC", "AddLogistic"),
+    17: ("MAX_POOL_2D", "AddMaxPool2D"),
+    18: ("MUL", "AddMul"),
+    19: ("RELU", "AddRelu"),
+    21: ("RELU6", "AddRelu6"),
+    22: ("RESHAPE", "AddReshape"),
+    23: ("RESIZE_BILINEAR", "AddResizeBilinear"),
+    25: ("SOFTMAX", "AddSoftmax"),
+    26: ("SPACE_TO_DEPTH", "AddSpaceToDepth"),
+    28: ("TANH", "AddTanh"),
+    34: ("PAD", "AddPad"),
+    36: ("GATHER", "AddGather"),
+    37: ("BATCH_TO_SPACE_ND", "AddBatchToSpaceNd"),
+    38: ("SPACE_TO_BATCH_ND", "AddSpaceToBatchNd"),
+    39: ("TRANSPOSE", "AddTranspose"),
+    40: ("MEAN", "AddMean"),
+    41: ("SUB", "AddSub"),
+    42: ("DIV", "AddDiv"),
+    43: ("SQUEEZE", "AddSqueeze"),
+    45: ("STRIDED_SLICE", "AddStridedSlice"),
+    47: ("EXP", "AddExp"),
+    49: ("SPLIT", "AddSplit"),
+    50: ("LOG_SOFTMAX", "AddLogSoftmax"),
+    53: ("CAST", "AddCast"),
+    54: ("PRELU", "AddPrelu"),
+    55: ("MAXIMUM", "AddMaximum"),
+    56: ("ARG_MAX", "AddArgMax"),
+    57: ("MINIMUM", "AddMinimum"),
+    60: ("PADV2", "AddPadV2"),
+    65: ("SLICE", "AddSlice"),
+    67: ("TRANSPOSE_CONV", "AddTransposeConv"),
+    70: ("EXPAND_DIMS", "AddExpandDims"),
+    74: ("SUM", "AddSum"),
+    75: ("SQRT", "AddSqrt"),
+    76: ("RSQRT", "AddRsqrt"),
+    77: ("SHAPE", "AddShape"),
+    79: ("ARG_MIN", "AddArgMin"),
+    82: ("REDUCE_MAX", "AddReduceMax"),
+    83: ("PACK", "AddPack"),
+    87: ("UNPACK", "AddUnpack"),
+    96: ("RESIZE_NEAREST_NEIGHBOR", "AddResizeNearestNeighbor"),
+    97: ("LEAKY_RELU", "AddLeakyRelu"),
+    98: ("SQUARED_DIFFERENCE", "AddSquaredDifference"),
+    100: ("ABS", "AddAbs"),
+    101: ("SPLIT_V", "AddSplitV"),
+    113: ("QUANTIZE", "AddQuantize"),
+    116: ("HARD_SWISH", "AddHardSwish"),
+}
+CUSTOM_OP = 32
+
+
+class FlatbufferTable:
+    """Just enough of the flatbuffers wire format to walk a .tflite file."""
+
+    def __init__(self, buf, pos):
+        self.buf = buf
+        self.pos = pos
+        vtable = pos - struct.unpack_from("<i", buf, pos)[0]
+        self.vtable = vtable
+        self.vtable_size = struct.unpack_from("<H", buf, vtable)[0]
+
+    def _field_pos(self, index):
+        entry = 4 + 2 * index
+        if entry >= self.vtable_size:
+            return None
+        off = struct.unpack_from("<H", self.buf, self.vtable + entry)[0]
+        return self.pos + off if off else None
+
+    def scalar(self, index, fmt, default):
+        pos = self._field_pos(index)
+        return struct.unpack_from("<" + fmt, self.buf, pos)[0] if pos is not None else default
+
+    def table_vector(self, index):
+        pos = self._field_pos(index)
+        if pos is None:
+            return []
+        vec = pos + struct.unpack_from("<I", self.buf, pos)[0]
+        count = struct.unpack_from("<I", self.buf, vec)[0]
+        tables = []
+        for i in range(count):
+            elem = vec + 4 + 4 * i
+            tables.append(FlatbufferTable(self.buf, elem + struct.unpack_from("<I", self.buf, elem)[0]))
+        return tables
+
+
+def model_builtin_codes(path):
+    with open(path, "rb") as f:
+        buf = f.read()
+    if len(buf) < 8 or buf[4:8] != b"TFL3":
+        raise ValueError(f"{path} is not a TFLite flatbuffer (missing TFL3 identifier)")
+    model = FlatbufferTable(buf, struct.unpack_from("<I", buf, 0)[0])
+    codes = set()
+    # Model.operator_codes is field 1; OperatorCode.deprecated_builtin_code is field 0 (int8)
+    # and OperatorCode.builtin_code is field 3 (int32). Newer converters set both.
+    for opcode in model.table_vector(1):
+        deprecated = opcode.scalar(0, "b", 0)
+        builtin = opcode.scalar(3, "i", 0)
+        codes.add(max(deprecated, builtin))
+    return codes
+
+
+def generate_header(model_paths, out_path, all_ops=False):
+    """Writes the resolver header; with all_ops the models are not read (they may not exist)."""
+    codes = set()
+    if all_ops:
+        codes = set(TFLM_OPS)
+    for path in [] if all_ops else model_paths:
+        codes |= model_builtin_codes(path)
+
+    unsupported = sorted(c for c in codes if c not in TFLM_OPS)
+    if unsupported:
+        names = ", ".join("CUSTOM" if c == CUSTOM_OP else f"builtin {c}" for c in unsupported)
+        raise ValueError(f"model needs operators the firmware resolver can't register: {names}")
+
+    ops = sorted(codes, key=lambda c: TFLM_OPS[c][0])
+    all_codes = sorted(TFLM_OPS, key=lambda c: TFLM_OPS[c][0])
+    source = ("every operator gen_op_resolver.py knows" if all_ops
+              else ", ".join(os.path.basename(p) for p in model_paths))
+    lines = [
+        f"// Generated by scripts/gen_op_resolver.py from {source}.",
+        "// Do not edit: rebuilt whenever the model changes.",
+        "#ifndef SIGN_MODEL_OPS_H",
+        "#define SIGN_MODEL_OPS_H",
+        "",
+        '#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"',
+        '#include "tensorflow/lite/schema/schema_generated.h"',
+        "",
+        "// 0: no model at build time (or custom_all_ops_resolver), every known op is registered",
+        f"#define SIGN_MODEL_OPS_FROM_MODEL {0 if all_ops else 1}",
+        "",
+        f"constexpr int kSignModelOpCount = {len(ops)};",
+        "using SignModelOpResolver = tflite::MicroMutableOpResolver<kSignModelOpCount>;",
+        "",
+        "// Builtin operators registered below, used to reject a model loaded at runtime",
+        "// that needs something this build doesn't have.",
+        "constexpr tflite::BuiltinOperator kSignModelOps[kSignModelOpCount] = {",
+    ]
+    lines += [f"    tflite::BuiltinOperator_{TFLM_OPS[c][0]}," for c in ops]
+    lines += [
+        "};",
+        "",
+        "inline bool sign_model_register_ops(SignModelOpResolver& resolver) {",
+        "    return true",
+    ]
+    lines += [f"        && resolver.{TFLM_OPS[c][1]}() == kTfLiteOk" for c in ops]
+    lines += [
+        "        ;",
+        "}",
+        "",
+        "// Every operator the script knows: the resolver a model-independent build would use",
+        f"constexpr int kSignModelAllOpsCount = {len(all_codes)};",
+        "using SignModelAllOpsResolver = tflite::MicroMutableOpResolver<kSignModelAllOpsCount>;",
+        "",
+        "inline bool sign_model_register_all_ops(SignModelAllOpsResolver& resolver) {",
+        "    return true",
+    ]
+    lines += [f"        && resolver.{TFLM_OPS[c][1]}() == kTfLiteOk" for c in all_codes]
+    lines += [
+        "        ;",
+        "}",
+        "",
+        "#endif // SIGN_MODEL_OPS_H",
+        "",
+    ]
+    content = "\n".join(lines)
+
+    # Only touch the file when it changes so unrelated builds don't recompile the model layer
+    if os.path.exists(out_path):
+        with open(out_path) as f:
+            if f.read() == content:
+                return ops
+    os.makedirs(os.path.dirname(out_path) or ".", exist_ok=True)
+    with open(out_path, "w") as f:
+        f.write(content)
+    return ops
+
+
+def run_platformio(env):
+    project_dir = env.subst("$PROJECT_DIR")
+    model_option = env.GetProjectOption("custom_sign_model", "data/sign_model.tflite")
+    model_paths = [os.path.join(project_dir, p.strip()) for p in model_option.split(",") if p.strip()]
+    all_ops = env.GetProjectOption("custom_all_ops_resolver", "no").strip().lower() in ("yes", "true", "1")
+    missing = [p for p in model_paths if not os.path.isfile(p)]
+    if missing and not all_ops:
+        sys.stderr.write(f"gen_op_resolver: WARNING: model not found: {', '.join(missing)}\n"
+                         "  Building with every known operator registered instead (bigger flash, slower init).\n"
+                         "  Put the model there, or set custom_sign_model to the one this build ships with.\n")
+        all_ops = True
+
+    out_dir = os.path.join(env.subst("$BUILD_DIR"), "generated")
+    try:
+        ops = generate_header(model_paths, os.path.join(out_dir, "sign_model_ops.h"), all_ops)
+    except ValueError as e:
+        sys.stderr.write(f"gen_op_resolver: {e}\n")
+        env.Exit(1)
+    if all_ops:
+        print(f"gen_op_resolver: all {len(ops)} known ops")
+    else:
+        print(f"gen_op_resolver: {len(ops)} ops: {', '.join(TFLM_OPS[c][0] for c in ops)}")
+    env.Append(CPPPATH=[out_dir])
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        sys.exit(__doc__)
+    result = generate_header([sys.argv[1]], sys.argv[2] if len(sys.argv) > 2 else "sign_model_ops.h")
+    print(", ".join(TFLM_OPS[c][0] for c in result))
+elif "Import" in globals():  # Run by PlatformIO/SCons, not imported by a test
+    Import("env")  # noqa: F821
+    run_platformio(env)  # noqa: F821
@@ -0,0 +1,134 @@
+"""
+Diffs two per-op profiles (OPPROF lines from OpTimingProfiler::log_report) layer by layer,
+e.g. the band against a host build of the same model, or two model variants on the band.
+
+    pio run -e esp32pico -t monitor | tee device.log     (built with -DTFLITE_OP_PROFILE=1)
+    pio test -e native_tflm -v | tee host.log            (same model, TFLM on x86)
+    python scripts/op_profile_diff.py device.log host.log
+    python scripts/op_profile_diff.py boot.log boot.log --label-a internal --label-b split
+
+Each log may hold several reports; the last complete one (per label) is used. Layers are
+matched by index; a mismatch in op type or shapes means the models differ and is flagged.
+
+With --kernels the KCHECK lines of two builds with -DTFLITE_KERNEL_CHECK=1 are compared
+instead (e.g. reference vs. ESP-NN kernels): every case's output CRC must match, and the
+Invoke() speed ratio is reported. Exits 1 on any mismatch.
+
+    python scripts/op_profile_diff.py reference.log esp_nn.log --kernels
+"""
+import argparse
+import sys
+
+FIELDS = ("idx", "op", "inputs", "outputs", "out_bytes", "ticks", "us")
+
+
+def read_reports(path):
+    """Returns {label: [rows]} with the last complete report per label."""
+    reports, current = {}, {}
+    with open(path, errors="replace") as f:
+        for line in f:
+            pos = line.find("OPPROF,")
+            if pos < 0:
+                continue
+            parts = line[pos:].rstrip("\n").split(",")
+            if len(parts) < 3:
+                continue
+            label, rest = parts[1], parts[2:]
+            if rest[0] == "idx":
+                current[label] = []
+            elif rest[0] == "total":
+                if label in current:
+                    reports[label] = current.pop(label)
+            elif rest[0].isdigit() and len(rest) == len(FIELDS) and label in current:
+                row = dict(zip(FIELDS, rest))
+                for key in ("idx", "out_bytes", "ticks", "us"):
+                    row[key] = int(row[key])
+                current[label].append(row)
+    return reports
+
+
+def read_kernel_checks(path):
+    """Returns (backend, {case: (crc, us)}) from the KCHECK lines of the last boot in the log."""
+    backend, cases = None, {}
+    with open(path, errors="replace") as f:
+        for line in f:
+            pos = line.find("KCHECK,")
+            if pos < 0:
+                continue
+            parts = line[pos:].rstrip("\n").split(",")
+            if len(parts) != 5 or not parts[2].isdigit():
+                continue
+            case = int(parts[2])
+            if case == 0:
+                cases = {}
+            backend = parts[1]
+            cases[case] = (parts[3], int(parts[4]))
+    if not cases:
+        sys.exit(f"{path}: no KCHECK lines (build with -DTFLITE_KERNEL_CHECK=1)")
+    return backend, cases
+
+
+def compare_kernels(path_a, path_b):
+    backend_a, a = read_kernel_checks(path_a)
+    backend_b, b = read_kernel_checks(path_b)
+    common = sorted(set(a) & set(b))
+    mismatches = [c for c in common if a[c][0] != b[c][0]]
+    print(f"{'case':>4} {backend_a + ' crc':>16} {backend_b + ' crc':>16} {'A us':>8} {'B us':>8} {'A/B':>6}")
+    for c in common:
+        ratio = a[c][1] / b[c][1] if b[c][1] else float("inf")
+        flag = "" if a[c][0] == b[c][0] else "  <- outputs differ"
+        print(f"{c:>4} {a[c][0]:>16} {b[c][0]:>16} {a[c][1]:>8} {b[c][1]:>8} {ratio:>6.2f}{flag}")
+    total_a = sum(a[c][1] for c in common)
+    total_b = sum(b[c][1] for c in common) or 1
+    print(f"{len(common)} cases, {len(mismatches)} mismatched, {backend_a}/{backend_b} speed ratio {total_a / total_b:.2f}")
+    return 1 if mismatches or not common else 0
+
+
+def pick(reports, label, path):
+    if not reports:
+        sys.exit(f"{path}: no complete OPPROF report found")
+    if label is None:
+        if len(reports) > 1:
+            print(f"{path}: several labels ({', '.join(reports)}), using the last; pick one with --label-a/-b",
+                  file=sys.stderr)
+        return list(reports.values())[-1]
+    if label not in reports:
+        sys.exit(f"{path}: no report labelled '{label}' (have: {', '.join(reports)})")
+    return reports[label]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("log_a")
+    parser.add_argument("log_b")
+    parser.add_argument("--label-a")
+    parser.add_argument("--label-b")
+    parser.add_argument("--top", type=int, default=0, help="only show the N slowest layers of A")
+    parser.add_argument("--kernels", action="store_true", help="compare KCHECK output CRCs and Invoke() times")
+    args = parser.parse_args()
+    if args.kernels:
+        sys.exit(compare_kernels(args.log_a, args.log_b))
+
+    a = pick(read_reports(args.log_a), args.label_a, args.log_a)
+    b = pick(read_reports(args.log_b), args.label_b, args.log_b)
+    if len(a) != len(b):
+        print(f"warning: {len(a)} ops vs {len(b)} ops, comparing the common prefix", file=sys.stderr)
+
+    total_a = sum(r["us"] for r in a) or 1
+    total_b = sum(r["us"] for r in b) or 1
+    rows = list(zip(a, b))
+    if args.top:
+        rows = sorted(rows, key=lambda ab: ab[0]["us"], reverse=True)[:args.top]
+
+    print(f"{'idx':>3} {'op':<22} {'outputs':<24} {'bytes':>8} {'A us':>8} {'B us':>8} {'A/B':>6} {'A %':>6}")
+    for ra, rb in rows:
+        same = ra["op"] == rb["op"] and ra["inputs"] == rb["inputs"] and ra["outputs"] == rb["outputs"]
+        ratio = ra["us"] / rb["us"] if rb["us"] else float("inf")
+        flag = "" if same else f"  <- B is {rb['op']} {rb['outputs']}"
+        print(f"{ra['idx']:>3} {ra['op']:<22} {ra['outputs']:<24} {ra['out_bytes']:>8} {ra['us']:>8} {rb['us']:>8} "
+              f"{ratio:>6.2f} {100.0 * ra['us'] / total_a:>5.1f}%{flag}")
+    print(f"{'':>3} {'total':<22} {'':<24} {'':>8} {total_a:>8} {total_b:>8} {total_a / total_b:>6.2f}")
+
+
+if __name__ == "__main__":
+    main()
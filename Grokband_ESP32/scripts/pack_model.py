@@ -0,0 +1,38 @@
+"""
+Wraps a .tflite model in the image format read by model_loader.cpp (ModelImageHeader
+followed by the flatbuffer) so it can be flashed to the `model` data partition:
+
+    python scripts/pack_model.py data/sign_model.tflite .pio/model.bin
+    parttool.py --port <port> write_partition --partition-name model --input .pio/model.bin
+
+The cascade's hand detector is packed the same way and written to the `hand_det` partition.
+
+The firmware maps the partition in place at boot; SPIFFS is only used as a fallback.
+"""
+import struct
+import sys
+import zlib
+
+MODEL_IMAGE_MAGIC = 0x444D4247  # "GBMD"
+MODEL_IMAGE_HEADER_VERSION = 1
+TFLITE_SCHEMA_VERSION = 3
+HEADER = struct.Struct("<IHHII16x")  # Must match ModelImageHeader (32 bytes)
+
+
+def pack(model_bytes, schema_version=TFLITE_SCHEMA_VERSION):
+    if model_bytes[4:8] != b"TFL3":
+        raise ValueError("input is not a TFLite flatbuffer")
+    header = HEADER.pack(MODEL_IMAGE_MAGIC, MODEL_IMAGE_HEADER_VERSION, schema_version,
+                         len(model_bytes), zlib.crc32(model_bytes) & 0xFFFFFFFF)
+    return header + model_bytes
+
+
+if __name__ == "__main__":
+    if len(sys.argv) != 3:
+        sys.exit(__doc__)
+    with open(sys.argv[1], "rb") as f:
+        model = f.read()
+    image = pack(model)
+    with open(sys.argv[2], "wb") as f:
+        f.write(image)
+    print(f"{sys.argv[2]}: {len(model)} byte model, crc32 0x{zlib.crc32(model) & 0xFFFFFFFF:08x}")
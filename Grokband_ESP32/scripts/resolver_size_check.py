@@ -0,0 +1,71 @@
+"""
+Flash and RAM cost of the generated op resolver against registering every op: builds the
+firmware twice, esp32pico (only the model's ops, scripts/gen_op_resolver.py) and
+esp32pico_all_ops (every op the generator knows, what AllOpsResolver used to link), and
+compares the sizes PlatformIO reports.
+
+    python scripts/resolver_size_check.py
+    python scripts/resolver_size_check.py --logs model_boot.log all_ops_boot.log
+
+With --logs, the AllocateTensors() time each firmware logs at boot ("AllocateTensors() took N
+us") is compared too; capture them with `pio run -e <env> -t upload -t monitor`. The host
+equivalent is test_tflm_op_profile (pio test -e native_tflm -v). Exits 1 if the model-specific
+build is not smaller, e.g. because the model was missing and both fell back to every op.
+"""
+import argparse
+import re
+import subprocess
+import sys
+
+ENVS = ("esp32pico", "esp32pico_all_ops")
+USAGE = re.compile(r"^(RAM|Flash):.*\(used (\d+) bytes from (\d+) bytes\)", re.MULTILINE)
+ALLOCATE = re.compile(r"AllocateTensors\(\) took (\d+) us")
+
+
+def build_sizes(env):
+    """{"RAM": used, "Flash": used} from the summary `pio run` prints"""
+    result = subprocess.run(["pio", "run", "-e", env], capture_output=True, text=True)
+    if result.returncode != 0:
+        sys.stderr.write(result.stdout[-2000:] + result.stderr[-2000:])
+        sys.exit(f"pio run -e {env} failed")
+    return parse_sizes(result.stdout, env)
+
+
+def parse_sizes(output, what):
+    sizes = {m.group(1): int(m.group(2)) for m in USAGE.finditer(output)}
+    if "Flash" not in sizes:
+        sys.exit(f"{what}: no 'Flash: ... (used N bytes ...)' line in the build output")
+    return sizes
+
+
+def allocate_us(path):
+    """Last AllocateTensors() time in a boot log"""
+    with open(path, errors="replace") as f:
+        times = ALLOCATE.findall(f.read())
+    if not times:
+        sys.exit(f"{path}: no 'AllocateTensors() took N us' line")
+    return int(times[-1])
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--logs", nargs=2, metavar=("MODEL_LOG", "ALL_OPS_LOG"),
+                        help="boot logs of the two firmwares, for AllocateTensors() time")
+    args = parser.parse_args()
+
+    model, all_ops = (build_sizes(env) for env in ENVS)
+    print(f"{'':>20} {'model ops':>12} {'all ops':>12} {'saved':>10}")
+    for key in ("Flash", "RAM"):
+        if key in model and key in all_ops:
+            print(f"{key + ' bytes':>20} {model[key]:>12} {all_ops[key]:>12} {all_ops[key] - model[key]:>10}")
+    if args.logs:
+        a, b = allocate_us(args.logs[0]), allocate_us(args.logs[1])
+        print(f"{'AllocateTensors us':>20} {a:>12} {b:>12} {b - a:>10}")
+    if model["Flash"] >= all_ops["Flash"]:
+        print("model-specific resolver is not smaller: is custom_sign_model present?", file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,84 @@
+"""
+calibrate_thresholds.py on a synthetic corpus whose classes are miscalibrated in known ways.
+
+    python3 -m unittest discover -s scripts
+"""
+import os
+import random
+import subprocess
+import sys
+import tempfile
+import unittest
+
+sys.path.insert(0, os.path.dirname(__file__))
+import calibrate_thresholds as ct  # noqa: E402
+
+NUM_CLASSES = 4
+
+
+def corpus(frames=6000, seed=24):
+    """Class 0 is overconfident (right half as often as its score says), class 1 honest,
+    classes 2 and 3 underconfident. A third of the frames have no sign."""
+    rng = random.Random(seed)
+    reliability = [0.5, 1.0, 1.3, 1.3]
+    labels, rows = [], []
+    for _ in range(frames):
+        winner = rng.randrange(NUM_CLASSES)
+        top = rng.uniform(0.3, 0.75)
+        rest = [rng.random() for _ in range(NUM_CLASSES - 1)]
+        row = [(1.0 - top) * r / sum(rest) for r in rest]
+        row.insert(winner, top)
+        correct = rng.random() < min(1.0, reliability[winner] * top)
+        labels.append(winner if correct else -1)
+        rows.append(row)
+    return labels, rows
+
+
+class CalibrateThresholdsTest(unittest.TestCase):
+    def test_fit_follows_reliability(self):
+        labels, rows = corpus()
+        _, calibrations = ct.calibrate(labels, rows, margin=0.0, precision=0.8)
+        # p = scale * s + offset against P(correct | s) = reliability * s
+        for c, expected in enumerate([0.5, 1.0, 1.3, 1.3]):
+            scale, offset = calibrations[c]
+            self.assertGreater(scale, 0.0)
+            self.assertAlmostEqual(scale * 0.6 + offset, min(1.0, expected * 0.6), delta=0.08)
+
+    def test_calibrated_table_beats_argmax(self):
+        labels, rows = corpus()
+        thresholds, calibrations = ct.calibrate(labels, rows, margin=0.0, precision=0.7)
+        argmax = ct.precision_recall(labels, [ct.argmax(r) for r in rows], NUM_CLASSES)
+        table = ct.precision_recall(labels, [ct.decide(r, calibrations, thresholds, 0.0) for r in rows], NUM_CLASSES)
+        for c in range(1, NUM_CLASSES):
+            self.assertGreaterEqual(table[c][0], 0.7)
+            self.assertGreater(table[c][0], argmax[c][0])
+        # Class 0 is never right more than 37.5% of the time: it gets the highest p seen, so
+        # almost nothing passes
+        self.assertLess(table[0][1], 0.01)
+
+    def test_degenerate_class_keeps_identity(self):
+        labels, rows = [-1, -1, 0], [[0.9, 0.1], [0.8, 0.2], [0.7, 0.3]]  # Class 1 never wins
+        self.assertEqual(ct.fit_calibration(1, labels, rows), (1.0, 0.0))
+        self.assertEqual(ct.fit_calibration(0, labels, rows), (1.0, 0.0))  # Falling line
+
+    def test_writes_fitted_table(self):
+        labels, rows = corpus(frames=2000)
+        with tempfile.TemporaryDirectory() as tmp:
+            src, out = os.path.join(tmp, "corpus.csv"), os.path.join(tmp, "sign_model.calib")
+            with open(src, "w") as f:
+                f.write("label," + ",".join(f"s{c}" for c in range(NUM_CLASSES)) + "\n")
+                for y, r in zip(labels, rows):
+                    # Quantized like an int8 softmax output: scale 1/256, zero point -128
+                    f.write(f"{y}," + ",".join(str(min(127, round(s * 256) - 128)) for s in r) + "\n")
+            subprocess.run([sys.executable, os.path.join(os.path.dirname(__file__), "calibrate_thresholds.py"), src,
+                            "--scale", "0.00390625", "--zero-point", "-128", "--precision", "0.8", "-o", out],
+                           check=True, capture_output=True)
+            with open(out) as f:
+                table = [line.split(",") for line in f if not line.startswith("#")]
+        self.assertEqual([int(row[0]) for row in table], list(range(NUM_CLASSES)))
+        self.assertTrue(all(len(row) == 5 for row in table))
+        self.assertTrue(any(float(row[3]) != 1.0 or float(row[4]) != 0.0 for row in table))
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,138 @@
+"""
+gen_op_resolver.py on hand-built .tflite flatbuffers: the resolver follows the model's operator
+codes, unknown ops fail the build, and a missing model falls back to every known op.
+
+    python3 -m unittest discover -s scripts
+"""
+import os
+import struct
+import sys
+import tempfile
+import unittest
+
+sys.path.insert(0, os.path.dirname(__file__))
+import gen_op_resolver as gen  # noqa: E402
+
+CONV_2D, DEPTHWISE_CONV_2D, FULLY_CONNECTED = 3, 4, 9
+
+
+def tflite_with_ops(codes):
+    """Smallest flatbuffer the script reads: a Model whose operator_codes hold `codes`"""
+    buf = bytearray(b"\0\0\0\0TFL3")
+    # Model vtable (operator_codes is field 1), then the table: soffset, uoffset to the vector
+    model_vtable = len(buf)
+    buf += struct.pack("<HHHH", 8, 8, 0, 4)
+    model = len(buf)
+    buf += struct.pack("<iI", model - model_vtable, 0)
+    struct.pack_into("<I", buf, 0, model)
+    vector = len(buf)
+    struct.pack_into("<I", buf, model + 4, vector - (model + 4))
+    buf += struct.pack("<I", len(codes)) + b"\0" * 4 * len(codes)
+    for i, code in enumerate(codes):
+        # OperatorCode: deprecated_builtin_code (field 0, int8) and builtin_code (field 3, int32)
+        vtable = len(buf)
+        buf += struct.pack("<HHHHHH", 12, 12, 8, 0, 0, 4)
+        table = len(buf)
+        buf += struct.pack("<iibxxx", table - vtable, code, min(code, 127))
+        elem = vector + 4 + 4 * i
+        struct.pack_into("<I", buf, elem, table - elem)
+    return bytes(buf)
+
+
+class FakeEnv:
+    """The bits of the PlatformIO environment run_platformio() uses"""
+
+    def __init__(self, project_dir, options):
+        self.project_dir = project_dir
+        self.options = options
+        self.cpppath = []
+        self.exit_code = None
+
+    def subst(self, value):
+        return {"$PROJECT_DIR": self.project_dir, "$BUILD_DIR": os.path.join(self.project_dir, "build")}[value]
+
+    def GetProjectOption(self, name, default=None):
+        return self.options.get(name, default)
+
+    def Append(self, CPPPATH):
+        self.cpppath += CPPPATH
+
+    def Exit(self, code):
+        self.exit_code = code
+        raise SystemExit(code)
+
+
+class GenOpResolverTest(unittest.TestCase):
+    def setUp(self):
+        self.tmp = tempfile.TemporaryDirectory()
+        self.dir = self.tmp.name
+
+    def tearDown(self):
+        self.tmp.cleanup()
+
+    def write_model(self, name, codes):
+        path = os.path.join(self.dir, name)
+        with open(path, "wb") as f:
+            f.write(tflite_with_ops(codes))
+        return path
+
+    def header(self):
+        with open(os.path.join(self.dir, "build", "generated", "sign_model_ops.h")) as f:
+            return f.read()
+
+    def test_registers_exactly_the_models_ops(self):
+        model = self.write_model("m.tflite", [CONV_2D, DEPTHWISE_CONV_2D, FULLY_CONNECTED, CONV_2D])
+        self.assertEqual(gen.model_builtin_codes(model), {CONV_2D, DEPTHWISE_CONV_2D, FULLY_CONNECTED})
+        out = os.path.join(self.dir, "ops.h")
+        gen.generate_header([model], out)
+        with open(out) as f:
+            text = f.read()
+        self.assertIn("constexpr int kSignModelOpCount = 3;", text)
+        self.assertIn("#define SIGN_MODEL_OPS_FROM_MODEL 1", text)
+        specific = text[:text.index("sign_model_register_all_ops")]
+        for method in ("AddConv2D", "AddDepthwiseConv2D", "AddFullyConnected"):
+            self.assertEqual(specific.count(f"resolver.{method}()"), 1)
+        self.assertNotIn("AddSoftmax", specific)
+        self.assertIn(f"constexpr int kSignModelAllOpsCount = {len(gen.TFLM_OPS)};", text)
+
+    def test_variants_are_merged(self):
+        a = self.write_model("a.tflite", [CONV_2D])
+        b = self.write_model("b.tflite", [FULLY_CONNECTED])
+        self.assertEqual(gen.generate_header([a, b], os.path.join(self.dir, "ops.h")), [CONV_2D, FULLY_CONNECTED])
+
+    def test_unknown_op_fails(self):
+        model = self.write_model("m.tflite", [CONV_2D, gen.CUSTOM_OP])
+        with self.assertRaisesRegex(ValueError, "CUSTOM"):
+            gen.generate_header([model], os.path.join(self.dir, "ops.h"))
+
+    def test_not_a_tflite_file(self):
+        path = os.path.join(self.dir, "m.tflite")
+        with open(path, "wb") as f:
+            f.write(b"\0" * 64)
+        with self.assertRaisesRegex(ValueError, "TFL3"):
+            gen.model_builtin_codes(path)
+
+    def test_missing_model_falls_back_to_all_ops(self):
+        env = FakeEnv(self.dir, {"custom_sign_model": "data/sign_model.tflite"})
+        gen.run_platformio(env)
+        self.assertIsNone(env.exit_code)
+        text = self.header()
+        self.assertIn("#define SIGN_MODEL_OPS_FROM_MODEL 0", text)
+        self.assertIn(f"constexpr int kSignModelOpCount = {len(gen.TFLM_OPS)};", text)
+        self.assertEqual(env.cpppath, [os.path.join(self.dir, "build", "generated")])
+
+    def test_all_ops_on_request(self):
+        self.write_model("m.tflite", [CONV_2D])
+        env = FakeEnv(self.dir, {"custom_sign_model": "m.tflite", "custom_all_ops_resolver": "yes"})
+        gen.run_platformio(env)
+        self.assertIn("#define SIGN_MODEL_OPS_FROM_MODEL 0", self.header())
+
+    def test_model_present_is_used(self):
+        self.write_model("m.tflite", [CONV_2D])
+        env = FakeEnv(self.dir, {"custom_sign_model": "m.tflite"})
+        gen.run_platformio(env)
+        self.assertIn("constexpr int kSignModelOpCount = 1;", self.header())
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,104 @@
+#include "boot_sequencer.h"
+#include "config.h"
+#include "camera_handler.h"
+#include "sign_language_model.h"
+#include "signing_pipeline.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include <stdio.h>
+
+static const char* TAG = "boot";
+
+#ifndef FIRMWARE_BUILD_ID
+#define FIRMWARE_BUILD_ID __DATE__ " " __TIME__ // Override with -DFIRMWARE_BUILD_ID="..." in CI builds
+#endif
+
+namespace {
+    constexpr int kMilestones = (int)BootMilestone::COUNT;
+    const char* const kMilestoneNames[kMilestones] = {
+        "display", "wifi_started", "camera", "model", "pipeline", "wifi_connected", "mqtt_connected"
+    };
+
+    volatile uint32_t milestone_us[kMilestones] = {};
+    volatile BootStatus status = BootStatus::RUNNING;
+
+    void boot_task(void*) {
+        if (!camera_init()) {
+            status = BootStatus::CAMERA_FAILED;
+        } else {
+            boot_mark(BootMilestone::CAMERA_READY);
+            camera_set_power(CameraPower::STANDBY); // Boots into IDLE; SIGNING wakes it
+            if (!tflite_init()) {
+                status = BootStatus::MODEL_FAILED;
+            } else {
+                boot_mark(BootMilestone::MODEL_READY);
+                if (!signing_pipeline_init()) {
+                    status = BootStatus::PIPELINE_FAILED;
+                } else {
+                    boot_mark(BootMilestone::PIPELINE_READY);
+                    status = BootStatus::READY;
+                }
+            }
+        }
+        if (status != BootStatus::READY) ESP_LOGE(TAG, "Background init failed (status %d)", (int)status);
+        vTaskDelete(nullptr);
+    }
+}
+
+void boot_mark(BootMilestone m) {
+    int i = (int)m;
+    if (i < 0 || i >= kMilestones || milestone_us[i]) return;
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    milestone_us[i] = now ? now : 1;
+    ESP_LOGI(TAG, "%s at %u ms", kMilestoneNames[i], (unsigned)(now / 1000));
+}
+
+uint32_t boot_milestone_ms(BootMilestone m) {
+    int i = (int)m;
+    return i >= 0 && i < kMilestones ? milestone_us[i] / 1000 : 0;
+}
+
+const char* boot_milestone_name(BootMilestone m) {
+    int i = (int)m;
+    return i >= 0 && i < kMilestones ? kMilestoneNames[i] : "unknown";
+}
+
+void boot_start_background() {
+    // Core 0 while loop() (core 1) keeps the UI responsive. The camera driver's ISR lands on
+    // this core too, next to the capture task. TFLite init needs the larger stack.
+    if (xTaskCreatePinnedToCore(boot_task, "boot_init", 8192, nullptr, 4, nullptr, 0) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create boot task");
+        status = BootStatus::PIPELINE_FAILED;
+    }
+}
+
+BootStatus boot_status() {
+    return status;
+}
+
+bool boot_models_ready() {
+    return status == BootStatus::READY;
+}
+
+void boot_log_milestones() {
+    ESP_LOGI(TAG, "Build %s", FIRMWARE_BUILD_ID);
+    for (int i = 0; i < kMilestones; ++i) {
+        if (milestone_us[i]) ESP_LOGI(TAG, "  %-15s %6u ms", kMilestoneNames[i], (unsigned)(milestone_us[i] / 1000));
+    }
+}
+
+size_t boot_format_milestones(char* buf, size_t len, const char* device_id) {
+    int n = snprintf(buf, len, "{\"dev\":\"%s\",\"build\":\"%s\",\"boot_ms\":{", device_id, FIRMWARE_BUILD_ID);
+    bool first = true;
+    for (int i = 0; i < kMilestones && n > 0 && (size_t)n < len; ++i) {
+        if (!milestone_us[i]) continue;
+        n += snprintf(buf + n, len - n, "%s\"%s\":%u", first ? "" : ",", kMilestoneNames[i],
+                      (unsigned)(milestone_us[i] / 1000));
+        first = false;
+    }
+    if (n > 0 && (size_t)n < len) n += snprintf(buf + n, len - n, "}}");
+    return n > 0 && (size_t)n < len ? (size_t)n : 0;
+}
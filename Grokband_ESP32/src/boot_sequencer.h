@@ -0,0 +1,47 @@
+#ifndef BOOT_SEQUENCER_H
+#define BOOT_SEQUENCER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Boot runs in parallel instead of WiFi -> MQTT -> camera -> TFLite in series:
+// setup() brings up the display, starts WiFi association (non-blocking) and hands camera,
+// model and pipeline init to a core-0 task. loop() starts right away, so the UI and
+// incoming messages work while the model is still loading; signing becomes available when
+// boot_models_ready() turns true.
+enum class BootMilestone : uint8_t {
+    DISPLAY_READY,
+    WIFI_STARTED,
+    CAMERA_READY,
+    MODEL_READY,        // tflite_init() done
+    PIPELINE_READY,     // Signing pipeline tasks created: everything offline is usable
+    WIFI_CONNECTED,
+    MQTT_CONNECTED,
+    COUNT
+};
+
+enum class BootStatus : uint8_t {
+    RUNNING,
+    READY,
+    CAMERA_FAILED,
+    MODEL_FAILED,
+    PIPELINE_FAILED
+};
+
+// Records the first time `m` is reached (us since reset). Later calls are ignored. Any task.
+void boot_mark(BootMilestone m);
+// 0 if not reached yet
+uint32_t boot_milestone_ms(BootMilestone m);
+const char* boot_milestone_name(BootMilestone m);
+
+// Starts the background init task (camera, TFLite, signing pipeline)
+void boot_start_background();
+BootStatus boot_status();
+bool boot_models_ready();
+
+// Logs every milestone reached so far
+void boot_log_milestones();
+// One JSON object for the telemetry topic: build id plus ms per milestone. Returns length or 0.
+size_t boot_format_milestones(char* buf, size_t len, const char* device_id);
+
+#endif // BOOT_SEQUENCER_H
@@ -0,0 +1,44 @@
+#include "camera_format.h"
+#include "frame_preprocess.h" // preprocess_center_crop
+
+bool camera_select_format(const CameraFrameSize* sizes, int count, const CameraNeeds& needs, CameraFormat* out) {
+    if (!sizes || count <= 0 || !out) return false;
+    const int need_w = needs.model_w * (needs.oversample > 1 ? needs.oversample : 1);
+    const int need_h = needs.model_h * (needs.oversample > 1 ? needs.oversample : 1);
+
+    int best = -1, largest = 0;
+    for (int i = 0; i < count; ++i) {
+        const CameraFrameSize& s = sizes[i];
+        if ((int64_t)s.width * s.height > (int64_t)sizes[largest].width * sizes[largest].height) largest = i;
+        CropRect crop = preprocess_center_crop(s.width, s.height, needs.model_w, needs.model_h);
+        if (crop.w < need_w || crop.h < need_h) continue;
+        if (best < 0 || (int64_t)s.width * s.height < (int64_t)sizes[best].width * sizes[best].height) best = i;
+    }
+    if (best < 0) best = largest;
+
+    const CameraFrameSize& s = sizes[best];
+    const size_t pixels = (size_t)s.width * s.height;
+    out->id = s.id;
+    out->width = s.width;
+    out->height = s.height;
+    if (needs.want_colour && pixels * 2 <= needs.max_raw_bytes) {
+        out->pixels = CameraPixels::RGB565;
+        out->frame_bytes = pixels * 2;
+    } else if (pixels <= needs.max_raw_bytes) {
+        out->pixels = CameraPixels::GRAY; // Motion alone still drives the tracker
+        out->frame_bytes = pixels;
+    } else {
+        out->pixels = CameraPixels::JPEG;
+        out->frame_bytes = 0;
+    }
+    return true;
+}
+
+const char* camera_pixels_name(CameraPixels pixels) {
+    switch (pixels) {
+        case CameraPixels::GRAY: return "gray";
+        case CameraPixels::RGB565: return "rgb565";
+        case CameraPixels::JPEG: return "jpeg";
+    }
+    return "unknown";
+}
@@ -0,0 +1,43 @@
+#ifndef CAMERA_FORMAT_H
+#define CAMERA_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Picks the sensor output for the model instead of a fixed QVGA JPEG: the smallest frame
+// size whose centered model-aspect crop still has `oversample` source pixels per model pixel,
+// so the OV2640's DSP does most of the downscale and the frame buffers shrink. Raw formats
+// are preferred (no decode), colour only when something uses it (the hand tracker's skin
+// mask); JPEG is the fallback when a raw frame would not fit the per-buffer budget.
+// Nothing in here depends on ESP-IDF.
+enum class CameraPixels : uint8_t {
+    GRAY,
+    RGB565,
+    JPEG
+};
+
+struct CameraFrameSize {
+    int id;             // framesize_t on the target
+    int width, height;
+};
+
+struct CameraNeeds {
+    int model_w, model_h;
+    int oversample;         // Source pixels per model pixel the crop needs (> 1 leaves room for ROI crops)
+    bool want_colour;
+    size_t max_raw_bytes;   // Per frame buffer
+};
+
+struct CameraFormat {
+    int id;
+    int width, height;
+    CameraPixels pixels;
+    size_t frame_bytes;     // Raw frame size; 0 for JPEG, whose size varies
+};
+
+// `sizes` in any order. Returns false only if `count` is 0; with no size large enough, the
+// largest one is used.
+bool camera_select_format(const CameraFrameSize* sizes, int count, const CameraNeeds& needs, CameraFormat* out);
+const char* camera_pixels_name(CameraPixels pixels);
+
+#endif // CAMERA_FORMAT_H
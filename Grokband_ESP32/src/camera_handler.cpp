@@ -1,11 +1,76 @@
 #include "camera_handler.h"
 #include "config.h" // For CAM_PINS
 #include "esp_log.h" // For ESP_LOGE, etc.
+#include "esp_jpg_decode.h" // MCU-streaming JPEG decoder from esp32-camera
+#include "frame_preprocess.h"
+#include "preprocess_kernels.h"
+#include "camera_format.h"
+#include "trace.h"
+#include "esp_timer.h"
+#include "driver/gpio.h"
+#include "sdkconfig.h"
+#include <string.h>
 
 static const char* TAG = "camera";
 
+// Worst case is every buffer holding a raw frame at the full per-buffer budget
+#if CAMERA_FB_PSRAM
+#if !defined(CONFIG_SPIRAM) && !defined(CONFIG_ESP32_SPIRAM_SUPPORT)
+#error "CAMERA_FB_PSRAM=1 needs PSRAM enabled in sdkconfig"
+#endif
+#else
+static_assert((size_t)CAMERA_FB_COUNT * CAMERA_RAW_FB_MAX_BYTES <= CAMERA_FB_INTERNAL_MAX_BYTES,
+              "camera frame buffers don't fit CAMERA_FB_INTERNAL_MAX_BYTES of internal DRAM");
+#endif
+
+namespace {
+    // OV2640 output sizes the selector may pick from (camera_format.h)
+    const CameraFrameSize kFrameSizes[] = {
+        { FRAMESIZE_96X96, 96, 96 },     { FRAMESIZE_QQVGA, 160, 120 },  { FRAMESIZE_QCIF, 176, 144 },
+        { FRAMESIZE_HQVGA, 240, 176 },   { FRAMESIZE_240X240, 240, 240 }, { FRAMESIZE_QVGA, 320, 240 },
+        { FRAMESIZE_CIF, 400, 296 },     { FRAMESIZE_HVGA, 480, 320 },   { FRAMESIZE_VGA, 640, 480 },
+    };
+
+    // OV2640 COM2 (sensor register bank, hence the 0x100 for esp32-camera's set_reg()): standby
+    // stops the pixel array and output but keeps every register, exposure and gain included
+    constexpr int kOv2640Com2 = 0x109;
+    constexpr int kOv2640Com2Standby = 0x10;
+
+    camera_config_t cam_config;     // Kept for re-init after power-down
+    CameraFormat cam_format;
+    volatile CameraPower power = CameraPower::POWER_DOWN;
+
+    // Time to first frame after leaving standby/power-down, measured by camera_capture_frame()
+    volatile bool first_frame_pending = false;
+    int64_t resume_us = 0;
+    CameraPower resumed_from = CameraPower::POWER_DOWN;
+
+    pixformat_t to_pixformat(CameraPixels pixels) {
+        switch (pixels) {
+            case CameraPixels::GRAY: return PIXFORMAT_GRAYSCALE;
+            case CameraPixels::RGB565: return PIXFORMAT_RGB565;
+            default: return PIXFORMAT_JPEG;
+        }
+    }
+
+    bool sensor_standby(bool on) {
+        sensor_t* s = esp_camera_sensor_get();
+        if (!s || s->id.PID != OV2640_PID) return false;
+        return s->set_reg(s, kOv2640Com2, kOv2640Com2Standby, on ? kOv2640Com2Standby : 0) == 0;
+    }
+
+    bool start_driver() {
+        esp_err_t err = esp_camera_init(&cam_config);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Camera init failed with error 0x%x", err);
+            return false;
+        }
+        return true;
+    }
+}
+
 bool camera_init() {
-    camera_config_t config;
+    camera_config_t& config = cam_config;
     config.ledc_channel = LEDC_CHANNEL_0;
     config.ledc_timer = LEDC_TIMER_0;
     config.pin_d0 = CAM_PIN_D0;
@@ -24,28 +89,40 @@ bool camera_init() {
     config.pin_sccb_scl = CAM_PIN_SIOC; // SIOC
     config.pin_pwdn = CAM_PIN_PWDN;
     config.pin_reset = CAM_PIN_RESET;
-    config.xclk_freq_hz = 20000000;
-    config.frame_size = FRAMESIZE_QVGA; // (320x240) Start with this, then maybe smaller for TFLite
-    config.pixel_format = PIXFORMAT_JPEG; // Or PIXFORMAT_RGB565 / PIXFORMAT_GRAYSCALE
-                                          // For TFLite, you'll likely want GRAYSCALE or RGB
-                                          // If JPEG, you'll need to decode it first.
-    config.grab_mode = CAMERA_GRAB_WHEN_EMPTY;
-    config.fb_location = CAMERA_FB_IN_PSRAM; // Use PSRAM if available
-    config.jpeg_quality = 12; // 0-63, lower means higher quality
-    config.fb_count = 1;      // If more than one, can do double buffering.
+    config.xclk_freq_hz = CAMERA_XCLK_HZ;
 
-    // For TFLite, you might want a smaller frame size and non-JPEG format
-    // e.g., FRAMESIZE_96X96 if your model takes 96x96 input
-    // config.frame_size = FRAMESIZE_96X96;
-    // config.pixel_format = PIXFORMAT_GRAYSCALE;
+    // Smallest output that still covers the model input (with room for hand crops): the
+    // sensor downscales for free, and raw frames skip the JPEG decode
+    CameraNeeds needs;
+    needs.model_w = TFLITE_MODEL_INPUT_WIDTH;
+    needs.model_h = TFLITE_MODEL_INPUT_HEIGHT;
+    needs.oversample = HAND_ROI_ENABLED ? CAMERA_ROI_OVERSAMPLE : 1;
+    needs.want_colour = HAND_ROI_ENABLED || TFLITE_MODEL_INPUT_CHANNELS == 3; // Skin mask, or an RGB model
+    needs.max_raw_bytes = CAMERA_RAW_FB_MAX_BYTES;
+    camera_select_format(kFrameSizes, sizeof(kFrameSizes) / sizeof(kFrameSizes[0]), needs, &cam_format);
+    config.frame_size = (framesize_t)cam_format.id;
+    config.pixel_format = to_pixformat(cam_format.pixels);
 
+    config.grab_mode = CAMERA_GRAB_LATEST;     // Always hand the pipeline the freshest frame
+#if CAMERA_FB_PSRAM
+    config.fb_location = CAMERA_FB_IN_PSRAM;
+#else
+    config.fb_location = CAMERA_FB_IN_DRAM;  // No PSRAM on the Pico D4; sized by CAMERA_FB_INTERNAL_MAX_BYTES
+#endif
+    config.jpeg_quality = 12; // 0-63, lower means higher quality
+    config.fb_count = CAMERA_FB_COUNT; // >1 lets the sensor fill a buffer while we run inference
 
-    esp_err_t err = esp_camera_init(&config);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Camera init failed with error 0x%x", err);
+    if (!start_driver()) {
         return false;
     }
-    ESP_LOGI(TAG, "Camera Initialized");
+    power = CameraPower::STREAMING;
+    ESP_LOGI(TAG, "Camera Initialized: %dx%d %s for a %dx%d model (%u bytes per raw frame)",
+             cam_format.width, cam_format.height, camera_pixels_name(cam_format.pixels),
+             TFLITE_MODEL_INPUT_WIDTH, TFLITE_MODEL_INPUT_HEIGHT, (unsigned)cam_format.frame_bytes);
+    if (needs.want_colour && cam_format.pixels != CameraPixels::RGB565) {
+        ESP_LOGW(TAG, "RGB565 frames exceed CAMERA_RAW_FB_MAX_BYTES (%u), using %s: no colour (skin mask) downstream",
+                 (unsigned)CAMERA_RAW_FB_MAX_BYTES, camera_pixels_name(cam_format.pixels));
+    }
     
     // Optional: Adjust sensor settings (exposure, gain, etc.)
     // sensor_t * s = esp_camera_sensor_get();
@@ -54,12 +131,79 @@ bool camera_init() {
     return true;
 }
 
+bool camera_set_power(CameraPower target) {
+    const CameraPower from = power;
+    if (target == from) return true;
+
+    if (from == CameraPower::POWER_DOWN) {
+        if (!start_driver()) return false;
+        power = CameraPower::STREAMING;
+    }
+    switch (target) {
+        case CameraPower::STREAMING:
+            if (from == CameraPower::STANDBY && !sensor_standby(false)) {
+                ESP_LOGE(TAG, "Failed to wake the sensor from standby");
+                return false;
+            }
+            break;
+        case CameraPower::STANDBY:
+            if (!sensor_standby(true)) {
+                ESP_LOGW(TAG, "Sensor has no standby; powering down instead");
+                return camera_set_power(CameraPower::POWER_DOWN);
+            }
+            break;
+        case CameraPower::POWER_DOWN:
+            sensor_standby(true); // Lowest draw we can get without a PWDN pin
+            esp_camera_deinit();  // Stops XCLK and the DMA, frees the frame buffers
+            if (CAM_PIN_PWDN >= 0) {
+                gpio_set_direction((gpio_num_t)CAM_PIN_PWDN, GPIO_MODE_OUTPUT);
+                gpio_set_level((gpio_num_t)CAM_PIN_PWDN, 1);
+            }
+            break;
+    }
+    if (target == CameraPower::STREAMING) {
+        resumed_from = from;
+        resume_us = esp_timer_get_time();
+        first_frame_pending = true;
+    }
+    power = target;
+    ESP_LOGI(TAG, "Camera %s -> %s", camera_power_name(from), camera_power_name(target));
+    return true;
+}
+
+CameraPower camera_get_power() {
+    return power;
+}
+
+const char* camera_power_name(CameraPower p) {
+    switch (p) {
+        case CameraPower::STREAMING: return "streaming";
+        case CameraPower::STANDBY: return "standby";
+        case CameraPower::POWER_DOWN: return "power-down";
+    }
+    return "unknown";
+}
+
 camera_fb_t* camera_capture_frame() {
+    if (power != CameraPower::STREAMING) return nullptr;
     camera_fb_t *fb = esp_camera_fb_get();
     if (!fb) {
         ESP_LOGE(TAG, "Camera frame capture failed");
         return nullptr;
     }
+    if (first_frame_pending) {
+        // Buffers filled before standby are still queued; only a frame exposed after the wake counts
+        int64_t fb_us = (int64_t)fb->timestamp.tv_sec * 1000000 + fb->timestamp.tv_usec;
+        if (fb_us < resume_us) {
+            esp_camera_fb_return(fb);
+            return nullptr;
+        }
+        first_frame_pending = false;
+        uint32_t ttff_us = (uint32_t)(esp_timer_get_time() - resume_us);
+        trace_record_us(TraceStage::CAMERA_WAKE, ttff_us);
+        ESP_LOGI(TAG, "First frame %u ms after %s -> streaming",
+                 (unsigned)(ttff_us / 1000), camera_power_name(resumed_from));
+    }
     // ESP_LOGI(TAG, "Frame captured: %u bytes, %dx%d", fb->len, fb->width, fb->height);
     return fb;
 }
@@ -70,72 +214,225 @@ void camera_return_frame(camera_fb_t* fb) {
     }
 }
 
-// VERY BASIC PREPROCESSING EXAMPLE - YOU MUST ADAPT THIS
-// Assumes input is GRAYSCALE and output is also GRAYSCALE for the model
-// For RGB or other conversions, this will be more complex.
-// img_transform from esp-dl can be very_helpful here if using their TFLite helper
-// https://github.com/espressif/esp-dl/blob/master/include/image_util.hpp
-bool preprocess_camera_frame(camera_fb_t* fb, uint8_t* model_input_buffer, int input_w, int input_h, int input_channels) {
+// JPEG frames are decoded MCU by MCU straight into the area downscaler; the decoded image
+// only ever exists one block at a time.
+namespace {
+    struct JpegStream {
+        const uint8_t* data;
+        size_t len;
+        LumaAreaDownscaler* downscaler;
+    };
+
+    LumaAreaDownscaler jpeg_downscaler; // ~5KB of row accumulators, only used by the preprocess stage
+
+    size_t jpeg_read(void* arg, size_t index, uint8_t* buf, size_t len) {
+        JpegStream* stream = (JpegStream*)arg;
+        if (index >= stream->len) return 0;
+        if (index + len > stream->len) len = stream->len - index;
+        if (buf) memcpy(buf, stream->data + index, len); // buf == NULL means skip
+        return len;
+    }
+
+    bool jpeg_write(void* arg, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t* data) {
+        if (!data) return true; // Start/end of image markers
+        JpegStream* stream = (JpegStream*)arg;
+        stream->downscaler->push_block(x, y, w, h, data);
+        return true;
+    }
+
+    // Let the decoder do as much of the downscale as possible (it skips IDCT work when scaling)
+    int pick_jpeg_scale(const CropRect& crop, int out_w, int out_h, jpg_scale_t* scale) {
+        static const jpg_scale_t scales[] = { JPG_SCALE_8X, JPG_SCALE_4X, JPG_SCALE_2X };
+        static const int factors[] = { 8, 4, 2 };
+        for (int i = 0; i < 3; ++i) {
+            if (crop.w / factors[i] >= out_w && crop.h / factors[i] >= out_h) {
+                *scale = scales[i];
+                return factors[i];
+            }
+        }
+        *scale = JPG_SCALE_NONE;
+        return 1;
+    }
+
+    bool preprocess_jpeg(camera_fb_t* fb, CropRect crop, const ModelInput& input) {
+        jpg_scale_t scale;
+        int f = pick_jpeg_scale(crop, input.width, input.height, &scale);
+        CropRect scaled = { crop.x / f, crop.y / f, crop.w / f, crop.h / f };
+        if (!jpeg_downscaler.begin(fb->width / f, fb->height / f, scaled, input)) {
+            ESP_LOGE(TAG, "Unsupported JPEG crop/scale for preprocessing");
+            return false;
+        }
+        JpegStream stream = { fb->buf, fb->len, &jpeg_downscaler };
+        esp_err_t err = esp_jpg_decode(fb->len, scale, jpeg_read, jpeg_write, &stream);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "JPEG decode failed: 0x%x", err);
+            return false;
+        }
+        jpeg_downscaler.finish();
+        return true;
+    }
+}
+
+// Raw frames into the configured model input take the kernels specialized for its size and
+// tensor type (preprocess_kernels.h); other inputs, like the hand detector's, the generic ones
+namespace {
+    LumaResizeFn resize_gray(const ModelInput& input) {
+#if PREPROCESS_SPECIALIZED
+        return pick_luma_resize<PixelGray, TFLITE_MODEL_INPUT_WIDTH, TFLITE_MODEL_INPUT_HEIGHT>(input, luma_resize_gray);
+#else
+        (void)input;
+        return luma_resize_gray;
+#endif
+    }
+
+    LumaResizeFn resize_rgb565(const ModelInput& input) {
+#if PREPROCESS_SPECIALIZED
+        return pick_luma_resize<PixelRgb565, TFLITE_MODEL_INPUT_WIDTH, TFLITE_MODEL_INPUT_HEIGHT>(input, luma_resize_rgb565);
+#else
+        (void)input;
+        return luma_resize_rgb565;
+#endif
+    }
+}
+
+bool preprocess_camera_frame(camera_fb_t* fb, const ModelInput& input) {
+    if (!fb) {
+        ESP_LOGE(TAG, "Invalid frame buffer for preprocessing");
+        return false;
+    }
+    return preprocess_camera_frame(fb, input, preprocess_center_crop(fb->width, fb->height, input.width, input.height));
+}
+
+// Single pass from the camera frame to the model input: integer luma conversion fused with
+// the downscale of the crop (bilinear for raw formats, area average for JPEG).
+// Output rows go through input.lut straight into the interpreter's input tensor.
+bool preprocess_camera_frame(camera_fb_t* fb, const ModelInput& input, CropRect crop) {
     if (!fb || !fb->buf) {
         ESP_LOGE(TAG, "Invalid frame buffer for preprocessing");
         return false;
     }
-    if (fb->format != PIXFORMAT_GRAYSCALE && input_channels == 1) {
-         ESP_LOGE(TAG, "Frame format is not GRAYSCALE. Preprocessing needs to handle conversion.");
-         // You might need to convert from RGB565 or JPEG to GRAYSCALE here.
-         // For JPEG: fmt2rgb888, then rgb2gray
-         // For RGB565: directly to gray (R*0.299 + G*0.587 + B*0.114)
-         return false; // Placeholder - implement conversion
+    if (input.channels != 1) {
+        ESP_LOGE(TAG, "Only single-channel (luma) model input is supported, got %d channels", input.channels);
+        return false;
+    }
+
+    bool ok;
+    switch (fb->format) {
+        case PIXFORMAT_GRAYSCALE:
+            ok = resize_gray(input)(fb->buf, fb->width, fb->height, crop, input);
+            break;
+        case PIXFORMAT_RGB565:
+            ok = resize_rgb565(input)(fb->buf, fb->width, fb->height, crop, input);
+            break;
+        case PIXFORMAT_JPEG:
+            ok = preprocess_jpeg(fb, crop, input);
+            break;
+        default:
+            ESP_LOGE(TAG, "Unsupported frame format %d for preprocessing", fb->format);
+            return false;
     }
-    if (fb->format == PIXFORMAT_JPEG) {
-        ESP_LOGE(TAG, "Frame format is JPEG. It needs to be decoded first for TFLite raw input.");
-        // Use jpg2rgb565 or similar from esp_camera.h, then process
-        return false; // Placeholder - implement JPEG decoding
+    if (!ok) {
+        ESP_LOGE(TAG, "Preprocessing %dx%d crop at (%d,%d) of %dx%d frame to %dx%d failed",
+                 crop.w, crop.h, crop.x, crop.y, fb->width, fb->height, input.width, input.height);
     }
+    return ok;
+}
 
+// --- Motion gate and hand tracking ---
 
-    // This is a naive resize (sub-sampling). For better quality, use bilinear interpolation.
-    // This also assumes fb->width, fb->height >= input_w, input_h
-    int H = fb->height;
-    int W = fb->width;
+namespace {
+    LumaThumb gate_thumb;   // ~5.3KB, only touched by the inference task
+    bool gate_thumb_valid = false; // Holds the frame last passed to camera_analyze_frame()
+    MotionGate motion_gate(MOTION_GATE_MIN_CHANGED_Q8, MOTION_GATE_HANGOVER_FRAMES, MOTION_GATE_MAX_HOLD_FRAMES);
+    HandRoiTracker hand_tracker;
 
-    // Example: simple crop and resize (if needed, or just take center crop)
-    // This is just a placeholder for actual image resizing/scaling logic
-    // For a real application, you'd use a library function for proper resizing (e.g., from esp-dl)
-    
-    // Example for center crop if camera frame is larger than model input
-    int y_offset = (H - input_h) / 2;
-    int x_offset = (W - input_w) / 2;
-
-    for (int y = 0; y < input_h; ++y) {
-        for (int x = 0; x < input_w; ++x) {
-            int fb_y = y_offset + y;
-            int fb_x = x_offset + x;
-            if (fb_y < H && fb_x < W) { // bounds check
-                // Assuming single channel (grayscale)
-                 if (input_channels == 1) {
-                    model_input_buffer[y * input_w + x] = fb->buf[fb_y * W + fb_x];
-                 } else if (input_channels == 3) {
-                    // If model needs RGB, and camera provides RGB (e.g. RGB565 decoded to RGB888)
-                    // This part highly depends on camera output format and model input format
-                    // Example for RGB888 input (fb->buf points to RGB888 data)
-                    // model_input_buffer[(y * input_w + x) * 3 + 0] = fb->buf[(fb_y * W + fb_x) * 3 + 0]; // R
-                    // model_input_buffer[(y * input_w + x) * 3 + 1] = fb->buf[(fb_y * W + fb_x) * 3 + 1]; // G
-                    // model_input_buffer[(y * input_w + x) * 3 + 2] = fb->buf[(fb_y * W + fb_x) * 3 + 2]; // B
-                    ESP_LOGE(TAG, "RGB preprocessing not fully implemented in this skeleton.");
-                    return false;
-                 }
-            } else {
-                model_input_buffer[y * input_w + x] = 0; // Padding if needed
+    struct ThumbStream {
+        const uint8_t* data;
+        size_t len;
+        LumaThumb* thumb;
+        int prescale;
+    };
+
+    size_t thumb_jpeg_read(void* arg, size_t index, uint8_t* buf, size_t len) {
+        ThumbStream* stream = (ThumbStream*)arg;
+        if (index >= stream->len) return 0;
+        if (index + len > stream->len) len = stream->len - index;
+        if (buf) memcpy(buf, stream->data + index, len);
+        return len;
+    }
+
+    bool thumb_jpeg_write(void* arg, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t* data) {
+        if (!data) return true;
+        ThumbStream* stream = (ThumbStream*)arg;
+        thumb_push_rgb888_block(stream->thumb, stream->prescale, x, y, w, h, data);
+        return true;
+    }
+
+    bool build_thumb(camera_fb_t* fb, LumaThumb* thumb) {
+        switch (fb->format) {
+            case PIXFORMAT_GRAYSCALE:
+                return thumb_from_gray(fb->buf, fb->width, fb->height, thumb);
+            case PIXFORMAT_RGB565:
+                return thumb_from_rgb565(fb->buf, fb->width, fb->height, thumb);
+            case PIXFORMAT_JPEG: {
+                thumb_begin(thumb, fb->width, fb->height);
+                thumb->has_skin = true;
+                // The decoder skips most of the IDCT at 1/8; thumbnail scales are powers of two >= 4
+                jpg_scale_t scale = thumb->scale >= 8 ? JPG_SCALE_8X : JPG_SCALE_4X;
+                ThumbStream stream = { fb->buf, fb->len, thumb, thumb->scale >= 8 ? 8 : 4 };
+                return esp_jpg_decode(fb->len, scale, thumb_jpeg_read, thumb_jpeg_write, &stream) == ESP_OK;
             }
+            default:
+                return false;
         }
     }
-    // Normalize if your model expects it (e.g., input range -1 to 1 or 0 to 1 float)
-    // For uint8_t models, normalization might be part of the model (quantization).
-    // If model expects float input:
-    // for(int i=0; i < input_w * input_h * input_channels; ++i) {
-    //    float_model_input_buffer[i] = (model_input_buffer[i] / 255.0f) - 0.5f; // Example: scale to -0.5 to 0.5
-    // }
+}
 
+bool camera_analyze_frame(camera_fb_t* fb, const ModelInput& input, HandRois* rois) {
+    if (!fb || !fb->buf || !rois) return false;
+    rois->count = 1;
+    rois->crop[0] = preprocess_center_crop(fb->width, fb->height, input.width, input.height);
+    gate_thumb_valid = false;
+#if MOTION_GATE_ENABLED || HAND_ROI_ENABLED || HAND_DETECTOR_ENABLED
+    gate_thumb_valid = build_thumb(fb, &gate_thumb);
+    if (!gate_thumb_valid) return true; // Can't tell; let preprocessing deal with the frame
+#endif
+#if MOTION_GATE_ENABLED || HAND_ROI_ENABLED
+#if HAND_ROI_ENABLED
+    hand_tracker.configure(fb->width, fb->height, input.width, input.height, HAND_ROI_TWO_HANDS);
+    CropRect region = hand_tracker.gate_region();
+#else
+    const int s = gate_thumb.scale;
+    CropRect region = { rois->crop[0].x / s, rois->crop[0].y / s, rois->crop[0].w / s, rois->crop[0].h / s };
+#endif
+    bool moved = motion_gate.update(gate_thumb, region);
+#if HAND_ROI_ENABLED
+    hand_tracker.update(gate_thumb, motion_gate.motion_mask());
+    hand_tracker.get(rois);
+#endif
+#if MOTION_GATE_ENABLED
+    return moved;
+#else
+    (void)moved;
+#endif
+#endif
     return true;
-}
\ No newline at end of file
+}
+
+bool camera_thumb_to_input(const ModelInput& input, CropRect* region) {
+    if (!gate_thumb_valid || input.channels != 1) return false;
+    const int s = gate_thumb.scale;
+    CropRect crop = preprocess_center_crop(gate_thumb.w, gate_thumb.h, input.width, input.height);
+    if (!luma_resize_gray(gate_thumb.luma, gate_thumb.w, gate_thumb.h, crop, input)) return false;
+    if (region) *region = { crop.x * s, crop.y * s, crop.w * s, crop.h * s };
+    return true;
+}
+
+void camera_analyze_reset() {
+    motion_gate.reset();
+    hand_tracker.reset();
+}
+
+void camera_motion_gate_stats(MotionGateStats* out) {
+    if (out) *out = motion_gate.stats();
+}
@@ -2,14 +2,50 @@
 #define CAMERA_HANDLER_H
 
 #include "esp_camera.h"
+#include "model_input.h"
+#include "motion_gate.h"
+#include "hand_roi.h"
 
+// Picks the sensor frame size and pixel format for the model input (camera_format.h) and
+// starts streaming
 bool camera_init();
+// Null while not streaming, and for frames queued before the last wake-up
 camera_fb_t* camera_capture_frame();
 void camera_return_frame(camera_fb_t* fb);
 
+// STANDBY keeps the driver and the sensor's registers (warm start: one exposure to the first
+// frame); POWER_DOWN deinits the driver and frees the frame buffers (cold start: full init).
+// Only change it with no frame outstanding, i.e. while the signing pipeline is stopped.
+// The time to the first frame after each wake is logged and traced (TraceStage::CAMERA_WAKE).
+enum class CameraPower : uint8_t {
+    STREAMING,
+    STANDBY,
+    POWER_DOWN
+};
+bool camera_set_power(CameraPower power);
+CameraPower camera_get_power();
+const char* camera_power_name(CameraPower power);
+
 // For TFLite:
-// You'll need a function to preprocess the frame (resize, grayscale, normalize)
-// This depends heavily on your TFLite model's input requirements
-bool preprocess_camera_frame(camera_fb_t* fb, uint8_t* model_input_buffer, int input_w, int input_h, int input_channels);
+// Converts GRAYSCALE, RGB565 or JPEG frames to luma and writes them, center-cropped and downscaled,
+// directly into the model input (see tflite_get_input()). Integer-only, no intermediate frame buffers.
+bool preprocess_camera_frame(camera_fb_t* fb, const ModelInput& input);
+// Same, for an explicit source crop (e.g. from camera_analyze_frame()). The crop should have the
+// input's aspect ratio; it is scaled, not padded.
+bool preprocess_camera_frame(camera_fb_t* fb, const ModelInput& input, CropRect crop);
+
+
+// Cheap pass run before preprocess_camera_frame(): builds a 1/4-scale luma thumbnail, asks the
+// motion gate whether the hand region moved and updates the hand tracker. Returns true if the
+// frame should be inferred (always, when MOTION_GATE_ENABLED is 0). `rois` receives the crops to
+// preprocess: the tracked hand box(es) with HAND_ROI_ENABLED, else the center crop.
+bool camera_analyze_frame(camera_fb_t* fb, const ModelInput& input, HandRois* rois);
+// Hand detector input (cascade stage 1): the thumbnail of the frame last analyzed, center-cropped
+// to the input's aspect and resized into it, so the detector never touches the full frame.
+// `region` receives the crop in source pixels, for hand_box_to_crop().
+bool camera_thumb_to_input(const ModelInput& input, CropRect* region);
+// Reseeds the background and the tracker, e.g. when signing starts after the band has been moved around
+void camera_analyze_reset();
+void camera_motion_gate_stats(MotionGateStats* out);
 
 #endif // CAMERA_HANDLER_H
\ No newline at end of file
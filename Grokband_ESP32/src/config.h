@@ -4,16 +4,37 @@
 // Wi-Fi Credentials
 #define WIFI_SSID "YOUR_WIFI_SSID"
 #define WIFI_PASSWORD "YOUR_WIFI_PASSWORD"
+#define WIFI_FAST_CONNECT_TIMEOUT_MS 3000 // Cached channel/BSSID join; then fall back to a scan
 
 // MQTT Broker
 #define MQTT_BROKER_IP "YOUR_MQTT_BROKER_IP" // e.g., IP of your Raspberry Pi
 #define MQTT_BROKER_PORT 1883
 #define MQTT_CLIENT_ID "grokband_esp32"
+#define MQTT_CONNECT_TIMEOUT_S 1          // Bounds one connect attempt (TCP + CONNACK); runs on its own task
+#define MQTT_BACKOFF_MIN_MS 500           // First retry delay; doubles per failure, with jitter
+#define MQTT_BACKOFF_MAX_MS 30000
+#define MQTT_OUTBOX_SLOTS 8               // Messages held while disconnected (see mqtt_outbox.h)
+#define MQTT_OUTBOX_MAX_PAYLOAD 512
+#define MQTT_OUTBOX_POLICY OutboxPolicy::DROP_OLDEST
+#define MQTT_DRAIN_PER_LOOP 4             // Queued messages sent per mqtt_loop() after a reconnect
 
 // MQTT Topics (Consistent with Grokcom)
 #define MQTT_TOPIC_SIGN_TO_TEXT "grokware/grokband/sign_to_text"
 #define MQTT_TOPIC_SPEECH_TO_SIGN "grokware/grokcom/speech_to_text" // Grokband subscribes to this
 #define MQTT_TOPIC_QUICK_RESPONSE "grokware/grokband/quick_response"
+#define MQTT_TOPIC_TELEMETRY "grokware/grokband/telemetry" // Per-stage latency summaries (trace.h)
+#define MQTT_TOPIC_LATENCY "grokware/grokband/latency" // Per-sign capture/infer/publish stamps (Grokcom latency.py)
+#define MQTT_TOPIC_TIMESYNC_PING "grokware/grokcom/timesync" // Grokband subscribes, echoes with millis()
+#define MQTT_TOPIC_TIMESYNC_PONG "grokware/grokband/timesync"
+#ifndef LATENCY_STAMPS_ENABLED
+#define LATENCY_STAMPS_ENABLED 1 // Publish the stamps after each sign frame; 0 for field builds
+#endif
+#ifndef WIRE_PROTOCOL_BINARY
+#define WIRE_PROTOCOL_BINARY 1  // Signs/quick responses as binary frames (wire_protocol.h); 0 = label text
+#endif
+
+// Tracing
+#define TRACE_PUBLISH_INTERVAL_MS 10000 // Telemetry window; 0 disables publishing
 
 // Hardware Pins (ADJUST THESE TO YOUR ACTUAL WIRING)
 
@@ -41,25 +62,181 @@
 #define OLED_SCL_PIN GPIO_NUM_15 // Example
 #define OLED_RST_PIN GPIO_NUM_16 // Example, or -1 if not used
 
+// LVGL draw buffers (see display_handler.cpp). Two buffers of DISPLAY_BUF_LINES full-width lines:
+// LVGL renders into one while the other is on its way out over SPI DMA.
+#ifndef DISPLAY_BUF_LINES
+#define DISPLAY_BUF_LINES 24
+#endif
+#ifndef DISPLAY_BUF_IN_PSRAM
+#define DISPLAY_BUF_IN_PSRAM 0  // 1 = draw buffers in PSRAM (frees internal RAM; flushes go through an internal bounce buffer)
+#endif
+#define DISPLAY_ROUND 1         // Panel glass is the inscribed circle; don't push the corners
+// A quick-response detent should only redraw the two list items involved (screen_manager.h)
+#define DISPLAY_REDRAW_BUDGET_PX (2 * 240 * 28)
+
 // PC311 Rotary Encoder Pins
 #define ROTARY_ENCODER_A_PIN  GPIO_NUM_32 // Example DT
 #define ROTARY_ENCODER_B_PIN  GPIO_NUM_33 // Example CLK
 #define ROTARY_ENCODER_SW_PIN GPIO_NUM_25 // Example SW (Button)
 
+// Encoder/button decoding (see input_handler.h)
+#ifndef ENCODER_USE_PCNT
+#define ENCODER_USE_PCNT 1              // 0 = decode A/B in a GPIO ISR when no PCNT unit is free
+#endif
+#define ENCODER_PCNT_UNIT 0
+#define ENCODER_COUNTS_PER_DETENT 4     // Full-quadrature counts per mechanical click
+#define ENCODER_GLITCH_FILTER_NS 10000  // PCNT drops pulses shorter than this (max ~12.7us at 80 MHz APB)
+#define BUTTON_DEBOUNCE_MS 8
+#define BUTTON_LONG_PRESS_MS 700        // Long press enters signing mode
+#define BUTTON_DOUBLE_CLICK_MS 350
+// Longest loop() sleeps waiting for input; bounds MQTT keepalive/receive polling
+#define LOOP_MAX_IDLE_MS 20
+
 // LED Pin
 #define LED_PIN GPIO_NUM_2 // Example, onboard LED if available or external
 
 // Vibration Motor Pin
 #define VIBRATION_MOTOR_PIN GPIO_NUM_12 // Example
 
+// LED/motor PWM for notification patterns (see notifications.h). Low-speed LEDC channels,
+// since the camera's XCLK uses high-speed channel 0 / timer 0.
+#define NOTIFY_LED_LEDC_CHANNEL 8
+#define NOTIFY_MOTOR_LEDC_CHANNEL 9
+#define NOTIFY_LEDC_FREQ_HZ 5000
+
 // TFLite Model settings
 #define TFLITE_MODEL_INPUT_WIDTH 96   // Example, depends on your model
 #define TFLITE_MODEL_INPUT_HEIGHT 96  // Example
 #define TFLITE_MODEL_INPUT_CHANNELS 1 // Example (grayscale) or 3 (RGB)
 #define TFLITE_NUM_CLASSES 10         // Example, number of sign language gestures
+// Real-valued model input = (pixel - MEAN) / STD. Quantized (uint8/int8) inputs are derived
+// from that using the input tensor's scale/zero_point, so this must match training.
+#define TFLITE_INPUT_MEAN 127.5f
+#define TFLITE_INPUT_STD 127.5f
+
+// Tensor arena. Sizes come from src/tensor_arena_size.h, written by scripts/arena_from_log.py
+// from the boot log of a TFLITE_ARENA_MEASURE=1 build (unmeasured builds fall back to 90KB).
+#ifndef TFLITE_ARENA_MEASURE
+#define TFLITE_ARENA_MEASURE 0  // 1 = record exact arena usage and per-layer timing for each placement at boot
+#endif
+#ifndef TFLITE_ARENA_SPLIT
+#define TFLITE_ARENA_SPLIT 0    // 1 = persistent buffers in PSRAM, scratch/activation tensors in internal SRAM
+#endif
+
+// Kernel backend: reference TFLM kernels, or Espressif's ESP-NN optimized ones (set by the
+// esp32pico_esp_nn env in platformio.ini). The op resolver is the same; the kernels are chosen at link time.
+#ifndef TFLITE_ESP_NN
+#define TFLITE_ESP_NN 0
+#endif
+#if TFLITE_ESP_NN
+#define TFLITE_KERNEL_BACKEND "esp-nn"
+#else
+#define TFLITE_KERNEL_BACKEND "reference"
+#endif
+// Boot-time equivalence check: seeded inputs through the model, output CRC per case (KCHECK lines),
+// to diff a reference build against an ESP-NN one with scripts/op_profile_diff.py --kernels. The
+// kernels are checked on randomized shapes by the host suite (pio test -e native_esp_nn); this
+// covers the whole model on the device
+#ifndef TFLITE_KERNEL_CHECK
+#define TFLITE_KERNEL_CHECK 0
+#endif
+#define TFLITE_KERNEL_CHECK_CASES 8
+
+// Per-op profiling: OPPROF lines diffable against a host run (pio test -e native_tflm -v) with
+// scripts/op_profile_diff.py
+#ifndef TFLITE_OP_PROFILE
+#define TFLITE_OP_PROFILE 0     // 1 = per-op timing/shape report (OPPROF lines) from the running interpreter
+#endif
+#define TFLITE_OP_PROFILE_EVERY 50 // Report one Invoke() in this many
+
+// Raw-frame preprocessing into the model input uses kernels compiled for TFLITE_MODEL_INPUT_WIDTH x
+// HEIGHT and each tensor type (preprocess_kernels.h); 0 = generic runtime-sized kernels only
+#ifndef PREPROCESS_SPECIALIZED
+#define PREPROCESS_SPECIALIZED 1
+#endif
+
+// Camera frame buffers. The Pico D4 has no PSRAM, so by default they come out of internal DRAM
+// next to the tensor arena, LVGL and WiFi: two buffers, all of them together within
+// CAMERA_FB_INTERNAL_MAX_BYTES. A board with PSRAM (enabled in sdkconfig) builds with
+// -DCAMERA_FB_PSRAM=1 and gets three there.
+#ifndef CAMERA_FB_PSRAM
+#define CAMERA_FB_PSRAM 0
+#endif
+#define CAMERA_FB_INTERNAL_MAX_BYTES (120 * 1024)
+
+// Signing pipeline (capture task -> inference task, which preprocesses into the input tensor)
+#if CAMERA_FB_PSRAM
+#define CAMERA_FB_COUNT 3             // 3 = one filling, one queued, one being preprocessed
+#else
+#define CAMERA_FB_COUNT 2             // One filling while the other is queued or preprocessed
+#endif
+#define SIGNING_CAPTURE_CORE 0        // WiFi also lives on core 0; capture mostly waits on DMA
+#define SIGNING_INFERENCE_CORE 1      // Shares core 1 with the Arduino loop task
+
+// Camera output is chosen from the model input (camera_format.h) rather than fixed
+#define CAMERA_XCLK_HZ 20000000
+#define CAMERA_ROI_OVERSAMPLE 2       // Source pixels per model pixel across the frame, so hand crops aren't upscaled
+// Per frame buffer; a larger raw frame falls back to JPEG. With the defaults (96x96 model,
+// CAMERA_ROI_OVERSAMPLE 2) the camera runs at 240x240, where RGB565 takes 115200 bytes: over this
+// budget, so frames are grayscale (57600 bytes, 2 x 56 KB of DRAM) and the hand tracker works on
+// motion alone (no skin mask). Colour needs (120 * 1024), i.e. CAMERA_FB_COUNT such buffers,
+// which only fit with PSRAM.
+#if CAMERA_FB_PSRAM
+#define CAMERA_RAW_FB_MAX_BYTES (64 * 1024)
+#else
+#define CAMERA_RAW_FB_MAX_BYTES (CAMERA_FB_INTERNAL_MAX_BYTES / CAMERA_FB_COUNT)
+#endif
+// Power states follow the app mode: streaming in SIGNING, sensor standby otherwise (fast warm
+// start), powered down after this long without signing
+#define CAMERA_POWER_DOWN_AFTER_MS 60000
+
+// Motion gate: only run inference when the hand region changes (see motion_gate.h)
+#ifndef MOTION_GATE_ENABLED
+#define MOTION_GATE_ENABLED 1
+#endif
+#define MOTION_GATE_MIN_CHANGED_Q8 8   // >= 8/256 (~3%) of hand-region pixels must change
+#define MOTION_GATE_HANGOVER_FRAMES 4  // Keep inferring this many frames after motion stops
+#define MOTION_GATE_MAX_HOLD_FRAMES 150 // ...and while a still hand stays in the region, up to ~10 s at 15 fps
+
+// Hand ROI tracker: crop the tracked hand box instead of the frame center (see hand_roi.h)
+#ifndef HAND_ROI_ENABLED
+#define HAND_ROI_ENABLED 1
+#endif
+#ifndef HAND_ROI_TWO_HANDS
+#define HAND_ROI_TWO_HANDS 0  // 1 = track left/right hands separately; one inference (or batch slot) per hand
+#endif
+
+// Hand detector: a tiny presence (+box) model gates the classifier (cascade, see sign_language_model.h).
+// Needs data/hand_detector.tflite in the hand_det partition; without it the classifier runs alone.
+#ifndef HAND_DETECTOR_ENABLED
+#define HAND_DETECTOR_ENABLED 1
+#endif
+#define HAND_DETECTOR_THRESHOLD 0.5f              // Presence below this = no hand, frame not classified
+#define HAND_DETECTOR_ARENA_PERSISTENT_SIZE (8 * 1024) // Its scratch is the classifier's
+#define HAND_DETECTOR_BOX_MARGIN_Q8 51            // Pad the detector's box by ~20% per side
+
+// Temporal models (input [batch, frames, H, W, C]) keep the last frames per hand in a ring (frame_history.h)
+#define TEMPORAL_MAX_GAP_MS 300       // A longer gap between inferred frames (motion gate closed) restarts the window
+
+// Output post-processing (score_postprocess.h). Per-class values come from data/sign_model.calib
+// (scripts/calibrate_thresholds.py); these apply to classes it doesn't list, or without one
+#define SCORE_DEFAULT_THRESHOLD 0.6f  // Calibrated probability the winner needs
+#define SCORE_DEFAULT_MARGIN 0.1f     // Lead over the runner-up it needs
+#define SCORE_TOPK 3
+
+// Streaming classification (sign_stream.h): per-frame scores become one result per gesture
+#define SIGN_STREAM_WINDOW 4          // Inferences averaged
+#define SIGN_STREAM_ENTER 0.6f        // Window mean of calibrated probability that starts a gesture...
+#define SIGN_STREAM_EXIT 0.4f         // ...and that it must fall below to end
+#define SIGN_STREAM_MIN_FRAMES 2      // Consecutive inferences at/above ENTER before the sign is sent
+#define SIGN_STREAM_RELEASE_FRAMES 3  // Consecutive inferences below EXIT before the next sign can start
+#ifndef SIGNING_CONTINUOUS
+#define SIGNING_CONTINUOUS 1          // Stay in SIGNING after a sign; leave by long press or SIGNING_TIMEOUT_MS without one
+#endif
 
 // Quick Responses
-const char* quick_responses[] = {"Yes", "No", "Okay", "Thank You", "Hello"};
+// Sent as indexes in binary frames: Grokcom_RPI/config.py QUICK_RESPONSES must match
+static const char* const quick_responses[] = {"Yes", "No", "Okay", "Thank You", "Hello"};
 #define NUM_QUICK_RESPONSES (sizeof(quick_responses) / sizeof(char*))
 
 #endif // CONFIG_H
\ No newline at end of file
@@ -0,0 +1,80 @@
+#include "display_flush.h"
+#include <string.h>
+
+namespace {
+    uint32_t isqrt(uint32_t v) {
+        uint32_t r = 0;
+        uint32_t bit = 1u << 30;
+        while (bit > v) bit >>= 2;
+        while (bit) {
+            if (v >= r + bit) {
+                v -= r + bit;
+                r = (r >> 1) + bit;
+            } else {
+                r >>= 1;
+            }
+            bit >>= 2;
+        }
+        return r;
+    }
+
+    int floor_div2(int v) { return v >= 0 ? v / 2 : -((1 - v) / 2); }
+}
+
+bool flush_clip_round(int disp_w, int disp_h, const FlushRegion& area, FlushRegion* out) {
+    // Doubled coordinates keep pixel centres integral: pixel x is at 2x+1, the centre at w
+    const int d = disp_w < disp_h ? disp_w : disp_h;
+    const uint32_t d2 = (uint32_t)d * d;
+    int x0 = area.x + area.w, x1 = area.x - 1;
+    int y0 = -1, y1 = -1;
+    for (int y = area.y; y < area.y + area.h; ++y) {
+        int dy = 2 * y + 1 - disp_h;
+        if ((uint32_t)(dy * dy) > d2) continue;
+        int half = (int)isqrt(d2 - (uint32_t)(dy * dy));
+        int lo = -floor_div2(half + 1 - disp_w);   // ceil((w - half - 1) / 2)
+        int hi = floor_div2(disp_w + half - 1);
+        if (lo < area.x) lo = area.x;
+        if (hi > area.x + area.w - 1) hi = area.x + area.w - 1;
+        if (lo > hi) continue;
+        if (y0 < 0) y0 = y;
+        y1 = y;
+        if (lo < x0) x0 = lo;
+        if (hi > x1) x1 = hi;
+    }
+    if (y0 < 0) return false;
+    out->x = (int16_t)x0;
+    out->y = (int16_t)y0;
+    out->w = (int16_t)(x1 - x0 + 1);
+    out->h = (int16_t)(y1 - y0 + 1);
+    return true;
+}
+
+void flush_pack(uint16_t* pixels, const FlushRegion& area, const FlushRegion& clip) {
+    if (clip.x == area.x && clip.y == area.y && clip.w == area.w) return; // Already contiguous
+    const uint16_t* src = pixels + (size_t)(clip.y - area.y) * area.w + (clip.x - area.x);
+    uint16_t* dst = pixels;
+    for (int row = 0; row < clip.h; ++row) {
+        // dst never passes src (clip.w <= area.w), so rows move front to back safely
+        memmove(dst, src, (size_t)clip.w * sizeof(uint16_t));
+        dst += clip.w;
+        src += area.w;
+    }
+}
+
+bool FlushPlanner::plan(uint16_t* pixels, const FlushRegion& area, FlushRegion* push) {
+    stats_.flushes++;
+    stats_.pixels_rendered += (uint32_t)area.w * area.h;
+
+    FlushRegion clip = area;
+    if (round_ && !flush_clip_round(w_, h_, area, &clip)) {
+        stats_.skipped++;
+        return false;
+    }
+    flush_pack(pixels, area, clip);
+
+    stats_.pixels_pushed += (uint32_t)clip.w * clip.h;
+    if (recorded_count_ < kMaxRecorded) recorded_[recorded_count_] = clip;
+    recorded_count_++;
+    *push = clip;
+    return true;
+}
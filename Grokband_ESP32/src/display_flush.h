@@ -0,0 +1,58 @@
+#ifndef DISPLAY_FLUSH_H
+#define DISPLAY_FLUSH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Flush planning for the round display: clips each LVGL flush area to the visible circle,
+// packs the surviving pixels so they go out as one contiguous transfer, and accounts for
+// what was rendered versus what was actually pushed. No LVGL or display-driver dependency:
+// the device flush callback pushes the planned region over SPI DMA, and a host program can
+// run LVGL against the planner alone and compare the recorded regions between builds.
+struct FlushRegion {
+    int16_t x, y, w, h;
+};
+
+struct DisplayFlushStats {
+    uint32_t flushes;           // Flush callbacks
+    uint32_t skipped;           // Areas entirely outside the circle, nothing pushed
+    uint64_t pixels_rendered;   // Pixels LVGL handed to the flush callback
+    uint64_t pixels_pushed;     // Pixels that went to the panel after clipping
+};
+
+// Visible part of `area` on a `disp_w` x `disp_h` panel whose glass is the inscribed circle.
+// Returns false if none of it is visible. The result is the bounding box of the visible pixels,
+// so it may still include some corner pixels; it is never larger than `area`.
+bool flush_clip_round(int disp_w, int disp_h, const FlushRegion& area, FlushRegion* out);
+
+// Moves the `clip` sub-rectangle of the `area`-sized pixel block to the start of `pixels`,
+// row after row, so it can be pushed as one contiguous block. Works in place.
+void flush_pack(uint16_t* pixels, const FlushRegion& area, const FlushRegion& clip);
+
+class FlushPlanner {
+public:
+    static constexpr int kMaxRecorded = 64;
+
+    FlushPlanner(int disp_w, int disp_h, bool round) : w_(disp_w), h_(disp_h), round_(round) {}
+
+    // Clips and packs one flush. Returns false if nothing needs pushing; otherwise `*push`
+    // is the region to send, its pixels packed at the start of `pixels`.
+    bool plan(uint16_t* pixels, const FlushRegion& area, FlushRegion* push);
+
+    // Every pushed region since the last reset_recorded(), in order, up to kMaxRecorded
+    // (recorded_count() keeps counting past that).
+    const FlushRegion* recorded() const { return recorded_; }
+    int recorded_count() const { return recorded_count_; }
+    void reset_recorded() { recorded_count_ = 0; }
+
+    const DisplayFlushStats& stats() const { return stats_; }
+
+private:
+    int w_, h_;
+    bool round_;
+    DisplayFlushStats stats_ = {};
+    FlushRegion recorded_[kMaxRecorded];
+    int recorded_count_ = 0;
+};
+
+#endif // DISPLAY_FLUSH_H
@@ -1,102 +1,165 @@
 #include "display_handler.h"
 #include "config.h" // For display pins if not passed directly
 #include <TFT_eSPI.h> // Or your specific display library
-
-// For LVGL:
+#include "screen_manager.h"
+#include "trace.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+
+// For LVGL: two draw buffers so rendering the next band overlaps the DMA of the previous one.
+// A flush starts the transfer and returns; LVGL is told the buffer is free once the DMA has
+// completed (polled from wait_cb while LVGL waits on it, and from display_update_loop()).
 static lv_disp_draw_buf_t disp_buf;
-static lv_color_t buf_1[LV_HOR_RES_MAX * 10]; // Adjust buffer size
+static lv_color_t* buf_1 = nullptr;
+static lv_color_t* buf_2 = nullptr;
+static uint16_t* dma_bounce = nullptr; // Internal-RAM copy target when the draw buffers are in PSRAM
 TFT_eSPI tft = TFT_eSPI(); // Your display object
 
-lv_obj_t *main_screen;
-lv_obj_t *message_label;
-lv_obj_t *status_label;
-lv_obj_t *quick_response_list; // For LVGL list or similar widget
+static FlushPlanner* flush_planner = nullptr;
+static lv_disp_drv_t* flushing_drv = nullptr; // Flush whose DMA is in flight
+static uint32_t flush_start_us = 0;
+
+// Encoder input device for the screen manager's group. loop() drains input_handler and
+// feeds the net detents in here; the read callback hands them to LVGL.
+static lv_indev_t* encoder_indev = nullptr;
+static int16_t pending_enc_diff = 0;
+
+// Releases the draw buffer once its DMA transfer is done
+static void flush_poll_complete() {
+    if (!flushing_drv || tft.dmaBusy()) return;
+    lv_disp_drv_t* drv = flushing_drv;
+    flushing_drv = nullptr;
+    trace_record_us(TraceStage::SPI_FLUSH, (uint32_t)esp_timer_get_time() - flush_start_us);
+    lv_disp_flush_ready(drv);
+}
 
-// LVGL display flush callback
+// LVGL display flush callback: clip to the visible circle, then hand off to SPI DMA
 void my_disp_flush(lv_disp_drv_t *disp, const lv_area_t *area, lv_color_t *color_p) {
-    uint32_t w = (area->x2 - area->x1 + 1);
-    uint32_t h = (area->y2 - area->y1 + 1);
-    tft.startWrite();
-    tft.setAddrWindow(area->x1, area->y1, w, h);
-    tft.pushColors((uint16_t *)color_p, w * h, true);
-    tft.endWrite();
-    lv_disp_flush_ready(disp);
+    FlushRegion rendered = { (int16_t)area->x1, (int16_t)area->y1,
+                             (int16_t)(area->x2 - area->x1 + 1), (int16_t)(area->y2 - area->y1 + 1) };
+    FlushRegion push;
+    if (!flush_planner->plan((uint16_t*)color_p, rendered, &push)) {
+        lv_disp_flush_ready(disp); // Entirely outside the glass
+        return;
+    }
+    // The bus stays claimed between flushes (the panel is alone on it), as TFT_eSPI's DMA path expects
+    if (tft.getStartCount() == 0) tft.startWrite();
+    flush_start_us = (uint32_t)esp_timer_get_time();
+    tft.pushImageDMA(push.x, push.y, push.w, push.h, (uint16_t*)color_p, dma_bounce);
+    flushing_drv = disp;
 }
 
-// LVGL input device (rotary encoder) read callback
-// This needs to be integrated with your input_handler.cpp
-// For simplicity, we'll assume input_handler.cpp calls functions here directly for now.
-// Or, input_handler calls a registered callback from display_handler.
+static void my_disp_wait(lv_disp_drv_t *disp) {
+    flush_poll_complete();
+}
+
+static void my_disp_monitor(lv_disp_drv_t *disp, uint32_t time_ms, uint32_t px) {
+    trace_record_us(TraceStage::FRAME, time_ms * 1000);
+}
+
+// LVGL input device (rotary encoder) read callback. Presses are handled by loop()'s mode
+// logic, so LVGL only ever sees rotation.
+static void encoder_read(lv_indev_drv_t *drv, lv_indev_data_t *data) {
+    data->enc_diff = pending_enc_diff;
+    pending_enc_diff = 0;
+    data->state = LV_INDEV_STATE_RELEASED;
+}
+
+static lv_color_t* alloc_draw_buf(size_t pixels) {
+#if DISPLAY_BUF_IN_PSRAM
+    return (lv_color_t*)heap_caps_malloc(pixels * sizeof(lv_color_t), MALLOC_CAP_SPIRAM);
+#else
+    return (lv_color_t*)heap_caps_malloc(pixels * sizeof(lv_color_t), MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+#endif
+}
 
 void display_init() {
     tft.begin();
     tft.setRotation(0); // Adjust as needed
+    tft.setSwapBytes(true); // LVGL renders native-endian RGB565, the panel wants big-endian
+    tft.initDMA();
 
     lv_init();
-    lv_disp_draw_buf_init(&disp_buf, buf_1, NULL, LV_HOR_RES_MAX * 10);
+    const size_t buf_pixels = (size_t)tft.width() * DISPLAY_BUF_LINES;
+    buf_1 = alloc_draw_buf(buf_pixels);
+    buf_2 = alloc_draw_buf(buf_pixels);
+#if DISPLAY_BUF_IN_PSRAM
+    // The ESP32's SPI DMA cannot read PSRAM; pushImageDMA() copies each flush through this
+    dma_bounce = (uint16_t*)heap_caps_malloc(buf_pixels * sizeof(uint16_t), MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+#endif
+    if (!buf_1 || !buf_2 || (DISPLAY_BUF_IN_PSRAM && !dma_bounce)) {
+        Serial.println("LVGL draw buffer allocation failed");
+        return;
+    }
+    lv_disp_draw_buf_init(&disp_buf, buf_1, buf_2, buf_pixels);
+    flush_planner = new FlushPlanner(tft.width(), tft.height(), DISPLAY_ROUND);
 
     static lv_disp_drv_t disp_drv;
     lv_disp_drv_init(&disp_drv);
     disp_drv.hor_res = tft.width(); // Adjust to your OLED width
     disp_drv.ver_res = tft.height(); // Adjust to your OLED height
     disp_drv.flush_cb = my_disp_flush;
+    disp_drv.wait_cb = my_disp_wait;
+    disp_drv.monitor_cb = my_disp_monitor;
     disp_drv.draw_buf = &disp_buf;
     lv_disp_drv_register(&disp_drv);
 
-    // TODO: Initialize input device driver for LVGL (rotary encoder)
-    // static lv_indev_drv_t indev_drv;
-    // lv_indev_drv_init(&indev_drv);
-    // indev_drv.type = LV_INDEV_TYPE_ENCODER;
-    // indev_drv.read_cb = my_encoder_read_cb; // You need to implement this
-    // lv_indev_t *mouse_indev = lv_indev_drv_register(&indev_drv);
+    // Build every screen object once; after this the UI only changes focus, text and visibility
+    screen_build(lv_scr_act(), tft.width(), tft.height());
 
+    static lv_indev_drv_t indev_drv;
+    lv_indev_drv_init(&indev_drv);
+    indev_drv.type = LV_INDEV_TYPE_ENCODER;
+    indev_drv.read_cb = encoder_read;
+    encoder_indev = lv_indev_drv_register(&indev_drv);
+    lv_indev_set_group(encoder_indev, screen_quick_response_group());
 
-    // Create a simple UI
-    main_screen = lv_scr_act();
-    lv_obj_set_style_bg_color(main_screen, lv_color_black(), LV_PART_MAIN);
+    Serial.println("LVGL Display Initialized");
+}
 
-    message_label = lv_label_create(main_screen);
-    lv_label_set_text(message_label, "Grokband Ready");
-    lv_obj_set_style_text_color(message_label, lv_color_white(), LV_PART_MAIN);
-    lv_obj_align(message_label, LV_ALIGN_CENTER, 0, -20);
-    lv_label_set_long_mode(message_label, LV_LABEL_LONG_WRAP);
-    lv_obj_set_width(message_label, tft.width() - 20);
+uint32_t display_update_loop() {
+    flush_poll_complete(); // Free the buffer of a transfer that finished while we were away
+    return lv_timer_handler(); // handles LVGL tasks
+}
 
-    status_label = lv_label_create(main_screen);
-    lv_label_set_text(status_label, "Status: ---");
-    lv_obj_set_style_text_color(status_label, lv_color_hex(0x888888), LV_PART_MAIN);
-    lv_obj_align(status_label, LV_ALIGN_BOTTOM_MID, 0, -5);
+void display_get_flush_stats(DisplayFlushStats* out) {
+    if (!out) return;
+    *out = flush_planner ? flush_planner->stats() : DisplayFlushStats{};
+}
 
-    Serial.println("LVGL Display Initialized");
+uint32_t display_refresh_now() {
+    uint64_t before = flush_planner ? flush_planner->stats().pixels_rendered : 0;
+    lv_refr_now(NULL);
+    return flush_planner ? (uint32_t)(flush_planner->stats().pixels_rendered - before) : 0;
 }
 
-void display_update_loop() {
-    lv_timer_handler(); // handles LVGL tasks
-    delay(5);
+void display_encoder_feed(int steps) {
+    if (!encoder_indev || steps == 0) return;
+    pending_enc_diff += steps;
+    lv_indev_read_timer_cb(encoder_indev->driver->read_timer); // Apply now rather than on the next indev poll
 }
 
 void display_show_message(const char* message) {
-    lv_label_set_text(message_label, message);
+    screen_show_message(message);
     Serial.print("Display: "); Serial.println(message);
 }
 
-void display_show_quick_responses_ui(const char* responses[], int count, int selected_idx) {
-    // This is a placeholder. You'd typically use an lv_list or similar
-    // For simplicity, we'll just update the message_label for now.
-    char buffer[128];
-    strcpy(buffer, "Quick Reply:\n");
-    for (int i = 0; i < count; ++i) {
-        if (i == selected_idx) strcat(buffer, "> ");
-        strcat(buffer, responses[i]);
-        strcat(buffer, "\n");
-    }
-    lv_label_set_text(message_label, buffer);
+void display_set_quick_responses(const char* const* responses, int count) {
+    screen_set_quick_responses(responses, count);
+}
+
+void display_show_quick_responses(int selected_idx) {
+    screen_show_quick_responses(selected_idx);
+}
+
+int display_quick_response_selected() {
+    return screen_quick_response_selected();
 }
 
 void display_clear() {
-    lv_label_set_text(message_label, "");
+    screen_clear_message();
 }
 
 void display_show_status(const char* status) {
-    lv_label_set_text(status_label, status);
-}
\ No newline at end of file
+    screen_show_status(status);
+}
@@ -2,17 +2,21 @@
 #define DISPLAY_HANDLER_H
 
 #include "lvgl.h"
+#include "display_flush.h"
 
 void display_init();
-void display_update_loop(); // Call this in your main loop
+uint32_t display_update_loop(); // Call this in your main loop; returns ms until LVGL next needs to run
+// Redraws invalidated areas immediately instead of on the next refresh timer; returns the pixels rendered
+uint32_t display_refresh_now();
+void display_get_flush_stats(DisplayFlushStats* out); // Rendered vs pushed pixels (round-mask clipping)
 void display_show_message(const char* message);
-void display_show_quick_responses_ui(const char* responses[], int count, int selected_idx);
+// The list is built once; showing it and turning the encoder only move focus (screen_manager.h)
+void display_set_quick_responses(const char* const* responses, int count);
+void display_show_quick_responses(int selected_idx);
+int display_quick_response_selected();
+void display_encoder_feed(int steps); // Detents from input_handler, applied to the focused group
 void display_clear();
 void display_show_status(const char* status);
 
-// Callback type for rotary encoder events if needed by display
-typedef void (*input_event_cb_t)(int8_t direction, bool pressed); 
-void display_set_input_callback(input_event_cb_t cb);
-
 
 #endif // DISPLAY_HANDLER_H
\ No newline at end of file
@@ -0,0 +1,25 @@
+#include "frame_history.h"
+#include <string.h>
+
+bool FrameHistory::begin(uint8_t* storage, size_t frame_bytes, int depth) {
+    if (!storage || frame_bytes == 0 || depth < 1 || depth > FRAME_HISTORY_MAX_DEPTH) return false;
+    storage_ = storage;
+    frame_bytes_ = frame_bytes;
+    depth_ = depth;
+    head_ = 0;
+    count_ = 0;
+    return true;
+}
+
+void FrameHistory::commit(uint32_t capture_us) {
+    head_ = head_ + 1 == depth_ ? 0 : head_ + 1;
+    if (count_ < depth_) count_++;
+    newest_us_ = capture_us;
+}
+
+void FrameHistory::copy_window(uint8_t* dst) const {
+    // Oldest frame sits at the head once full: [head, depth) then [0, head)
+    const size_t tail = (size_t)(depth_ - head_) * frame_bytes_;
+    memcpy(dst, head(), tail);
+    memcpy(dst + tail, storage_, (size_t)head_ * frame_bytes_);
+}
@@ -0,0 +1,46 @@
+#ifndef FRAME_HISTORY_H
+#define FRAME_HISTORY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define FRAME_HISTORY_MAX_DEPTH 16
+
+// Circular history of the last `depth` preprocessed frames of one hand, for temporal models
+// (input tensor [batch, depth, H, W, C], see model_input.h). Each new frame is preprocessed
+// once, straight into the slot at the head, and never moved. copy_window() lays the slots
+// out oldest first in the input tensor before each Invoke(); the tensor itself can't carry
+// the history, since the arena planner reuses input memory for activations.
+// Nothing in here depends on ESP-IDF.
+class FrameHistory {
+public:
+    static size_t bytes_needed(size_t frame_bytes, int depth) { return frame_bytes * (size_t)depth; }
+
+    // `storage` holds bytes_needed(frame_bytes, depth) bytes and is owned by the caller
+    bool begin(uint8_t* storage, size_t frame_bytes, int depth);
+    // Forgets the frames (e.g. after a pause); the window has to fill again
+    void reset() { count_ = 0; }
+
+    // Slot the next frame is written into; commit() once it holds a frame
+    uint8_t* head() const { return storage_ + (size_t)head_ * frame_bytes_; }
+    void commit(uint32_t capture_us);
+
+    int depth() const { return depth_; }
+    int count() const { return count_; }
+    bool full() const { return depth_ > 0 && count_ == depth_; }
+    uint32_t newest_us() const { return newest_us_; }
+    size_t frame_bytes() const { return frame_bytes_; }
+
+    // Copies the window, oldest frame first, to dst (depth * frame_bytes). Requires full().
+    void copy_window(uint8_t* dst) const;
+
+private:
+    uint8_t* storage_ = nullptr;
+    size_t frame_bytes_ = 0;
+    int depth_ = 0;
+    int head_ = 0;      // Slot the next frame goes to; once full, also the oldest frame
+    int count_ = 0;
+    uint32_t newest_us_ = 0;
+};
+
+#endif // FRAME_HISTORY_H
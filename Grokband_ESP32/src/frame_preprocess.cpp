@@ -0,0 +1,239 @@
+#include "frame_preprocess.h"
+#include "preprocess_kernels.h"
+#include <string.h>
+
+namespace {
+    template <typename T>
+    inline void store_row_lut(const ModelInput& dst, int y, const uint8_t* row) {
+        const T* lut = static_cast<const T*>(dst.lut);
+        T* out = static_cast<T*>(dst.data) + y * dst.width;
+        for (int x = 0; x < dst.width; ++x) {
+            out[x] = lut[row[x]];
+        }
+    }
+
+    // Bilinear luma resize, two source rows per output row. Luma is computed on the fly for the
+    // four taps only, so the cost scales with the output size rather than the source size.
+    // Weights are Q12: 255 * 4096 * 4096 plus the rounding term still fits the uint32 sum, and
+    // the result stays within one level of the float reference (test_preprocess_kernels).
+    template <typename Pixel>
+    bool luma_resize_bilinear(const uint8_t* src, int src_w, int src_h, CropRect crop, const ModelInput& dst) {
+        if (!src || !preprocess_crop_is_valid(src_w, src_h, crop, dst)) return false;
+
+        const int dst_w = dst.width;
+        const int dst_h = dst.height;
+        const int stride = src_w * Pixel::kBytes;
+        const int x_last = crop.x + crop.w - 1;
+        const int y_last = crop.y + crop.h - 1;
+
+        // Per-column taps are identical for every output row
+        uint16_t col_off0[PREPROCESS_MAX_OUT_DIM];
+        uint16_t col_off1[PREPROCESS_MAX_OUT_DIM];
+        uint16_t col_frac[PREPROCESS_MAX_OUT_DIM];
+        for (int ox = 0; ox < dst_w; ++ox) {
+            int32_t sx = source_coord_q16(ox, crop.x, crop.w, dst_w);
+            int x0 = sx >> 16;
+            int x1 = x0 < x_last ? x0 + 1 : x_last;
+            col_off0[ox] = (uint16_t)(x0 * Pixel::kBytes);
+            col_off1[ox] = (uint16_t)(x1 * Pixel::kBytes);
+            col_frac[ox] = (uint16_t)((sx >> 4) & 0xFFF);
+        }
+
+        for (int oy = 0; oy < dst_h; ++oy) {
+            int32_t sy = source_coord_q16(oy, crop.y, crop.h, dst_h);
+            int y0 = sy >> 16;
+            int y1 = y0 < y_last ? y0 + 1 : y_last;
+            uint32_t fy = (sy >> 4) & 0xFFF;
+            const uint8_t* row0 = src + y0 * stride;
+            const uint8_t* row1 = src + y1 * stride;
+            uint8_t out[PREPROCESS_MAX_OUT_DIM];
+
+            for (int ox = 0; ox < dst_w; ++ox) {
+                uint32_t fx = col_frac[ox];
+                uint32_t top = Pixel::luma(row0 + col_off0[ox]) * (4096 - fx) + Pixel::luma(row0 + col_off1[ox]) * fx;
+                uint32_t bot = Pixel::luma(row1 + col_off0[ox]) * (4096 - fx) + Pixel::luma(row1 + col_off1[ox]) * fx;
+                out[ox] = (uint8_t)((top * (4096 - fy) + bot * fy + (1u << 23)) >> 24);
+            }
+            luma_store_row(dst, oy, out);
+        }
+        return true;
+    }
+}
+
+CropRect preprocess_center_crop(int src_w, int src_h, int dst_w, int dst_h) {
+    CropRect c;
+    // Compare aspect ratios without dividing: src_w/src_h vs dst_w/dst_h
+    if ((int64_t)src_w * dst_h > (int64_t)src_h * dst_w) {
+        c.h = src_h;
+        c.w = (int)((int64_t)src_h * dst_w / dst_h);
+    } else {
+        c.w = src_w;
+        c.h = (int)((int64_t)src_w * dst_h / dst_w);
+    }
+    c.x = (src_w - c.w) / 2;
+    c.y = (src_h - c.h) / 2;
+    return c;
+}
+
+void luma_store_row(const ModelInput& dst, int y, const uint8_t* row) {
+    switch (dst.type) {
+        case ModelInputType::UINT8:   store_row_lut<uint8_t>(dst, y, row); break;
+        case ModelInputType::INT8:    store_row_lut<int8_t>(dst, y, row); break;
+        case ModelInputType::FLOAT32: store_row_lut<float>(dst, y, row); break;
+    }
+}
+
+bool luma_resize_rgb565(const uint8_t* src, int src_w, int src_h, CropRect crop, const ModelInput& dst) {
+    return luma_resize_bilinear<PixelRgb565>(src, src_w, src_h, crop, dst);
+}
+
+bool luma_resize_gray(const uint8_t* src, int src_w, int src_h, CropRect crop, const ModelInput& dst) {
+    return luma_resize_bilinear<PixelGray>(src, src_w, src_h, crop, dst);
+}
+
+// --- Thumbnails ---
+
+namespace {
+    template <typename Pixel>
+    bool thumb_from_pixels(const uint8_t* src, int src_w, int src_h, LumaThumb* thumb) {
+        if (!src || !thumb) return false;
+        thumb_begin(thumb, src_w, src_h);
+        thumb->has_skin = Pixel::kColor;
+        const int step = thumb->scale;
+        const int stride = src_w * Pixel::kBytes;
+        for (int ty = 0; ty < thumb->h; ++ty) {
+            // Sample the middle of each scale x scale cell
+            const uint8_t* row = src + (ty * step + step / 2) * stride + (step / 2) * Pixel::kBytes;
+            uint8_t* out = thumb->luma + ty * thumb->w;
+            for (int tx = 0; tx < thumb->w; ++tx, row += step * Pixel::kBytes) {
+                out[tx] = Pixel::luma(row);
+                if (Pixel::kColor && Pixel::skin(row)) thumb_set_bit(thumb->skin, ty * thumb->w + tx);
+            }
+        }
+        return true;
+    }
+}
+
+void thumb_begin(LumaThumb* thumb, int src_w, int src_h) {
+    int scale = 4;
+    while (src_w / scale > THUMB_MAX_W || src_h / scale > THUMB_MAX_H) scale *= 2;
+    thumb->scale = scale;
+    thumb->w = src_w / scale;
+    thumb->h = src_h / scale;
+    thumb->has_skin = false;
+    memset(thumb->skin, 0, sizeof(thumb->skin));
+}
+
+bool thumb_from_gray(const uint8_t* src, int src_w, int src_h, LumaThumb* thumb) {
+    return thumb_from_pixels<PixelGray>(src, src_w, src_h, thumb);
+}
+
+bool thumb_from_rgb565(const uint8_t* src, int src_w, int src_h, LumaThumb* thumb) {
+    return thumb_from_pixels<PixelRgb565>(src, src_w, src_h, thumb);
+}
+
+void thumb_push_rgb888_block(LumaThumb* thumb, int prescale, int x, int y, int w, int h, const uint8_t* rgb888) {
+    const int step = thumb->scale / prescale; // Remaining subsampling after the decoder's own scaling
+    for (int by = 0; by < h; ++by) {
+        int sy = y + by;
+        if (sy % step) continue;
+        int ty = sy / step;
+        if (ty >= thumb->h) break;
+        for (int bx = 0; bx < w; ++bx) {
+            int sx = x + bx;
+            if (sx % step) continue;
+            int tx = sx / step;
+            if (tx >= thumb->w) break;
+            const uint8_t* px = rgb888 + (by * w + bx) * 3;
+            thumb->luma[ty * thumb->w + tx] = luma_rgb888(px[0], px[1], px[2]);
+            if (skin_rgb888(px[0], px[1], px[2])) thumb_set_bit(thumb->skin, ty * thumb->w + tx);
+        }
+    }
+}
+
+// --- LumaAreaDownscaler ---
+
+int LumaAreaDownscaler::bin_x(int sx) const {
+    int b = (int)(((uint32_t)(sx - crop_.x) * step_x_) >> 16);
+    return b < dst_w_ ? b : dst_w_ - 1;
+}
+
+int LumaAreaDownscaler::bin_y(int sy) const {
+    int b = (int)(((uint32_t)(sy - crop_.y) * step_y_) >> 16);
+    return b < dst_h_ ? b : dst_h_ - 1;
+}
+
+bool LumaAreaDownscaler::begin(int src_w, int src_h, CropRect crop, const ModelInput& dst) {
+    const int dst_w = dst.width;
+    const int dst_h = dst.height;
+    // Area averaging only downsamples; the ring of accumulator rows relies on that too
+    if (!preprocess_crop_is_valid(src_w, src_h, crop, dst) || crop.w < dst_w || crop.h < dst_h) {
+        return false;
+    }
+    crop_ = crop;
+    dst_ = dst;
+    dst_w_ = dst_w;
+    dst_h_ = dst_h;
+    // Rounded up so the last source pixel always reaches the last output bin
+    step_x_ = (uint32_t)((((uint64_t)dst_w << 16) + crop.w - 1) / crop.w);
+    step_y_ = (uint32_t)((((uint64_t)dst_h << 16) + crop.h - 1) / crop.h);
+    next_row_ = 0;
+
+    memset(col_count_, 0, sizeof(col_count_));
+    memset(row_count_, 0, sizeof(row_count_));
+    for (int sx = crop.x; sx < crop.x + crop.w; ++sx) col_count_[bin_x(sx)]++;
+    for (int sy = crop.y; sy < crop.y + crop.h; ++sy) row_count_[bin_y(sy)]++;
+    // Each accumulator is uint16: 255 * pixels-per-bin must fit
+    uint32_t max_cols = 0, max_rows = 0;
+    for (int i = 0; i < dst_w; ++i) if (col_count_[i] > max_cols) max_cols = col_count_[i];
+    for (int i = 0; i < dst_h; ++i) if (row_count_[i] > max_rows) max_rows = row_count_[i];
+    if (max_cols * max_rows > 257) return false;
+
+    memset(acc_, 0, sizeof(acc_));
+    return true;
+}
+
+void LumaAreaDownscaler::flush_rows_before(int oy) {
+    if (oy > dst_h_) oy = dst_h_;
+    for (; next_row_ < oy; ++next_row_) {
+        uint16_t* acc = acc_[next_row_ % kAccRows];
+        uint8_t out[PREPROCESS_MAX_OUT_DIM];
+        uint32_t rows = row_count_[next_row_];
+        for (int ox = 0; ox < dst_w_; ++ox) {
+            uint32_t n = rows * col_count_[ox];
+            out[ox] = (uint8_t)((acc[ox] + n / 2) / n);
+        }
+        luma_store_row(dst_, next_row_, out);
+        memset(acc, 0, dst_w_ * sizeof(uint16_t));
+    }
+}
+
+void LumaAreaDownscaler::push_block(int x, int y, int w, int h, const uint8_t* rgb888) {
+    const int cx_end = crop_.x + crop_.w;
+    const int cy_end = crop_.y + crop_.h;
+
+    // Blocks arrive in raster order, so every output row that ends above this block is final
+    if (y >= cy_end) {
+        flush_rows_before(dst_h_);
+        return;
+    }
+    if (y > crop_.y) flush_rows_before(bin_y(y));
+
+    int x_begin = x > crop_.x ? x : crop_.x;
+    int x_end = x + w < cx_end ? x + w : cx_end;
+    int y_begin = y > crop_.y ? y : crop_.y;
+    int y_end = y + h < cy_end ? y + h : cy_end;
+    if (x_begin >= x_end || y_begin >= y_end) return;
+
+    for (int sy = y_begin; sy < y_end; ++sy) {
+        uint16_t* acc = acc_[bin_y(sy) % kAccRows];
+        const uint8_t* px = rgb888 + ((sy - y) * w + (x_begin - x)) * 3;
+        for (int sx = x_begin; sx < x_end; ++sx, px += 3) {
+            acc[bin_x(sx)] += luma_rgb888(px[0], px[1], px[2]);
+        }
+    }
+}
+
+void LumaAreaDownscaler::finish() {
+    flush_rows_before(dst_h_);
+}
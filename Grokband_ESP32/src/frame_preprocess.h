@@ -0,0 +1,81 @@
+#ifndef FRAME_PREPROCESS_H
+#define FRAME_PREPROCESS_H
+
+#include <stdint.h>
+#include "model_input.h"
+
+// Integer-only luma conversion + downscale kernels used by preprocess_camera_frame().
+// They read the source a row (or a JPEG MCU) at a time and write each finished output row
+// through the destination's LUT straight into the model input tensor, so no full-frame
+// RGB888, grayscale or model-sized staging buffer is ever allocated.
+// Nothing in here depends on ESP-IDF.
+
+#define PREPROCESS_MAX_OUT_DIM 128 // Bounds the per-column/per-row tables and the JPEG accumulator rows
+
+struct CropRect {
+    int x, y, w, h; // Source region, in source pixels
+};
+
+// Largest centered crop of (src_w x src_h) with the aspect ratio of (dst_w x dst_h)
+CropRect preprocess_center_crop(int src_w, int src_h, int dst_w, int dst_h);
+
+// Low-resolution luma copy of the whole frame (nominally 1/4 scale) for the motion gate and
+// the hand ROI tracker. Point-sampled, so building it reads 1/scale^2 of the source pixels.
+#define THUMB_MAX_W 80
+#define THUMB_MAX_H 60
+#define THUMB_BITS_BYTES ((THUMB_MAX_W * THUMB_MAX_H + 7) / 8)
+
+struct LumaThumb {
+    uint8_t luma[THUMB_MAX_W * THUMB_MAX_H];
+    uint8_t skin[THUMB_BITS_BYTES]; // One bit per pixel: skin-tone chroma. Only set for colour sources
+    bool has_skin;                  // false for grayscale frames
+    int w, h;
+    int scale;      // Source pixels per thumbnail pixel, >= 4
+};
+
+// Per-pixel masks over a thumbnail (skin, motion) are packed one bit per pixel, index y * w + x
+inline bool thumb_bit(const uint8_t* bits, int i) { return (bits[i >> 3] >> (i & 7)) & 1; }
+inline void thumb_set_bit(uint8_t* bits, int i) { bits[i >> 3] |= (uint8_t)(1u << (i & 7)); }
+
+// Picks the thumbnail scale for a source frame and sets w/h accordingly
+void thumb_begin(LumaThumb* thumb, int src_w, int src_h);
+bool thumb_from_gray(const uint8_t* src, int src_w, int src_h, LumaThumb* thumb);
+bool thumb_from_rgb565(const uint8_t* src, int src_w, int src_h, LumaThumb* thumb);
+// JPEG: decode at `prescale` (1/2/4/8, must divide thumb->scale) and feed the RGB888 blocks here
+void thumb_push_rgb888_block(LumaThumb* thumb, int prescale, int x, int y, int w, int h, const uint8_t* rgb888);
+
+// Converts one row of 8-bit luma through dst.lut and stores it as row `y` of the tensor
+void luma_store_row(const ModelInput& dst, int y, const uint8_t* row);
+
+// Bilinear resize of `crop` into dst (single channel, dst.width x dst.height).
+// RGB565 is expected big-endian, as delivered by esp32-camera.
+bool luma_resize_rgb565(const uint8_t* src, int src_w, int src_h, CropRect crop, const ModelInput& dst);
+bool luma_resize_gray(const uint8_t* src, int src_w, int src_h, CropRect crop, const ModelInput& dst);
+
+// Area downscale fed with decoded RGB888 blocks in raster (MCU) order.
+// Only a small ring of output-row accumulators is kept, not the decoded frame.
+class LumaAreaDownscaler {
+public:
+    // Decoded image is (src_w x src_h); crop is in the same (already JPEG-scaled) coordinates.
+    bool begin(int src_w, int src_h, CropRect crop, const ModelInput& dst);
+    void push_block(int x, int y, int w, int h, const uint8_t* rgb888);
+    void finish();
+
+private:
+    static constexpr int kAccRows = 20; // An MCU row (<= 16 lines) at <= 1:1 spans at most 17 output rows
+
+    int bin_x(int sx) const;
+    int bin_y(int sy) const;
+    void flush_rows_before(int oy);
+
+    CropRect crop_;
+    ModelInput dst_;
+    int dst_w_, dst_h_;
+    uint32_t step_x_, step_y_;  // Q16 output pixels per source pixel
+    int next_row_;              // First output row not yet written to dst
+    uint8_t col_count_[PREPROCESS_MAX_OUT_DIM]; // Source pixels that land in each output column
+    uint8_t row_count_[PREPROCESS_MAX_OUT_DIM];
+    uint16_t acc_[kAccRows][PREPROCESS_MAX_OUT_DIM];
+};
+
+#endif // FRAME_PREPROCESS_H
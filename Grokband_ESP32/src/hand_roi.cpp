@@ -0,0 +1,287 @@
+#include "hand_roi.h"
+#include <string.h>
+
+namespace {
+    constexpr int kMinBlobPixels = 12;    // Thumbnail pixels; fewer is noise, not a hand
+    constexpr uint32_t kTrimQ8 = 13;      // Ignore ~5% of foreground on each side (stray pixels)
+    constexpr int32_t kMarginQ8 = 64;     // Pad the box by 25% so fingertips stay inside
+    constexpr int32_t kAlphaQ8 = 64;      // EMA weight for small moves...
+    constexpr int32_t kFastAlphaQ8 = 128; // ...and for jumps larger than half the box
+    constexpr int32_t kDeadbandQ8 = 128;  // Half a thumbnail pixel: below this the box holds still
+    constexpr int kHoldFrames = 30;       // Keep the last box this long after the hands stop showing
+    constexpr uint32_t kValleyDiv = 4;    // Two-hand split needs a valley below 1/4 of both peaks
+
+    inline int32_t clamp32(int32_t v, int32_t lo, int32_t hi) {
+        return v < lo ? lo : (v > hi ? hi : v);
+    }
+
+    // Normalized detector output -> Q8 in [0, 256]. Clamped as a float, since converting NaN or
+    // anything outside int32 range to an integer is undefined; NaN takes `nan_q8`.
+    inline int32_t unit_q8(float v, int32_t nan_q8) {
+        if (v != v) return nan_q8;
+        if (v <= 0.0f) return 0;
+        if (v >= 1.0f) return 256;
+        return (int32_t)(v * 256);
+    }
+
+    inline int32_t ease(int32_t cur, int32_t target, int32_t fast_limit) {
+        int32_t diff = target - cur;
+        int32_t mag = diff < 0 ? -diff : diff;
+        if (mag < kDeadbandQ8) return cur;
+        return cur + diff * (mag > fast_limit ? kFastAlphaQ8 : kAlphaQ8) / 256;
+    }
+}
+
+void HandRoiTracker::configure(int src_w, int src_h, int dst_w, int dst_h, bool two_hands) {
+    if (src_w == src_w_ && src_h == src_h_ && dst_w == dst_w_ && dst_h == dst_h_ && two_hands == two_hands_) return;
+    src_w_ = src_w;
+    src_h_ = src_h;
+    dst_w_ = dst_w > 0 ? dst_w : 1;
+    dst_h_ = dst_h > 0 ? dst_h : 1;
+    two_hands_ = two_hands;
+    LumaThumb geometry;
+    thumb_begin(&geometry, src_w, src_h);
+    scale_ = geometry.scale;
+    thumb_w_ = geometry.w;
+    thumb_h_ = geometry.h;
+    reset();
+}
+
+void HandRoiTracker::reset() {
+    lost_frames_ = 0;
+    num_tracks_ = 1;
+    for (Track& t : tracks_) t.valid = false;
+    track_default(&tracks_[0]);
+}
+
+// Center crop, the same framing preprocess_camera_frame() uses without a tracker
+void HandRoiTracker::track_default(Track* t) {
+    CropRect c = preprocess_center_crop(thumb_w_, thumb_h_, dst_w_, dst_h_);
+    Box box = { c.x, c.y, c.x + c.w, c.y + c.h };
+    if (!t->valid) {
+        t->cx_q8 = (box.x0 + box.x1) << 7;
+        t->cy_q8 = (box.y0 + box.y1) << 7;
+        t->h_q8 = c.h << 8;
+        t->valid = true;
+        return;
+    }
+    t->cx_q8 = ease(t->cx_q8, (box.x0 + box.x1) << 7, t->h_q8 / 2);
+    t->cy_q8 = ease(t->cy_q8, (box.y0 + box.y1) << 7, t->h_q8 / 2);
+    t->h_q8 = ease(t->h_q8, c.h << 8, t->h_q8 / 2);
+}
+
+void HandRoiTracker::track_toward(Track* t, const Box& box) {
+    // Height that fits the blob at the model's aspect ratio, padded, within [model input, frame]
+    int32_t need_h = box.y1 - box.y0;
+    int32_t from_w = (box.x1 - box.x0) * dst_h_ / dst_w_;
+    if (from_w > need_h) need_h = from_w;
+    int32_t h_q8 = (need_h << 8) * (256 + kMarginQ8) / 256;
+    int32_t min_h_q8 = (dst_h_ << 8) / scale_; // Never crop below 1:1 with the model input
+    int32_t max_h_q8 = thumb_h_ << 8;
+    int32_t max_from_w = ((thumb_w_ * dst_h_) << 8) / dst_w_;
+    if (max_from_w < max_h_q8) max_h_q8 = max_from_w;
+    if (min_h_q8 > max_h_q8) min_h_q8 = max_h_q8;
+    h_q8 = clamp32(h_q8, min_h_q8, max_h_q8);
+
+    int32_t cx_q8 = (box.x0 + box.x1) << 7;
+    int32_t cy_q8 = (box.y0 + box.y1) << 7;
+    if (!t->valid) {
+        t->cx_q8 = cx_q8;
+        t->cy_q8 = cy_q8;
+        t->h_q8 = h_q8;
+        t->valid = true;
+        return;
+    }
+    t->cx_q8 = ease(t->cx_q8, cx_q8, t->h_q8 / 2);
+    t->cy_q8 = ease(t->cy_q8, cy_q8, t->h_q8 / 2);
+    t->h_q8 = ease(t->h_q8, h_q8, t->h_q8 / 2);
+}
+
+// Percentile bounds of the foreground in columns [col_lo, col_hi)
+bool HandRoiTracker::blob_box(int col_lo, int col_hi, Box* box) const {
+    uint16_t col_hist[THUMB_MAX_W] = {};
+    uint16_t row_hist[THUMB_MAX_H] = {};
+    uint32_t total = 0;
+    for (int y = 0; y < thumb_h_; ++y) {
+        for (int x = col_lo; x < col_hi; ++x) {
+            if (thumb_bit(fg_, y * thumb_w_ + x)) {
+                col_hist[x]++;
+                row_hist[y]++;
+                total++;
+            }
+        }
+    }
+    if (total < (uint32_t)kMinBlobPixels) return false;
+
+    const uint32_t trim = (total * kTrimQ8) >> 8;
+    auto bounds = [trim](const uint16_t* hist, int lo, int hi, int* first, int* last) {
+        uint32_t acc = 0;
+        *first = lo;
+        for (int i = lo; i < hi; ++i) {
+            acc += hist[i];
+            if (acc > trim) { *first = i; break; }
+        }
+        acc = 0;
+        *last = hi;
+        for (int i = hi - 1; i >= lo; --i) {
+            acc += hist[i];
+            if (acc > trim) { *last = i + 1; break; }
+        }
+    };
+    bounds(col_hist, col_lo, col_hi, &box->x0, &box->x1);
+    bounds(row_hist, 0, thumb_h_, &box->y0, &box->y1);
+    return box->x1 > box->x0 && box->y1 > box->y0;
+}
+
+void HandRoiTracker::update(const LumaThumb& thumb, const uint8_t* motion) {
+    if (thumb.w != thumb_w_ || thumb.h != thumb_h_ || !motion) return;
+
+    // Skin only counts near a box we already track, so a static face or wooden desk in the
+    // background can't pull the crop away; new hands have to announce themselves by moving.
+    Box skin_zone[HAND_ROI_MAX_HANDS];
+    int num_zones = 0;
+    if (thumb.has_skin) {
+        for (int i = 0; i < num_tracks_; ++i) {
+            const Track& t = tracks_[i];
+            if (!t.valid) continue;
+            int32_t half_h = (t.h_q8 * 5 / 4) >> 9;
+            int32_t half_w = half_h * dst_w_ / dst_h_;
+            skin_zone[num_zones++] = { (int)((t.cx_q8 >> 8) - half_w), (int)((t.cy_q8 >> 8) - half_h),
+                                 (int)((t.cx_q8 >> 8) + half_w), (int)((t.cy_q8 >> 8) + half_h) };
+        }
+    }
+    memset(fg_, 0, sizeof(fg_));
+    for (int y = 0; y < thumb_h_; ++y) {
+        for (int x = 0; x < thumb_w_; ++x) {
+            const int i = y * thumb_w_ + x;
+            bool fg = thumb_bit(motion, i);
+            if (!fg && num_zones && thumb_bit(thumb.skin, i)) {
+                for (int b = 0; b < num_zones && !fg; ++b) {
+                    fg = x >= skin_zone[b].x0 && x < skin_zone[b].x1 && y >= skin_zone[b].y0 && y < skin_zone[b].y1;
+                }
+            }
+            if (fg) thumb_set_bit(fg_, i);
+        }
+    }
+
+    Box boxes[HAND_ROI_MAX_HANDS];
+    int found = 0;
+    if (two_hands_) {
+        // Split at the emptiest column between the two halves of the foreground, if it is a real gap
+        uint16_t col_hist[THUMB_MAX_W] = {};
+        int lo = thumb_w_, hi = 0;
+        for (int y = 0; y < thumb_h_; ++y) {
+            for (int x = 0; x < thumb_w_; ++x) {
+                if (thumb_bit(fg_, y * thumb_w_ + x)) col_hist[x]++;
+            }
+        }
+        for (int x = 0; x < thumb_w_; ++x) {
+            if (col_hist[x]) {
+                if (x < lo) lo = x;
+                hi = x + 1;
+            }
+        }
+        if (hi - lo >= 4) {
+            int a = lo + (hi - lo) / 4;
+            int b = hi - (hi - lo) / 4;
+            int valley = a;
+            for (int x = a; x < b; ++x) {
+                if (col_hist[x] < col_hist[valley]) valley = x;
+            }
+            uint16_t left_peak = 0, right_peak = 0;
+            for (int x = lo; x < valley; ++x) if (col_hist[x] > left_peak) left_peak = col_hist[x];
+            for (int x = valley + 1; x < hi; ++x) if (col_hist[x] > right_peak) right_peak = col_hist[x];
+            if (col_hist[valley] * kValleyDiv <= left_peak && col_hist[valley] * kValleyDiv <= right_peak &&
+                blob_box(lo, valley, &boxes[0]) && blob_box(valley + 1, hi, &boxes[1])) {
+                found = 2;
+            }
+        }
+    }
+    if (!found && blob_box(0, thumb_w_, &boxes[0])) found = 1;
+
+    if (!found) {
+        // Hands still (and no skin near the box): hold, then drift back to the center crop
+        if (++lost_frames_ > kHoldFrames) {
+            num_tracks_ = 1;
+            track_default(&tracks_[0]);
+        }
+        return;
+    }
+    lost_frames_ = 0;
+    if (found == 1 && num_tracks_ == 2) {
+        // One blob left: keep whichever track it is closer to
+        int32_t cx_q8 = (boxes[0].x0 + boxes[0].x1) << 7;
+        int32_t d0 = tracks_[0].cx_q8 - cx_q8;
+        int32_t d1 = tracks_[1].cx_q8 - cx_q8;
+        if ((d1 < 0 ? -d1 : d1) < (d0 < 0 ? -d0 : d0)) tracks_[0] = tracks_[1];
+    }
+    if (found == 2 && num_tracks_ == 1) {
+        tracks_[1].valid = false;
+    }
+    num_tracks_ = found;
+    for (int i = 0; i < found; ++i) track_toward(&tracks_[i], boxes[i]);
+}
+
+CropRect HandRoiTracker::to_source(const Track& t) const {
+    int h = (t.h_q8 * scale_) >> 8;
+    int w = h * dst_w_ / dst_h_;
+    if (w > src_w_) { w = src_w_; h = w * dst_h_ / dst_w_; }
+    if (h > src_h_) { h = src_h_; w = h * dst_w_ / dst_h_; }
+    if (w < 1) w = 1;
+    if (h < 1) h = 1;
+    int x = ((t.cx_q8 * scale_) >> 8) - w / 2;
+    int y = ((t.cy_q8 * scale_) >> 8) - h / 2;
+    CropRect c = { (int)clamp32(x, 0, src_w_ - w), (int)clamp32(y, 0, src_h_ - h), w, h };
+    return c;
+}
+
+void HandRoiTracker::get(HandRois* out) const {
+    if (!out) return;
+    out->count = 0;
+    for (int i = 0; i < num_tracks_; ++i) {
+        if (tracks_[i].valid) out->crop[out->count++] = to_source(tracks_[i]);
+    }
+    if (out->count == 0) {
+        out->crop[0] = preprocess_center_crop(src_w_, src_h_, dst_w_, dst_h_);
+        out->count = 1;
+    }
+}
+
+CropRect HandRoiTracker::gate_region() const {
+    int x0 = thumb_w_, y0 = thumb_h_, x1 = 0, y1 = 0;
+    for (int i = 0; i < num_tracks_; ++i) {
+        if (!tracks_[i].valid) continue;
+        CropRect c = to_source(tracks_[i]);
+        if (c.x / scale_ < x0) x0 = c.x / scale_;
+        if (c.y / scale_ < y0) y0 = c.y / scale_;
+        if ((c.x + c.w) / scale_ > x1) x1 = (c.x + c.w) / scale_;
+        if ((c.y + c.h) / scale_ > y1) y1 = (c.y + c.h) / scale_;
+    }
+    if (x1 <= x0 || y1 <= y0) return preprocess_center_crop(thumb_w_, thumb_h_, dst_w_, dst_h_);
+    CropRect r = { x0, y0, x1 - x0, y1 - y0 };
+    return r;
+}
+
+CropRect hand_box_to_crop(float cx, float cy, float w, float h, CropRect region,
+                          int src_w, int src_h, int dst_w, int dst_h, int32_t margin_q8) {
+    if (dst_w < 1) dst_w = 1;
+    if (dst_h < 1) dst_h = 1;
+    // Source pixels from here on; models may emit out-of-range or non-finite values. A NaN
+    // center falls back to the middle of the region, a NaN size to the smallest crop.
+    int32_t bx = region.x + unit_q8(cx, 128) * region.w / 256;
+    int32_t by = region.y + unit_q8(cy, 128) * region.h / 256;
+    int32_t bw = unit_q8(w, 0) * region.w / 256;
+    int32_t bh = unit_q8(h, 0) * region.h / 256;
+    bw += 2 * (bw * margin_q8 / 256);
+    bh += 2 * (bh * margin_q8 / 256);
+
+    // Grow the short side to the dst aspect so the hand is scaled, not cropped
+    if ((int64_t)bw * dst_h > (int64_t)bh * dst_w) bh = (int32_t)((int64_t)bw * dst_h / dst_w);
+    else bw = (int32_t)((int64_t)bh * dst_w / dst_h);
+    if (bw < dst_w || bh < dst_h) { bw = dst_w; bh = dst_h; }
+    if (bw > src_w) { bw = src_w; bh = (int32_t)((int64_t)bw * dst_h / dst_w); }
+    if (bh > src_h) { bh = src_h; bw = (int32_t)((int64_t)bh * dst_w / dst_h); }
+
+    CropRect c = { (int)clamp32(bx - bw / 2, 0, src_w - bw), (int)clamp32(by - bh / 2, 0, src_h - bh), (int)bw, (int)bh };
+    return c;
+}
@@ -0,0 +1,65 @@
+#ifndef HAND_ROI_H
+#define HAND_ROI_H
+
+#include <stdint.h>
+#include "frame_preprocess.h"
+
+// Tracks where the hands are so preprocessing can crop them instead of a fixed center crop,
+// letting a small model input spend its pixels on the hand rather than the background.
+// Runs on the motion gate's thumbnail: foreground = moving pixels, plus skin-tone pixels
+// near the current box when the frame has colour. The box comes from percentile bounds of
+// the foreground row/column histograms, padded, shaped to the model's aspect ratio, and
+// smoothed with a Q8 EMA so it doesn't jitter. Integer-only; nothing here depends on ESP-IDF.
+#define HAND_ROI_MAX_HANDS 2
+
+struct HandRois {
+    CropRect crop[HAND_ROI_MAX_HANDS]; // Source pixels, aspect of the model input. Left hand first
+    int count;
+};
+
+class HandRoiTracker {
+public:
+    // Frame size, model input size and whether to look for two hands. Resets the tracks if
+    // anything changed; cheap to call every frame.
+    void configure(int src_w, int src_h, int dst_w, int dst_h, bool two_hands);
+    void reset();
+    // `motion` is the motion mask for `thumb` (MotionGate::motion_mask()).
+    void update(const LumaThumb& thumb, const uint8_t* motion);
+    void get(HandRois* out) const;
+    // Union of the tracked boxes in thumbnail pixels: where the motion gate should look
+    CropRect gate_region() const;
+
+private:
+    struct Track {
+        int32_t cx_q8, cy_q8;   // Box center, thumbnail pixels, Q8
+        int32_t h_q8;           // Box height, thumbnail pixels, Q8 (width follows the aspect)
+        bool valid;
+    };
+    struct Box {
+        int x0, y0, x1, y1;     // Thumbnail pixels, exclusive end
+    };
+
+    bool blob_box(int col_lo, int col_hi, Box* box) const;
+    void track_toward(Track* t, const Box& box);
+    void track_default(Track* t);
+    CropRect to_source(const Track& t) const;
+
+    int src_w_ = 0, src_h_ = 0;
+    int dst_w_ = 1, dst_h_ = 1;
+    int scale_ = 4;
+    int thumb_w_ = 0, thumb_h_ = 0;
+    bool two_hands_ = false;
+    int lost_frames_ = 0;
+    int num_tracks_ = 1;
+    Track tracks_[HAND_ROI_MAX_HANDS] = {};
+    uint8_t fg_[THUMB_BITS_BYTES];
+};
+
+// Classifier crop for a box proposed by the hand detector (cascade stage 1). The box is
+// normalized (center, size) to `region`, the source area the detector saw. It is padded by
+// margin_q8/256 on each side, shaped to the dst aspect, kept at least dst-sized (never
+// upscaled) and clamped to the frame.
+CropRect hand_box_to_crop(float cx, float cy, float w, float h, CropRect region,
+                          int src_w, int src_h, int dst_w, int dst_h, int32_t margin_q8);
+
+#endif // HAND_ROI_H
@@ -0,0 +1,127 @@
+#include "input_decoder.h"
+
+namespace {
+    // Indexed by (previous AB << 2) | current AB. 0 = no change, 2 = both pins changed (invalid).
+    // Forward is the Gray sequence 00 -> 01 -> 11 -> 10 -> 00.
+    constexpr int8_t kQuadTable[16] = {
+         0, +1, -1,  2,
+        -1,  0,  2, +1,
+        +1,  2,  0, -1,
+         2, -1, +1,  0
+    };
+}
+
+int QuadratureDecoder::feed(uint8_t a, uint8_t b) {
+    uint8_t state = (uint8_t)(((a & 1) << 1) | (b & 1));
+    if (state_ == 0xFF) {
+        state_ = state;
+        return 0;
+    }
+    int step = kQuadTable[(state_ << 2) | state];
+    state_ = state;
+    if (step == 2) {
+        invalid_++;
+        return 0;
+    }
+    count_ += step;
+    return step;
+}
+
+int DetentAccumulator::update(int32_t raw) {
+    int32_t delta = raw - last_raw_;
+    last_raw_ = raw;
+    if (wrap_ > 0) {
+        // The counter cannot move half its range between two reads, so a bigger jump is a wrap
+        if (delta > wrap_ / 2) delta -= wrap_;
+        else if (delta < -wrap_ / 2) delta += wrap_;
+    }
+    remainder_ += delta;
+    int32_t detents = remainder_ / per_detent_;   // Truncates toward zero, so both directions keep their remainder
+    remainder_ -= detents * per_detent_;
+    return (int)detents;
+}
+
+void ButtonClassifier::emit(ButtonAction action, uint32_t t_us) {
+    if (pending_count_ == kPending) return; // Caller stopped polling; the oldest actions win
+    pending_[(pending_head_ + pending_count_) % kPending] = { action, t_us };
+    pending_count_++;
+}
+
+void ButtonClassifier::accept(bool pressed, uint32_t t_us) {
+    pressed_ = pressed;
+    accepted_any_ = true;
+    last_accept_us_ = t_us;
+    if (pressed) {
+        press_us_ = t_us;
+        long_fired_ = false;
+        return;
+    }
+
+    if (!long_fired_ && t_us - press_us_ >= long_press_us_) {
+        // Held long enough but poll() did not run in time; still a long press
+        emit(ButtonAction::LONG_PRESS, press_us_ + long_press_us_);
+        long_fired_ = true;
+    }
+    if (long_fired_) {
+        have_click_ = false;
+        return;
+    }
+    emit(ButtonAction::CLICK, t_us);
+    if (have_click_ && t_us - last_click_us_ <= double_click_us_) {
+        emit(ButtonAction::DOUBLE_CLICK, t_us);
+        have_click_ = false;
+    } else {
+        have_click_ = true;
+        last_click_us_ = t_us;
+    }
+}
+
+void ButtonClassifier::feed(const InputEdge& edge) {
+    if (raw_pending_ && edge.t_us - last_accept_us_ >= debounce_us_) {
+        // An edge from inside the last bounce window was never settled by poll(); it is the
+        // level the pin actually held until this edge
+        raw_pending_ = false;
+        if ((raw_level_ == 0) != pressed_) accept(raw_level_ == 0, raw_us_);
+    }
+    if (accepted_any_ && edge.t_us - last_accept_us_ < debounce_us_) {
+        raw_pending_ = true;
+        raw_level_ = edge.level;
+        raw_us_ = edge.t_us;
+        return;
+    }
+    raw_pending_ = false;
+    bool pressed = edge.level == 0;
+    if (pressed != pressed_) accept(pressed, edge.t_us);
+}
+
+ButtonEvent ButtonClassifier::poll(uint32_t now_us) {
+    if (raw_pending_ && now_us - last_accept_us_ >= debounce_us_) {
+        raw_pending_ = false;
+        // The pin settled somewhere other than where the accepted edge left it (a tap shorter
+        // than the bounce window, or a bounce that ended on the opposite level)
+        if ((raw_level_ == 0) != pressed_) accept(raw_level_ == 0, raw_us_);
+    }
+    if (pressed_ && !long_fired_ && now_us - press_us_ >= long_press_us_) {
+        long_fired_ = true;
+        emit(ButtonAction::LONG_PRESS, press_us_ + long_press_us_);
+    }
+    if (pending_count_ == 0) return { ButtonAction::NONE, now_us };
+    ButtonEvent event = pending_[pending_head_];
+    pending_head_ = (pending_head_ + 1) % kPending;
+    pending_count_--;
+    return event;
+}
+
+bool ButtonClassifier::next_deadline_us(uint32_t* deadline_us) const {
+    bool have = false;
+    uint32_t deadline = 0;
+    auto consider = [&](uint32_t t) {
+        if (!have || (int32_t)(t - deadline) < 0) deadline = t;
+        have = true;
+    };
+    if (pending_count_ > 0) consider(last_accept_us_);
+    if (raw_pending_) consider(last_accept_us_ + debounce_us_);
+    if (pressed_ && !long_fired_) consider(press_us_ + long_press_us_);
+    if (have && deadline_us) *deadline_us = deadline;
+    return have;
+}
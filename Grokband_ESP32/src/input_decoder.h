@@ -0,0 +1,138 @@
+#ifndef INPUT_DECODER_H
+#define INPUT_DECODER_H
+
+#include <atomic>
+#include <stdint.h>
+
+// Decoding cores for the rotary encoder and its push button. Everything takes timestamps
+// (microseconds, from the ISR) instead of reading a clock, and nothing touches hardware, so
+// a host program can drive it with synthetic edge sequences.
+
+// Single-producer/single-consumer ring: one ISR pushes, one task pops, no locks.
+// kSize must be a power of two; a full ring rejects the push.
+template <typename T, uint32_t kSize>
+class SpscRing {
+    static_assert((kSize & (kSize - 1)) == 0, "SpscRing size must be a power of two");
+
+public:
+    bool push(const T& item) {
+        uint32_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) == kSize) {
+            overflows_++;
+            return false;
+        }
+        items_[head & (kSize - 1)] = item;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T* out) {
+        uint32_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire)) return false;
+        *out = items_[tail & (kSize - 1)];
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    uint32_t overflows() const { return overflows_; }
+
+private:
+    T items_[kSize];
+    std::atomic<uint32_t> head_{0};
+    std::atomic<uint32_t> tail_{0};
+    uint32_t overflows_ = 0;    // Written by the producer only
+};
+
+// One raw level change of a pin, as captured in the ISR
+struct InputEdge {
+    uint32_t t_us;
+    uint8_t level;      // Pin level after the edge (the button is active low)
+};
+
+// Software quadrature decoder for when the PCNT peripheral is unavailable. Feeds on A/B
+// levels; transitions that skip a state (both pins changed, i.e. a glitch or a missed edge)
+// are counted and ignored instead of guessed at.
+class QuadratureDecoder {
+public:
+    // Returns the count change (-1, 0, +1) caused by the new levels
+    int feed(uint8_t a, uint8_t b);
+    int32_t count() const { return count_; }
+    uint32_t invalid_transitions() const { return invalid_; }
+
+private:
+    uint8_t state_ = 0xFF;      // Last AB state, 0xFF until the first sample
+    int32_t count_ = 0;
+    uint32_t invalid_ = 0;
+};
+
+// Turns a raw quadrature count (PCNT or QuadratureDecoder) into whole detents, keeping the
+// remainder so slow turns are not lost. `wrap` is the counter's modulus: the PCNT counter
+// resets to 0 when it reaches +-limit, so it wraps at `limit`; 0 means it never wraps.
+class DetentAccumulator {
+public:
+    DetentAccumulator(int counts_per_detent, int32_t wrap) : per_detent_(counts_per_detent), wrap_(wrap) {}
+
+    // `raw` is the current counter value; returns detents moved since the last call
+    int update(int32_t raw);
+    void reset(int32_t raw) { last_raw_ = raw; remainder_ = 0; }
+
+private:
+    int per_detent_;
+    int32_t wrap_;
+    int32_t last_raw_ = 0;
+    int32_t remainder_ = 0;
+};
+
+enum class ButtonAction : uint8_t {
+    NONE,
+    CLICK,          // Released before the long-press time
+    DOUBLE_CLICK,   // Second click within the double-click window (follows its own CLICK)
+    LONG_PRESS      // Held for the long-press time; fires while still held
+};
+
+struct ButtonEvent {
+    ButtonAction action;
+    uint32_t t_us;      // Edge (or long-press deadline) that produced the action
+};
+
+// Debounces button edges and classifies them. CLICK fires on release without waiting for a
+// possible second click, so a click never costs the double-click window in latency; callers
+// that care treat DOUBLE_CLICK as an addition to the CLICK before it.
+class ButtonClassifier {
+public:
+    ButtonClassifier(uint32_t debounce_us, uint32_t long_press_us, uint32_t double_click_us)
+        : debounce_us_(debounce_us), long_press_us_(long_press_us), double_click_us_(double_click_us) {}
+
+    void feed(const InputEdge& edge);
+    // Settles edges whose bounce window has passed and reports at most one action
+    ButtonEvent poll(uint32_t now_us);
+    // Time poll() next needs to run for a pending long press or settling edge, or false if none
+    bool next_deadline_us(uint32_t* deadline_us) const;
+    bool pressed() const { return pressed_; }
+
+private:
+    static constexpr int kPending = 4;
+
+    void accept(bool pressed, uint32_t t_us);
+    void emit(ButtonAction action, uint32_t t_us);
+
+    uint32_t debounce_us_, long_press_us_, double_click_us_;
+
+    bool pressed_ = false;          // Debounced state
+    bool accepted_any_ = false;
+    uint32_t last_accept_us_ = 0;   // Last accepted edge, opens the bounce window
+    bool raw_pending_ = false;      // A raw edge arrived inside the bounce window
+    uint8_t raw_level_ = 1;
+    uint32_t raw_us_ = 0;
+
+    uint32_t press_us_ = 0;
+    bool long_fired_ = false;
+    bool have_click_ = false;       // A click ended recently enough to pair with the next
+    uint32_t last_click_us_ = 0;
+
+    ButtonEvent pending_[kPending];
+    int pending_head_ = 0;
+    int pending_count_ = 0;
+};
+
+#endif // INPUT_DECODER_H
@@ -1,126 +1,167 @@
 #include "input_handler.h"
+#include "input_decoder.h"
 #include "config.h"
-#include <RotaryEncoder.h>
-#include "lvgl.h" // For lv_indev_state_t
-
-// Setup a RotaryEncoder with 2 steps per detent and internal pullup resistors
-// RotaryEncoder encoder(ROTARY_ENCODER_A_PIN, ROTARY_ENCODER_B_PIN, RotaryEncoder::LatchMode::FOUR3); // Example for specific encoder
-// Simpler constructor:
-RotaryEncoder encoder(ROTARY_ENCODER_A_PIN, ROTARY_ENCODER_B_PIN);
-
-
-volatile long last_encoder_pos = 0;
-volatile bool encoder_button_pressed = false;
-lvgl_encoder_cb_t g_lvgl_cb = nullptr;
-
-
-// Interrupt service routines (ISRs) - keep them short!
-#if defined(ESP32)
-void IRAM_ATTR read_encoder_isr() {
-    encoder.tick();
-}
-void IRAM_ATTR encoder_button_isr() {
-    // Basic debouncing, you might need more sophisticated logic
-    static unsigned long last_interrupt_time = 0;
-    unsigned long interrupt_time = millis();
-    if (interrupt_time - last_interrupt_time > 200) { // 200ms debounce
-        encoder_button_pressed = true; // Set flag, process in loop
-        last_interrupt_time = interrupt_time;
-    }
-}
+#include <Arduino.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/gpio.h"
+#include "esp_timer.h"
+#if ENCODER_USE_PCNT
+#include "driver/pcnt.h"
 #endif
 
+namespace {
+    constexpr int16_t kPcntLimit = 32000;   // Counter resets to 0 here; DetentAccumulator unwraps it
+
+    TaskHandle_t loop_task = nullptr;
+    SpscRing<InputEdge, 16> button_edges;   // Button ISR -> loop()
+    ButtonClassifier button(BUTTON_DEBOUNCE_MS * 1000, BUTTON_LONG_PRESS_MS * 1000, BUTTON_DOUBLE_CLICK_MS * 1000);
+#if ENCODER_USE_PCNT
+    DetentAccumulator detents(ENCODER_COUNTS_PER_DETENT, kPcntLimit);
+#else
+    QuadratureDecoder quadrature;           // Fed from the A/B ISR
+    DetentAccumulator detents(ENCODER_COUNTS_PER_DETENT, 0);
+#endif
 
-void input_init() {
-    pinMode(ROTARY_ENCODER_SW_PIN, INPUT_PULLUP); // Assuming active low button
-    
-    #if defined(ESP_PLATFORM) // ESP32 specific
-    // attachInterrupt(digitalPinToInterrupt(ROTARY_ENCODER_A_PIN), read_encoder_isr, CHANGE);
-    // attachInterrupt(digitalPinToInterrupt(ROTARY_ENCODER_B_PIN), read_encoder_isr, CHANGE);
-    // The RotaryEncoder library often handles its own tick if you call encoder.tick() regularly.
-    // If it does not, you might need ISRs like above or use ESP32's PCNT peripheral.
-
-    attachInterrupt(digitalPinToInterrupt(ROTARY_ENCODER_SW_PIN), encoder_button_isr, FALLING);
-    #else
-    // For other platforms, you might need different interrupt setup
-    #endif
-    
-    encoder.setPosition(0); // Start position
-    Serial.println("Input Handler Initialized");
-}
-
-void input_set_lvgl_cb(lvgl_encoder_cb_t cb) {
-    g_lvgl_cb = cb;
-}
+    // First encoder edge not yet reported, 0 when none (a real timestamp of 0 is never seen)
+    volatile uint32_t encoder_edge_us = 0;
 
+    void IRAM_ATTR wake_loop_from_isr() {
+        BaseType_t woken = pdFALSE;
+        if (loop_task) vTaskNotifyGiveFromISR(loop_task, &woken);
+        if (woken) portYIELD_FROM_ISR();
+    }
 
-// This function should be called by LVGL's input device read callback
-// It simulates how LVGL would read an encoder
-void lvgl_encoder_read_fake(lv_indev_drv_t * drv, lv_indev_data_t * data) {
-    encoder.tick(); // Ensure encoder state is up-to-date
-    long new_pos = encoder.getPosition();
-    int diff = 0;
+    void IRAM_ATTR button_isr() {
+        InputEdge edge = { (uint32_t)esp_timer_get_time(), (uint8_t)gpio_get_level(ROTARY_ENCODER_SW_PIN) };
+        button_edges.push(edge); // A full ring means loop() is stalled; ButtonClassifier resyncs on the next edge
+        wake_loop_from_isr();
+    }
 
-    if (new_pos > last_encoder_pos) {
-        diff = 1;
-    } else if (new_pos < last_encoder_pos) {
-        diff = -1;
+    // With PCNT this only wakes loop() (the counting is in hardware); otherwise it also decodes
+    void IRAM_ATTR encoder_isr() {
+        if (encoder_edge_us == 0) encoder_edge_us = (uint32_t)esp_timer_get_time() | 1;
+#if !ENCODER_USE_PCNT
+        quadrature.feed(gpio_get_level(ROTARY_ENCODER_A_PIN), gpio_get_level(ROTARY_ENCODER_B_PIN));
+#endif
+        wake_loop_from_isr();
     }
-    last_encoder_pos = new_pos; // Update for next comparison
 
-    data->enc_diff = diff;
+#if ENCODER_USE_PCNT
+    void encoder_pcnt_init() {
+        const pcnt_unit_t unit = (pcnt_unit_t)ENCODER_PCNT_UNIT;
+
+        // Full quadrature: each channel counts the edges of one pin, with the other pin as direction
+        pcnt_config_t cfg = {};
+        cfg.unit = unit;
+        cfg.counter_h_lim = kPcntLimit;
+        cfg.counter_l_lim = -kPcntLimit;
+        cfg.channel = PCNT_CHANNEL_0;
+        cfg.pulse_gpio_num = ROTARY_ENCODER_A_PIN;
+        cfg.ctrl_gpio_num = ROTARY_ENCODER_B_PIN;
+        cfg.pos_mode = PCNT_COUNT_DEC;
+        cfg.neg_mode = PCNT_COUNT_INC;
+        cfg.lctrl_mode = PCNT_MODE_REVERSE;
+        cfg.hctrl_mode = PCNT_MODE_KEEP;
+        pcnt_unit_config(&cfg);
+
+        cfg.channel = PCNT_CHANNEL_1;
+        cfg.pulse_gpio_num = ROTARY_ENCODER_B_PIN;
+        cfg.ctrl_gpio_num = ROTARY_ENCODER_A_PIN;
+        cfg.pos_mode = PCNT_COUNT_INC;
+        cfg.neg_mode = PCNT_COUNT_DEC;
+        pcnt_unit_config(&cfg);
+
+        // Filter length is in APB (80 MHz) cycles, 10 bits
+        uint32_t filter = ENCODER_GLITCH_FILTER_NS * 80 / 1000;
+        pcnt_set_filter_value(unit, filter > 1023 ? 1023 : (uint16_t)filter);
+        pcnt_filter_enable(unit);
+
+        pcnt_counter_pause(unit);
+        pcnt_counter_clear(unit);
+        pcnt_counter_resume(unit);
+    }
 
-    if (encoder_button_pressed) {
-        data->state = LV_INDEV_STATE_PRESSED;
-        encoder_button_pressed = false; // Consume press
-    } else {
-        data->state = LV_INDEV_STATE_RELEASED;
+    int32_t encoder_raw_count() {
+        int16_t count = 0;
+        pcnt_get_counter_value((pcnt_unit_t)ENCODER_PCNT_UNIT, &count);
+        return count;
     }
+#else
+    int32_t encoder_raw_count() {
+        return quadrature.count(); // Aligned 32-bit read, written only by the ISR
+    }
+#endif
 }
 
 
-// If not using LVGL's input system directly, you can poll
-InputEvent input_get_event() {
-    encoder.tick(); // Call regularly if not using ISRs handled by the library
-    long new_pos = encoder.getPosition();
-    InputEvent event = InputEvent::NONE;
+void input_init() {
+    loop_task = xTaskGetCurrentTaskHandle();
+    pinMode(ROTARY_ENCODER_SW_PIN, INPUT_PULLUP); // Active low button
+    pinMode(ROTARY_ENCODER_A_PIN, INPUT_PULLUP);
+    pinMode(ROTARY_ENCODER_B_PIN, INPUT_PULLUP);
+
+#if ENCODER_USE_PCNT
+    encoder_pcnt_init();
+    // PCNT has no per-count interrupt; an edge interrupt on A just wakes loop() to read it
+    attachInterrupt(digitalPinToInterrupt(ROTARY_ENCODER_A_PIN), encoder_isr, CHANGE);
+#else
+    attachInterrupt(digitalPinToInterrupt(ROTARY_ENCODER_A_PIN), encoder_isr, CHANGE);
+    attachInterrupt(digitalPinToInterrupt(ROTARY_ENCODER_B_PIN), encoder_isr, CHANGE);
+#endif
+    attachInterrupt(digitalPinToInterrupt(ROTARY_ENCODER_SW_PIN), button_isr, CHANGE);
 
-    if (new_pos > last_encoder_pos) {
-        event = InputEvent::ENCODER_DOWN; // Or UP, depending on your wiring/interpretation
-    } else if (new_pos < last_encoder_pos) {
-        event = InputEvent::ENCODER_UP;
-    }
-    last_encoder_pos = new_pos;
+    detents.reset(encoder_raw_count());
+    Serial.println("Input Handler Initialized");
+}
 
-    if (encoder_button_pressed) {
-        event = InputEvent::ENCODER_PRESS;
-        encoder_button_pressed = false; // Consume the event
+bool input_next_event(InputEventInfo* out) {
+    InputEdge edge;
+    while (button_edges.pop(&edge)) button.feed(edge);
+
+    uint32_t now_us = (uint32_t)esp_timer_get_time();
+    ButtonEvent press = button.poll(now_us);
+    if (press.action != ButtonAction::NONE) {
+        out->steps = 0;
+        out->t_us = press.t_us;
+        switch (press.action) {
+            case ButtonAction::CLICK: out->type = InputEvent::ENCODER_PRESS; break;
+            case ButtonAction::DOUBLE_CLICK: out->type = InputEvent::ENCODER_DOUBLE_PRESS; break;
+            default: out->type = InputEvent::ENCODER_LONG_PRESS; break;
+        }
+        return true;
     }
-    return event;
-}
 
-// --- Simplified accessors for main loop if not using full LVGL integration for input yet ---
-int8_t get_encoder_diff() {
-    encoder.tick();
-    long new_pos = encoder.getPosition();
-    int diff = 0;
-    if (new_pos != last_encoder_pos) {
-        diff = new_pos - last_encoder_pos;
-        encoder.setPosition(0); // Reset for delta next time, or manage absolute
-        last_encoder_pos = 0; // If resetting above
+    uint32_t edge_us = encoder_edge_us;
+    int steps = detents.update(encoder_raw_count());
+    if (steps == 0) {
+        // Edges that did not add up to a detent (yet) should not skew the next latency sample
+        if (edge_us) encoder_edge_us = 0;
+        return false;
     }
-    return (int8_t)diff;
+    encoder_edge_us = 0;
+    if (steps > 127) steps = 127;
+    if (steps < -127) steps = -127;
+    out->type = steps > 0 ? InputEvent::ENCODER_DOWN : InputEvent::ENCODER_UP;
+    out->steps = (int8_t)steps;
+    out->t_us = edge_us ? edge_us : now_us;
+    return true;
 }
 
-bool is_encoder_pressed() {
-    bool pressed = encoder_button_pressed;
-    if (pressed) {
-        encoder_button_pressed = false; // Consume
+void input_wait(uint32_t max_ms) {
+    uint32_t deadline_us;
+    if (button.next_deadline_us(&deadline_us)) {
+        int32_t until_us = (int32_t)(deadline_us - (uint32_t)esp_timer_get_time());
+        if (until_us <= 0) return;
+        uint32_t until_ms = (until_us + 999) / 1000;
+        if (until_ms < max_ms) max_ms = until_ms;
     }
-    return pressed;
+    // An edge between the caller's last input_next_event() and here has already given the
+    // notification, so the take returns at once rather than missing it
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(max_ms));
 }
 
-void clear_encoder_state() {
-    encoder_button_pressed = false;
-    last_encoder_pos = encoder.getPosition();
-}
\ No newline at end of file
+void input_wake() {
+    if (loop_task) xTaskNotifyGive(loop_task);
+}
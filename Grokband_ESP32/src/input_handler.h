@@ -3,24 +3,34 @@
 
 #include <stdint.h>
 
+// Rotary encoder and push button. The encoder is decoded in hardware by a PCNT unit with its
+// glitch filter on; the button ISR timestamps each edge into a lock-free queue that loop()
+// drains, debounces and classifies (input_decoder.h). Every edge also wakes the loop task, so
+// loop() sleeps in input_wait() instead of polling on a fixed delay.
 enum class InputEvent {
     NONE,
     ENCODER_UP,
     ENCODER_DOWN,
-    ENCODER_PRESS
+    ENCODER_PRESS,          // Click, reported on release
+    ENCODER_DOUBLE_PRESS,   // Second click within BUTTON_DOUBLE_CLICK_MS, after its own ENCODER_PRESS
+    ENCODER_LONG_PRESS      // Held for BUTTON_LONG_PRESS_MS, reported while still held
 };
 
-void input_init();
-InputEvent input_get_event(); // Polling based
-void input_rotary_loop(); // If using RotaryEncoder library's loop method
-
-// For LVGL integration (if not polling)
-typedef void (*lvgl_encoder_cb_t)(int8_t diff, lv_indev_state_t state);
-void input_set_lvgl_cb(lvgl_encoder_cb_t cb);
-
-int8_t get_encoder_diff();
-bool is_encoder_pressed();
-void clear_encoder_state();
+struct InputEventInfo {
+    InputEvent type;
+    int8_t steps;           // Detents turned (positive = ENCODER_DOWN), 0 for button events
+    uint32_t t_us;          // esp_timer time of the edge that caused it, for input-to-display latency
+};
 
+// Call from the loop task: that task is the one the ISRs wake
+void input_init();
+// Next pending event, or false once there are none. Encoder turns since the last call are
+// reported as one event with the net step count.
+bool input_next_event(InputEventInfo* out);
+// Sleeps until an input edge arrives, a pending long press/settling edge is due, or `max_ms`
+// passes. Returns immediately if edges are already waiting.
+void input_wait(uint32_t max_ms);
+// Ends the loop task's input_wait() early from another task, e.g. when a result for loop() is queued
+void input_wake();
 
-#endif // INPUT_HANDLER_H
\ No newline at end of file
+#endif // INPUT_HANDLER_H
@@ -6,9 +6,11 @@
 #include "camera_handler.h"
 #include "sign_language_model.h"
 #include "notifications.h"
-
-// For TFLite model input buffer
-uint8_t model_input_buf[TFLITE_MODEL_INPUT_HEIGHT * TFLITE_MODEL_INPUT_WIDTH * TFLITE_MODEL_INPUT_CHANNELS];
+#include "signing_pipeline.h"
+#include "trace.h"
+#include "wifi_handler.h"
+#include "boot_sequencer.h"
+#include "wire_protocol.h"
 
 // State machine or application mode
 enum class AppMode {
@@ -18,15 +20,46 @@ enum class AppMode {
     SIGNING // Capturing and processing sign language
 };
 AppMode current_mode = AppMode::IDLE;
+AppMode previous_mode = AppMode::IDLE; // Used to start/stop the signing pipeline on mode changes
 
 int selected_quick_response_idx = 0;
 unsigned long last_activity_time = 0;
 const unsigned long MESSAGE_DISPLAY_TIMEOUT_MS = 10000; // 10 seconds
 const unsigned long SIGNING_TIMEOUT_MS = 15000; // 15 seconds in signing mode
+unsigned long last_telemetry_time = 0;
+unsigned long last_signing_time = 0; // When SIGNING was last left, for the camera power-down
+BootStatus last_boot_status = BootStatus::RUNNING;
+bool boot_milestones_published = false;
+uint16_t wire_seq = 0;
+
 
+#if LATENCY_STAMPS_ENABLED
+// Numeric value of `"key":` in a flat JSON object, e.g. Grokcom's {"id": 7, "t0": 1234.5}
+static bool json_number(const char* json, const char* key, double* out) {
+    char quoted[16];
+    snprintf(quoted, sizeof(quoted), "\"%s\"", key);
+    const char* p = strstr(json, quoted);
+    if (!p) return false;
+    p += strlen(quoted);
+    while (*p == ' ') ++p;
+    if (*p++ != ':') return false;
+    char* end;
+    *out = strtod(p, &end);
+    return end != p && isfinite(*out);
+}
+
+static bool parse_timesync_ping(const char* json, unsigned long* id, double* t0) {
+    double id_value;
+    if (!json_number(json, "id", &id_value) || !json_number(json, "t0", t0)) return false;
+    if (id_value < 0 || id_value > 4294967295.0 || id_value != (unsigned long)id_value) return false;
+    *id = (unsigned long)id_value;
+    return *t0 >= 0 && *t0 < 1e15; // Host monotonic ms; keeps the %.3f echo short
+}
+#endif
 
 // MQTT Callback function
 void mqtt_callback(char* topic, byte* payload, unsigned int length) {
+    uint32_t received_ms = millis();
     Serial.print("Message arrived [");
     Serial.print(topic);
     Serial.print("] ");
@@ -42,6 +75,22 @@ void mqtt_callback(char* topic, byte* payload, unsigned int length) {
         current_mode = AppMode::SHOWING_MESSAGE;
         last_activity_time = millis();
     }
+#if LATENCY_STAMPS_ENABLED
+    else if (strcmp(topic, MQTT_TOPIC_TIMESYNC_PING) == 0) {
+        // Echo the ping with our clock so Grokcom can map our stamps onto its own (latency.py).
+        // Only the parsed id and t0 go back out, never the payload itself.
+        unsigned long ping_id;
+        double ping_t0;
+        if (!parse_timesync_ping(msg_buffer, &ping_id, &ping_t0)) {
+            Serial.println("Malformed timesync ping, not answered");
+            return;
+        }
+        char reply[128];
+        snprintf(reply, sizeof(reply), "{\"dev_id\":%u,\"t1\":%u,\"ping\":{\"id\":%lu,\"t0\":%.3f}}",
+                 (unsigned)wire_device_id(MQTT_CLIENT_ID), (unsigned)received_ms, ping_id, ping_t0);
+        mqtt_publish(MQTT_TOPIC_TIMESYNC_PONG, reply);
+    }
+#endif
 }
 
 void setup() {
@@ -50,54 +99,161 @@ void setup() {
     Serial.println("Grokband Starting...");
 
     notification_init();
-    input_init(); // Before display if display uses input for LVGL
+    input_init(); // From the loop task: input edges wake this task out of input_wait()
     display_init(); // LVGL init
-    
-    // Example of how LVGL input might be set up (if using its indev system)
-    // static lv_indev_drv_t indev_drv;
-    // lv_indev_drv_init(&indev_drv);
-    // indev_drv.type = LV_INDEV_TYPE_ENCODER;
-    // indev_drv.read_cb = lvgl_encoder_read_fake; // from input_handler.cpp
-    // lv_indev_t *encoder_indev = lv_indev_drv_register(&indev_drv);
-    // You also need to associate this indev with a group and objects if objects are to be focused/clicked by encoder.
-
-    display_show_status("Connecting WiFi...");
-    setup_wifi();
-    display_show_status("Connecting MQTT...");
-    setup_mqtt(mqtt_callback);
-
-    display_show_status("Initializing Camera...");
-    if (!camera_init()) {
-        display_show_message("Camera Init Failed!");
-        // Maybe enter a fault state
-        while(1) delay(1000);
-    }
-
-    display_show_status("Initializing TFLite...");
-    if (!tflite_init()) {
-        display_show_message("TFLite Init Failed!");
-        // Maybe enter a fault state
-        while(1) delay(1000);
-    }
-    
+    display_set_quick_responses(quick_responses, NUM_QUICK_RESPONSES);
+    boot_mark(BootMilestone::DISPLAY_READY);
+
+    // WiFi associates while the camera, model and pipeline come up on core 0 (boot_sequencer.h);
+    // loop() starts immediately and poll_boot() reports when signing is available.
+    wifi_start();
+    boot_mark(BootMilestone::WIFI_STARTED);
+    boot_start_background();
+    setup_mqtt(mqtt_callback); // Non-blocking: connects from mqtt_loop() once WiFi is up
+
     display_show_message("Grokband Ready");
-    display_show_status(is_mqtt_connected() ? "MQTT Connected" : "MQTT Disconnected");
+    display_show_status("Loading model...");
     current_mode = AppMode::IDLE;
     last_activity_time = millis();
 
-    // Quick test for notifications
-    // notification_alert_message(true); 
-    // delay(1000);
+    // Quick test for notifications (returns immediately; the pattern plays from a timer)
+    // notification_alert_message(true);
+}
+
+
+// Reacts to the background init finishing (or failing) and publishes the boot milestones once
+void poll_boot() {
+    BootStatus status = boot_status();
+    if (status != last_boot_status) {
+        last_boot_status = status;
+        switch (status) {
+            case BootStatus::READY:
+                display_show_status(is_mqtt_connected() ? "MQTT Connected" : "MQTT Disconnected");
+                notification_play(Notification::READY);
+                Serial.printf("Boot to ready: %u ms, free heap: %u bytes\n",
+                              (unsigned)boot_milestone_ms(BootMilestone::PIPELINE_READY), ESP.getFreeHeap());
+                break;
+            case BootStatus::CAMERA_FAILED:
+                display_show_message("Camera Init Failed!");
+                notification_play(Notification::ERROR);
+                break;
+            case BootStatus::MODEL_FAILED:
+                display_show_message("TFLite Init Failed!");
+                notification_play(Notification::ERROR);
+                break;
+            case BootStatus::PIPELINE_FAILED:
+                display_show_message("Pipeline Init Failed!");
+                notification_play(Notification::ERROR);
+                break;
+            case BootStatus::RUNNING: break;
+        }
+        boot_log_milestones();
+    }
+    // Messaging keeps working after an init failure; only signing stays unavailable
+    if (!boot_milestones_published && status != BootStatus::RUNNING && is_mqtt_connected()) {
+        char payload[256];
+        if (boot_format_milestones(payload, sizeof(payload), MQTT_CLIENT_ID)) {
+            mqtt_publish(MQTT_TOPIC_TELEMETRY, payload);
+        }
+        boot_milestones_published = true;
+    }
+}
+
+// Sends recognized signs / quick responses as one binary frame (wire_protocol.h), or as the
+// legacy label text when WIRE_PROTOCOL_BINARY is off: one publish per record, no metadata.
+void publish_frame(const char* topic, WireFrame& frame) {
+    frame.seq = wire_seq++;
+    frame.device_id = wire_device_id(MQTT_CLIENT_ID);
+#if WIRE_PROTOCOL_BINARY
+    uint8_t buf[WIRE_MAX_FRAME_SIZE];
+    WireStatus status;
+    size_t len = wire_encode(frame, buf, sizeof(buf), &status);
+    if (len) {
+        mqtt_publish_binary(topic, buf, len);
+        return;
+    }
+    Serial.printf("Wire encode failed (%s); sending text\n", wire_status_name(status));
+#endif
+    for (int i = 0; i < frame.count; ++i) {
+        uint16_t id = frame.records[i].class_id;
+        mqtt_publish(topic, frame.type == WireMsgType::SIGN ? get_class_label(id)
+                            : id < NUM_QUICK_RESPONSES ? quick_responses[id] : "?");
+    }
+}
+
+// Pipeline stamps are micros(); frame times and Grokcom's clock sync use millis().
+// Converted by age so neither counter's wrap matters.
+uint32_t micros_to_millis(uint32_t t_us) {
+    return millis() - ((uint32_t)micros() - t_us) / 1000;
+}
+
+#if LATENCY_STAMPS_ENABLED
+// Capture, inference-done and publish times of the sign frame just sent, joined with
+// Grokcom's receive and playback stamps by (device_id, seq)
+void publish_latency_stamps(const WireFrame& frame, uint32_t capture_ms, uint32_t infer_ms) {
+    char payload[160];
+    snprintf(payload, sizeof(payload), "{\"dev_id\":%u,\"seq\":%u,\"capture\":%u,\"infer\":%u,\"publish\":%u}",
+             (unsigned)frame.device_id, (unsigned)frame.seq, (unsigned)capture_ms, (unsigned)infer_ms,
+             (unsigned)millis());
+    mqtt_publish(MQTT_TOPIC_LATENCY, payload);
 }
+#endif
 
+// Publishes the per-stage latency summary of the last window (see trace.h)
+void publish_telemetry() {
+    char payload[512];
+    if (trace_format_summary(payload, sizeof(payload), MQTT_CLIENT_ID, millis())) {
+        mqtt_publish(MQTT_TOPIC_TELEMETRY, payload);
+    }
+}
 
 void loop() {
-    mqtt_loop(); // Keep MQTT connection alive and process incoming
-    display_update_loop(); // Keep LVGL refreshing
+    uint32_t loop_start = trace_begin();
+    {
+        TRACE_SCOPE(TraceStage::MQTT_LOOP);
+        mqtt_loop(); // Keep MQTT connection alive and process incoming
+    }
+    uint32_t lvgl_next_ms;
+    {
+        TRACE_SCOPE(TraceStage::LVGL);
+        lvgl_next_ms = display_update_loop(); // Keep LVGL refreshing
+    }
+    poll_boot();
 
-    // Non-LVGL direct input handling (simpler for start)
-    int8_t encoder_change = get_encoder_diff(); // From input_handler
-    bool encoder_pressed = is_encoder_pressed(); // From input_handler
+    // Drain input: net encoder steps plus the button actions since the last pass
+    int8_t encoder_change = 0;
+    bool encoder_pressed = false;
+    bool encoder_long_pressed = false;
+    bool have_input = false;
+    uint32_t input_us = 0; // Oldest edge handled this pass
+    InputEventInfo event;
+    while (input_next_event(&event)) {
+        if (!have_input) input_us = event.t_us;
+        have_input = true;
+        switch (event.type) {
+            case InputEvent::ENCODER_UP:
+            case InputEvent::ENCODER_DOWN: encoder_change += event.steps; break;
+            case InputEvent::ENCODER_PRESS: encoder_pressed = true; break;
+            case InputEvent::ENCODER_LONG_PRESS: encoder_long_pressed = true; break;
+            default: break;
+        }
+    }
+
+    // Long press starts signing from any other mode, and stops it from signing mode. Handled
+    // before the mode-edge block below, so the pipeline is started (and its stale results
+    // dropped) before the SIGNING case reads any
+    if (encoder_long_pressed) {
+        if (current_mode == AppMode::SIGNING) {
+            display_show_message("Signing stopped.");
+            current_mode = AppMode::IDLE;
+        } else {
+            current_mode = AppMode::SIGNING;
+            Serial.println("Mode: SIGNING");
+        }
+        last_activity_time = millis();
+        encoder_pressed = false;
+        encoder_change = 0;
+    }
 
     // Timeout to return to IDLE from message display or quick response
     if ((current_mode == AppMode::SHOWING_MESSAGE || current_mode == AppMode::QUICK_RESPONSE_NAV) &&
@@ -111,28 +267,48 @@ void loop() {
         current_mode = AppMode::IDLE;
     }
 
+    // The pipeline tasks only run while in SIGNING so the camera and core 1 are free otherwise.
+    // The camera streams only then too: standby in the other modes, powered down after a while.
+    if (current_mode != previous_mode) {
+        if (current_mode == AppMode::SIGNING && !boot_models_ready()) {
+            display_show_message(boot_status() == BootStatus::RUNNING ? "Model loading..." : "Signing unavailable");
+            current_mode = AppMode::IDLE;
+        } else if (current_mode == AppMode::SIGNING && !camera_set_power(CameraPower::STREAMING)) {
+            display_show_message("Camera unavailable");
+            current_mode = AppMode::IDLE;
+        } else if (current_mode == AppMode::SIGNING) {
+            display_show_message("Signing...");
+            signing_pipeline_start();
+        } else if (previous_mode == AppMode::SIGNING) {
+            signing_pipeline_stop();
+            camera_set_power(CameraPower::STANDBY);
+            last_signing_time = millis();
+        }
+        previous_mode = current_mode;
+    }
+    // Not gated on the models: after a model boot failure the camera must still power down
+    if (current_mode != AppMode::SIGNING && camera_get_power() == CameraPower::STANDBY &&
+        millis() - last_signing_time > CAMERA_POWER_DOWN_AFTER_MS) {
+        camera_set_power(CameraPower::POWER_DOWN);
+    }
 
     switch (current_mode) {
         case AppMode::IDLE:
             if (encoder_pressed) {
-                // Enter quick response mode or signing mode
-                // Let's say short press = quick response, long press = signing
-                // For now, any press goes to quick response
+                // Short press = quick response, long press = signing (handled above)
                 current_mode = AppMode::QUICK_RESPONSE_NAV;
                 selected_quick_response_idx = 0;
-                display_show_quick_responses_ui(quick_responses, NUM_QUICK_RESPONSES, selected_quick_response_idx);
+                display_show_quick_responses(selected_quick_response_idx);
                 last_activity_time = millis();
                 Serial.println("Mode: QUICK_RESPONSE_NAV");
             }
-            // Potentially add a way to enter SIGNING mode (e.g., double click, or if no quick responses selected)
-            // Or a dedicated "start signing" UI option in quick responses.
             break;
 
         case AppMode::SHOWING_MESSAGE:
             if (encoder_pressed) { // Acknowledge message / go to quick reply
                 current_mode = AppMode::QUICK_RESPONSE_NAV;
                 selected_quick_response_idx = 0;
-                display_show_quick_responses_ui(quick_responses, NUM_QUICK_RESPONSES, selected_quick_response_idx);
+                display_show_quick_responses(selected_quick_response_idx);
                 last_activity_time = millis();
                 Serial.println("Mode: QUICK_RESPONSE_NAV from SHOWING_MESSAGE");
             }
@@ -140,15 +316,18 @@ void loop() {
 
         case AppMode::QUICK_RESPONSE_NAV:
             if (encoder_change != 0) {
-                selected_quick_response_idx += encoder_change;
-                if (selected_quick_response_idx < 0) selected_quick_response_idx = NUM_QUICK_RESPONSES - 1;
-                if (selected_quick_response_idx >= NUM_QUICK_RESPONSES) selected_quick_response_idx = 0;
-                display_show_quick_responses_ui(quick_responses, NUM_QUICK_RESPONSES, selected_quick_response_idx);
+                // Moves focus in the pre-built list (wrapping); only the two items involved redraw
+                display_encoder_feed(encoder_change);
+                selected_quick_response_idx = display_quick_response_selected();
                 last_activity_time = millis();
             }
             if (encoder_pressed) {
                 const char* resp = quick_responses[selected_quick_response_idx];
-                mqtt_publish(MQTT_TOPIC_QUICK_RESPONSE, resp);
+                WireFrame frame = {};
+                frame.type = WireMsgType::QUICK_RESPONSE;
+                frame.count = 1;
+                frame.records[0] = { (uint16_t)selected_quick_response_idx, 255, 0, (uint32_t)millis() };
+                publish_frame(MQTT_TOPIC_QUICK_RESPONSE, frame);
                 display_show_message("Sent Quick Resp.");
                 current_mode = AppMode::SHOWING_MESSAGE; // Show confirmation
                 last_activity_time = millis();
@@ -156,64 +335,76 @@ void loop() {
             }
             break;
 
-        case AppMode::SIGNING:
-            // This is the core loop for sign language recognition
-            // Should be triggered by user action (e.g. from menu or long press)
-            display_show_message("Signing...");
-            camera_fb_t* fb = camera_capture_frame();
-            if (fb) {
-                // Preprocess the frame
-                // Ensure your camera is set to a format preprocess_camera_frame can handle,
-                // or that preprocess_camera_frame does the necessary conversions (e.g. JPEG decode, RGB2GRAY)
-                if (preprocess_camera_frame(fb, model_input_buf, TFLITE_MODEL_INPUT_WIDTH, TFLITE_MODEL_INPUT_HEIGHT, TFLITE_MODEL_INPUT_CHANNELS)) {
-                    // Run inference
-                    float scores[TFLITE_NUM_CLASSES];
-                    int detected_class_idx = tflite_predict(model_input_buf, scores);
-                    
-                    if (detected_class_idx != -1) {
-                        const char* sign_label = get_class_label(detected_class_idx);
-                        char msg_to_send[64];
-                        snprintf(msg_to_send, sizeof(msg_to_send), "%s (%.2f)", sign_label, scores[detected_class_idx]);
-                        
-                        display_show_message(msg_to_send); // Show what was detected
-                        mqtt_publish(MQTT_TOPIC_SIGN_TO_TEXT, sign_label); // Send just the label
-                        Serial.print("Detected Sign: "); Serial.println(sign_label);
-                        
-                        // Potentially: Add logic to accumulate signs for a sentence before sending
-                        // Or exit signing mode after one sign
-                        current_mode = AppMode::IDLE; // Exit signing mode after one detection for now
-                        display_show_message("Sent Sign."); // Confirmation
-                        last_activity_time = millis();
-
-                    } else {
-                        // Serial.println("No sign detected or low confidence.");
-                        // Keep trying or show "no detection" on display
-                    }
-                } else {
+        case AppMode::SIGNING: {
+            // Capture, preprocessing, inference and gesture segmentation run in the signing
+            // pipeline tasks; each result here is one completed sign. Everything recognized since
+            // the last pass (both hands, or a backlog) goes out as one batched frame.
+            WireFrame frame = {};
+            frame.type = WireMsgType::SIGN;
+            uint32_t first_capture_ms = 0, first_infer_ms = 0;
+            SignResult result;
+            while (current_mode == AppMode::SIGNING && signing_pipeline_get_result(&result)) {
+                if (!result.ok) {
                     Serial.println("Frame preprocessing failed.");
                     display_show_message("Preprocessing err");
                     current_mode = AppMode::IDLE;
+                } else if (result.class_idx != -1 && frame.count < WIRE_MAX_RECORDS) {
+                    WireRecord& record = frame.records[frame.count++];
+                    record.class_id = (uint16_t)result.class_idx;
+                    record.confidence = wire_quantize_confidence(result.score);
+                    record.flags = result.hand ? WIRE_FLAG_RIGHT_HAND : 0;
+                    record.t_ms = micros_to_millis(result.capture_us);
+                    if (frame.count == 1) {
+                        first_capture_ms = record.t_ms;
+                        first_infer_ms = micros_to_millis(result.capture_us + result.latency_us);
+                    }
+                    Serial.print("Detected Sign: "); Serial.print(get_class_label(result.class_idx));
+                    Serial.print(" latency(us): "); Serial.println(result.latency_us);
                 }
-                camera_return_frame(fb); // IMPORTANT: return frame buffer
-            } else {
-                Serial.println("Failed to capture frame.");
-                display_show_message("Cam Capture Err");
-                current_mode = AppMode::IDLE;
             }
-            // For continuous signing, remove return to IDLE until user explicitly exits
-            // last_activity_time = millis(); // Keep resetting timeout if in continuous mode
+            if (frame.count > 0) {
+                const WireRecord& last = frame.records[frame.count - 1];
+                char msg_to_send[64];
+                snprintf(msg_to_send, sizeof(msg_to_send), "%s (%.2f)", get_class_label(last.class_id),
+                         wire_dequantize_confidence(last.confidence));
+                display_show_message(msg_to_send); // Show what was detected
+                publish_frame(MQTT_TOPIC_SIGN_TO_TEXT, frame);
+#if LATENCY_STAMPS_ENABLED
+                publish_latency_stamps(frame, first_capture_ms, first_infer_ms);
+#endif
+                notification_play(Notification::SIGN_SENT);
+                last_activity_time = millis(); // Each sign extends SIGNING_TIMEOUT_MS
+#if !SIGNING_CONTINUOUS
+                current_mode = AppMode::IDLE; // One sign per long press
+                display_show_message("Sent Sign."); // Confirmation
+#endif
+            }
             break;
+        }
     }
 
-    // One way to enter signing mode (e.g. from IDLE, with a longer press or specific UI choice)
-    // This logic is currently missing, you'd need to differentiate encoder presses
-    // or add a "Start Signing" option to the quick response menu.
-    // For now, let's assume if IDLE and a rotary click happens, it goes to QUICK_RESPONSE_NAV.
-    // If another click happens in QUICK_RESPONSE_NAV on a special "Start Sign" item, then mode becomes SIGNING.
-    // Or, as a HACK for testing, if encoder is pressed AND HELD for >1 second while IDLE, go to SIGNING.
-    // This requires more advanced input handling than currently implemented.
-    // For now, you can manually change current_mode to AppMode::SIGNING in setup for testing:
-    // if(setup_is_done) current_mode = AppMode::SIGNING; 
+    // Input-to-display latency: draw now rather than on the next LVGL refresh timer, and
+    // time it from the ISR timestamp of the edge
+    if (have_input) {
+        uint32_t redraw_px = display_refresh_now();
+        trace_record_us(TraceStage::INPUT_LATENCY, (uint32_t)micros() - input_us);
+        if (redraw_px > DISPLAY_REDRAW_BUDGET_PX && current_mode == AppMode::QUICK_RESPONSE_NAV && encoder_change != 0) {
+            Serial.printf("Detent redraw over budget: %u px\n", (unsigned)redraw_px);
+        }
+    }
 
-    delay(10); // Small delay to prevent busy-looping too fast
+    trace_collect();
+    if (TRACE_PUBLISH_INTERVAL_MS && millis() - last_telemetry_time >= TRACE_PUBLISH_INTERVAL_MS) {
+        last_telemetry_time = millis();
+        publish_telemetry();
+    }
+    trace_end(TraceStage::LOOP, loop_start);
+
+    // Sleep until input arrives or LVGL/MQTT next need servicing; a mode change just made
+    // (e.g. starting the signing pipeline) is acted on right away
+    uint32_t delay_start = trace_begin();
+    if (current_mode == previous_mode) {
+        input_wait(min(lvgl_next_ms, (uint32_t)LOOP_MAX_IDLE_MS));
+    }
+    trace_end(TraceStage::LOOP_DELAY, delay_start);
 }
\ No newline at end of file
@@ -0,0 +1,48 @@
+#ifndef MODEL_INPUT_H
+#define MODEL_INPUT_H
+
+#include <stdint.h>
+
+// View of the interpreter's input tensor handed to the preprocessing stage, so pixels are
+// written exactly once, already in the tensor's native type.
+enum class ModelInputType : uint8_t {
+    UINT8,
+    INT8,
+    FLOAT32
+};
+
+struct ModelInput {
+    void* data;             // Interpreter-owned tensor storage, frames * width * height * channels elements per batch slot
+    ModelInputType type;
+    int width;
+    int height;
+    int channels;
+    int batch;              // Slots in the tensor's batch dimension (1 for most models)
+    int frames;             // Temporal models ([batch, frames, H, W, C]): consecutive frames per slot, oldest first; else 1
+    const void* lut;        // 256 entries of `type`: 8-bit pixel -> normalized/quantized tensor value
+};
+
+// Bytes of one frame (one image) of the input
+inline int model_input_frame_bytes(const ModelInput& input) {
+    const int elem = input.type == ModelInputType::FLOAT32 ? 4 : 1;
+    return input.width * input.height * input.channels * elem;
+}
+
+// View of batch slot `slot`, so a preprocessor can fill one image of a batched input
+inline ModelInput model_input_slot(const ModelInput& input, int slot) {
+    ModelInput view = input;
+    view.data = static_cast<uint8_t*>(input.data) + slot * input.frames * model_input_frame_bytes(input);
+    view.batch = 1;
+    return view;
+}
+
+// Same format as `input`, one frame, stored at `data` (e.g. a FrameHistory slot)
+inline ModelInput model_input_frame_at(const ModelInput& input, void* data) {
+    ModelInput view = input;
+    view.data = data;
+    view.batch = 1;
+    view.frames = 1;
+    return view;
+}
+
+#endif // MODEL_INPUT_H
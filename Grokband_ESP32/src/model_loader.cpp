@@ -0,0 +1,160 @@
+#include "model_loader.h"
+#include <string.h>
+
+#if defined(ESP_PLATFORM)
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "esp_log.h"
+static const char* TAG = "model_loader";
+#define LOADER_LOGI(fmt, ...) ESP_LOGI(TAG, fmt, ##__VA_ARGS__)
+#define LOADER_LOGW(fmt, ...) ESP_LOGW(TAG, fmt, ##__VA_ARGS__)
+#else
+// Host stand-in: the "partition" is a file named by $GROKBAND_<LABEL>_PARTITION
+// ($GROKBAND_MODEL_PARTITION, $GROKBAND_HAND_DET_PARTITION), mapped read-only, so validation
+// and lookup can be exercised on Linux with the same images we flash.
+#include <ctype.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define LOADER_LOGI(fmt, ...) fprintf(stderr, "I model_loader: " fmt "\n", ##__VA_ARGS__)
+#define LOADER_LOGW(fmt, ...) fprintf(stderr, "W model_loader: " fmt "\n", ##__VA_ARGS__)
+#endif
+
+static_assert(sizeof(ModelImageHeader) == 32, "ModelImageHeader layout is shared with scripts/pack_model.py");
+
+namespace {
+    uint32_t crc32(const uint8_t* data, size_t len) {
+#if defined(ESP_PLATFORM)
+        return esp_rom_crc32_le(0, data, len); // ROM table implementation, same result as zlib.crc32
+#else
+        uint32_t crc = 0xFFFFFFFFu;
+        for (size_t i = 0; i < len; ++i) {
+            crc ^= data[i];
+            for (int k = 0; k < 8; ++k) {
+                crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+            }
+        }
+        return ~crc;
+#endif
+    }
+}
+
+ModelImageStatus model_image_validate(const uint8_t* image, size_t image_len, uint16_t expected_schema,
+                                      const uint8_t** model, size_t* model_len) {
+    if (!image || image_len < sizeof(ModelImageHeader)) return ModelImageStatus::TOO_SMALL;
+
+    ModelImageHeader header;
+    memcpy(&header, image, sizeof(header)); // Flash mappings are fine with this; avoids alignment assumptions
+    if (header.magic != MODEL_IMAGE_MAGIC) return ModelImageStatus::BAD_MAGIC;
+    if (header.header_version != MODEL_IMAGE_HEADER_VERSION) return ModelImageStatus::BAD_HEADER_VERSION;
+    if (header.schema_version != expected_schema) return ModelImageStatus::BAD_SCHEMA_VERSION;
+    if (header.model_size == 0 || header.model_size > image_len - sizeof(header)) return ModelImageStatus::BAD_SIZE;
+
+    const uint8_t* data = image + sizeof(header);
+    if (crc32(data, header.model_size) != header.model_crc32) return ModelImageStatus::BAD_CRC;
+
+    if (model) *model = data;
+    if (model_len) *model_len = header.model_size;
+    return ModelImageStatus::OK;
+}
+
+const char* model_image_status_name(ModelImageStatus status) {
+    switch (status) {
+        case ModelImageStatus::OK: return "ok";
+        case ModelImageStatus::TOO_SMALL: return "image too small";
+        case ModelImageStatus::BAD_MAGIC: return "bad magic (partition not written?)";
+        case ModelImageStatus::BAD_HEADER_VERSION: return "unsupported header version";
+        case ModelImageStatus::BAD_SCHEMA_VERSION: return "schema version mismatch";
+        case ModelImageStatus::BAD_SIZE: return "model size exceeds partition";
+        case ModelImageStatus::BAD_CRC: return "CRC mismatch";
+    }
+    return "unknown";
+}
+
+#if defined(ESP_PLATFORM)
+
+bool model_map_from_partition(const char* label, uint16_t expected_schema, const uint8_t** model, size_t* model_len) {
+    const esp_partition_t* part = esp_partition_find_first(
+        ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)MODEL_PARTITION_SUBTYPE, label);
+    if (!part) {
+        LOADER_LOGW("No '%s' partition in the partition table", label);
+        return false;
+    }
+
+    // Read just the header first so only the model's pages get mapped, not the whole partition
+    ModelImageHeader header;
+    if (esp_partition_read(part, 0, &header, sizeof(header)) != ESP_OK) {
+        LOADER_LOGW("Failed to read '%s' partition header", label);
+        return false;
+    }
+    size_t map_len = sizeof(header) + header.model_size;
+    if (header.magic != MODEL_IMAGE_MAGIC || map_len > part->size) {
+        map_len = sizeof(header); // Let model_image_validate() report what is wrong
+    }
+
+    const void* mapped = nullptr;
+    esp_partition_mmap_handle_t handle;
+    esp_err_t err = esp_partition_mmap(part, 0, map_len, ESP_PARTITION_MMAP_DATA, &mapped, &handle);
+    if (err != ESP_OK) {
+        LOADER_LOGW("esp_partition_mmap failed: %s", esp_err_to_name(err));
+        return false;
+    }
+
+    size_t len = 0; // model_len may be null
+    ModelImageStatus status = model_image_validate((const uint8_t*)mapped, map_len, expected_schema, model, &len);
+    if (status != ModelImageStatus::OK) {
+        LOADER_LOGW("Model partition '%s' rejected: %s", label, model_image_status_name(status));
+        esp_partition_munmap(handle);
+        return false;
+    }
+    if (model_len) *model_len = len;
+    LOADER_LOGI("Model mapped from partition '%s' at 0x%x, %u bytes",
+                part->label, (unsigned)part->address, (unsigned)len);
+    return true;
+}
+
+#else
+
+bool model_map_from_partition(const char* label, uint16_t expected_schema, const uint8_t** model, size_t* model_len) {
+    char var[64];
+    int n = snprintf(var, sizeof(var), "GROKBAND_%s_PARTITION", label);
+    for (int i = 0; i < n && i < (int)sizeof(var); ++i) var[i] = (char)toupper((unsigned char)var[i]);
+    const char* path = getenv(var);
+    if (!path) {
+        LOADER_LOGW("%s is not set", var);
+        return false;
+    }
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        LOADER_LOGW("Cannot open %s", path);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        LOADER_LOGW("%s is empty", path);
+        close(fd);
+        return false;
+    }
+    void* mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        LOADER_LOGW("mmap of %s failed", path);
+        return false;
+    }
+
+    size_t len = 0;
+    ModelImageStatus status = model_image_validate((const uint8_t*)mapped, st.st_size, expected_schema, model, &len);
+    if (status != ModelImageStatus::OK) {
+        LOADER_LOGW("Model image %s rejected: %s", path, model_image_status_name(status));
+        munmap(mapped, st.st_size);
+        return false;
+    }
+    if (model_len) *model_len = len;
+    LOADER_LOGI("Model mapped from %s, %zu bytes", path, len);
+    return true;
+}
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef MODEL_LOADER_H
+#define MODEL_LOADER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Model image as written to the `model` data partition by scripts/pack_model.py:
+// this header followed directly by the .tflite flatbuffer. The model is used in place
+// through a flash mmap, so it costs no heap and no copy at boot.
+#define MODEL_IMAGE_MAGIC 0x444D4247u // "GBMD"
+#define MODEL_IMAGE_HEADER_VERSION 1
+#define MODEL_PARTITION_LABEL "model"
+#define HAND_DETECTOR_PARTITION_LABEL "hand_det" // Stage-1 model of the cascade, same image format
+#define MODEL_PARTITION_SUBTYPE 0x40  // Custom data subtype, see partitions.csv
+
+struct ModelImageHeader {
+    uint32_t magic;
+    uint16_t header_version;
+    uint16_t schema_version;   // TFLite schema version the model was converted with
+    uint32_t model_size;       // Bytes of flatbuffer following the header
+    uint32_t model_crc32;      // CRC-32 (zlib polynomial) of the flatbuffer
+    uint32_t reserved[4];      // Pads the header to 32 bytes so the model stays 16-byte aligned
+};
+
+enum class ModelImageStatus {
+    OK,
+    TOO_SMALL,
+    BAD_MAGIC,
+    BAD_HEADER_VERSION,
+    BAD_SCHEMA_VERSION,
+    BAD_SIZE,
+    BAD_CRC
+};
+
+// Checks the header and CRC of an image of `image_len` bytes. On OK, *model/*model_len
+// point at the flatbuffer inside the image.
+ModelImageStatus model_image_validate(const uint8_t* image, size_t image_len, uint16_t expected_schema,
+                                      const uint8_t** model, size_t* model_len);
+const char* model_image_status_name(ModelImageStatus status);
+
+// Finds the model partition `label`, maps it and validates it. The mapping is kept for the life
+// of the firmware. Returns false (and logs why) if there is no usable image.
+bool model_map_from_partition(const char* label, uint16_t expected_schema, const uint8_t** model, size_t* model_len);
+
+#endif // MODEL_LOADER_H
@@ -0,0 +1,107 @@
+#include "motion_gate.h"
+#include <string.h>
+
+namespace {
+    constexpr int kBackgroundShift = 2;    // Background alpha = 1/4: a hand at rest is absorbed within ~6 frames (reference_ keeps it)
+    constexpr int kNoiseShift = 5;         // Noise EMA alpha = 1/32
+    constexpr int kThresholdGain = 3;      // Pixel threshold = 3x mean noise...
+    constexpr int kMinThreshold = 6;       // ...but never below sensor quantization/JPEG ringing
+    constexpr int kMaxThreshold = 48;
+    constexpr uint16_t kInitialNoiseQ8 = 4 << 8;
+}
+
+MotionGate::MotionGate(uint16_t min_changed_q8, int hangover, int max_hold)
+    : noise_q8_(kInitialNoiseQ8), min_changed_q8_(min_changed_q8), hangover_(hangover), max_hold_(max_hold) {}
+
+void MotionGate::reset() {
+    seeded_ = false;
+    hangover_left_ = 0;
+    held_frames_ = 0;
+    noise_q8_ = kInitialNoiseQ8;
+}
+
+bool MotionGate::update(const LumaThumb& thumb, CropRect region) {
+    const int n = thumb.w * thumb.h;
+    if (!seeded_ || thumb.w != w_ || thumb.h != h_) {
+        for (int i = 0; i < n; ++i) background_[i] = (uint16_t)(thumb.luma[i] << 8);
+        memcpy(reference_, thumb.luma, n);
+        memset(motion_, 0, sizeof(motion_));
+        w_ = thumb.w;
+        h_ = thumb.h;
+        seeded_ = true;
+        hangover_left_ = hangover_;
+        stats_.frames_passed++;
+        return true;
+    }
+
+    // Clamp the region to the thumbnail
+    int x0 = region.x < 0 ? 0 : region.x;
+    int y0 = region.y < 0 ? 0 : region.y;
+    int x1 = region.x + region.w > w_ ? w_ : region.x + region.w;
+    int y1 = region.y + region.h > h_ ? h_ : region.y + region.h;
+    if (x1 <= x0 || y1 <= y0) { x0 = 0; y0 = 0; x1 = w_; y1 = h_; }
+
+    int threshold = (noise_q8_ * kThresholdGain) >> 8;
+    if (threshold < kMinThreshold) threshold = kMinThreshold;
+    if (threshold > kMaxThreshold) threshold = kMaxThreshold;
+
+    // Difference over the whole thumbnail: the ROI tracker needs the motion mask outside the
+    // current region too, and at 1/4 scale this is a few thousand pixels
+    memset(motion_, 0, sizeof(motion_));
+    uint32_t changed = 0;
+    uint32_t present = 0;
+    uint32_t diff_sum = 0;
+    for (int y = 0; y < h_; ++y) {
+        const uint8_t* px = thumb.luma + y * w_;
+        uint16_t* bg = background_ + y * w_;
+        const uint8_t* ref = reference_ + y * w_;
+        const bool in_rows = y >= y0 && y < y1;
+        for (int x = 0; x < w_; ++x) {
+            int d = (int)px[x] - (bg[x] >> 8);
+            if (d < 0) d = -d;
+            int32_t delta = ((int32_t)px[x] << 8) - bg[x];
+            bg[x] = (uint16_t)(bg[x] + (delta >> kBackgroundShift));
+            if (d > threshold) thumb_set_bit(motion_, y * w_ + x);
+            if (in_rows && x >= x0 && x < x1) {
+                diff_sum += d;
+                changed += d > threshold;
+                int r = (int)px[x] - ref[x];
+                present += (r < 0 ? -r : r) > threshold;
+            }
+        }
+    }
+
+    const uint32_t area = (uint32_t)(x1 - x0) * (y1 - y0);
+    const uint16_t changed_q8 = (uint16_t)((changed << 8) / area);
+    const bool motion = changed_q8 >= min_changed_q8_;
+    const bool held = !motion && held_frames_ < max_hold_ && ((present << 8) / area) >= min_changed_q8_;
+    if (!motion) {
+        // Learn the noise floor from still frames only, otherwise a gesture raises its own threshold
+        int32_t mean_q8 = (int32_t)((diff_sum << 8) / area);
+        noise_q8_ = (uint16_t)(noise_q8_ + ((mean_q8 - (int32_t)noise_q8_) >> kNoiseShift));
+    }
+
+    stats_.threshold = (uint8_t)threshold;
+    stats_.last_changed_q8 = changed_q8;
+    if (motion) {
+        hangover_left_ = hangover_;
+        held_frames_ = 0;
+    } else if (held) {
+        held_frames_++;
+        stats_.frames_held++;
+    } else if (hangover_left_ > 0) {
+        hangover_left_--;
+    } else {
+        // Nothing here worth inferring: this is the scene a hand has to differ from. Taken from
+        // the background (noise averaged out) where it has settled, so something still moving
+        // outside the region leaves no ghost; whatever outstays max_hold is taken in as well
+        for (int i = 0; i < n; ++i) {
+            if (!thumb_bit(motion_, i)) reference_[i] = (uint8_t)(background_[i] >> 8);
+        }
+        held_frames_ = 0;
+        stats_.frames_skipped++;
+        return false;
+    }
+    stats_.frames_passed++;
+    return true;
+}
@@ -0,0 +1,58 @@
+#ifndef MOTION_GATE_H
+#define MOTION_GATE_H
+
+#include <stdint.h>
+#include "frame_preprocess.h"
+
+// Decides per frame whether the hands moved enough to be worth an Invoke().
+// Works on a LumaThumb: a Q8 running-average background, per-pixel absolute difference,
+// and the fraction of changed pixels inside the hand region. The per-pixel threshold
+// follows the sensor noise (EMA of the mean difference on still frames), so it adapts to
+// lighting and gain changes. After motion stops the gate stays open for a few frames so
+// the end of a gesture is still classified.
+// The running average absorbs a hand that stops moving within a few frames, so a static
+// hand shape would be gated out while it is held. The gate therefore also compares the
+// region against a reference: the scene as it was on the last skipped frame. While the
+// region differs from it (something arrived and stayed) the gate stays open, for up to
+// `max_hold` frames; when the hand leaves, the region matches the reference again and the
+// gate closes without waiting for the background to forget it.
+struct MotionGateStats {
+    uint32_t frames_passed;
+    uint32_t frames_skipped;
+    uint32_t frames_held;       // Passed for a still hand in the region (no motion)
+    uint8_t threshold;          // Current per-pixel difference threshold
+    uint16_t last_changed_q8;   // Changed fraction of the region on the last frame, Q8 (256 = all)
+};
+
+class MotionGate {
+public:
+    // `min_changed_q8`: fraction of region pixels (Q8) that must change to count as motion.
+    // `hangover`: frames the gate stays open after the last motion.
+    // `max_hold`: frames a still hand in the region keeps it open after the last motion.
+    MotionGate(uint16_t min_changed_q8, int hangover, int max_hold);
+
+    // Forgets the background; the next frame seeds it and passes. Counters are kept.
+    void reset();
+    // `region` is in thumbnail pixels. Returns true if the frame should be inferred.
+    bool update(const LumaThumb& thumb, CropRect region);
+    const MotionGateStats& stats() const { return stats_; }
+    // Changed pixels of the last update() over the whole thumbnail, one bit per pixel (thumb_bit())
+    const uint8_t* motion_mask() const { return motion_; }
+
+private:
+    uint16_t background_[THUMB_MAX_W * THUMB_MAX_H]; // Q8 luma
+    uint8_t reference_[THUMB_MAX_W * THUMB_MAX_H];   // Scene on the last skipped frame
+    uint8_t motion_[THUMB_BITS_BYTES];
+    int w_ = 0;
+    int h_ = 0;
+    bool seeded_ = false;
+    uint16_t noise_q8_;          // EMA of the mean absolute difference on still frames, Q8
+    uint16_t min_changed_q8_;
+    int hangover_;
+    int hangover_left_ = 0;
+    int max_hold_;
+    int held_frames_ = 0;
+    MotionGateStats stats_ = {};
+};
+
+#endif // MOTION_GATE_H
@@ -1,64 +1,155 @@
 #include "mqtt_handler.h"
 #include "config.h"
+#include "trace.h"
+#include "wifi_handler.h"
+#include "boot_sequencer.h"
 #include <WiFiClient.h>
+#include <string.h>
+#include <atomic>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 
 WiFiClient espClient;
 PubSubClient mqttClient(espClient);
 
-void setup_wifi() {
-    delay(10);
-    Serial.println();
-    Serial.print("Connecting to ");
-    Serial.println(WIFI_SSID);
-    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
-    while (WiFi.status() != WL_CONNECTED) {
-        delay(500);
-        Serial.print(".");
+namespace {
+    MqttOutbox<MQTT_OUTBOX_SLOTS, MQTT_OUTBOX_MAX_PAYLOAD> outbox(MQTT_OUTBOX_POLICY);
+    MqttConnection connection(ReconnectBackoff(MQTT_BACKOFF_MIN_MS, MQTT_BACKOFF_MAX_MS, 0)); // Reseeded per device in setup_mqtt()
+
+    // mqttClient.connect() blocks for up to the TCP connect timeout plus MQTT_CONNECT_TIMEOUT_S
+    // when the broker host is unreachable, so it runs here instead of on the loop task. The loop
+    // task leaves the client alone while the connection is CONNECTING, which is the only time this runs.
+    TaskHandle_t connect_task = nullptr;
+    std::atomic<bool> connect_done{false};
+    bool connect_ok = false; // Written before connect_done is set
+
+    void connect_task_fn(void*) {
+        for (;;) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            connect_ok = mqttClient.connect(MQTT_CLIENT_ID);
+            connect_done.store(true);
+        }
+    }
+
+    bool send(const char* topic, const uint8_t* payload, size_t len) {
+        if (!mqttClient.publish(topic, payload, len)) return false;
+        Serial.print("MQTT Published ["); Serial.print(topic); Serial.print("]: "); Serial.print(len); Serial.println(" bytes");
+        return true;
+    }
+
+    // Hands queued messages to the client oldest first, a few per loop so a long backlog
+    // doesn't stall the UI. Stops at the first failure; the message stays queued.
+    void drain_outbox() {
+        for (int i = 0; i < MQTT_DRAIN_PER_LOOP; ++i) {
+            const char* topic;
+            const uint8_t* payload;
+            size_t len;
+            if (!outbox.peek(&topic, &payload, &len) || !send(topic, payload, len)) return;
+            outbox.pop();
+        }
+    }
+
+    void on_connected() {
+        boot_mark(BootMilestone::MQTT_CONNECTED);
+        mqttClient.subscribe(MQTT_TOPIC_SPEECH_TO_SIGN);
+        Serial.print("Subscribed to: "); Serial.println(MQTT_TOPIC_SPEECH_TO_SIGN);
+#if LATENCY_STAMPS_ENABLED
+        mqttClient.subscribe(MQTT_TOPIC_TIMESYNC_PING);
+#endif
+    }
+
+    void log_transition(MqttState from, uint32_t now) {
+        MqttState to = connection.state();
+        if (to == from) return;
+        if (from == MqttState::CONNECTING && to == MqttState::BACKOFF) {
+            Serial.print("MQTT connect failed, rc="); Serial.print(mqttClient.state());
+            Serial.print(", retry in "); Serial.print(connection.next_attempt_in_ms(now)); Serial.println(" ms");
+        } else if (from == MqttState::CONNECTED && to == MqttState::BACKOFF) {
+            Serial.print("MQTT connection lost, rc="); Serial.println(mqttClient.state());
+        }
+        Serial.print("MQTT state: "); Serial.print(mqtt_state_name(from));
+        Serial.print(" -> "); Serial.println(mqtt_state_name(to));
     }
-    Serial.println("");
-    Serial.println("WiFi connected");
-    Serial.println("IP address: ");
-    Serial.println(WiFi.localIP());
 }
 
 void setup_mqtt(MQTT_CALLBACK_SIGNATURE callback) {
+    connection = MqttConnection(ReconnectBackoff(MQTT_BACKOFF_MIN_MS, MQTT_BACKOFF_MAX_MS, esp_random()));
     mqttClient.setServer(MQTT_BROKER_IP, MQTT_BROKER_PORT);
     mqttClient.setCallback(callback);
-    mqtt_reconnect();
-}
-
-void mqtt_reconnect() {
-    while (!mqttClient.connected()) {
-        Serial.print("Attempting MQTT connection...");
-        if (mqttClient.connect(MQTT_CLIENT_ID)) {
-            Serial.println("connected");
-            mqttClient.subscribe(MQTT_TOPIC_SPEECH_TO_SIGN);
-            Serial.print("Subscribed to: "); Serial.println(MQTT_TOPIC_SPEECH_TO_SIGN);
-        } else {
-            Serial.print("failed, rc=");
-            Serial.print(mqttClient.state());
-            Serial.println(" try again in 5 seconds");
-            delay(5000);
-        }
+    mqttClient.setBufferSize(MQTT_OUTBOX_MAX_PAYLOAD + MQTT_OUTBOX_MAX_TOPIC + 8); // Default 256 is too small for telemetry
+    mqttClient.setSocketTimeout(MQTT_CONNECT_TIMEOUT_S);
+    espClient.setTimeout(MQTT_CONNECT_TIMEOUT_S);
+    if (xTaskCreate(connect_task_fn, "mqtt_connect", 4096, nullptr, 1, &connect_task) != pdPASS) {
+        Serial.println("Failed to create the MQTT connect task");
+        connect_task = nullptr;
     }
+    mqtt_loop(); // First attempt now; failures fall back to the backoff schedule
 }
 
 void mqtt_loop() {
-    if (!mqttClient.connected()) {
-        mqtt_reconnect();
+    wifi_loop();
+    if (!connect_task) return;
+    uint32_t now = millis();
+    MqttState before = connection.state();
+    if (before == MqttState::CONNECTING && connect_done.load()) {
+        connection.connect_finished(connect_ok, now);
+        if (connection.state() == MqttState::CONNECTED) on_connected();
+    }
+    bool session_up = connection.state() == MqttState::CONNECTED && mqttClient.connected();
+    switch (connection.step(now, wifi_is_connected(), session_up)) {
+        case MqttAction::CONNECT:
+            connect_done.store(false);
+            xTaskNotifyGive(connect_task);
+            break;
+        case MqttAction::DISCONNECT:
+            mqttClient.disconnect();
+            break;
+        case MqttAction::NONE:
+            break;
+    }
+    log_transition(before, now);
+    if (connection.state() == MqttState::CONNECTED) {
+        mqttClient.loop();
+        drain_outbox();
     }
-    mqttClient.loop();
 }
 
-void mqtt_publish(const char* topic, const char* payload) {
-    if (mqttClient.connected()) {
-        mqttClient.publish(topic, payload);
-        Serial.print("MQTT Published ["); Serial.print(topic); Serial.print("]: "); Serial.println(payload);
-    } else {
-        Serial.println("MQTT not connected. Cannot publish.");
+bool mqtt_publish(const char* topic, const char* payload) {
+    return mqtt_publish_binary(topic, (const uint8_t*)payload, strlen(payload));
+}
+
+bool mqtt_publish_binary(const char* topic, const uint8_t* payload, size_t len) {
+    TRACE_SCOPE(TraceStage::MQTT_PUBLISH);
+    // Straight out if nothing is waiting, so queued messages never get overtaken
+    if (connection.state() == MqttState::CONNECTED && outbox.empty() && send(topic, payload, len)) {
+        return true;
+    }
+    if (!outbox.push(topic, payload, len)) {
+        Serial.print("MQTT outbox dropped message for "); Serial.println(topic);
+        return false;
     }
+    return true;
 }
 
 bool is_mqtt_connected() {
-    return mqttClient.connected();
-}
\ No newline at end of file
+    return connection.state() == MqttState::CONNECTED && mqttClient.connected();
+}
+
+void mqtt_get_stats(MqttStats* out) {
+    if (!out) return;
+    out->state = connection.state();
+    out->connect_attempts = connection.connect_attempts();
+    out->connects = connection.connects();
+    out->next_attempt_in_ms = connection.next_attempt_in_ms(millis());
+    out->outbox = outbox.stats();
+}
+
+const char* mqtt_state_name(MqttState s) {
+    switch (s) {
+        case MqttState::WIFI_DOWN: return "wifi_down";
+        case MqttState::BACKOFF: return "backoff";
+        case MqttState::CONNECTING: return "connecting";
+        case MqttState::CONNECTED: return "connected";
+    }
+    return "unknown";
+}
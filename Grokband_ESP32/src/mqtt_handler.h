@@ -3,12 +3,26 @@
 
 #include <PubSubClient.h>
 #include <WiFi.h>
+#include "mqtt_outbox.h"
+
+// Connection state machine driven by mqtt_loop() (MqttConnection, mqtt_outbox.h). Nothing here
+// waits for the broker: connect attempts run on their own task on a jittered exponential
+// backoff, and publishes made while disconnected wait in a bounded outbox until the next connect.
+struct MqttStats {
+    MqttState state;
+    uint32_t connect_attempts;
+    uint32_t connects;
+    uint32_t next_attempt_in_ms;   // Only meaningful in BACKOFF
+    OutboxStats outbox;
+};
 
-void setup_wifi();
 void setup_mqtt(MQTT_CALLBACK_SIGNATURE); // Pass callback for received messages
-void mqtt_reconnect();
-void mqtt_loop();
-void mqtt_publish(const char* topic, const char* payload);
+void mqtt_loop();   // Call every loop(); also advances wifi_loop(). Returns promptly whatever the broker does
+// Sends now if connected and nothing is queued, else queues. Returns false if dropped.
+bool mqtt_publish(const char* topic, const char* payload);
+bool mqtt_publish_binary(const char* topic, const uint8_t* payload, size_t len);
 bool is_mqtt_connected();
+void mqtt_get_stats(MqttStats* out);
+const char* mqtt_state_name(MqttState state);
 
-#endif // MQTT_HANDLER_H
\ No newline at end of file
+#endif // MQTT_HANDLER_H
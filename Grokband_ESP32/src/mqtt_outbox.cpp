@@ -0,0 +1,65 @@
+#include "mqtt_outbox.h"
+
+ReconnectBackoff::ReconnectBackoff(uint32_t min_ms, uint32_t max_ms, uint32_t seed)
+    : min_ms_(min_ms), max_ms_(max_ms), rng_(seed ? seed : 0x9E3779B9u) {}
+
+uint32_t ReconnectBackoff::next_delay_ms() {
+    uint32_t d = min_ms_;
+    for (uint32_t i = 0; i < failures_ && d < max_ms_; ++i) d *= 2;
+    if (d > max_ms_) d = max_ms_;
+    failures_++;
+    // xorshift32: jitter only needs to decorrelate devices, not be unpredictable
+    rng_ ^= rng_ << 13;
+    rng_ ^= rng_ >> 17;
+    rng_ ^= rng_ << 5;
+    return d / 2 + rng_ % (d / 2 + 1);
+}
+
+MqttAction MqttConnection::step(uint32_t now_ms, bool wifi_up, bool session_up) {
+    switch (state_) {
+        case MqttState::CONNECTING:
+            return MqttAction::NONE; // The attempt ends by itself, link or no link
+        case MqttState::CONNECTED:
+            if (!wifi_up) {
+                state_ = MqttState::WIFI_DOWN;
+                return MqttAction::DISCONNECT;
+            }
+            if (!session_up) {
+                next_attempt_ms_ = now_ms + backoff_.next_delay_ms();
+                state_ = MqttState::BACKOFF;
+            }
+            return MqttAction::NONE;
+        case MqttState::WIFI_DOWN:
+            if (!wifi_up) return MqttAction::NONE;
+            next_attempt_ms_ = now_ms; // Link is back: try right away
+            state_ = MqttState::BACKOFF;
+            // fall through
+        case MqttState::BACKOFF:
+            if (!wifi_up) {
+                state_ = MqttState::WIFI_DOWN;
+                return MqttAction::NONE;
+            }
+            if ((int32_t)(now_ms - next_attempt_ms_) < 0) return MqttAction::NONE;
+            attempts_++;
+            state_ = MqttState::CONNECTING;
+            return MqttAction::CONNECT;
+    }
+    return MqttAction::NONE;
+}
+
+void MqttConnection::connect_finished(bool ok, uint32_t now_ms) {
+    if (state_ != MqttState::CONNECTING) return;
+    if (ok) {
+        connects_++;
+        backoff_.reset();
+        state_ = MqttState::CONNECTED;
+        return;
+    }
+    next_attempt_ms_ = now_ms + backoff_.next_delay_ms();
+    state_ = MqttState::BACKOFF;
+}
+
+uint32_t MqttConnection::next_attempt_in_ms(uint32_t now_ms) const {
+    int32_t wait = (int32_t)(next_attempt_ms_ - now_ms);
+    return state_ == MqttState::BACKOFF && wait > 0 ? (uint32_t)wait : 0;
+}
@@ -0,0 +1,156 @@
+#ifndef MQTT_OUTBOX_H
+#define MQTT_OUTBOX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Store-and-forward queue for outbound MQTT messages: a fixed ring of slots, no heap.
+// Messages published while the broker is unreachable wait here and drain on reconnect.
+// Payloads carry an explicit length, so binary payloads fit as well as text.
+// Not thread-safe: owned by the task that runs mqtt_loop().
+// Nothing in here depends on Arduino or ESP-IDF.
+#define MQTT_OUTBOX_MAX_TOPIC 64
+
+enum class OutboxPolicy : uint8_t {
+    DROP_OLDEST,    // A full queue evicts its oldest message (stale telemetry matters least)
+    DROP_NEWEST     // A full queue rejects the new message (ordering of what's queued is kept)
+};
+
+struct OutboxStats {
+    uint32_t queued;        // Accepted into the ring
+    uint32_t sent;          // Handed to the client after waiting in the ring
+    uint32_t dropped;       // Evicted or rejected because the ring was full
+    uint32_t rejected;      // Topic or payload too large for a slot
+    uint16_t depth;         // Messages waiting now
+    uint16_t high_water;    // Deepest the ring has been
+};
+
+template <int kSlots, size_t kMaxPayload>
+class MqttOutbox {
+public:
+    explicit MqttOutbox(OutboxPolicy policy) : policy_(policy) {}
+
+    // Copies topic and payload into the ring. Returns false if the message was not queued.
+    bool push(const char* topic, const uint8_t* payload, size_t len);
+    // Oldest waiting message, or false if empty. Valid until pop().
+    bool peek(const char** topic, const uint8_t** payload, size_t* len) const;
+    // Removes the oldest message after it was handed to the client
+    void pop();
+    bool empty() const { return count_ == 0; }
+    const OutboxStats& stats() const { return stats_; }
+
+private:
+    struct Slot {
+        char topic[MQTT_OUTBOX_MAX_TOPIC];
+        uint16_t len;
+        uint8_t payload[kMaxPayload];
+    };
+
+    Slot slots_[kSlots];
+    int head_ = 0;      // Oldest message
+    int count_ = 0;
+    OutboxPolicy policy_;
+    OutboxStats stats_ = {};
+};
+
+// Reconnect pacing: exponential backoff from min_ms to max_ms with jitter, so a fleet of
+// bands doesn't reconnect in lockstep after a broker restart.
+class ReconnectBackoff {
+public:
+    ReconnectBackoff(uint32_t min_ms, uint32_t max_ms, uint32_t seed);
+    // Delay before the next attempt: a random value in [d/2, d], d doubling per failure
+    uint32_t next_delay_ms();
+    void reset() { failures_ = 0; }
+    uint32_t failures() const { return failures_; }
+
+private:
+    uint32_t min_ms_, max_ms_;
+    uint32_t failures_ = 0;
+    uint32_t rng_;
+};
+
+// Connection state machine for the broker session. Like the outbox it has no clock and no
+// client: the caller reports the WiFi link and the client's session, and carries out the
+// action step() returns. A connect attempt stays CONNECTING until connect_finished(), so the
+// blocking client connect can run on another task and step() never waits for the broker.
+enum class MqttState : uint8_t {
+    WIFI_DOWN,      // No WiFi link; nothing to do until it comes back
+    BACKOFF,        // Disconnected, waiting for the next connect attempt
+    CONNECTING,     // An attempt is running off the caller's task
+    CONNECTED
+};
+
+enum class MqttAction : uint8_t {
+    NONE,
+    CONNECT,        // Start an attempt and report its outcome with connect_finished()
+    DISCONNECT      // The link went down under the session; close the client
+};
+
+class MqttConnection {
+public:
+    explicit MqttConnection(const ReconnectBackoff& backoff) : backoff_(backoff) {}
+
+    // `session_up` is the client's own view of its session; only used while CONNECTED
+    MqttAction step(uint32_t now_ms, bool wifi_up, bool session_up);
+    void connect_finished(bool ok, uint32_t now_ms);
+
+    MqttState state() const { return state_; }
+    uint32_t next_attempt_in_ms(uint32_t now_ms) const; // 0 unless in BACKOFF
+    uint32_t connect_attempts() const { return attempts_; }
+    uint32_t connects() const { return connects_; }
+
+private:
+    ReconnectBackoff backoff_;
+    MqttState state_ = MqttState::WIFI_DOWN;
+    uint32_t next_attempt_ms_ = 0;
+    uint32_t attempts_ = 0;
+    uint32_t connects_ = 0;
+};
+
+// --- MqttOutbox ---
+
+template <int kSlots, size_t kMaxPayload>
+bool MqttOutbox<kSlots, kMaxPayload>::push(const char* topic, const uint8_t* payload, size_t len) {
+    size_t topic_len = 0;
+    while (topic[topic_len] && topic_len < MQTT_OUTBOX_MAX_TOPIC) topic_len++;
+    if (topic_len >= MQTT_OUTBOX_MAX_TOPIC || len > kMaxPayload) {
+        stats_.rejected++;
+        return false;
+    }
+    if (count_ == kSlots) {
+        stats_.dropped++;
+        if (policy_ == OutboxPolicy::DROP_NEWEST) return false;
+        head_ = (head_ + 1) % kSlots; // DROP_OLDEST
+        count_--;
+    }
+    Slot& slot = slots_[(head_ + count_) % kSlots];
+    for (size_t i = 0; i <= topic_len; ++i) slot.topic[i] = topic[i];
+    for (size_t i = 0; i < len; ++i) slot.payload[i] = payload[i];
+    slot.len = (uint16_t)len;
+    count_++;
+    stats_.queued++;
+    stats_.depth = (uint16_t)count_;
+    if (stats_.depth > stats_.high_water) stats_.high_water = stats_.depth;
+    return true;
+}
+
+template <int kSlots, size_t kMaxPayload>
+bool MqttOutbox<kSlots, kMaxPayload>::peek(const char** topic, const uint8_t** payload, size_t* len) const {
+    if (count_ == 0) return false;
+    const Slot& slot = slots_[head_];
+    *topic = slot.topic;
+    *payload = slot.payload;
+    *len = slot.len;
+    return true;
+}
+
+template <int kSlots, size_t kMaxPayload>
+void MqttOutbox<kSlots, kMaxPayload>::pop() {
+    if (count_ == 0) return;
+    head_ = (head_ + 1) % kSlots;
+    count_--;
+    stats_.sent++;
+    stats_.depth = (uint16_t)count_;
+}
+
+#endif // MQTT_OUTBOX_H
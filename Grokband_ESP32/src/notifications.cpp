@@ -1,33 +1,142 @@
 #include "notifications.h"
 #include "config.h"
-#include <Arduino.h> // For pinMode, digitalWrite, delay
+#include <Arduino.h> // For ledcSetup, ledcAttachPin, ledcWrite
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+namespace {
+    // Patterns. Priorities: ambient < confirmation < message < urgent
+    const PatternStep kMessageSteps[] = { {120, 255, 255, false}, {100, 0, 0, false} };
+    const PatternStep kUrgentSteps[] = { {500, 255, 255, false}, {50, 0, 0, false} };
+    const PatternStep kSignSentSteps[] = { {40, 128, 160, false}, {10, 0, 0, false} };
+    const PatternStep kErrorSteps[] = { {80, 255, 0, false}, {80, 0, 0, false} };
+    const PatternStep kReadySteps[] = { {300, 255, 0, true}, {300, 0, 0, true} };
+
+    const Pattern kPatterns[] = {
+        { "message", kMessageSteps, 2, 1, 2 },
+        { "urgent", kUrgentSteps, 2, 0, 3 },
+        { "sign_sent", kSignSentSteps, 2, 0, 1 },
+        { "error", kErrorSteps, 2, 2, 2 },
+        { "ready", kReadySteps, 2, 0, 0 },
+    };
+
+    // notification_vibrate(duration) with an arbitrary duration; one pulse in flight at a time
+    PatternStep pulse_steps[1];
+    Pattern pulse_pattern = { "pulse", pulse_steps, 1, 0, 1 };
+
+    PatternEngine engine;
+    portMUX_TYPE engine_mux = portMUX_INITIALIZER_UNLOCKED; // play() from loop/MQTT vs tick() from the timer
+    esp_timer_handle_t timer = nullptr;
+    uint32_t timer_deadline_ms = PatternEngine::kIdle;
+
+    inline uint32_t now_ms() {
+        return (uint32_t)(esp_timer_get_time() / 1000);
+    }
+
+    void apply(PatternOutput out) {
+        ledcWrite(NOTIFY_LED_LEDC_CHANNEL, out.led);
+        ledcWrite(NOTIFY_MOTOR_LEDC_CHANNEL, out.motor);
+    }
+
+    // Re-arms the one-shot timer for the engine's next deadline. Call with engine_mux held.
+    void schedule_locked(uint32_t now) {
+        uint32_t deadline = engine.next_deadline_ms(now);
+        if (deadline == timer_deadline_ms) return;
+        timer_deadline_ms = deadline;
+        esp_timer_stop(timer); // Fails harmlessly if not running
+        if (deadline != PatternEngine::kIdle) {
+            int32_t wait_ms = (int32_t)(deadline - now);
+            esp_timer_start_once(timer, (uint64_t)(wait_ms > 0 ? wait_ms : 0) * 1000);
+        }
+    }
+
+    void on_timer(void*) {
+        uint32_t now = now_ms();
+        portENTER_CRITICAL(&engine_mux);
+        timer_deadline_ms = PatternEngine::kIdle; // The one-shot has fired
+        PatternOutput out = engine.tick(now);
+        schedule_locked(now);
+        portEXIT_CRITICAL(&engine_mux);
+        apply(out);
+    }
+
+    void request(const Pattern* pattern) {
+        if (!timer) return;
+        uint32_t now = now_ms();
+        portENTER_CRITICAL(&engine_mux);
+        engine.play(pattern, now);
+        PatternOutput out = engine.tick(now);
+        schedule_locked(now);
+        portEXIT_CRITICAL(&engine_mux);
+        apply(out);
+    }
+}
 
 void notification_init() {
-    pinMode(LED_PIN, OUTPUT);
-    digitalWrite(LED_PIN, LOW); // Off
-    pinMode(VIBRATION_MOTOR_PIN, OUTPUT);
-    digitalWrite(VIBRATION_MOTOR_PIN, LOW); // Off
+    // PWM so patterns can fade and the motor can run below full strength
+    ledcSetup(NOTIFY_LED_LEDC_CHANNEL, NOTIFY_LEDC_FREQ_HZ, 8);
+    ledcAttachPin(LED_PIN, NOTIFY_LED_LEDC_CHANNEL);
+    ledcSetup(NOTIFY_MOTOR_LEDC_CHANNEL, NOTIFY_LEDC_FREQ_HZ, 8);
+    ledcAttachPin(VIBRATION_MOTOR_PIN, NOTIFY_MOTOR_LEDC_CHANNEL);
+    apply({ 0, 0 }); // Off
+
+    esp_timer_create_args_t args = {};
+    args.callback = on_timer;
+    args.name = "notify";
+    if (esp_timer_create(&args, &timer) != ESP_OK) {
+        Serial.println("Notification timer creation failed");
+        timer = nullptr;
+        return;
+    }
     Serial.println("Notification Handler Initialized");
 }
 
+void notification_play(Notification n) {
+    request(&kPatterns[(int)n]);
+}
+
 void notification_alert_message(bool long_buzz) {
-    digitalWrite(LED_PIN, HIGH);
-    digitalWrite(VIBRATION_MOTOR_PIN, HIGH);
-    delay(long_buzz ? 500 : 150);
-    digitalWrite(LED_PIN, LOW);
-    digitalWrite(VIBRATION_MOTOR_PIN, LOW);
+    notification_play(long_buzz ? Notification::MESSAGE_URGENT : Notification::MESSAGE);
 }
 
 void notification_led_on() {
-    digitalWrite(LED_PIN, HIGH);
+    portENTER_CRITICAL(&engine_mux);
+    engine.set_idle({ 255, 0 });
+    bool idle = !engine.busy();
+    portEXIT_CRITICAL(&engine_mux);
+    if (idle) apply({ 255, 0 });
 }
 
 void notification_led_off() {
-    digitalWrite(LED_PIN, LOW);
+    portENTER_CRITICAL(&engine_mux);
+    engine.set_idle({ 0, 0 });
+    bool idle = !engine.busy();
+    portEXIT_CRITICAL(&engine_mux);
+    if (idle) apply({ 0, 0 });
 }
 
 void notification_vibrate(int duration_ms) {
-    digitalWrite(VIBRATION_MOTOR_PIN, HIGH);
-    delay(duration_ms);
-    digitalWrite(VIBRATION_MOTOR_PIN, LOW);
-}
\ No newline at end of file
+    if (duration_ms <= 0) return;
+    portENTER_CRITICAL(&engine_mux);
+    bool in_use = engine.current() == &pulse_pattern;
+    if (!in_use) pulse_steps[0] = { (uint16_t)(duration_ms > 0xFFFF ? 0xFFFF : duration_ms), 0, 255, false };
+    portEXIT_CRITICAL(&engine_mux);
+    request(&pulse_pattern); // While one pulse is playing, another request coalesces into it
+}
+
+void notification_stop() {
+    uint32_t now = now_ms();
+    portENTER_CRITICAL(&engine_mux);
+    engine.stop(now);
+    PatternOutput out = engine.tick(now);
+    schedule_locked(now);
+    portEXIT_CRITICAL(&engine_mux);
+    apply(out);
+}
+
+PatternEngineStats notification_stats() {
+    portENTER_CRITICAL(&engine_mux);
+    PatternEngineStats stats = engine.stats();
+    portEXIT_CRITICAL(&engine_mux);
+    return stats;
+}
@@ -1,10 +1,26 @@
 #ifndef NOTIFICATIONS_H
 #define NOTIFICATIONS_H
 
+#include "pattern_engine.h"
+
+// LED and vibration feedback. Everything here returns immediately: patterns are played by
+// PatternEngine from an esp_timer callback driving LEDC PWM, so calling these from
+// mqtt_callback() or loop() never stalls MQTT, LVGL or input.
+enum class Notification {
+    MESSAGE,            // Incoming message: short double buzz
+    MESSAGE_URGENT,     // Long buzz, preempts everything else
+    SIGN_SENT,          // Light tick confirming a published sign
+    ERROR,              // Three fast LED blinks, no vibration
+    READY               // LED fade in/out when boot completes
+};
+
 void notification_init();
+void notification_play(Notification n);
 void notification_alert_message(bool long_buzz = false); // LED blink + vibration
-void notification_led_on();
+void notification_led_on();     // Idle LED level; patterns still play over it
 void notification_led_off();
 void notification_vibrate(int duration_ms);
+void notification_stop();
+PatternEngineStats notification_stats();
 
-#endif // NOTIFICATIONS_H
\ No newline at end of file
+#endif // NOTIFICATIONS_H
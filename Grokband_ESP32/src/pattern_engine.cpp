@@ -0,0 +1,110 @@
+#include "pattern_engine.h"
+
+void PatternEngine::start(const Pattern* pattern, uint32_t now_ms) {
+    current_ = pattern;
+    step_ = 0;
+    plays_left_ = pattern->repeats;
+    step_start_ms_ = now_ms;
+    from_ = out_;
+    stats_.played++;
+}
+
+void PatternEngine::play(const Pattern* pattern, uint32_t now_ms) {
+    if (!pattern || pattern->num_steps == 0) return;
+
+    // Rapid-fire alerts: one buzz for a burst of messages, not one per message
+    if (pattern == current_) {
+        stats_.coalesced++;
+        return;
+    }
+    for (int i = 0; i < queued_; ++i) {
+        if (queue_[i] == pattern) {
+            stats_.coalesced++;
+            return;
+        }
+    }
+
+    if (!current_) {
+        start(pattern, now_ms);
+        return;
+    }
+    if (pattern->priority > current_->priority) {
+        stats_.preempted++;
+        start(pattern, now_ms);
+        return;
+    }
+
+    // Insert behind everything of equal or higher priority
+    int pos = queued_;
+    while (pos > 0 && queue_[pos - 1]->priority < pattern->priority) pos--;
+    if (queued_ == kQueueLen) {
+        if (pos == kQueueLen) {
+            stats_.dropped++;
+            return;
+        }
+        stats_.dropped++; // Lowest-priority entry falls off the end
+        queued_--;
+    }
+    for (int i = queued_; i > pos; --i) queue_[i] = queue_[i - 1];
+    queue_[pos] = pattern;
+    queued_++;
+}
+
+void PatternEngine::stop(uint32_t now_ms) {
+    (void)now_ms;
+    current_ = nullptr;
+    queued_ = 0;
+    out_ = idle_;
+}
+
+void PatternEngine::finish_current(uint32_t now_ms) {
+    if (queued_ > 0) {
+        const Pattern* next = queue_[0];
+        for (int i = 1; i < queued_; ++i) queue_[i - 1] = queue_[i];
+        queued_--;
+        start(next, now_ms);
+    } else {
+        current_ = nullptr;
+        out_ = idle_;
+    }
+}
+
+PatternOutput PatternEngine::tick(uint32_t now_ms) {
+    // Catch up over any steps that ended since the last tick (a late timer callback)
+    while (current_) {
+        const PatternStep& step = current_->steps[step_];
+        uint32_t elapsed = now_ms - step_start_ms_;
+        if (elapsed < step.duration_ms) {
+            if (step.ramp) {
+                out_.led = (uint8_t)(from_.led + ((int32_t)step.led - from_.led) * (int32_t)elapsed / step.duration_ms);
+                out_.motor = (uint8_t)(from_.motor + ((int32_t)step.motor - from_.motor) * (int32_t)elapsed / step.duration_ms);
+            } else {
+                out_.led = step.led;
+                out_.motor = step.motor;
+            }
+            break;
+        }
+        // Step over: land exactly on its end levels and move on from its scheduled end time
+        step_start_ms_ += step.duration_ms;
+        out_.led = step.led;
+        out_.motor = step.motor;
+        from_ = out_;
+        if (++step_ < current_->num_steps) continue;
+        if (plays_left_ > 0) {
+            plays_left_--;
+            step_ = 0;
+            continue;
+        }
+        finish_current(step_start_ms_);
+    }
+    return current_ ? out_ : idle_;
+}
+
+uint32_t PatternEngine::next_deadline_ms(uint32_t now_ms) const {
+    if (!current_) return kIdle;
+    const PatternStep& step = current_->steps[step_];
+    uint32_t end = step_start_ms_ + step.duration_ms;
+    // While fading, come back every kRampStepMs for the intermediate levels
+    if (step.ramp && (int32_t)(end - (now_ms + kRampStepMs)) > 0) return now_ms + kRampStepMs;
+    return end;
+}
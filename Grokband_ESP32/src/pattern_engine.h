@@ -0,0 +1,77 @@
+#ifndef PATTERN_ENGINE_H
+#define PATTERN_ENGINE_H
+
+#include <stdint.h>
+
+// Scheduler core for LED/vibration patterns. Patterns are declarative step lists; the engine
+// decides what to output at a given time and when it next needs to run. It has no clock of its
+// own (every call takes `now_ms`) and no hardware access, so a driver can run it from a timer
+// callback and a host program can step it on a virtual clock.
+struct PatternStep {
+    uint16_t duration_ms;
+    uint8_t led;        // Intensity 0..255 at the end of the step
+    uint8_t motor;
+    bool ramp;          // true = fade linearly from the previous step's levels, false = jump
+};
+
+struct Pattern {
+    const char* name;
+    const PatternStep* steps;
+    uint8_t num_steps;
+    uint8_t repeats;    // Extra plays after the first
+    uint8_t priority;   // Higher preempts lower
+};
+
+struct PatternOutput {
+    uint8_t led;
+    uint8_t motor;
+};
+
+struct PatternEngineStats {
+    uint32_t played;
+    uint32_t coalesced;     // Requests folded into an identical pattern already playing/queued
+    uint32_t preempted;     // Patterns cut short by a higher-priority one
+    uint32_t dropped;       // Requests rejected because the queue was full of higher priorities
+};
+
+class PatternEngine {
+public:
+    static constexpr int kQueueLen = 4;
+    static constexpr uint32_t kRampStepMs = 10;   // Output update interval while fading
+    static constexpr uint32_t kIdle = 0xFFFFFFFFu;
+
+    // Requests a pattern. An identical pattern that is playing or queued absorbs the request.
+    // A higher priority than the current pattern preempts it; otherwise it queues by priority.
+    // `pattern` must outlive playback (use static const).
+    void play(const Pattern* pattern, uint32_t now_ms);
+    // Stops everything and clears the queue
+    void stop(uint32_t now_ms);
+    // Levels shown when no pattern is playing (e.g. a status LED left on)
+    void set_idle(PatternOutput idle) { idle_ = idle; }
+
+    // Advances to `now_ms` and returns the levels to output now
+    PatternOutput tick(uint32_t now_ms);
+    // When tick() next needs to run (absolute ms), or kIdle if nothing is playing
+    uint32_t next_deadline_ms(uint32_t now_ms) const;
+
+    bool busy() const { return current_ != nullptr; }
+    const Pattern* current() const { return current_; }
+    const PatternEngineStats& stats() const { return stats_; }
+
+private:
+    void start(const Pattern* pattern, uint32_t now_ms);
+    void finish_current(uint32_t now_ms);
+
+    const Pattern* current_ = nullptr;
+    int step_ = 0;
+    int plays_left_ = 0;
+    uint32_t step_start_ms_ = 0;
+    PatternOutput from_ = {};       // Levels at the start of the current step
+    PatternOutput out_ = {};
+    PatternOutput idle_ = {};
+    const Pattern* queue_[kQueueLen] = {};
+    int queued_ = 0;
+    PatternEngineStats stats_ = {};
+};
+
+#endif // PATTERN_ENGINE_H
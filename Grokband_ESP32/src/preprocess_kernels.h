@@ -0,0 +1,139 @@
+#ifndef PREPROCESS_KERNELS_H
+#define PREPROCESS_KERNELS_H
+
+#include <stdint.h>
+#include "frame_preprocess.h"
+
+// Pixel formats and building blocks shared by the kernels in frame_preprocess.cpp, plus
+// versions of the bilinear resize specialized at compile time on the output size and tensor
+// type. Those fuse the LUT store into the inner loop (no row buffer, no per-row type switch)
+// and give the compiler constant trip counts to unroll. pick_luma_resize() chooses one for a
+// given input at runtime; the output is bit-identical to the generic kernel's.
+// Nothing in here depends on ESP-IDF.
+
+// BT.601 luma in 8.8 fixed point; the weights sum to 256 so white maps to exactly 255
+constexpr uint32_t kLumaR = 77;
+constexpr uint32_t kLumaG = 150;
+constexpr uint32_t kLumaB = 29;
+
+inline uint8_t luma_rgb888(uint32_t r, uint32_t g, uint32_t b) {
+    return (uint8_t)((r * kLumaR + g * kLumaG + b * kLumaB + 128) >> 8);
+}
+
+inline void rgb565_to_rgb888(const uint8_t* p, uint32_t* r, uint32_t* g, uint32_t* b) {
+    uint32_t v = ((uint32_t)p[0] << 8) | p[1];
+    uint32_t r5 = (v >> 11) & 0x1F;
+    uint32_t g6 = (v >> 5) & 0x3F;
+    uint32_t b5 = v & 0x1F;
+    // Expand to 8 bits by replicating the high bits, same as the float reference does
+    *r = (r5 << 3) | (r5 >> 2);
+    *g = (g6 << 2) | (g6 >> 4);
+    *b = (b5 << 3) | (b5 >> 2);
+}
+
+inline uint8_t luma_rgb565(const uint8_t* p) {
+    uint32_t r, g, b;
+    rgb565_to_rgb888(p, &r, &g, &b);
+    return luma_rgb888(r, g, b);
+}
+
+// Skin-tone test on BT.601 chroma (Chai & Ngan box: Cb 77..127, Cr 133..173).
+// Chroma is largely independent of brightness, so one box covers most lighting.
+inline bool skin_rgb888(int32_t r, int32_t g, int32_t b) {
+    int32_t cb = 128 + ((-43 * r - 85 * g + 128 * b) >> 8);
+    int32_t cr = 128 + ((128 * r - 107 * g - 21 * b) >> 8);
+    return cb >= 77 && cb <= 127 && cr >= 133 && cr <= 173;
+}
+
+struct PixelRgb565 {
+    static constexpr int kBytes = 2;
+    static constexpr bool kColor = true;
+    static uint8_t luma(const uint8_t* p) { return luma_rgb565(p); }
+    static bool skin(const uint8_t* p) {
+        uint32_t r, g, b;
+        rgb565_to_rgb888(p, &r, &g, &b);
+        return skin_rgb888(r, g, b);
+    }
+};
+
+struct PixelGray {
+    static constexpr int kBytes = 1;
+    static constexpr bool kColor = false;
+    static uint8_t luma(const uint8_t* p) { return *p; }
+    static bool skin(const uint8_t*) { return false; }
+};
+
+inline bool preprocess_crop_is_valid(int src_w, int src_h, const CropRect& c, const ModelInput& dst) {
+    return c.w > 0 && c.h > 0 && c.x >= 0 && c.y >= 0 &&
+           c.x + c.w <= src_w && c.y + c.h <= src_h &&
+           dst.data && dst.lut && dst.channels == 1 &&
+           dst.width > 0 && dst.height > 0 &&
+           dst.width <= PREPROCESS_MAX_OUT_DIM && dst.height <= PREPROCESS_MAX_OUT_DIM;
+}
+
+// Pixel-center aligned source coordinate for output index `o`, in Q16, clamped to [lo, hi - 1]
+inline int32_t source_coord_q16(int o, int lo, int extent, int dst_extent) {
+    int32_t step = (int32_t)(((int64_t)extent << 16) / dst_extent);
+    int32_t s = (lo << 16) + step / 2 - (1 << 15) + o * step;
+    if (s < (lo << 16)) s = lo << 16;
+    if (s > ((lo + extent - 1) << 16)) s = (lo + extent - 1) << 16;
+    return s;
+}
+
+using LumaResizeFn = bool (*)(const uint8_t* src, int src_w, int src_h, CropRect crop, const ModelInput& dst);
+
+// Same arithmetic as luma_resize_bilinear() in frame_preprocess.cpp, with W x H and T fixed
+template <typename Pixel, int W, int H, typename T>
+bool luma_resize_fixed(const uint8_t* src, int src_w, int src_h, CropRect crop, const ModelInput& dst) {
+    static_assert(W > 0 && H > 0 && W <= PREPROCESS_MAX_OUT_DIM && H <= PREPROCESS_MAX_OUT_DIM, "output size");
+    if (!src || !preprocess_crop_is_valid(src_w, src_h, crop, dst) || dst.width != W || dst.height != H) return false;
+
+    const int stride = src_w * Pixel::kBytes;
+    const int x_last = crop.x + crop.w - 1;
+    const int y_last = crop.y + crop.h - 1;
+    const T* lut = static_cast<const T*>(dst.lut);
+    T* out = static_cast<T*>(dst.data);
+
+    uint16_t col_off0[W];
+    uint16_t col_off1[W];
+    uint16_t col_frac[W];
+    for (int ox = 0; ox < W; ++ox) {
+        int32_t sx = source_coord_q16(ox, crop.x, crop.w, W);
+        int x0 = sx >> 16;
+        int x1 = x0 < x_last ? x0 + 1 : x_last;
+        col_off0[ox] = (uint16_t)(x0 * Pixel::kBytes);
+        col_off1[ox] = (uint16_t)(x1 * Pixel::kBytes);
+        col_frac[ox] = (uint16_t)((sx >> 4) & 0xFFF);
+    }
+
+    for (int oy = 0; oy < H; ++oy, out += W) {
+        int32_t sy = source_coord_q16(oy, crop.y, crop.h, H);
+        int y0 = sy >> 16;
+        int y1 = y0 < y_last ? y0 + 1 : y_last;
+        uint32_t fy = (sy >> 4) & 0xFFF;
+        const uint8_t* row0 = src + y0 * stride;
+        const uint8_t* row1 = src + y1 * stride;
+        for (int ox = 0; ox < W; ++ox) {
+            uint32_t fx = col_frac[ox];
+            uint32_t top = Pixel::luma(row0 + col_off0[ox]) * (4096 - fx) + Pixel::luma(row0 + col_off1[ox]) * fx;
+            uint32_t bot = Pixel::luma(row1 + col_off0[ox]) * (4096 - fx) + Pixel::luma(row1 + col_off1[ox]) * fx;
+            out[ox] = lut[(top * (4096 - fy) + bot * fy + (1u << 23)) >> 24];
+        }
+    }
+    return true;
+}
+
+// The W x H variant for dst's tensor type, or `generic` for any other input (another size,
+// e.g. the hand detector's, or more than one channel)
+template <typename Pixel, int W, int H>
+LumaResizeFn pick_luma_resize(const ModelInput& dst, LumaResizeFn generic) {
+    if (dst.width != W || dst.height != H || dst.channels != 1) return generic;
+    switch (dst.type) {
+        case ModelInputType::UINT8:   return &luma_resize_fixed<Pixel, W, H, uint8_t>;
+        case ModelInputType::INT8:    return &luma_resize_fixed<Pixel, W, H, int8_t>;
+        case ModelInputType::FLOAT32: return &luma_resize_fixed<Pixel, W, H, float>;
+    }
+    return generic;
+}
+
+#endif // PREPROCESS_KERNELS_H
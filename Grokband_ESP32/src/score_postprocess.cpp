@@ -0,0 +1,160 @@
+#include "score_postprocess.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits>
+
+namespace {
+    // Raw top-1 against the class limit: an integer compare for quantized outputs
+    inline bool below_limit(uint8_t v, int32_t q_limit, float) { return v < q_limit; }
+    inline bool below_limit(int8_t v, int32_t q_limit, float) { return v < q_limit; }
+    inline bool below_limit(float v, int32_t, float limit) { return v < limit; }
+
+    // Rank keys: the output with its class index underneath (lower index first on ties), so every
+    // class has a distinct key and each rank is a plain max, with no data-dependent branches
+    inline int32_t rank_key(uint8_t v, int c) { return (int32_t)v * 256 + (255 - c); }
+    inline int32_t rank_key(int8_t v, int c) { return (int32_t)v * 256 + (255 - c); }
+    inline int64_t rank_key(float v, int c) {
+        if (v == 0.0f) v = 0.0f; // -0 ties with +0
+        int32_t bits;
+        memcpy(&bits, &v, sizeof(bits));
+        if (bits < 0) bits ^= 0x7fffffff; // IEEE order as signed integer order
+        return (int64_t)bits * 256 + (255 - c);
+    }
+    template <typename K> inline int key_class(K key) { return 255 - (int)(key & 255); }
+}
+
+bool ScorePostprocessor::begin(int num_classes, ScoreType type, float scale, int32_t zero_point,
+                               const ClassCalibration& defaults) {
+    if (num_classes < 1 || num_classes > SCORE_MAX_CLASSES) return false;
+    if (type != ScoreType::FLOAT32 && !(scale > 0.0f)) return false;
+    num_classes_ = num_classes;
+    type_ = type;
+    scale_ = type == ScoreType::FLOAT32 ? 1.0f : scale;
+    zero_point_ = type == ScoreType::FLOAT32 ? 0 : zero_point;
+    for (int c = 0; c < num_classes_; ++c) set_class(c, defaults);
+    return true;
+}
+
+void ScorePostprocessor::set_class(int class_idx, const ClassCalibration& calibration) {
+    if (class_idx < 0 || class_idx >= num_classes_) return;
+    calib_[class_idx] = calibration;
+    if (!(calib_[class_idx].scale > 0.0f)) calib_[class_idx].scale = 1.0f; // Must stay monotonic
+    update_limit(class_idx);
+}
+
+// threshold <= scale_c * s + offset_c, with s = scale * (q - zero_point), solved for q
+void ScorePostprocessor::update_limit(int class_idx) {
+    const ClassCalibration& c = calib_[class_idx];
+    float s_min = (c.threshold - c.offset) / c.scale;
+    limit_[class_idx] = s_min;
+    float q = ceilf(s_min / scale_ + zero_point_);
+    q_limit_[class_idx] = q < -1000.0f ? -1000 : (q > 1000.0f ? 1000 : (int32_t)q); // Beyond any 8-bit value either way
+}
+
+float ScorePostprocessor::probability(int class_idx, float dequantized) const {
+    const ClassCalibration& c = calib_[class_idx];
+    float p = c.scale * dequantized + c.offset;
+    return p < 0.0f ? 0.0f : (p > 1.0f ? 1.0f : p);
+}
+
+int ScorePostprocessor::load_calibration(const char* text) {
+    if (!text || num_classes_ == 0) return -1;
+    // Parsed in full before anything is applied, so a bad table leaves the defaults in place
+    ClassCalibration parsed[SCORE_MAX_CLASSES + 1];
+    int targets[SCORE_MAX_CLASSES + 1];
+    int n = 0;
+    for (const char* line = text; *line; ) {
+        const char* end = strchr(line, '\n');
+        size_t len = end ? (size_t)(end - line) : strlen(line);
+        char buf[96];
+        if (len >= sizeof(buf)) return -1;
+        memcpy(buf, line, len);
+        buf[len] = '\0';
+        line = end ? end + 1 : line + len;
+
+        char* hash = strchr(buf, '#');
+        if (hash) *hash = '\0';
+        char* p = buf;
+        while (*p == ' ' || *p == '\t' || *p == '\r') ++p;
+        if (*p == '\0' || *p == '\r') continue;
+
+        char cls[8];
+        ClassCalibration c;
+        if (sscanf(p, "%7[^,],%f,%f,%f,%f", cls, &c.threshold, &c.margin, &c.scale, &c.offset) != 5) return -1;
+        int target = -1; // Every class
+        if (strcmp(cls, "*") != 0) {
+            char* cls_end;
+            target = (int)strtol(cls, &cls_end, 10);
+            if (*cls_end != '\0' || target < 0 || target >= num_classes_) return -1;
+        }
+        if (n == SCORE_MAX_CLASSES + 1) return -1;
+        parsed[n] = c;
+        targets[n++] = target;
+    }
+    for (int i = 0; i < n; ++i) {
+        if (targets[i] >= 0) {
+            set_class(targets[i], parsed[i]);
+        } else {
+            for (int cls = 0; cls < num_classes_; ++cls) set_class(cls, parsed[i]);
+        }
+    }
+    return n;
+}
+
+template <typename T>
+void ScorePostprocessor::process_typed(const T* scores, int k, TopKResult* out) const {
+    // One max pass per rank: a rejected frame costs one pass, an accepted one k (at least 2, the
+    // runner-up is needed for the margin)
+    using Key = decltype(rank_key(scores[0], 0));
+    Key top = rank_key(scores[0], 0);
+    for (int c = 1; c < num_classes_; ++c) {
+        const Key key = rank_key(scores[c], c);
+        top = key > top ? key : top;
+    }
+    const int best = key_class(top);
+    out->top[0].class_idx = best;
+    out->top[0].prob = probability(best, scale_ * ((float)scores[best] - zero_point_));
+    out->count = 1;
+    if (below_limit(scores[best], q_limit_[best], limit_[best])) {
+        out->verdict = ScoreVerdict::BELOW_THRESHOLD;
+        return;
+    }
+
+    float runner_up = 0.0f;
+    const int ranks = k > 1 ? k : 2;
+    for (int i = 1; i < ranks && i < num_classes_; ++i) {
+        const Key prev = top;
+        top = std::numeric_limits<Key>::min();
+        for (int c = 0; c < num_classes_; ++c) {
+            const Key key = rank_key(scores[c], c);
+            top = key < prev && key > top ? key : top;
+        }
+        const int cls = key_class(top);
+        const float p = probability(cls, scale_ * ((float)scores[cls] - zero_point_));
+        if (i == 1) runner_up = p;
+        if (i < k) {
+            out->top[i].class_idx = cls;
+            out->top[i].prob = p;
+            out->count = i + 1;
+        }
+    }
+    out->verdict = out->top[0].prob - runner_up >= calib_[best].margin ? ScoreVerdict::ACCEPTED
+                                                                       : ScoreVerdict::LOW_MARGIN;
+}
+
+void ScorePostprocessor::process(const void* scores, int k, TopKResult* out) const {
+    if (!out) return;
+    out->count = 0;
+    out->verdict = ScoreVerdict::BELOW_THRESHOLD;
+    if (!scores || num_classes_ == 0) return;
+    if (k < 1) k = 1;
+    if (k > SCORE_MAX_TOPK) k = SCORE_MAX_TOPK;
+    if (k > num_classes_) k = num_classes_;
+    switch (type_) {
+        case ScoreType::UINT8:   process_typed(static_cast<const uint8_t*>(scores), k, out); break;
+        case ScoreType::INT8:    process_typed(static_cast<const int8_t*>(scores), k, out); break;
+        case ScoreType::FLOAT32: process_typed(static_cast<const float*>(scores), k, out); break;
+    }
+}
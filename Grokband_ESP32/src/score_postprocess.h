@@ -0,0 +1,76 @@
+#ifndef SCORE_POSTPROCESS_H
+#define SCORE_POSTPROCESS_H
+
+#include <stdint.h>
+
+#define SCORE_MAX_CLASSES 32
+#define SCORE_MAX_TOPK 5
+
+// Model output -> decision, on the quantized scores themselves. Top-k is found by integer
+// compares (dequantization is monotonic), and each class's threshold is precomputed as a raw
+// output value, so a frame whose winner is below it is rejected after one integer compare. Only
+// the k winners are converted to calibrated probabilities: p = clamp(scale * s + offset, 0, 1),
+// s being the dequantized score. Accepting also needs p(top1) - p(top2) >= the winner's margin.
+// Nothing in here depends on ESP-IDF.
+enum class ScoreType : uint8_t {
+    UINT8,
+    INT8,
+    FLOAT32
+};
+
+struct ClassCalibration {
+    float threshold;    // Minimum calibrated probability
+    float margin;       // Minimum lead over the runner-up
+    float scale;        // Calibration of the dequantized score
+    float offset;
+};
+
+enum class ScoreVerdict : uint8_t {
+    ACCEPTED,
+    BELOW_THRESHOLD,    // Early reject: decided on the raw top-1 value
+    LOW_MARGIN
+};
+
+struct ScoreCandidate {
+    int class_idx;
+    float prob;         // Calibrated
+};
+
+struct TopKResult {
+    ScoreCandidate top[SCORE_MAX_TOPK]; // Best first. Only top[0] is filled on an early reject
+    int count;
+    ScoreVerdict verdict;
+
+    int class_idx() const { return verdict == ScoreVerdict::ACCEPTED ? top[0].class_idx : -1; }
+};
+
+class ScorePostprocessor {
+public:
+    // Output layout and quantization. Every class gets `defaults` until load_calibration()
+    bool begin(int num_classes, ScoreType type, float scale, int32_t zero_point, const ClassCalibration& defaults);
+    void set_class(int class_idx, const ClassCalibration& calibration);
+    // Calibration table shipped with the model (scripts/calibrate_thresholds.py), one class per line:
+    //   class,threshold,margin,scale,offset     ('*' as class = every class; '#' starts a comment)
+    // Returns the number of lines applied, or -1 (nothing applied) on a malformed line.
+    int load_calibration(const char* text);
+    const ClassCalibration& calibration(int class_idx) const { return calib_[class_idx]; }
+
+    // `scores`: num_classes values of the output type (one batch slot). k is capped at SCORE_MAX_TOPK
+    void process(const void* scores, int k, TopKResult* out) const;
+
+private:
+    void update_limit(int class_idx);
+    float probability(int class_idx, float dequantized) const;
+    template <typename T> void process_typed(const T* scores, int k, TopKResult* out) const;
+
+    int num_classes_ = 0;
+    ScoreType type_ = ScoreType::FLOAT32;
+    float scale_ = 1.0f;
+    int32_t zero_point_ = 0;
+    ClassCalibration calib_[SCORE_MAX_CLASSES];
+    // Lowest raw output that can pass each class's threshold
+    int32_t q_limit_[SCORE_MAX_CLASSES]; // Quantized outputs
+    float limit_[SCORE_MAX_CLASSES];     // Float outputs
+};
+
+#endif // SCORE_POSTPROCESS_H
@@ -0,0 +1,145 @@
+#include "screen_manager.h"
+#include <string.h>
+
+namespace {
+    constexpr int kItemHeight = 28;
+
+    lv_obj_t* message_view = nullptr;
+    lv_obj_t* message_label = nullptr;
+    lv_obj_t* status_label = nullptr;
+    lv_obj_t* list_view = nullptr;
+    lv_obj_t* items[SCREEN_MAX_QUICK_RESPONSES] = {};
+    int item_count = 0;
+    lv_group_t* group = nullptr;
+
+    lv_style_t item_style;
+    lv_style_t item_focused_style;
+
+    // lv_label_set_text() invalidates the label even when the text is the same
+    void set_text_if_changed(lv_obj_t* label, const char* text) {
+        const char* current = lv_label_get_text(label);
+        if (current && strcmp(current, text) == 0) return;
+        lv_label_set_text(label, text);
+    }
+
+    void set_hidden(lv_obj_t* obj, bool hidden) {
+        if (lv_obj_has_flag(obj, LV_OBJ_FLAG_HIDDEN) == hidden) return;
+        if (hidden) lv_obj_add_flag(obj, LV_OBJ_FLAG_HIDDEN);
+        else lv_obj_clear_flag(obj, LV_OBJ_FLAG_HIDDEN);
+    }
+
+    // Full-screen, transparent, non-scrolling container for one view
+    lv_obj_t* create_view(lv_obj_t* screen) {
+        lv_obj_t* view = lv_obj_create(screen);
+        lv_obj_remove_style_all(view);
+        lv_obj_set_size(view, LV_PCT(100), LV_PCT(100));
+        lv_obj_clear_flag(view, LV_OBJ_FLAG_SCROLLABLE);
+        return view;
+    }
+}
+
+void screen_build(lv_obj_t* screen, int width, int height) {
+    lv_obj_set_style_bg_color(screen, lv_color_black(), LV_PART_MAIN);
+
+    message_view = create_view(screen);
+    message_label = lv_label_create(message_view);
+    lv_label_set_text(message_label, "Grokband Ready");
+    lv_obj_set_style_text_color(message_label, lv_color_white(), LV_PART_MAIN);
+    lv_obj_set_style_text_align(message_label, LV_TEXT_ALIGN_CENTER, LV_PART_MAIN);
+    lv_label_set_long_mode(message_label, LV_LABEL_LONG_WRAP);
+    lv_obj_set_width(message_label, width - 20);
+    lv_obj_align(message_label, LV_ALIGN_CENTER, 0, -20);
+
+    list_view = create_view(screen);
+    lv_obj_t* title = lv_label_create(list_view);
+    lv_label_set_text_static(title, "Quick Reply:");
+    lv_obj_set_style_text_color(title, lv_color_hex(0x888888), LV_PART_MAIN);
+    lv_obj_align(title, LV_ALIGN_TOP_MID, 0, height / 8);
+    set_hidden(list_view, true);
+
+    status_label = lv_label_create(screen);
+    lv_label_set_text(status_label, "Status: ---");
+    lv_obj_set_style_text_color(status_label, lv_color_hex(0x888888), LV_PART_MAIN);
+    lv_obj_align(status_label, LV_ALIGN_BOTTOM_MID, 0, -5);
+
+    // Focus is shown by the item background; only the items losing and gaining it redraw
+    lv_style_init(&item_style);
+    lv_style_set_radius(&item_style, 6);
+    lv_style_set_bg_opa(&item_style, LV_OPA_TRANSP);
+    lv_style_set_text_color(&item_style, lv_color_hex(0xAAAAAA));
+    lv_style_set_pad_hor(&item_style, 10);
+    lv_style_init(&item_focused_style);
+    lv_style_set_bg_opa(&item_focused_style, LV_OPA_COVER);
+    lv_style_set_bg_color(&item_focused_style, lv_color_hex(0x1E6FD9));
+    lv_style_set_text_color(&item_focused_style, lv_color_white());
+
+    group = lv_group_create();
+    lv_group_set_wrap(group, true);
+}
+
+void screen_set_quick_responses(const char* const* responses, int count) {
+    if (!group) return;
+    if (count > SCREEN_MAX_QUICK_RESPONSES) count = SCREEN_MAX_QUICK_RESPONSES;
+    for (int i = 0; i < item_count; ++i) lv_obj_del(items[i]);
+    lv_group_remove_all_objs(group);
+
+    // Centred on the round glass, where the rows are widest
+    const int top = -(count * kItemHeight) / 2 + kItemHeight / 2;
+    for (int i = 0; i < count; ++i) {
+        lv_obj_t* item = lv_obj_create(list_view);
+        lv_obj_remove_style_all(item);
+        lv_obj_add_style(item, &item_style, LV_PART_MAIN);
+        lv_obj_add_style(item, &item_focused_style, LV_PART_MAIN | LV_STATE_FOCUSED);
+        lv_obj_set_size(item, LV_SIZE_CONTENT, kItemHeight - 4);
+        lv_obj_clear_flag(item, LV_OBJ_FLAG_SCROLLABLE);
+        lv_obj_align(item, LV_ALIGN_CENTER, 0, top + i * kItemHeight);
+
+        lv_obj_t* label = lv_label_create(item);
+        lv_label_set_text_static(label, responses[i]);
+        lv_obj_center(label);
+
+        lv_group_add_obj(group, item);
+        items[i] = item;
+    }
+    item_count = count;
+}
+
+lv_group_t* screen_quick_response_group() {
+    return group;
+}
+
+void screen_show_message(const char* text) {
+    if (!message_view) return; // Display init failed; keep callers working
+    set_text_if_changed(message_label, text);
+    set_hidden(list_view, true);
+    set_hidden(message_view, false);
+}
+
+void screen_clear_message() {
+    if (!message_label) return;
+    set_text_if_changed(message_label, "");
+}
+
+void screen_show_quick_responses(int selected_idx) {
+    if (!list_view) return;
+    if (item_count > 0) {
+        if (selected_idx < 0 || selected_idx >= item_count) selected_idx = 0;
+        lv_group_focus_obj(items[selected_idx]);
+    }
+    set_hidden(message_view, true);
+    set_hidden(list_view, false);
+}
+
+int screen_quick_response_selected() {
+    if (!group) return 0;
+    lv_obj_t* focused = lv_group_get_focused(group);
+    for (int i = 0; i < item_count; ++i) {
+        if (items[i] == focused) return i;
+    }
+    return 0;
+}
+
+void screen_show_status(const char* text) {
+    if (!status_label) return;
+    set_text_if_changed(status_label, text);
+}
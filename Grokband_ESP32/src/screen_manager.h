@@ -0,0 +1,28 @@
+#ifndef SCREEN_MANAGER_H
+#define SCREEN_MANAGER_H
+
+#include "lvgl.h"
+
+// Retained-mode UI: every object (status bar, message view, quick-response list) is created
+// once by screen_build() and afterwards only shown, hidden, re-texted or re-focused, so each
+// interaction invalidates just the objects that changed. A detent in the quick-response list
+// moves focus in an LVGL group, which redraws the two items involved and nothing else.
+// Plain LVGL, no display driver or Arduino dependency, so it also runs in a host LVGL build.
+#define SCREEN_MAX_QUICK_RESPONSES 8
+
+void screen_build(lv_obj_t* screen, int width, int height);
+
+// Creates one list item per response (up to SCREEN_MAX_QUICK_RESPONSES). The strings must
+// outlive the UI; they are displayed in place, not copied.
+void screen_set_quick_responses(const char* const* responses, int count);
+// Group holding the list items, for the encoder input device
+lv_group_t* screen_quick_response_group();
+
+void screen_show_message(const char* text);
+void screen_clear_message();
+void screen_show_quick_responses(int selected_idx);
+// Index of the focused list item
+int screen_quick_response_selected();
+void screen_show_status(const char* text);
+
+#endif // SCREEN_MANAGER_H
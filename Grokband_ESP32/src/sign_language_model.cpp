@@ -1,15 +1,39 @@
 #include "sign_language_model.h"
 #include "config.h" // For TFLITE_MODEL_* defines
 
-#include "tensorflow/lite/micro/all_ops_resolver.h"
+#include "sign_model_ops.h" // Generated by scripts/gen_op_resolver.py from the model being built
+#include "model_loader.h"
+#include "frame_history.h" // FRAME_HISTORY_MAX_DEPTH
+#include "score_postprocess.h"
 #include "tensorflow/lite/micro/micro_error_reporter.h"
 #include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/micro/micro_allocator.h"
 #include "tensorflow/lite/schema/schema_generated.h"
+#include "tensorflow/lite/schema/schema_utils.h"
 #include "tensorflow/lite/version.h"
 
 // For loading model from flash (SPIFFS or LittleFS)
 #include "esp_spiffs.h" // Or LittleFS header if you use that
 #include <stdio.h> // For FILE* operations
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include <math.h>
+
+#if TFLITE_ARENA_MEASURE
+#include "tensorflow/lite/micro/recording_micro_interpreter.h"
+#endif
+#if TFLITE_ARENA_MEASURE || TFLITE_OP_PROFILE
+#include "tflite_profiler.h"
+#endif
+
+#if __has_include("tensor_arena_size.h")
+#include "tensor_arena_size.h" // Measured for the current model, see scripts/arena_from_log.py
+#endif
+#ifndef TFLITE_ARENA_PERSISTENT_SIZE
+// Unmeasured guess (same 90KB total as before). Too small = AllocateTensors() fails.
+#define TFLITE_ARENA_PERSISTENT_SIZE (16 * 1024)
+#define TFLITE_ARENA_NONPERSISTENT_SIZE (74 * 1024)
+#endif
 
 namespace {
     tflite::ErrorReporter* error_reporter = nullptr;
@@ -18,24 +42,250 @@ namespace {
     TfLiteTensor* input_tensor = nullptr;
     TfLiteTensor* output_tensor = nullptr;
 
-    // Arena for TFLite, size depends on your model.
-    // This needs to be tuned! Too small = crash, too large = wasted RAM.
-    constexpr int kTensorArenaSize = 90 * 1024; // EXAMPLE: 90KB, VERY model dependent
-    uint8_t tensor_arena[kTensorArenaSize];
+    // Arena for TFLite. The persistent part holds tensor metadata, quantization params and
+    // kernel state; the non-persistent part holds activations and scratch buffers, which are
+    // touched on every Invoke() and so benefit most from internal SRAM.
+    constexpr size_t kArenaPersistentSize = TFLITE_ARENA_PERSISTENT_SIZE;
+    constexpr size_t kArenaNonPersistentSize = TFLITE_ARENA_NONPERSISTENT_SIZE;
+#if !TFLITE_ARENA_SPLIT
+    constexpr size_t kTensorArenaSize = kArenaPersistentSize + kArenaNonPersistentSize;
+    alignas(16) uint8_t tensor_arena[kTensorArenaSize];
+#endif
+    uint8_t* scratch_arena = nullptr; // Non-persistent part, when it is a separate buffer (shared with the detector)
+
+    // Pixel (0..255) -> input tensor value, built from TFLITE_INPUT_MEAN/STD and the tensor's
+    // quantization params so preprocessing never does per-pixel arithmetic
+    union InputLut {
+        uint8_t u8[256];
+        int8_t i8[256];
+        float f32[256];
+    };
+    InputLut input_lut;
+    ModelInputType input_type;
+
+    SignModelOpResolver op_resolver; // Registered once, shared by both interpreters
+    ModelStageStats classifier_stats = {};
+
+#if HAND_DETECTOR_ENABLED
+    // Stage 1 of the cascade: its own small persistent arena, and the classifier's scratch
+    // arena for activations. Safe because the two never Invoke() at the same time, and every
+    // input is rewritten before its Invoke() (see sign_language_model.h).
+    const tflite::Model* detector_model = nullptr;
+    tflite::MicroInterpreter* detector = nullptr;
+    unsigned char* detector_data_buffer = nullptr; // SPIFFS fallback only
+    const char* detector_path = "/spiffs/hand_detector.tflite";
+    InputLut detector_lut;
+    ModelInputType detector_input_type;
+    ModelStageStats detector_stats = {};
+#endif
+
+#if TFLITE_OP_PROFILE
+    OpTimingProfiler op_profiler;  // Attached to the main interpreter; reported every TFLITE_OP_PROFILE_EVERY invokes
+    uint32_t profiled_invokes = 0;
+#endif
 
     // Path to the model file in SPIFFS/LittleFS
     const char* model_path = "/spiffs/sign_model.tflite"; // Ensure this matches your data dir upload
-    unsigned char* model_data_buffer = nullptr; // To hold model data read from flash
+    unsigned char* model_data_buffer = nullptr; // Heap copy, only used by the SPIFFS fallback
+    const char* calibration_path = "/spiffs/sign_model.calib"; // Per-class thresholds shipped with the model
+
+    ScorePostprocessor postprocessor; // Output tensor -> top-k decision (score_postprocess.h)
 
-    // Example class labels - must match your model's output
+    // Example class labels - must match your model's output (and SIGN_CLASS_LABELS in Grokcom_RPI/config.py,
+    // since binary frames carry the index)
     const char* class_labels[TFLITE_NUM_CLASSES] = {
         "Sign A", "Sign B", "Sign C", "Help", "Yes", "No", "Hello", "Goodbye", "Thank You", "Eat" // Adjust these!
     };
 }
 
-// Helper to load model from flash storage
-bool load_model_from_flash() {
-    // Mount SPIFFS if not already mounted
+// Builds the arena allocator for the configured placement. With the cascade the persistent
+// and non-persistent parts are always separate buffers, so the detector can share the latter.
+static tflite::MicroAllocator* create_arena_allocator() {
+#if TFLITE_ARENA_SPLIT
+    uint8_t* persistent = (uint8_t*)heap_caps_aligned_alloc(16, kArenaPersistentSize, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!persistent) {
+        error_reporter->Report("No PSRAM for the persistent arena, using internal RAM");
+        persistent = (uint8_t*)heap_caps_aligned_alloc(16, kArenaPersistentSize, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    uint8_t* scratch = (uint8_t*)heap_caps_aligned_alloc(16, kArenaNonPersistentSize, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (!persistent || !scratch) {
+        error_reporter->Report("Failed to allocate split tensor arena (%u + %u bytes)",
+                               (unsigned)kArenaPersistentSize, (unsigned)kArenaNonPersistentSize);
+        return nullptr;
+    }
+    scratch_arena = scratch;
+    return tflite::MicroAllocator::Create(persistent, kArenaPersistentSize, scratch, kArenaNonPersistentSize);
+#elif HAND_DETECTOR_ENABLED
+    scratch_arena = tensor_arena + kArenaPersistentSize;
+    return tflite::MicroAllocator::Create(tensor_arena, kArenaPersistentSize, scratch_arena, kArenaNonPersistentSize);
+#else
+    return tflite::MicroAllocator::Create(tensor_arena, kTensorArenaSize);
+#endif
+}
+
+#if TFLITE_ARENA_MEASURE
+// Runs the model a few times in one placement and logs per-layer invoke time
+static void profile_placement(const char* label, tflite::MicroAllocator* allocator, const tflite::MicroOpResolver& resolver) {
+    static OpTimingProfiler profiler;
+    if (!allocator) {
+        error_reporter->Report("[%s] arena allocation failed, skipped", label);
+        return;
+    }
+    tflite::MicroInterpreter* interp = new tflite::MicroInterpreter(model, resolver, allocator, nullptr, &profiler);
+    if (interp->AllocateTensors() == kTfLiteOk) {
+        for (int run = 0; run < 3; ++run) { // Last run is reported, earlier ones warm the caches
+            profiler.reset();
+            interp->Invoke();
+        }
+        profiler.log_report(label, model);
+    } else {
+        error_reporter->Report("[%s] AllocateTensors() failed", label);
+    }
+    delete interp;
+}
+
+// Measures exact arena usage with the recording allocator, prints the size constants for
+// tensor_arena_size.h ("ARENA:" lines, picked up by scripts/arena_from_log.py), then
+// compares per-layer timing for internal-only, PSRAM-only and split placements.
+static void measure_arena(const tflite::MicroOpResolver& resolver) {
+    constexpr size_t kMeasureArenaSize = 512 * 1024;
+    constexpr size_t kMargin = 1024; // Headroom for allocator alignment differences
+    uint8_t* arena = (uint8_t*)heap_caps_aligned_alloc(16, kMeasureArenaSize, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!arena) {
+        error_reporter->Report("Arena measurement needs %u bytes of PSRAM", (unsigned)kMeasureArenaSize);
+        return;
+    }
+
+    size_t persistent = 0, nonpersistent = 0;
+    {
+        tflite::RecordingMicroInterpreter recorder(model, resolver, arena, kMeasureArenaSize);
+        if (recorder.AllocateTensors() != kTfLiteOk) {
+            error_reporter->Report("Arena measurement: AllocateTensors() failed");
+            heap_caps_free(arena);
+            return;
+        }
+        recorder.Invoke(); // Some kernels request scratch lazily
+        recorder.GetMicroAllocator().PrintAllocations();
+        const auto* buffers = recorder.GetMicroAllocator().GetSimpleMemoryAllocator();
+        persistent = (buffers->GetPersistentUsedBytes() + kMargin + 15) & ~(size_t)15;
+        nonpersistent = (buffers->GetNonPersistentUsedBytes() + kMargin + 15) & ~(size_t)15;
+    }
+    heap_caps_free(arena);
+
+    printf("ARENA: #define TFLITE_ARENA_PERSISTENT_SIZE %u\n", (unsigned)persistent);
+    printf("ARENA: #define TFLITE_ARENA_NONPERSISTENT_SIZE %u\n", (unsigned)nonpersistent);
+
+    struct Placement { const char* label; uint32_t persistent_caps; uint32_t scratch_caps; };
+    const Placement placements[] = {
+        { "internal", MALLOC_CAP_INTERNAL, MALLOC_CAP_INTERNAL },
+        { "psram", MALLOC_CAP_SPIRAM, MALLOC_CAP_SPIRAM },
+        { "split", MALLOC_CAP_SPIRAM, MALLOC_CAP_INTERNAL },
+    };
+    for (const Placement& p : placements) {
+        uint8_t* a = (uint8_t*)heap_caps_aligned_alloc(16, persistent, p.persistent_caps | MALLOC_CAP_8BIT);
+        uint8_t* b = (uint8_t*)heap_caps_aligned_alloc(16, nonpersistent, p.scratch_caps | MALLOC_CAP_8BIT);
+        profile_placement(p.label, (a && b) ? tflite::MicroAllocator::Create(a, persistent, b, nonpersistent) : nullptr, resolver);
+        heap_caps_free(a);
+        heap_caps_free(b);
+    }
+}
+#endif
+
+static bool build_input_lut(const TfLiteTensor* tensor, InputLut* lut, ModelInputType* type) {
+    if (tensor->type == kTfLiteFloat32) {
+        *type = ModelInputType::FLOAT32;
+        for (int v = 0; v < 256; ++v) {
+            lut->f32[v] = (v - TFLITE_INPUT_MEAN) / TFLITE_INPUT_STD;
+        }
+        return true;
+    }
+
+    int qmin, qmax;
+    if (tensor->type == kTfLiteUInt8) {
+        *type = ModelInputType::UINT8;
+        qmin = 0; qmax = 255;
+    } else if (tensor->type == kTfLiteInt8) {
+        *type = ModelInputType::INT8;
+        qmin = -128; qmax = 127;
+    } else {
+        error_reporter->Report("Unsupported input tensor type: %d", tensor->type);
+        return false;
+    }
+
+    float scale = tensor->params.scale;
+    int zero_point = tensor->params.zero_point;
+    if (scale <= 0.0f) {
+        error_reporter->Report("Quantized input tensor has no scale");
+        return false;
+    }
+    for (int v = 0; v < 256; ++v) {
+        float real = (v - TFLITE_INPUT_MEAN) / TFLITE_INPUT_STD;
+        int q = (int)lroundf(real / scale) + zero_point;
+        q = q < qmin ? qmin : (q > qmax ? qmax : q);
+        if (*type == ModelInputType::UINT8) lut->u8[v] = (uint8_t)q;
+        else lut->i8[v] = (int8_t)q;
+    }
+    return true;
+}
+
+// ModelInput view of an input tensor ([B, H, W, C] or [B, T, H, W, C]) and its LUT
+static void fill_model_input(TfLiteTensor* tensor, const InputLut& lut, ModelInputType type, ModelInput* input) {
+    const TfLiteIntArray* dims = tensor->dims;
+    const int spatial = dims->size == 5 ? 2 : 1;
+    input->type = type;
+    input->height = dims->data[spatial];
+    input->width = dims->data[spatial + 1];
+    input->channels = dims->data[spatial + 2];
+    input->batch = dims->data[0];
+    input->frames = dims->size == 5 ? dims->data[1] : 1;
+    switch (type) {
+        case ModelInputType::UINT8:
+            input->data = tflite::GetTensorData<uint8_t>(tensor);
+            input->lut = lut.u8;
+            break;
+        case ModelInputType::INT8:
+            input->data = tflite::GetTensorData<int8_t>(tensor);
+            input->lut = lut.i8;
+            break;
+        case ModelInputType::FLOAT32:
+            input->data = tflite::GetTensorData<float>(tensor);
+            input->lut = lut.f32;
+            break;
+    }
+}
+
+// Real value of element `i` of an output tensor
+static float output_value(const TfLiteTensor* tensor, int i) {
+    switch (tensor->type) {
+        case kTfLiteFloat32: return tflite::GetTensorData<float>(tensor)[i];
+        case kTfLiteInt8: return tensor->params.scale * (tflite::GetTensorData<int8_t>(tensor)[i] - tensor->params.zero_point);
+        case kTfLiteUInt8: return tensor->params.scale * (tflite::GetTensorData<uint8_t>(tensor)[i] - tensor->params.zero_point);
+        default: return 0.0f;
+    }
+}
+
+// The resolver only contains the ops of the model this firmware was built against; a different
+// model in flash must not get as far as AllocateTensors() with a missing kernel.
+static bool model_ops_are_registered(const tflite::Model* m) {
+    bool ok = true;
+    for (const tflite::OperatorCode* opcode : *m->operator_codes()) {
+        tflite::BuiltinOperator op = tflite::GetBuiltinCode(opcode);
+        bool found = false;
+        for (tflite::BuiltinOperator registered : kSignModelOps) {
+            if (registered == op) { found = true; break; }
+        }
+        if (!found) {
+            error_reporter->Report("Model needs op %s, which this build does not register",
+                                   tflite::EnumNameBuiltinOperator(op));
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+static bool mount_spiffs() {
+    // Mount SPIFFS if not already mounted. It is never unmounted: the classifier, the detector
+    // fallback and the calibration table (postprocessor_init()) all read from it
     esp_vfs_spiffs_conf_t conf = {
       .base_path = "/spiffs",
       .partition_label = NULL, // Auto-find SPIFFS partition
@@ -47,11 +297,19 @@ bool load_model_from_flash() {
         error_reporter->Report("SPIFFS Mount Failed: %s", esp_err_to_name(ret));
         return false;
     }
+    return true;
+}
+
+// Fallback: copy the model at `path` from SPIFFS into the heap (costs RAM equal to the model size).
+// *buffer receives the heap copy, which backs *out for the life of the firmware.
+bool load_model_from_spiffs(const char* path, const tflite::Model** out, unsigned char** buffer) {
+    if (!mount_spiffs()) {
+        return false;
+    }
 
-    FILE* model_file = fopen(model_path, "rb");
+    FILE* model_file = fopen(path, "rb");
     if (!model_file) {
-        error_reporter->Report("Failed to open model file: %s", model_path);
-        esp_vfs_spiffs_unregister(NULL); // Unmount on failure to open
+        error_reporter->Report("Failed to open model file: %s", path);
         return false;
     }
 
@@ -59,45 +317,190 @@ bool load_model_from_flash() {
     long model_size = ftell(model_file);
     fseek(model_file, 0, SEEK_SET);
 
-    model_data_buffer = (unsigned char*)malloc(model_size);
+    unsigned char* model_data_buffer = (unsigned char*)malloc(model_size);
     if (!model_data_buffer) {
         error_reporter->Report("Failed to allocate memory for model data");
         fclose(model_file);
-        esp_vfs_spiffs_unregister(NULL);
         return false;
     }
 
     size_t bytes_read = fread(model_data_buffer, 1, model_size, model_file);
     fclose(model_file);
-    // Don't unmount SPIFFS yet if other parts of app might use it. Or unmount if done.
-    // esp_vfs_spiffs_unregister(NULL); 
 
     if (bytes_read != model_size) {
         error_reporter->Report("Failed to read entire model file. Read %d, expected %d", bytes_read, model_size);
         free(model_data_buffer);
-        model_data_buffer = nullptr;
         return false;
     }
     
-    model = tflite::GetModel(model_data_buffer);
-    if (model->version() != TFLITE_SCHEMA_VERSION) {
+    const tflite::Model* loaded = tflite::GetModel(model_data_buffer);
+    if (loaded->version() != TFLITE_SCHEMA_VERSION) {
         error_reporter->Report("Model provided is schema version %d not equal to supported version %d.",
-                               model->version(), TFLITE_SCHEMA_VERSION);
+                               loaded->version(), TFLITE_SCHEMA_VERSION);
         free(model_data_buffer); // clean up
-        model_data_buffer = nullptr;
-        model = nullptr;
         return false;
     }
-    error_reporter->Report("Model loaded successfully from flash. Size: %ld bytes", model_size);
+    *out = loaded;
+    *buffer = model_data_buffer;
+    error_reporter->Report("Model loaded successfully from %s. Size: %ld bytes", path, model_size);
+    return true;
+}
+
+// Preferred path: use the model in place from the memory-mapped partition `label`
+// (see model_loader.h). Falls back to SPIFFS for boards flashed before the partition existed.
+bool load_model_from_flash(const char* label, const char* spiffs_path, const tflite::Model** out, unsigned char** buffer) {
+    const uint8_t* mapped_model = nullptr;
+    size_t mapped_size = 0;
+    if (model_map_from_partition(label, TFLITE_SCHEMA_VERSION, &mapped_model, &mapped_size)) {
+        const tflite::Model* mapped = tflite::GetModel(mapped_model);
+        if (mapped->version() == TFLITE_SCHEMA_VERSION) {
+            error_reporter->Report("Model mapped from flash partition '%s'. Size: %u bytes", label, (unsigned)mapped_size);
+            *out = mapped;
+            return true;
+        }
+        error_reporter->Report("Mapped model has schema version %d, expected %d",
+                               mapped->version(), TFLITE_SCHEMA_VERSION);
+    }
+    error_reporter->Report("Model partition '%s' unusable, falling back to SPIFFS", label);
+    return load_model_from_spiffs(spiffs_path, out, buffer);
+}
+
+#if HAND_DETECTOR_ENABLED
+// Stage 1 of the cascade. Any failure leaves the classifier running alone on every frame.
+static bool hand_detector_init() {
+    if (!scratch_arena) return false;
+    if (!load_model_from_flash(HAND_DETECTOR_PARTITION_LABEL, detector_path, &detector_model, &detector_data_buffer)) {
+        return false;
+    }
+    if (!model_ops_are_registered(detector_model)) {
+        error_reporter->Report("List the detector in custom_sign_model so its ops are registered");
+        return false;
+    }
+    uint8_t* persistent = (uint8_t*)heap_caps_aligned_alloc(16, HAND_DETECTOR_ARENA_PERSISTENT_SIZE,
+                                                           MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    tflite::MicroAllocator* allocator = persistent
+        ? tflite::MicroAllocator::Create(persistent, HAND_DETECTOR_ARENA_PERSISTENT_SIZE, scratch_arena, kArenaNonPersistentSize)
+        : nullptr;
+    if (!allocator) {
+        error_reporter->Report("Hand detector arena allocation failed");
+        heap_caps_free(persistent);
+        return false;
+    }
+    static tflite::MicroInterpreter static_detector(detector_model, op_resolver, allocator);
+    if (static_detector.AllocateTensors() != kTfLiteOk) {
+        error_reporter->Report("Hand detector AllocateTensors() failed (needs more than the classifier's %u scratch bytes?)",
+                               (unsigned)kArenaNonPersistentSize);
+        return false;
+    }
+    TfLiteTensor* in = static_detector.input(0);
+    TfLiteTensor* out = static_detector.output(0);
+    const int outputs = out->dims->data[out->dims->size - 1];
+    if (in->dims->size != 4 || in->dims->data[0] != 1 || in->dims->data[3] != 1 || (outputs != 1 && outputs != 5)) {
+        error_reporter->Report("Hand detector must take [1, H, W, 1] luma and output [1, 1] or [1, 5]");
+        return false;
+    }
+    if (!build_input_lut(in, &detector_lut, &detector_input_type)) {
+        return false;
+    }
+    detector = &static_detector;
+    error_reporter->Report("Hand detector ready: %dx%d input, %s output, arena %u bytes (scratch shared)",
+                           in->dims->data[2], in->dims->data[1], outputs == 5 ? "presence+box" : "presence",
+                           (unsigned)static_detector.arena_used_bytes());
+    return true;
+}
+#endif
+
+
+// Output quantization plus the calibration table from SPIFFS, if the model shipped with one;
+// otherwise every class gets SCORE_DEFAULT_THRESHOLD/MARGIN
+static bool postprocessor_init() {
+    ScoreType type;
+    switch (output_tensor->type) {
+        case kTfLiteUInt8: type = ScoreType::UINT8; break;
+        case kTfLiteInt8: type = ScoreType::INT8; break;
+        case kTfLiteFloat32: type = ScoreType::FLOAT32; break;
+        default:
+            error_reporter->Report("Unsupported output tensor type: %d", output_tensor->type);
+            return false;
+    }
+    const ClassCalibration defaults = { SCORE_DEFAULT_THRESHOLD, SCORE_DEFAULT_MARGIN, 1.0f, 0.0f };
+    if (!postprocessor.begin(TFLITE_NUM_CLASSES, type, output_tensor->params.scale,
+                             output_tensor->params.zero_point, defaults)) {
+        error_reporter->Report("Output quantization unusable (scale %f)", (double)output_tensor->params.scale);
+        return false;
+    }
+
+    FILE* f = mount_spiffs() ? fopen(calibration_path, "rb") : nullptr;
+    if (!f) {
+        error_reporter->Report("No %s; default thresholds for every class", calibration_path);
+        return true;
+    }
+    char text[1024];
+    size_t len = fread(text, 1, sizeof(text) - 1, f);
+    fclose(f);
+    text[len] = '\0';
+    int lines = len < sizeof(text) - 1 ? postprocessor.load_calibration(text) : -1;
+    if (lines < 0) {
+        error_reporter->Report("Malformed or oversized %s ignored; default thresholds", calibration_path);
+    } else {
+        error_reporter->Report("Calibration: %d entries from %s", lines, calibration_path);
+    }
     return true;
 }
 
+#if TFLITE_KERNEL_CHECK
+static uint32_t crc32_update(uint32_t crc, const uint8_t* data, size_t len) {
+    crc = ~crc;
+    for (size_t i = 0; i < len; ++i) {
+        crc ^= data[i];
+        for (int b = 0; b < 8; ++b) crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+    }
+    return ~crc;
+}
+
+// Kernel backend equivalence: the same seeded pixels on every build, written through the input
+// LUT, so KCHECK lines from a reference and an ESP-NN build must match bit for bit
+// (scripts/op_profile_diff.py --kernels). Exercises exactly the ops and shapes of this model.
+static void run_kernel_check() {
+    const int elems = (int)(input_tensor->bytes / (input_type == ModelInputType::FLOAT32 ? sizeof(float) : 1));
+    uint32_t seed = 0x9E3779B9u;
+    uint32_t total_us = 0;
+    for (int c = 0; c < TFLITE_KERNEL_CHECK_CASES; ++c) {
+        for (int i = 0; i < elems; ++i) {
+            seed ^= seed << 13; seed ^= seed >> 17; seed ^= seed << 5; // xorshift32
+            const uint8_t pixel = (uint8_t)(seed >> 24);
+            switch (input_type) {
+                case ModelInputType::UINT8: input_tensor->data.uint8[i] = input_lut.u8[pixel]; break;
+                case ModelInputType::INT8: input_tensor->data.int8[i] = input_lut.i8[pixel]; break;
+                case ModelInputType::FLOAT32: input_tensor->data.f[i] = input_lut.f32[pixel]; break;
+            }
+        }
+#if TFLITE_OP_PROFILE
+        op_profiler.reset();
+#endif
+        int64_t start_us = esp_timer_get_time();
+        if (interpreter->Invoke() != kTfLiteOk) {
+            error_reporter->Report("Kernel check: Invoke() failed on case %d", c);
+            return;
+        }
+        uint32_t us = (uint32_t)(esp_timer_get_time() - start_us);
+        total_us += us;
+        printf("KCHECK,%s,%d,%08x,%u\n", TFLITE_KERNEL_BACKEND, c,
+               (unsigned)crc32_update(0, output_tensor->data.uint8, output_tensor->bytes), (unsigned)us);
+    }
+#if TFLITE_OP_PROFILE
+    op_profiler.log_report(TFLITE_KERNEL_BACKEND, model); // Per-op times of the last case
+#endif
+    error_reporter->Report("Kernel check (%s): %d cases, %u us per Invoke()", TFLITE_KERNEL_BACKEND,
+                           TFLITE_KERNEL_CHECK_CASES, (unsigned)(total_us / TFLITE_KERNEL_CHECK_CASES));
+}
+#endif
 
 bool tflite_init() {
     static tflite::MicroErrorReporter micro_error_reporter;
     error_reporter = &micro_error_reporter;
 
-    if (!load_model_from_flash()) {
+    if (!load_model_from_flash(MODEL_PARTITION_LABEL, model_path, &model, &model_data_buffer)) {
         error_reporter->Report("Failed to load TFLite model from flash.");
         return false; // Critical failure
     }
@@ -105,120 +508,221 @@ bool tflite_init() {
     if (!model) return false;
 
 
-    // This pulls in all operators. For production, you might want a subset
-    // to save space, using tflite::MicroMutableOpResolver.
-    static tflite::AllOpsResolver resolver;
-
-    static tflite::MicroInterpreter static_interpreter(model, resolver, tensor_arena, kTensorArenaSize, error_reporter);
+    // Only the kernels the model uses are linked in (see scripts/gen_op_resolver.py)
+    if (!model_ops_are_registered(model)) {
+        return false;
+    }
+    if (!sign_model_register_ops(op_resolver)) {
+        error_reporter->Report("Op resolver registration failed");
+        return false;
+    }
+#if !SIGN_MODEL_OPS_FROM_MODEL
+    error_reporter->Report("Resolver registers all %d known ops (built without the model, or custom_all_ops_resolver)",
+                           kSignModelOpCount);
+#endif
+
+#if TFLITE_ARENA_MEASURE
+    measure_arena(op_resolver);
+#endif
+
+    tflite::MicroAllocator* allocator = create_arena_allocator();
+    if (!allocator) {
+        error_reporter->Report("Tensor arena allocator creation failed");
+        return false;
+    }
+#if TFLITE_OP_PROFILE
+    static tflite::MicroInterpreter static_interpreter(model, op_resolver, allocator, nullptr, &op_profiler);
+#else
+    static tflite::MicroInterpreter static_interpreter(model, op_resolver, allocator);
+#endif
     interpreter = &static_interpreter;
 
+    int64_t allocate_start_us = esp_timer_get_time();
     TfLiteStatus allocate_status = interpreter->AllocateTensors();
     if (allocate_status != kTfLiteOk) {
         error_reporter->Report("AllocateTensors() failed");
         return false;
     }
+    error_reporter->Report("AllocateTensors() took %d us, %d ops registered (%s kernels), arena %u of %u bytes used",
+                           (int)(esp_timer_get_time() - allocate_start_us), kSignModelOpCount, TFLITE_KERNEL_BACKEND,
+                           (unsigned)interpreter->arena_used_bytes(),
+                           (unsigned)(kArenaPersistentSize + kArenaNonPersistentSize));
 
     input_tensor = interpreter->input(0);
     output_tensor = interpreter->output(0);
 
-    // Sanity check tensor dimensions (optional but good)
-    if (input_tensor->dims->size < 3 || // B, H, W, C (usually B is 1 for micro)
-        input_tensor->dims->data[1] != TFLITE_MODEL_INPUT_HEIGHT ||
-        input_tensor->dims->data[2] != TFLITE_MODEL_INPUT_WIDTH ||
-        input_tensor->dims->data[3] != TFLITE_MODEL_INPUT_CHANNELS) {
+    // Sanity check tensor dimensions: B, H, W, C, or B, T, H, W, C for temporal models
+    // (T consecutive frames per sample, see frame_history.h)
+    const TfLiteIntArray* in_dims = input_tensor->dims;
+    const int spatial = in_dims->size == 5 ? 2 : 1;
+    if ((in_dims->size != 4 && in_dims->size != 5) ||
+        in_dims->data[spatial] != TFLITE_MODEL_INPUT_HEIGHT ||
+        in_dims->data[spatial + 1] != TFLITE_MODEL_INPUT_WIDTH ||
+        in_dims->data[spatial + 2] != TFLITE_MODEL_INPUT_CHANNELS) {
         error_reporter->Report("Bad input tensor parameters in model!");
         return false;
     }
+    if (in_dims->size == 5 && (in_dims->data[1] < 1 || in_dims->data[1] > FRAME_HISTORY_MAX_DEPTH)) {
+        error_reporter->Report("Temporal model wants %d frames, at most %d supported",
+                               in_dims->data[1], FRAME_HISTORY_MAX_DEPTH);
+        return false;
+    }
     if (output_tensor->dims->data[1] != TFLITE_NUM_CLASSES) {
          error_reporter->Report("Bad output tensor parameters in model! Expected %d classes, got %d",
                                 TFLITE_NUM_CLASSES, output_tensor->dims->data[1]);
         return false;
     }
+    if (!build_input_lut(input_tensor, &input_lut, &input_type)) {
+        return false;
+    }
+    if (!postprocessor_init()) {
+        return false;
+    }
+#if TFLITE_KERNEL_CHECK
+    run_kernel_check();
+#endif
+#if HAND_DETECTOR_ENABLED
+    if (!hand_detector_init()) {
+        error_reporter->Report("No hand detector; the classifier runs on every frame");
+    }
+#endif
 
 
-    error_reporter->Report("TensorFlow Lite Micro Initialized");
+    error_reporter->Report("TensorFlow Lite Micro Initialized, free heap %u bytes",
+                           (unsigned)heap_caps_get_free_size(MALLOC_CAP_8BIT));
     return true;
 }
 
-int tflite_predict(uint8_t* image_data, float* scores_out) {
+bool tflite_get_input(ModelInput* input) {
+    if (!interpreter || !input_tensor || !input) return false;
+    fill_model_input(input_tensor, input_lut, input_type, input);
+    return true;
+}
+
+int tflite_predict(float* scores_out) {
+    if (!tflite_invoke()) return -1;
+    return tflite_read_output(0, scores_out);
+}
+
+bool tflite_invoke() {
     if (!interpreter || !input_tensor) {
         error_reporter->Report("TFLite not initialized or input tensor is null.");
-        return -1;
-    }
-
-    // Copy image data to input tensor
-    // Model might expect float input between -1 and 1 or 0 and 1.
-    // If so, normalization needs to happen here or in preprocess_camera_frame.
-    // For uint8 quantized models, direct copy might be fine.
-    if (input_tensor->type == kTfLiteUInt8) {
-        uint8_t* input_data_ptr = tflite::GetTensorData<uint8_t>(input_tensor);
-        memcpy(input_data_ptr, image_data, input_tensor->bytes);
-    } else if (input_tensor->type == kTfLiteFloat32) {
-        float* input_data_ptr = tflite::GetTensorData<float>(input_tensor);
-        // Assuming image_data is uint8, convert and normalize
-        for (size_t i = 0; i < input_tensor->bytes / sizeof(float); ++i) {
-            // Example normalization: (0 to 255) -> (-1 to 1)
-            input_data_ptr[i] = (static_cast<float>(image_data[i]) - 127.5f) / 127.5f;
-        }
-    } else {
-        error_reporter->Report("Unsupported input tensor type: %d", input_tensor->type);
-        return -1;
+        return false;
     }
 
-
+#if TFLITE_OP_PROFILE
+    op_profiler.reset();
+#endif
+    // The input tensor was filled in place by preprocess_camera_frame() via tflite_get_input()
+    int64_t start_us = esp_timer_get_time();
     TfLiteStatus invoke_status = interpreter->Invoke();
+    classifier_stats.invokes++;
+    classifier_stats.total_us += (uint64_t)(esp_timer_get_time() - start_us);
     if (invoke_status != kTfLiteOk) {
         error_reporter->Report("Invoke() failed");
-        return -1;
+        return false;
+    }
+#if TFLITE_OP_PROFILE
+    if (++profiled_invokes % TFLITE_OP_PROFILE_EVERY == 0) {
+        op_profiler.log_report("device", model);
     }
+#endif
+    return true;
+}
 
+int tflite_read_output(int slot, float* scores_out) {
+    if (!interpreter) return -1;
     output_tensor = interpreter->output(0); // Re-get output tensor just in case
+    if (slot < 0 || slot >= output_tensor->dims->data[0]) {
+        error_reporter->Report("Output batch slot %d out of range", slot);
+        return -1;
+    }
+    const int base = slot * TFLITE_NUM_CLASSES;
 
-    // Process output tensor
+    // Argmax on the dequantized scores; tflite_read_topk() is the thresholded decision
     int max_score_index = -1;
-    float max_score = -1.0f; // Assuming scores are probabilities (0-1) or logits
-
+    float max_score = -1e30f;
     for (int i = 0; i < TFLITE_NUM_CLASSES; ++i) {
-        float current_score;
-        if (output_tensor->type == kTfLiteUInt8) {
-            // Dequantize if necessary. Output scale and zero point are needed.
-            // For simplicity, let's assume it gives raw scores or direct class if it's argmax inside model.
-            // This part is highly dependent on your model's output layer.
-            // If it's logits, you might apply softmax here.
-            // If it's probabilities, they might be uint8 representing 0-255.
-            uint8_t val = tflite::GetTensorData<uint8_t>(output_tensor)[i];
-            current_score = val / 255.0f; // Simple scaling if output is uint8 prob
-            // Or use dequantize formula: float real_value = scale * (quantized_value - zero_point);
-            // float scale = output_tensor->params.scale;
-            // int zero_point = output_tensor->params.zero_point;
-            // current_score = scale * (val - zero_point);
-
-        } else if (output_tensor->type == kTfLiteFloat32) {
-            current_score = tflite::GetTensorData<float>(output_tensor)[i];
-        } else {
-            error_reporter->Report("Unsupported output tensor type: %d", output_tensor->type);
-            return -1;
-        }
-        
+        float current_score = output_value(output_tensor, base + i);
         if (scores_out) {
             scores_out[i] = current_score;
         }
-
         if (current_score > max_score) {
             max_score = current_score;
             max_score_index = i;
         }
     }
-    
-    // Optional: Add a confidence threshold
-    // float confidence_threshold = 0.7; // Example
-    // if (max_score < confidence_threshold) {
-    //     return -1; // Not confident enough
-    // }
-
     return max_score_index;
 }
 
+bool tflite_read_topk(int slot, int k, TopKResult* out) {
+    if (!interpreter || !out) return false;
+    output_tensor = interpreter->output(0);
+    if (slot < 0 || slot >= output_tensor->dims->data[0]) {
+        error_reporter->Report("Output batch slot %d out of range", slot);
+        return false;
+    }
+    const size_t element = output_tensor->type == kTfLiteFloat32 ? sizeof(float) : 1;
+    postprocessor.process(output_tensor->data.uint8 + (size_t)slot * TFLITE_NUM_CLASSES * element, k, out);
+    return true;
+}
+
+bool hand_detector_available() {
+#if HAND_DETECTOR_ENABLED
+    return detector != nullptr;
+#else
+    return false;
+#endif
+}
+
+bool hand_detector_get_input(ModelInput* input) {
+#if HAND_DETECTOR_ENABLED
+    if (!detector || !input) return false;
+    fill_model_input(detector->input(0), detector_lut, detector_input_type, input);
+    return true;
+#else
+    (void)input;
+    return false;
+#endif
+}
+
+bool hand_detector_run(HandDetection* out) {
+#if HAND_DETECTOR_ENABLED
+    if (!detector || !out) return false;
+    int64_t start_us = esp_timer_get_time();
+    TfLiteStatus status = detector->Invoke();
+    detector_stats.invokes++;
+    detector_stats.total_us += (uint64_t)(esp_timer_get_time() - start_us);
+    if (status != kTfLiteOk) {
+        error_reporter->Report("Hand detector Invoke() failed");
+        return false;
+    }
+    // Read now: the output lives in the shared scratch arena the classifier input overwrites
+    const TfLiteTensor* output = detector->output(0);
+    out->presence = output_value(output, 0);
+    out->has_box = output->dims->data[output->dims->size - 1] == 5;
+    if (out->has_box) {
+        out->cx = output_value(output, 1);
+        out->cy = output_value(output, 2);
+        out->w = output_value(output, 3);
+        out->h = output_value(output, 4);
+    }
+    return true;
+#else
+    (void)out;
+    return false;
+#endif
+}
+
+void tflite_get_stage_stats(ModelStageStats* detector_out, ModelStageStats* classifier_out) {
+#if HAND_DETECTOR_ENABLED
+    if (detector_out) *detector_out = detector_stats;
+#else
+    if (detector_out) *detector_out = ModelStageStats{};
+#endif
+    if (classifier_out) *classifier_out = classifier_stats;
+}
+
 const char* get_class_label(int class_index) {
     if (class_index >= 0 && class_index < TFLITE_NUM_CLASSES) {
         return class_labels[class_index];
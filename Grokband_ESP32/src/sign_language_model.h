@@ -2,11 +2,42 @@
 #define SIGN_LANGUAGE_MODEL_H
 
 #include <stdint.h>
+#include "model_input.h"
+#include "score_postprocess.h"
 
 bool tflite_init();
+// Exposes the interpreter's input tensor (and its pixel LUT) so preprocessing can write into it
+// directly. Valid after tflite_init(); fill it, then call tflite_predict().
+bool tflite_get_input(ModelInput* input);
+// Runs inference on the current contents of the input tensor.
 // Returns index of detected class, or -1 on error/no detection
 // `scores` array will be filled with probabilities if provided (size should be TFLITE_NUM_CLASSES)
-int tflite_predict(uint8_t* image_data, float* scores = nullptr); 
+int tflite_predict(float* scores = nullptr);
+// Same as tflite_predict(), split for batched inputs: one Invoke(), then read each batch slot.
+bool tflite_invoke();
+int tflite_read_output(int slot, float* scores = nullptr);
+// The decision for batch slot `slot`: top-k taken on the quantized output, per-class thresholds
+// and margins from the model's calibration table (score_postprocess.h). Only the k winners are
+// dequantized; tflite_read_output() converts every class.
+bool tflite_read_topk(int slot, int k, TopKResult* out);
 const char* get_class_label(int class_index); // Maps index to string like "Hello", "Thank You"
 
+// Stage 1 of the cascade (HAND_DETECTOR_ENABLED): a tiny hand-presence model on a luma thumbnail.
+// Its activations live in the classifier's scratch arena, so per frame: fill its input,
+// hand_detector_run(), and only then write the classifier input.
+struct HandDetection {
+    float presence;         // 0..1
+    bool has_box;           // Model also outputs a box, normalized to its input
+    float cx, cy, w, h;
+};
+bool hand_detector_available(); // False if disabled, or its model is missing/unusable
+bool hand_detector_get_input(ModelInput* input);
+bool hand_detector_run(HandDetection* out);
+
+struct ModelStageStats {
+    uint32_t invokes;
+    uint64_t total_us;
+};
+void tflite_get_stage_stats(ModelStageStats* detector, ModelStageStats* classifier);
+
 #endif // SIGN_LANGUAGE_MODEL_H
\ No newline at end of file
@@ -0,0 +1,63 @@
+#include "sign_stream.h"
+
+SignStreamClassifier::SignStreamClassifier(const SignStreamParams& params) : params_(params) {
+    if (params_.num_classes > SIGN_STREAM_MAX_CLASSES) params_.num_classes = SIGN_STREAM_MAX_CLASSES;
+    if (params_.num_classes < 1) params_.num_classes = 1;
+    if (params_.window > SIGN_STREAM_MAX_WINDOW) params_.window = SIGN_STREAM_MAX_WINDOW;
+    if (params_.window < 1) params_.window = 1;
+    if (params_.exit > params_.enter) params_.exit = params_.enter;
+    reset();
+}
+
+void SignStreamClassifier::reset() {
+    head_ = 0;
+    count_ = 0;
+    candidate_ = -1;
+    candidate_frames_ = 0;
+    active_ = -1;
+    below_frames_ = 0;
+}
+
+bool SignStreamClassifier::update(const float* scores, SignEmission* out) {
+    const int n = params_.num_classes;
+    for (int c = 0; c < n; ++c) window_[head_][c] = scores[c];
+    head_ = head_ + 1 == params_.window ? 0 : head_ + 1;
+    if (count_ < params_.window) count_++;
+
+    // Summed afresh each time (window * classes adds): no drift from a running sum
+    int best = 0;
+    for (int c = 0; c < n; ++c) {
+        float sum = 0.0f;
+        for (int i = 0; i < count_; ++i) sum += window_[i][c];
+        mean_[c] = sum / count_;
+        if (mean_[c] > mean_[best]) best = c;
+    }
+
+    if (active_ >= 0) {
+        below_frames_ = mean_[active_] < params_.exit ? below_frames_ + 1 : 0;
+        if (below_frames_ >= params_.release_frames) {
+            active_ = -1;
+            candidate_ = -1;
+            candidate_frames_ = 0;
+        }
+        return false;
+    }
+
+    if (mean_[best] < params_.enter) {
+        candidate_ = -1;
+        candidate_frames_ = 0;
+        return false;
+    }
+    candidate_frames_ = best == candidate_ ? candidate_frames_ + 1 : 1;
+    candidate_ = best;
+    if (candidate_frames_ < params_.min_frames) return false;
+
+    active_ = best;
+    below_frames_ = 0;
+    emitted_++;
+    if (out) {
+        out->class_idx = best;
+        out->score = mean_[best];
+    }
+    return true;
+}
@@ -0,0 +1,53 @@
+#ifndef SIGN_STREAM_H
+#define SIGN_STREAM_H
+
+#include <stdint.h>
+
+#define SIGN_STREAM_MAX_WINDOW 16
+#define SIGN_STREAM_MAX_CLASSES 32
+
+// Turns per-frame class scores into one event per gesture. Scores are averaged over a sliding
+// window of the last `window` inferences; a class is emitted once its mean has stayed at or
+// above `enter` for `min_frames` consecutive inferences. It then stays active, and nothing
+// else is emitted, until its mean has been below `exit` (< enter) for `release_frames`.
+// Nothing in here depends on ESP-IDF.
+struct SignStreamParams {
+    int num_classes;
+    int window;
+    float enter;
+    float exit;
+    int min_frames;
+    int release_frames;
+};
+
+struct SignEmission {
+    int class_idx;
+    float score;    // Window mean of the class when it was emitted
+};
+
+class SignStreamClassifier {
+public:
+    explicit SignStreamClassifier(const SignStreamParams& params);
+
+    // Clears the window and any active gesture, e.g. when signing restarts
+    void reset();
+    // Feeds one inference's scores (num_classes). Returns true, once per gesture, when a sign is recognized.
+    bool update(const float* scores, SignEmission* out);
+
+    int active_class() const { return active_; }    // -1 between gestures
+    uint32_t emitted() const { return emitted_; }
+
+private:
+    SignStreamParams params_;
+    float window_[SIGN_STREAM_MAX_WINDOW][SIGN_STREAM_MAX_CLASSES];
+    float mean_[SIGN_STREAM_MAX_CLASSES];
+    int head_ = 0;
+    int count_ = 0;
+    int candidate_ = -1;        // Class above `enter`, not yet for min_frames
+    int candidate_frames_ = 0;
+    int active_ = -1;
+    int below_frames_ = 0;
+    uint32_t emitted_ = 0;
+};
+
+#endif // SIGN_STREAM_H
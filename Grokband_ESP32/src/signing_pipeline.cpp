@@ -0,0 +1,436 @@
+#include "signing_pipeline.h"
+#include "camera_handler.h"
+#include "sign_language_model.h"
+#include "trace.h"
+#include "frame_history.h"
+#include "sign_stream.h"
+#include "input_handler.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/event_groups.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+
+static const char* TAG = "pipeline";
+
+// Two tasks:
+//   capture -> frame_q -> inference (preprocess into the input tensor + Invoke) -> result_q -> loop()
+// Frame handles (camera_fb_t*) are passed by value through a bounded queue. With
+// CAMERA_FB_COUNT >= 3 (PSRAM boards) the sensor DMA fills one buffer while another waits in
+// frame_q and a third is being preprocessed; with the Pico D4's two, the sensor fills one while
+// the other is queued or preprocessed. Either way capture overlaps inference. Preprocessing
+// writes straight into the interpreter's input tensor, so it has to run back to back with Invoke().
+// The motion gate and hand tracker run first: static frames go straight back to the driver,
+// the rest are cropped to the tracked hand box(es). With a hand detector (HAND_DETECTOR_ENABLED)
+// a tiny model then looks at the gate's thumbnail: frames without a hand never reach the
+// classifier, and its box, when it has one, replaces the tracker's crop for a single hand.
+// Temporal models take the last N frames per sample: each frame is preprocessed once into the
+// hand's FrameHistory and the window is copied into the tensor. Per-frame scores go through a
+// SignStreamClassifier per hand, so loop() gets one result per gesture, not one per frame.
+namespace {
+    struct FrameMsg {
+        camera_fb_t* fb;
+        uint32_t capture_us;
+    };
+
+    constexpr int kResultQueueLen = 4;
+    constexpr TickType_t kStageTimeout = pdMS_TO_TICKS(100); // bounds how long a stage takes to notice stop()
+    constexpr uint32_t kStatsWindowUs = 5 * 1000 * 1000;
+
+    constexpr EventBits_t RUN_BIT          = BIT0;
+    constexpr EventBits_t CAPTURE_IDLE_BIT = BIT1;
+    constexpr EventBits_t INFER_IDLE_BIT   = BIT2;
+    constexpr EventBits_t ALL_IDLE_BITS    = CAPTURE_IDLE_BIT | INFER_IDLE_BIT;
+
+    ModelInput model_input;              // Interpreter input tensor view, fetched once at init
+    ModelInput detector_input;           // Hand detector input; valid if use_detector
+    bool use_detector = false;
+
+    FrameHistory history[HAND_ROI_MAX_HANDS]; // Temporal models only; storage allocated at init
+    uint8_t* history_storage = nullptr;
+
+    const SignStreamParams kStreamParams = {
+        TFLITE_NUM_CLASSES, SIGN_STREAM_WINDOW, SIGN_STREAM_ENTER, SIGN_STREAM_EXIT,
+        SIGN_STREAM_MIN_FRAMES, SIGN_STREAM_RELEASE_FRAMES
+    };
+    static_assert(HAND_ROI_MAX_HANDS == 2, "one SignStreamClassifier per hand");
+    SignStreamClassifier streams[HAND_ROI_MAX_HANDS] = { SignStreamClassifier(kStreamParams), SignStreamClassifier(kStreamParams) };
+
+    QueueHandle_t frame_q = nullptr;  // FrameMsg, capture -> inference
+    QueueHandle_t result_q = nullptr; // SignResult, inference -> loop()
+    EventGroupHandle_t events = nullptr;
+
+    volatile uint32_t frames_captured = 0;
+    volatile uint32_t frames_dropped = 0;
+    volatile uint32_t frames_inferred = 0;
+    volatile uint32_t frames_skipped = 0;
+    volatile uint32_t frames_no_hand = 0;
+    volatile uint32_t frames_rejected = 0;
+    SignPipelineStats last_stats = {};
+
+    bool is_running() {
+        return (xEventGroupGetBits(events) & RUN_BIT) != 0;
+    }
+
+    // Parks the calling stage until start() and reports it as idle meanwhile
+    void wait_for_run(EventBits_t idle_bit) {
+        xEventGroupSetBits(events, idle_bit);
+        xEventGroupWaitBits(events, RUN_BIT, pdFALSE, pdTRUE, portMAX_DELAY);
+        xEventGroupClearBits(events, idle_bit);
+    }
+
+    void push_result(const SignResult& result) {
+        if (xQueueSend(result_q, &result, 0) != pdTRUE) {
+            // loop() is behind; keep the newest result
+            SignResult stale;
+            xQueueReceive(result_q, &stale, 0);
+            xQueueSend(result_q, &result, 0);
+        }
+        input_wake(); // loop() publishes it now rather than after its idle wait
+    }
+
+    // Feeds batch slot `slot` of the output tensor to `hand`'s gesture segmentation and queues
+    // a result when that completes a sign. The window sees the post-processor's calibrated
+    // probabilities for the k winners and zero for every other class; a frame it rejects
+    // counts as "no sign". Nothing else of the output is dequantized.
+    void push_hand_result(int hand, int slot, uint32_t capture_us) {
+        float scores[TFLITE_NUM_CLASSES] = {};
+        TopKResult top;
+        if (!tflite_read_topk(slot, SCORE_TOPK, &top)) return;
+        if (top.verdict != ScoreVerdict::ACCEPTED) {
+            frames_rejected++;
+        } else {
+            for (int i = 0; i < top.count; ++i) scores[top.top[i].class_idx] = top.top[i].prob;
+        }
+        SignEmission sign;
+        if (!streams[hand].update(scores, &sign)) return;
+        SignResult result;
+        result.ok = true;
+        result.class_idx = sign.class_idx;
+        result.hand = hand;
+        result.score = sign.score;
+        result.capture_us = capture_us;
+        result.latency_us = (uint32_t)esp_timer_get_time() - capture_us;
+        push_result(result);
+    }
+
+    // Preprocesses `hand`'s crop for tensor batch slot `slot`. Single-frame models get it straight
+    // in the tensor; temporal ones in the hand's history, whose window is then copied into the
+    // slot. *ready is false while that window is still filling (nothing to invoke yet).
+    bool stage_hand(camera_fb_t* fb, CropRect crop, int hand, int slot, uint32_t capture_us, bool* ready) {
+        ModelInput dst = model_input_slot(model_input, slot);
+        if (model_input.frames == 1) {
+            *ready = true;
+            return preprocess_camera_frame(fb, dst, crop);
+        }
+        FrameHistory& h = history[hand];
+        if (h.count() > 0 && capture_us - h.newest_us() > TEMPORAL_MAX_GAP_MS * 1000u) {
+            h.reset(); // A pause; frames from before it are another gesture
+        }
+        *ready = false;
+        if (!preprocess_camera_frame(fb, model_input_frame_at(model_input, h.head()), crop)) return false;
+        h.commit(capture_us);
+        if (h.full()) {
+            h.copy_window(static_cast<uint8_t*>(dst.data));
+            *ready = true;
+        }
+        return true;
+    }
+
+    // Cascade stage 1. Returns false if the detector saw no hand. Must run before anything is
+    // written to the classifier input: the two models share scratch arena memory.
+    bool detect_hand(camera_fb_t* fb, HandRois* rois) {
+        CropRect region;
+        HandDetection det;
+        if (!camera_thumb_to_input(detector_input, &region) || !hand_detector_run(&det)) {
+            return true; // No verdict; classify as if there were no detector
+        }
+        if (det.presence < HAND_DETECTOR_THRESHOLD) return false;
+        if (det.has_box && rois->count == 1) {
+            rois->crop[0] = hand_box_to_crop(det.cx, det.cy, det.w, det.h, region, fb->width, fb->height,
+                                             model_input.width, model_input.height, HAND_DETECTOR_BOX_MARGIN_Q8);
+        }
+        return true;
+    }
+
+    // Mean Invoke() time of a stage over the reporting window (counters are cumulative)
+    uint32_t window_avg_us(const ModelStageStats& now, const ModelStageStats& before) {
+        uint32_t n = now.invokes - before.invokes;
+        return n ? (uint32_t)((now.total_us - before.total_us) / n) : 0;
+    }
+
+    void capture_task(void*) {
+        for (;;) {
+            wait_for_run(CAPTURE_IDLE_BIT);
+            while (is_running()) {
+                uint32_t t0 = trace_begin();
+                camera_fb_t* fb = camera_capture_frame();
+                trace_end(TraceStage::CAPTURE, t0);
+                if (!fb) {
+                    vTaskDelay(pdMS_TO_TICKS(10));
+                    continue;
+                }
+                FrameMsg msg = { fb, (uint32_t)esp_timer_get_time() };
+                frames_captured++;
+                if (xQueueSend(frame_q, &msg, 0) != pdTRUE) {
+                    // Inference is still busy: the newer frame replaces the queued one, so a frame
+                    // never waits behind another (grab-latest, like the driver)
+                    FrameMsg stale;
+                    if (xQueueReceive(frame_q, &stale, 0) == pdTRUE) {
+                        camera_return_frame(stale.fb);
+                        frames_dropped++;
+                    }
+                    if (xQueueSend(frame_q, &msg, kStageTimeout) != pdTRUE) {
+                        camera_return_frame(fb);
+                        frames_dropped++;
+                    }
+                }
+            }
+        }
+    }
+
+    void inference_task(void*) {
+        uint32_t window_start_us = (uint32_t)esp_timer_get_time();
+        uint32_t window_frames = 0;
+        uint64_t window_latency_us = 0;
+        uint32_t window_no_hand = frames_no_hand;
+        ModelStageStats window_det = {}, window_cls = {};
+
+        for (;;) {
+            wait_for_run(INFER_IDLE_BIT);
+            while (is_running()) {
+                FrameMsg msg;
+                if (xQueueReceive(frame_q, &msg, kStageTimeout) != pdTRUE) continue;
+
+                HandRois rois;
+                uint32_t t0 = trace_begin();
+                bool moved = camera_analyze_frame(msg.fb, model_input, &rois);
+                trace_end(TraceStage::ANALYZE, t0);
+                if (!moved) {
+                    camera_return_frame(msg.fb);
+                    frames_skipped++;
+                    continue;
+                }
+                if (use_detector) {
+                    t0 = trace_begin();
+                    bool hand = detect_hand(msg.fb, &rois);
+                    trace_end(TraceStage::DETECT, t0);
+                    if (!hand) {
+                        camera_return_frame(msg.fb);
+                        frames_no_hand++;
+                        continue;
+                    }
+                }
+
+                // Two hands go into two batch slots of one Invoke() if the model has them,
+                // otherwise through the interpreter one after the other
+                bool ok = true;
+                bool returned = false;
+                bool invoked = false;
+                bool ready[HAND_ROI_MAX_HANDS] = {};
+                if (rois.count > 1 && model_input.batch >= rois.count) {
+                    t0 = trace_begin();
+                    for (int i = 0; i < rois.count && ok; ++i) {
+                        ok = stage_hand(msg.fb, rois.crop[i], i, i, msg.capture_us, &ready[i]);
+                    }
+                    trace_end(TraceStage::PREPROCESS, t0);
+                    camera_return_frame(msg.fb); // Free the buffer for the sensor before the slow part
+                    returned = true;
+                    if (ok && (ready[0] || ready[1])) {
+                        t0 = trace_begin();
+                        ok = invoked = tflite_invoke();
+                        trace_end(TraceStage::INVOKE, t0);
+                    }
+                    for (int i = 0; i < rois.count && invoked; ++i) {
+                        if (ready[i]) push_hand_result(i, i, msg.capture_us);
+                    }
+                } else {
+                    for (int i = 0; i < rois.count && ok; ++i) {
+                        t0 = trace_begin();
+                        ok = stage_hand(msg.fb, rois.crop[i], i, 0, msg.capture_us, &ready[i]);
+                        trace_end(TraceStage::PREPROCESS, t0);
+                        if (i == rois.count - 1) {
+                            camera_return_frame(msg.fb);
+                            returned = true;
+                        }
+                        if (!ok || !ready[i]) continue;
+                        t0 = trace_begin();
+                        ok = tflite_invoke();
+                        trace_end(TraceStage::INVOKE, t0);
+                        if (ok) {
+                            invoked = true;
+                            push_hand_result(i, 0, msg.capture_us);
+                        }
+                    }
+                }
+                if (!returned) camera_return_frame(msg.fb);
+                if (!ok) {
+                    SignResult result = { false, -1, 0, 0.0f, msg.capture_us, 0 };
+                    push_result(result);
+                    continue;
+                }
+                if (!invoked) continue; // Temporal window still filling
+
+                uint32_t now_us = (uint32_t)esp_timer_get_time();
+                frames_inferred++;
+                window_frames++;
+                window_latency_us += now_us - msg.capture_us;
+                if (now_us - window_start_us >= kStatsWindowUs) {
+                    last_stats.fps = window_frames * 1e6f / (now_us - window_start_us);
+                    last_stats.avg_latency_us = (uint32_t)(window_latency_us / window_frames);
+                    MotionGateStats gate;
+                    camera_motion_gate_stats(&gate);
+                    ESP_LOGI(TAG, "%.1f fps, %u us capture->result, %u captured, %u dropped, %u inferred, %u skipped (gate thr %u), %u rejected, %u signs",
+                             last_stats.fps, (unsigned)last_stats.avg_latency_us,
+                             (unsigned)frames_captured, (unsigned)frames_dropped,
+                             (unsigned)frames_inferred, (unsigned)frames_skipped, (unsigned)gate.threshold,
+                             (unsigned)frames_rejected,
+                             (unsigned)(streams[0].emitted() + streams[1].emitted()));
+                    if (use_detector) {
+                        // Cascade vs. the classifier alone: without the detector, every rejected
+                        // frame would have cost one more classifier Invoke()
+                        ModelStageStats det, cls;
+                        tflite_get_stage_stats(&det, &cls);
+                        const uint32_t det_us = window_avg_us(det, window_det);
+                        const uint32_t cls_us = window_avg_us(cls, window_cls);
+                        const uint32_t no_hand = frames_no_hand - window_no_hand;
+                        const uint32_t frames = det.invokes - window_det.invokes;
+                        const uint64_t cascade_us = (det.total_us - window_det.total_us) + (cls.total_us - window_cls.total_us);
+                        const uint64_t single_us = (uint64_t)cls_us * ((cls.invokes - window_cls.invokes) + no_hand);
+                        ESP_LOGI(TAG, "cascade: detector %u x %u us, classifier %u x %u us, %u no hand; per frame %u us vs %u us classifier-only",
+                                 (unsigned)frames, (unsigned)det_us, (unsigned)(cls.invokes - window_cls.invokes), (unsigned)cls_us,
+                                 (unsigned)no_hand, (unsigned)(frames ? cascade_us / frames : 0),
+                                 (unsigned)(frames ? single_us / frames : 0));
+                        window_det = det;
+                        window_cls = cls;
+                        window_no_hand = frames_no_hand;
+                    }
+                    window_start_us = now_us;
+                    window_frames = 0;
+                    window_latency_us = 0;
+                }
+            }
+        }
+    }
+}
+
+bool signing_pipeline_init() {
+    if (events) return true;
+
+    if (!tflite_get_input(&model_input)) {
+        ESP_LOGE(TAG, "Model input tensor not available; call tflite_init() first");
+        return false;
+    }
+
+    use_detector = hand_detector_available() && hand_detector_get_input(&detector_input);
+    if (use_detector) {
+        ESP_LOGI(TAG, "Hand detector gates the classifier (%dx%d input, threshold %.2f)",
+                 detector_input.width, detector_input.height, HAND_DETECTOR_THRESHOLD);
+    }
+
+    // All or nothing: everything the tasks touch is allocated before they exist, and a failure
+    // frees it again, so `events` is only left set once the pipeline is complete
+    EventGroupHandle_t new_events = xEventGroupCreate();
+    frame_q = xQueueCreate(1, sizeof(FrameMsg));
+    result_q = xQueueCreate(kResultQueueLen, sizeof(SignResult));
+    bool ok = new_events && frame_q && result_q;
+    if (!ok) ESP_LOGE(TAG, "Failed to allocate pipeline queues");
+
+    if (ok && model_input.frames > 1) {
+        // One window per tracked hand; internal RAM if it fits, since every inference copies it
+        const size_t frame_bytes = model_input_frame_bytes(model_input);
+        const size_t per_hand = FrameHistory::bytes_needed(frame_bytes, model_input.frames);
+        const int hands = HAND_ROI_TWO_HANDS ? HAND_ROI_MAX_HANDS : 1;
+        history_storage = (uint8_t*)heap_caps_malloc(per_hand * hands, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (!history_storage) {
+            history_storage = (uint8_t*)heap_caps_malloc(per_hand * hands, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        }
+        if (history_storage) {
+            for (int i = 0; i < hands; ++i) {
+                history[i].begin(history_storage + i * per_hand, frame_bytes, model_input.frames);
+            }
+            ESP_LOGI(TAG, "Temporal model: %d frames per sample, %u bytes of frame history for %d hand(s)",
+                     model_input.frames, (unsigned)(per_hand * hands), hands);
+        } else {
+            ESP_LOGE(TAG, "No memory for %d x %u bytes of frame history", hands, (unsigned)per_hand);
+            ok = false;
+        }
+    }
+
+    // Tasks last; they park on `events` until start(). The inference stage gets the higher
+    // priority so a backlog drains toward results, not captures
+    events = new_events;
+    TaskHandle_t capture = nullptr, inference = nullptr;
+    if (ok) {
+        ok = xTaskCreatePinnedToCore(capture_task, "sign_capture", 3072, nullptr, 5, &capture, SIGNING_CAPTURE_CORE) == pdPASS &&
+             xTaskCreatePinnedToCore(inference_task, "sign_infer", 8192, nullptr, 6, &inference, SIGNING_INFERENCE_CORE) == pdPASS;
+        if (!ok) ESP_LOGE(TAG, "Failed to create pipeline tasks");
+    }
+    if (!ok) {
+        // A stage that did start is blocked in wait_for_run() and holds nothing yet
+        if (capture) vTaskDelete(capture);
+        if (inference) vTaskDelete(inference);
+        for (FrameHistory& h : history) h = FrameHistory();
+        heap_caps_free(history_storage);
+        history_storage = nullptr;
+        if (result_q) vQueueDelete(result_q);
+        if (frame_q) vQueueDelete(frame_q);
+        if (new_events) vEventGroupDelete(new_events);
+        result_q = frame_q = nullptr;
+        events = nullptr;
+        return false;
+    }
+
+    ESP_LOGI(TAG, "Signing pipeline ready (capture core %d, inference core %d)",
+             SIGNING_CAPTURE_CORE, SIGNING_INFERENCE_CORE);
+    return true;
+}
+
+void signing_pipeline_start() {
+    if (!events || is_running()) return;
+    xQueueReset(result_q);
+    camera_analyze_reset(); // Inference task is parked, safe to touch the gate, tracker and windows
+    for (int i = 0; i < HAND_ROI_MAX_HANDS; ++i) {
+        history[i].reset();
+        streams[i].reset();
+    }
+    xEventGroupSetBits(events, RUN_BIT);
+}
+
+void signing_pipeline_stop() {
+    if (!events || !is_running()) return;
+    xEventGroupClearBits(events, RUN_BIT);
+    xEventGroupWaitBits(events, ALL_IDLE_BITS, pdFALSE, pdTRUE, portMAX_DELAY);
+
+    // Every stage is parked; hand any queued frames back to the driver and drop results
+    // finished after the user left SIGNING, so the next session doesn't publish them
+    FrameMsg msg;
+    while (xQueueReceive(frame_q, &msg, 0) == pdTRUE) {
+        camera_return_frame(msg.fb);
+    }
+    xQueueReset(result_q);
+}
+
+bool signing_pipeline_is_running() {
+    return events && is_running();
+}
+
+bool signing_pipeline_get_result(SignResult* out) {
+    if (!result_q || !out) return false;
+    return xQueueReceive(result_q, out, 0) == pdTRUE;
+}
+
+void signing_pipeline_get_stats(SignPipelineStats* out) {
+    if (!out) return;
+    *out = last_stats;
+    out->frames_captured = frames_captured;
+    out->frames_dropped = frames_dropped;
+    out->frames_inferred = frames_inferred;
+    out->frames_skipped = frames_skipped;
+    out->frames_no_hand = frames_no_hand;
+    out->frames_rejected = frames_rejected;
+    out->signs_emitted = streams[0].emitted() + streams[1].emitted();
+}
@@ -0,0 +1,44 @@
+#ifndef SIGNING_PIPELINE_H
+#define SIGNING_PIPELINE_H
+
+#include <stdint.h>
+#include "config.h"
+
+// A recognized sign: one per gesture, once the streaming classifier (sign_stream.h) is sure of it,
+// or a failed frame (ok = false).
+struct SignResult {
+    bool ok;                 // false if the frame could not be preprocessed or Invoke() failed
+    int class_idx;           // -1 when nothing was detected
+    int hand;                // 0 = single/left hand, 1 = right hand (HAND_ROI_TWO_HANDS)
+    float score;             // Mean calibrated probability over the classifier's window
+    uint32_t capture_us;     // esp_timer timestamp when the frame that completed the sign was grabbed
+    uint32_t latency_us;     // capture -> inference done
+};
+
+struct SignPipelineStats {
+    uint32_t frames_captured;
+    uint32_t frames_dropped;   // frames returned to the driver because the pipeline was full
+    uint32_t frames_inferred;
+    uint32_t frames_skipped;   // frames the motion gate judged static, never preprocessed
+    uint32_t frames_no_hand;   // frames the hand detector rejected, never classified
+    uint32_t frames_rejected;  // inferred frames whose winner missed its threshold or margin
+    uint32_t signs_emitted;    // gestures recognized (SignResults with a class)
+    float fps;                 // inference rate over the last reporting window
+    uint32_t avg_latency_us;   // mean capture -> inference latency over the same window
+};
+
+// Creates the queues and the capture/inference tasks. Tasks stay parked until signing_pipeline_start().
+// Requires tflite_init() to have run, since inference preprocesses straight into the input tensor.
+// All or nothing: on failure nothing is left allocated or running, and the call can be repeated.
+bool signing_pipeline_init();
+void signing_pipeline_start();
+// Blocks until every stage is parked, then returns all in-flight frame buffers to the camera driver
+// and discards results loop() hasn't read.
+void signing_pipeline_stop();
+bool signing_pipeline_is_running();
+
+// Non-blocking. Returns true and fills `out` if a result is available.
+bool signing_pipeline_get_result(SignResult* out);
+void signing_pipeline_get_stats(SignPipelineStats* out);
+
+#endif // SIGNING_PIPELINE_H
@@ -0,0 +1,102 @@
+#include "tflite_profiler.h"
+#include "trace.h"
+#include "tensorflow/lite/schema/schema_utils.h"
+#include <stdio.h>
+
+namespace {
+    size_t tensor_type_bytes(tflite::TensorType type) {
+        switch (type) {
+            case tflite::TensorType_FLOAT32:
+            case tflite::TensorType_INT32:
+                return 4;
+            case tflite::TensorType_INT16:
+                return 2;
+            case tflite::TensorType_INT64:
+                return 8;
+            default:
+                return 1;
+        }
+    }
+
+    // Appends "1x96x96x1:int8" for each tensor index, '|' separated; returns the total bytes
+    size_t format_tensors(const tflite::SubGraph* graph, const flatbuffers::Vector<int32_t>* indices,
+                          char* buf, size_t len) {
+        size_t bytes = 0;
+        int n = 0;
+        buf[0] = '\0';
+        if (!indices) return 0;
+        for (int32_t idx : *indices) {
+            if (idx < 0 || (uint32_t)idx >= graph->tensors()->size()) continue; // Optional input
+            const tflite::Tensor* t = graph->tensors()->Get(idx);
+            size_t elems = 1;
+            if (n > 0 && (size_t)n < len) n += snprintf(buf + n, len - n, "|");
+            if (t->shape() && t->shape()->size() > 0) {
+                for (uint32_t d = 0; d < t->shape()->size(); ++d) {
+                    int dim = t->shape()->Get(d);
+                    elems *= dim > 0 ? dim : 1;
+                    if ((size_t)n < len) n += snprintf(buf + n, len - n, d ? "x%d" : "%d", dim);
+                }
+            } else if ((size_t)n < len) {
+                n += snprintf(buf + n, len - n, "scalar");
+            }
+            if ((size_t)n < len) n += snprintf(buf + n, len - n, ":%s", tflite::EnumNameTensorType(t->type()));
+            bytes += elems * tensor_type_bytes(t->type());
+        }
+        return bytes;
+    }
+}
+
+uint32_t OpTimingProfiler::BeginEvent(const char* tag) {
+    if (num_events_ >= kMaxEvents) return kMaxEvents; // Dropped; EndEvent ignores it
+    int i = num_events_++;
+    tags_[i] = tag;
+    start_ticks_[i] = trace_now();
+    end_ticks_[i] = start_ticks_[i];
+    return (uint32_t)i;
+}
+
+void OpTimingProfiler::EndEvent(uint32_t event_handle) {
+    if (event_handle >= (uint32_t)kMaxEvents) return;
+    end_ticks_[event_handle] = trace_now();
+}
+
+uint32_t OpTimingProfiler::total_ticks() const {
+    uint32_t total = 0;
+    for (int i = 0; i < num_events_; ++i) total += event_ticks(i);
+    return total;
+}
+
+void OpTimingProfiler::log_report(const char* label, const tflite::Model* model) const {
+    const uint32_t ticks_per_us = trace_ticks_per_us();
+    const tflite::SubGraph* graph = nullptr;
+    if (model && model->subgraphs() && model->subgraphs()->size() > 0) {
+        graph = model->subgraphs()->Get(0);
+        if (!graph->operators() || (int)graph->operators()->size() != num_events_) {
+            printf("OPPROF,%s,# %d events for %d ops, shapes omitted\n", label, num_events_,
+                   graph->operators() ? (int)graph->operators()->size() : 0);
+            graph = nullptr;
+        }
+    }
+
+    printf("OPPROF,%s,idx,op,inputs,outputs,out_bytes,ticks,us\n", label);
+    char inputs[160];
+    char outputs[96];
+    size_t total_bytes = 0;
+    for (int i = 0; i < num_events_; ++i) {
+        const char* op = tags_[i];
+        size_t out_bytes = 0;
+        inputs[0] = outputs[0] = '\0';
+        if (graph) {
+            const tflite::Operator* oper = graph->operators()->Get(i);
+            const tflite::OperatorCode* code = model->operator_codes()->Get(oper->opcode_index());
+            op = tflite::EnumNameBuiltinOperator(tflite::GetBuiltinCode(code));
+            format_tensors(graph, oper->inputs(), inputs, sizeof(inputs));
+            out_bytes = format_tensors(graph, oper->outputs(), outputs, sizeof(outputs));
+            total_bytes += out_bytes;
+        }
+        printf("OPPROF,%s,%d,%s,%s,%s,%u,%u,%u\n", label, i, op, inputs, outputs, (unsigned)out_bytes,
+               (unsigned)event_ticks(i), (unsigned)(event_ticks(i) / ticks_per_us));
+    }
+    printf("OPPROF,%s,total,%d ops,,,%u,%u,%u\n", label, num_events_, (unsigned)total_bytes,
+           (unsigned)total_ticks(), (unsigned)(total_ticks() / ticks_per_us));
+}
@@ -0,0 +1,40 @@
+#ifndef TFLITE_PROFILER_H
+#define TFLITE_PROFILER_H
+
+#include <stdint.h>
+#include "tensorflow/lite/micro/micro_profiler_interface.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+// Per-operator timing for interpreter->Invoke(). TFLM calls BeginEvent/EndEvent around
+// every op with the op's name as tag; events are recorded in op order, so event i is
+// operator i of the model's main subgraph.
+// Ticks come from trace_now(): CPU cycles on target, nanoseconds on a host build.
+class OpTimingProfiler : public tflite::MicroProfilerInterface {
+public:
+    static constexpr int kMaxEvents = 96;
+
+    uint32_t BeginEvent(const char* tag) override;
+    void EndEvent(uint32_t event_handle) override;
+
+    void reset() { num_events_ = 0; }
+    int num_events() const { return num_events_; }
+    const char* event_tag(int i) const { return tags_[i]; }
+    uint32_t event_ticks(int i) const { return end_ticks_[i] - start_ticks_[i]; }
+    uint32_t total_ticks() const;
+
+    // Prints one CSV line per op, identical on target and host so the two can be diffed
+    // (scripts/op_profile_diff.py):
+    //   OPPROF,<label>,<idx>,<op>,<input shapes>,<output shapes>,<output bytes>,<ticks>,<us>
+    // Shapes are "1x96x96x1:int8", several tensors separated by '|'. Output bytes are the
+    // activation memory the op writes in the arena. With model == nullptr only the op tag
+    // and timing are reported.
+    void log_report(const char* label, const tflite::Model* model = nullptr) const;
+
+private:
+    const char* tags_[kMaxEvents];
+    uint32_t start_ticks_[kMaxEvents];
+    uint32_t end_ticks_[kMaxEvents];
+    int num_events_ = 0;
+};
+
+#endif // TFLITE_PROFILER_H
@@ -0,0 +1,188 @@
+#include "trace.h"
+#include <atomic>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(ESP_PLATFORM)
+#include "esp_cpu.h"
+#include "esp_clk.h"
+#else
+#include <time.h>
+#endif
+
+namespace {
+    constexpr uint32_t kRingSize = 256;         // Power of two; ~2KB
+    constexpr int kStageBits = 5;
+    constexpr uint32_t kMaxUs = (1u << (32 - kStageBits)) - 1; // ~134s, longer spans saturate
+    constexpr int kSubBuckets = 4;              // Linear steps per power of two: <= 25% bucket width
+    constexpr int kBuckets = 104;               // Covers up to kMaxUs
+    constexpr int kStages = (int)TraceStage::COUNT;
+    static_assert(kStages < (1 << kStageBits), "TraceStage no longer fits the packed event word");
+
+    // One event = duration (us) and stage packed in one word, published with a sequence
+    // number so the reader can tell complete, in-flight and overwritten slots apart.
+    struct Slot {
+        std::atomic<uint32_t> seq;   // Ring index + 1 once written, 0 while being written
+        std::atomic<uint32_t> word;  // stage << 27 | duration_us
+    };
+
+    Slot ring[kRingSize];
+    std::atomic<uint32_t> head{0};   // Next ring index to hand out (producers)
+    uint32_t tail = 0;               // Next ring index to read (trace_collect only)
+
+    struct StageHist {
+        uint32_t buckets[kBuckets];
+        uint32_t count;
+        uint32_t min_us, max_us;
+        uint64_t total_us;
+    };
+    StageHist hist[kStages];
+    uint32_t dropped = 0;
+    uint32_t window_start_ms = 0;
+
+    const char* const kStageNames[kStages] = {
+        "loop", "mqtt_loop", "mqtt_publish", "lvgl", "loop_delay", "input", "frame", "spi_flush",
+        "capture", "analyze", "detect", "preprocess", "invoke", "camera_wake"
+    };
+
+    inline int bucket_of(uint32_t us) {
+        if (us < kSubBuckets) return (int)us;
+        int msb = 31 - __builtin_clz(us);
+        int idx = (msb - 1) * kSubBuckets + (int)((us >> (msb - 2)) & (kSubBuckets - 1));
+        return idx < kBuckets ? idx : kBuckets - 1;
+    }
+
+    // Midpoint of a bucket, which is what percentiles report
+    inline uint32_t bucket_value(int idx) {
+        if (idx < kSubBuckets) return (uint32_t)idx;
+        int msb = idx / kSubBuckets + 1;
+        uint32_t width = 1u << (msb - 2);
+        uint32_t lower = (uint32_t)(kSubBuckets + idx % kSubBuckets) << (msb - 2);
+        return lower + width / 2;
+    }
+
+    void record(uint32_t word) {
+        int stage = (int)(word >> (32 - kStageBits));
+        uint32_t us = word & kMaxUs;
+        StageHist& h = hist[stage];
+        if (h.count == 0 || us < h.min_us) h.min_us = us;
+        if (us > h.max_us) h.max_us = us;
+        h.count++;
+        h.total_us += us;
+        h.buckets[bucket_of(us)]++;
+    }
+
+    uint32_t percentile(const StageHist& h, uint32_t permille) {
+        uint32_t rank = (uint32_t)(((uint64_t)h.count * permille + 999) / 1000);
+        if (rank == 0) rank = 1;
+        uint32_t acc = 0;
+        for (int i = 0; i < kBuckets; ++i) {
+            acc += h.buckets[i];
+            if (acc >= rank) {
+                uint32_t v = bucket_value(i);
+                return v < h.min_us ? h.min_us : (v > h.max_us ? h.max_us : v);
+            }
+        }
+        return h.max_us;
+    }
+}
+
+const char* trace_stage_name(TraceStage stage) {
+    int i = (int)stage;
+    return i >= 0 && i < kStages ? kStageNames[i] : "unknown";
+}
+
+uint32_t trace_ticks_per_us() {
+#if defined(ESP_PLATFORM)
+    return esp_clk_cpu_freq() / 1000000;
+#else
+    return 1000; // trace_now() counts nanoseconds on the host
+#endif
+}
+
+uint32_t trace_now() {
+#if defined(ESP_PLATFORM)
+    return esp_cpu_get_cycle_count();
+#else
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec);
+#endif
+}
+
+void trace_end(TraceStage stage, uint32_t start) {
+    // The cycle counter is per core; a task that migrated mid-span yields garbage, so tasks
+    // that trace are pinned (loop and the signing pipeline all are).
+    trace_record_us(stage, (trace_now() - start) / trace_ticks_per_us());
+}
+
+void trace_record_us(TraceStage stage, uint32_t us) {
+    if (us > kMaxUs) us = kMaxUs;
+    uint32_t idx = head.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = ring[idx & (kRingSize - 1)];
+    slot.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.word.store(((uint32_t)stage << (32 - kStageBits)) | us, std::memory_order_relaxed);
+    slot.seq.store(idx + 1, std::memory_order_release);
+}
+
+void trace_collect() {
+    uint32_t end = head.load(std::memory_order_acquire);
+    if (end - tail > kRingSize) {
+        dropped += end - tail - kRingSize;
+        tail = end - kRingSize;
+    }
+    while (tail != end) {
+        Slot& slot = ring[tail & (kRingSize - 1)];
+        uint32_t seq = slot.seq.load(std::memory_order_acquire);
+        uint32_t word = slot.word.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint32_t seq_after = slot.seq.load(std::memory_order_relaxed);
+        if (seq == tail + 1 && seq_after == seq) {
+            record(word);
+        } else if (seq == 0 || (int32_t)(seq - (tail + 1)) < 0) {
+            break; // A producer is still writing this slot; pick it up next time
+        } else {
+            dropped++; // Overwritten by a lap of the ring
+        }
+        tail++;
+    }
+}
+
+void trace_get_summary(TraceStage stage, TraceStageSummary* out) {
+    int i = (int)stage;
+    if (!out || i < 0 || i >= kStages) return;
+    const StageHist& h = hist[i];
+    out->count = h.count;
+    out->total_us = h.total_us;
+    out->min_us = h.count ? h.min_us : 0;
+    out->max_us = h.max_us;
+    out->p50_us = h.count ? percentile(h, 500) : 0;
+    out->p99_us = h.count ? percentile(h, 990) : 0;
+}
+
+uint32_t trace_dropped() {
+    return dropped;
+}
+
+size_t trace_format_summary(char* buf, size_t len, const char* device_id, uint32_t timestamp_ms) {
+    trace_collect();
+    // {"dev":..,"t":ms,"win_ms":..,"drop":n,"stages":{"name":[count,min,p50,p99,max],..}}
+    int n = snprintf(buf, len, "{\"dev\":\"%s\",\"t\":%u,\"win_ms\":%u,\"drop\":%u,\"stages\":{",
+                     device_id, (unsigned)timestamp_ms, (unsigned)(timestamp_ms - window_start_ms), (unsigned)dropped);
+    bool first = true;
+    for (int i = 0; i < kStages && n > 0 && (size_t)n < len; ++i) {
+        TraceStageSummary s;
+        trace_get_summary((TraceStage)i, &s);
+        if (!s.count) continue;
+        n += snprintf(buf + n, len - n, "%s\"%s\":[%u,%u,%u,%u,%u]", first ? "" : ",", kStageNames[i],
+                      (unsigned)s.count, (unsigned)s.min_us, (unsigned)s.p50_us, (unsigned)s.p99_us, (unsigned)s.max_us);
+        first = false;
+    }
+    if (n > 0 && (size_t)n < len) n += snprintf(buf + n, len - n, "}}");
+
+    memset(hist, 0, sizeof(hist));
+    dropped = 0;
+    window_start_ms = timestamp_ms;
+    return n > 0 && (size_t)n < len ? (size_t)n : 0;
+}
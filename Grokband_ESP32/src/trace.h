@@ -0,0 +1,73 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Lightweight stage tracing on the CPU cycle counter.
+// trace_begin()/trace_end() pairs (or TRACE_SCOPE) push one event per span into a fixed
+// lock-free ring, safe from any task on either core. trace_collect() drains the ring into
+// per-stage log2 histograms; trace_format_summary() turns those into a compact JSON line
+// (min/p50/p99/max in microseconds) for the telemetry topic, and starts a new window.
+// Builds on the host too (monotonic clock instead of the cycle counter).
+enum class TraceStage : uint8_t {
+    LOOP,           // One pass of loop()
+    MQTT_LOOP,      // mqtt_loop(): keepalive + incoming callbacks
+    MQTT_PUBLISH,
+    LVGL,           // display_update_loop() / lv_timer_handler()
+    LOOP_DELAY,     // Idle wait at the end of loop() (input_wait())
+    INPUT_LATENCY,  // Button/encoder edge in the ISR -> display refreshed with the result
+    FRAME,          // One LVGL refresh: render + flush of all invalidated areas
+    SPI_FLUSH,      // One DMA flush, start to transfer complete
+    CAPTURE,        // Waiting for a camera frame
+    ANALYZE,        // Thumbnail, motion gate and hand tracker
+    DETECT,         // Hand detector (cascade stage 1): thumbnail resize + Invoke()
+    PREPROCESS,
+    INVOKE,
+    CAMERA_WAKE,    // Camera standby/power-down -> first fresh frame
+    COUNT
+};
+
+const char* trace_stage_name(TraceStage stage);
+
+uint32_t trace_now();
+// trace_now() ticks per microsecond: the CPU clock in MHz on target, 1000 on the host
+uint32_t trace_ticks_per_us();
+// Records a span that started at `start` (from trace_now()/trace_begin()) and ends now
+void trace_end(TraceStage stage, uint32_t start);
+// Records a span measured some other way, e.g. between two esp_timer timestamps
+void trace_record_us(TraceStage stage, uint32_t us);
+inline uint32_t trace_begin() { return trace_now(); }
+
+class TraceScope {
+public:
+    explicit TraceScope(TraceStage stage) : stage_(stage), start_(trace_now()) {}
+    ~TraceScope() { trace_end(stage_, start_); }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    TraceStage stage_;
+    uint32_t start_;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(stage) TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(stage)
+
+struct TraceStageSummary {
+    uint32_t count;
+    uint32_t min_us, p50_us, p99_us, max_us;
+    uint64_t total_us;
+};
+
+// Drains pending ring events into the current window's histograms. Call from one task only.
+void trace_collect();
+void trace_get_summary(TraceStage stage, TraceStageSummary* out);
+// Events lost because the ring wrapped before trace_collect() ran, since the window started
+uint32_t trace_dropped();
+// Collects, writes the window summary as one JSON object into `buf` and starts a new window.
+// Returns the length written, or 0 if it did not fit.
+size_t trace_format_summary(char* buf, size_t len, const char* device_id, uint32_t timestamp_ms);
+
+#endif // TRACE_H
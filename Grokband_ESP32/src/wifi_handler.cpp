@@ -0,0 +1,134 @@
+#include "wifi_handler.h"
+#include "config.h"
+#include "boot_sequencer.h"
+#include <WiFi.h>
+#include <Preferences.h>
+
+namespace {
+    constexpr const char* kNvsNamespace = "wifi_cache";
+    constexpr uint8_t kCacheVersion = 2;
+
+    // Everything needed to rejoin without a scan. Stored as one blob so it is written (and
+    // invalidated) atomically. No address: a lease can expire or move to another host while
+    // the band is off, so only DHCP may hand one out.
+    struct WifiCache {
+        uint8_t version;
+        uint8_t channel;
+        uint8_t bssid[6];
+    };
+
+    enum class Phase : uint8_t {
+        IDLE,
+        FAST,       // Joining with the cached channel/BSSID
+        NORMAL,     // Scan + DHCP
+        CONNECTED
+    };
+
+    Phase phase = Phase::IDLE;
+    bool fast_path_used = false;
+    uint32_t phase_start_ms = 0;
+    WifiCache cache = {};
+
+    bool load_cache(WifiCache* out) {
+        Preferences prefs;
+        if (!prefs.begin(kNvsNamespace, true)) return false;
+        size_t n = prefs.getBytes("ap", out, sizeof(*out));
+        prefs.end();
+        return n == sizeof(*out) && out->version == kCacheVersion && out->channel != 0;
+    }
+
+    void store_cache() {
+        WifiCache now = {};
+        now.version = kCacheVersion;
+        now.channel = (uint8_t)WiFi.channel();
+        memcpy(now.bssid, WiFi.BSSID(), sizeof(now.bssid));
+        if (memcmp(&now, &cache, sizeof(now)) == 0) return; // Unchanged: spare the flash
+        Preferences prefs;
+        if (!prefs.begin(kNvsNamespace, false)) return;
+        prefs.putBytes("ap", &now, sizeof(now));
+        prefs.remove("lease"); // Address cache of older firmware
+        prefs.end();
+        cache = now;
+        Serial.println("WiFi: cached AP channel/BSSID for fast reconnect");
+    }
+
+    void clear_cache() {
+        Preferences prefs;
+        if (prefs.begin(kNvsNamespace, false)) {
+            prefs.remove("ap");
+            prefs.end();
+        }
+        cache = {};
+    }
+
+    void begin_normal() {
+        // Back to a full scan
+        WiFi.disconnect();
+        WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+        phase = Phase::NORMAL;
+        phase_start_ms = millis();
+        fast_path_used = false;
+    }
+}
+
+void wifi_start() {
+    Serial.print("Connecting to ");
+    Serial.println(WIFI_SSID);
+    WiFi.mode(WIFI_STA);
+    WiFi.setAutoReconnect(true);
+    if (load_cache(&cache)) {
+        // DHCP stays on: the address always comes from the server (see wifi_handler.h)
+        WiFi.begin(WIFI_SSID, WIFI_PASSWORD, cache.channel, cache.bssid);
+        phase = Phase::FAST;
+        fast_path_used = true;
+        Serial.printf("WiFi: fast join on channel %u\n", cache.channel);
+    } else {
+        WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+        phase = Phase::NORMAL;
+    }
+    phase_start_ms = millis();
+}
+
+void wifi_loop() {
+    const bool up = WiFi.status() == WL_CONNECTED;
+    switch (phase) {
+        case Phase::IDLE:
+            break;
+        case Phase::FAST:
+            if (up) {
+                phase = Phase::CONNECTED;
+                boot_mark(BootMilestone::WIFI_CONNECTED);
+                Serial.print("WiFi connected (fast path), IP address: "); Serial.println(WiFi.localIP());
+            } else if (millis() - phase_start_ms > WIFI_FAST_CONNECT_TIMEOUT_MS) {
+                // AP moved channel or was replaced: forget it and scan
+                Serial.println("WiFi: fast join timed out, falling back to scan + DHCP");
+                clear_cache();
+                begin_normal();
+            }
+            break;
+        case Phase::NORMAL:
+            if (up) {
+                phase = Phase::CONNECTED;
+                boot_mark(BootMilestone::WIFI_CONNECTED);
+                Serial.print("WiFi connected, IP address: "); Serial.println(WiFi.localIP());
+                store_cache();
+            }
+            break;
+        case Phase::CONNECTED:
+            if (!up) {
+                // The driver reconnects on its own (setAutoReconnect); just note the drop
+                Serial.println("WiFi link lost");
+                phase = Phase::NORMAL;
+                phase_start_ms = millis();
+            }
+            break;
+    }
+}
+
+bool wifi_is_connected() {
+    return phase == Phase::CONNECTED;
+}
+
+bool wifi_used_fast_path() {
+    return fast_path_used;
+}
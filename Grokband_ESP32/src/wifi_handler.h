@@ -0,0 +1,19 @@
+#ifndef WIFI_HANDLER_H
+#define WIFI_HANDLER_H
+
+#include <stdint.h>
+
+// Non-blocking WiFi bring-up. wifi_start() kicks off association and returns; wifi_loop()
+// (called from mqtt_loop()) tracks progress. The AP channel/BSSID of the last good connection
+// are cached in NVS: the next boot joins that AP directly (no scan), and falls back to a
+// normal scan if that doesn't connect within WIFI_FAST_CONNECT_TIMEOUT_MS. The address always
+// comes from DHCP, never from a cache the server doesn't know about. To reuse the last lease,
+// set CONFIG_LWIP_DHCP_RESTORE_LAST_IP in sdkconfig: DHCP then asks for that address directly
+// (one REQUEST/ACK instead of DISCOVER/OFFER/REQUEST/ACK) and the server can still refuse it.
+void wifi_start();
+void wifi_loop();
+bool wifi_is_connected();
+// True if the current/last association used the cached fast path
+bool wifi_used_fast_path();
+
+#endif // WIFI_HANDLER_H
@@ -0,0 +1,108 @@
+#include "wire_protocol.h"
+
+namespace {
+    inline void put_u16(uint8_t* p, uint16_t v) {
+        p[0] = (uint8_t)v;
+        p[1] = (uint8_t)(v >> 8);
+    }
+    inline void put_u32(uint8_t* p, uint32_t v) {
+        p[0] = (uint8_t)v;
+        p[1] = (uint8_t)(v >> 8);
+        p[2] = (uint8_t)(v >> 16);
+        p[3] = (uint8_t)(v >> 24);
+    }
+    inline uint16_t get_u16(const uint8_t* p) {
+        return (uint16_t)(p[0] | (p[1] << 8));
+    }
+    inline uint32_t get_u32(const uint8_t* p) {
+        return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+
+    inline bool valid_type(uint8_t type) {
+        return type == (uint8_t)WireMsgType::SIGN || type == (uint8_t)WireMsgType::QUICK_RESPONSE;
+    }
+
+    inline size_t fail(WireStatus* status, WireStatus why) {
+        if (status) *status = why;
+        return 0;
+    }
+}
+
+size_t wire_encode(const WireFrame& frame, uint8_t* buf, size_t len, WireStatus* status) {
+    if (!valid_type((uint8_t)frame.type)) return fail(status, WireStatus::BAD_TYPE);
+    if (frame.count == 0 || frame.count > WIRE_MAX_RECORDS) return fail(status, WireStatus::BAD_COUNT);
+    const size_t size = WIRE_HEADER_SIZE + (size_t)frame.count * WIRE_RECORD_SIZE;
+    if (!buf || len < size) return fail(status, WireStatus::BUFFER_TOO_SMALL);
+
+    const uint32_t base_ms = frame.records[0].t_ms;
+    for (int i = 1; i < frame.count; ++i) {
+        if (frame.records[i].t_ms - base_ms > 0xFFFFu) return fail(status, WireStatus::TIME_SPAN);
+    }
+
+    buf[0] = WIRE_MAGIC;
+    buf[1] = WIRE_VERSION;
+    buf[2] = (uint8_t)frame.type;
+    buf[3] = frame.count;
+    put_u16(buf + 4, frame.seq);
+    put_u32(buf + 6, frame.device_id);
+    put_u32(buf + 10, base_ms);
+    uint8_t* p = buf + WIRE_HEADER_SIZE;
+    for (int i = 0; i < frame.count; ++i, p += WIRE_RECORD_SIZE) {
+        const WireRecord& r = frame.records[i];
+        put_u16(p, r.class_id);
+        p[2] = r.confidence;
+        p[3] = r.flags;
+        put_u16(p + 4, (uint16_t)(r.t_ms - base_ms));
+    }
+    if (status) *status = WireStatus::OK;
+    return size;
+}
+
+WireStatus wire_decode(const uint8_t* buf, size_t len, WireFrame* out) {
+    if (!buf || len < WIRE_HEADER_SIZE) return WireStatus::TOO_SHORT;
+    if (buf[0] != WIRE_MAGIC) return WireStatus::BAD_MAGIC;
+    if (buf[1] != WIRE_VERSION) return WireStatus::BAD_VERSION;
+    if (!valid_type(buf[2])) return WireStatus::BAD_TYPE;
+    const uint8_t count = buf[3];
+    if (count == 0 || count > WIRE_MAX_RECORDS) return WireStatus::BAD_COUNT;
+    if (len != WIRE_HEADER_SIZE + (size_t)count * WIRE_RECORD_SIZE) return WireStatus::BAD_LENGTH;
+
+    out->type = (WireMsgType)buf[2];
+    out->count = count;
+    out->seq = get_u16(buf + 4);
+    out->device_id = get_u32(buf + 6);
+    const uint32_t base_ms = get_u32(buf + 10);
+    const uint8_t* p = buf + WIRE_HEADER_SIZE;
+    for (int i = 0; i < count; ++i, p += WIRE_RECORD_SIZE) {
+        WireRecord& r = out->records[i];
+        r.class_id = get_u16(p);
+        r.confidence = p[2];
+        r.flags = p[3];
+        r.t_ms = base_ms + get_u16(p + 4);
+    }
+    return WireStatus::OK;
+}
+
+const char* wire_status_name(WireStatus status) {
+    switch (status) {
+        case WireStatus::OK: return "ok";
+        case WireStatus::TOO_SHORT: return "frame too short";
+        case WireStatus::BAD_MAGIC: return "bad magic";
+        case WireStatus::BAD_VERSION: return "unsupported version";
+        case WireStatus::BAD_TYPE: return "unknown message type";
+        case WireStatus::BAD_COUNT: return "bad record count";
+        case WireStatus::BAD_LENGTH: return "length does not match record count";
+        case WireStatus::BUFFER_TOO_SMALL: return "output buffer too small";
+        case WireStatus::TIME_SPAN: return "records span more than 65535 ms";
+    }
+    return "unknown";
+}
+
+uint32_t wire_device_id(const char* client_id) {
+    uint32_t h = 2166136261u;
+    for (const char* c = client_id; c && *c; ++c) {
+        h ^= (uint8_t)*c;
+        h *= 16777619u;
+    }
+    return h;
+}
@@ -0,0 +1,78 @@
+#ifndef WIRE_PROTOCOL_H
+#define WIRE_PROTOCOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Binary payload for Grokband -> Grokcom messages. Shared verbatim with Grokcom's native
+// module (Grokcom_RPI/native), so it must build as plain C++ with no Arduino/ESP-IDF headers.
+// Encoding and decoding never allocate; buffers are the caller's.
+//
+// Layout, little endian:
+//   header  (14 bytes)  u8 magic, u8 version, u8 type, u8 count,
+//                       u16 seq, u32 device_id, u32 t_ms
+//   record  (6 bytes each, `count` of them)
+//                       u16 class_id, u8 confidence, u8 flags, u16 dt_ms
+// Record times are offsets from the header's t_ms (the first record's capture time). The
+// magic byte is a UTF-8 continuation byte, so it can never start a legacy text payload:
+// receivers tell the two apart by the first byte.
+#define WIRE_MAGIC 0xB7
+#define WIRE_VERSION 1
+#define WIRE_HEADER_SIZE 14
+#define WIRE_RECORD_SIZE 6
+#define WIRE_MAX_RECORDS 8
+#define WIRE_MAX_FRAME_SIZE (WIRE_HEADER_SIZE + WIRE_MAX_RECORDS * WIRE_RECORD_SIZE)
+
+#define WIRE_FLAG_RIGHT_HAND 0x01   // Record came from the second tracked hand (HAND_ROI_TWO_HANDS)
+
+enum class WireMsgType : uint8_t {
+    SIGN = 1,             // class_id indexes the model's class labels
+    QUICK_RESPONSE = 2    // class_id indexes the quick-response table
+};
+
+struct WireRecord {
+    uint16_t class_id;
+    uint8_t confidence;     // Score quantized to 0..255, see wire_quantize_confidence()
+    uint8_t flags;
+    uint32_t t_ms;          // Capture time on the device clock
+};
+
+struct WireFrame {
+    WireMsgType type;
+    uint8_t count;
+    uint16_t seq;           // Per-device, wraps; gaps mean lost messages
+    uint32_t device_id;     // wire_device_id() of the sender's client ID
+    WireRecord records[WIRE_MAX_RECORDS];
+};
+
+enum class WireStatus : uint8_t {
+    OK,
+    TOO_SHORT,
+    BAD_MAGIC,
+    BAD_VERSION,
+    BAD_TYPE,
+    BAD_COUNT,          // Zero records or more than WIRE_MAX_RECORDS
+    BAD_LENGTH,         // Length does not match the record count
+    BUFFER_TOO_SMALL,   // Encoder output buffer
+    TIME_SPAN           // Records further apart than a u16 ms offset can express
+};
+
+// Returns bytes written, or 0 with *status set (status may be null)
+size_t wire_encode(const WireFrame& frame, uint8_t* buf, size_t len, WireStatus* status);
+WireStatus wire_decode(const uint8_t* buf, size_t len, WireFrame* out);
+const char* wire_status_name(WireStatus status);
+
+// True if `buf` starts like a binary frame rather than a text payload
+inline bool wire_is_binary(const uint8_t* buf, size_t len) { return len > 0 && buf[0] == WIRE_MAGIC; }
+
+inline uint8_t wire_quantize_confidence(float score) {
+    if (!(score > 0.0f)) return 0;  // Also catches NaN
+    if (score >= 1.0f) return 255;
+    return (uint8_t)(score * 255.0f + 0.5f);
+}
+inline float wire_dequantize_confidence(uint8_t q) { return q / 255.0f; }
+
+// Stable 32-bit ID for a client ID string (FNV-1a)
+uint32_t wire_device_id(const char* client_id);
+
+#endif // WIRE_PROTOCOL_H
@@ -0,0 +1,24 @@
+#ifndef HOST_IDF_ESP_HEAP_CAPS_H
+#define HOST_IDF_ESP_HEAP_CAPS_H
+
+#include "freertos/FreeRTOS.h"
+#include <stdlib.h>
+
+#define MALLOC_CAP_8BIT     (1u << 2)
+#define MALLOC_CAP_DMA      (1u << 3)
+#define MALLOC_CAP_SPIRAM   (1u << 10)
+#define MALLOC_CAP_INTERNAL (1u << 11)
+
+// Heap allocations to let through before the next ones fail; negative = never fail
+inline std::atomic<int> host_fail_alloc_after{-1};
+
+inline void* heap_caps_malloc(size_t size, uint32_t) {
+    int left = host_fail_alloc_after.load();
+    if (left == 0) return nullptr;
+    if (left > 0) host_fail_alloc_after--;
+    return malloc(size);
+}
+
+inline void heap_caps_free(void* p) { free(p); }
+
+#endif // HOST_IDF_ESP_HEAP_CAPS_H
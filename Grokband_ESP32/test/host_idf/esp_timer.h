@@ -0,0 +1,11 @@
+#ifndef HOST_IDF_ESP_TIMER_H
+#define HOST_IDF_ESP_TIMER_H
+
+#include <chrono>
+#include <stdint.h>
+
+inline int64_t esp_timer_get_time() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#endif // HOST_IDF_ESP_TIMER_H
@@ -0,0 +1,57 @@
+#ifndef HOST_IDF_FREERTOS_H
+#define HOST_IDF_FREERTOS_H
+
+// Host stand-ins for the FreeRTOS and ESP-IDF calls the signing pipeline makes, on std::thread,
+// so signing_pipeline.cpp itself builds and runs on the host (test_pipeline_*). Header-only and
+// just enough of each API for that file: one tick is one millisecond, cores and priorities are
+// ignored, and the failure hooks (host_fail_*) let a test make the next allocations fail.
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdFAIL 0
+#define pdPASS 1
+#define portMAX_DELAY ((TickType_t)0xffffffffu)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+#define BIT0 0x01u
+#define BIT1 0x02u
+#define BIT2 0x04u
+#define BIT3 0x08u
+#define BIT4 0x10u
+#define BIT5 0x20u
+#define BIT6 0x40u
+#define BIT7 0x80u
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+// Creations to let through before the next ones fail; negative = never fail
+inline std::atomic<int> host_fail_create_after{-1};
+
+inline bool host_create_allowed() {
+    int left = host_fail_create_after.load();
+    while (left >= 0) {
+        if (left == 0) return false;
+        if (host_fail_create_after.compare_exchange_weak(left, left - 1)) return true;
+    }
+    return true;
+}
+
+// Waits on `cv` until `ready()` or `ticks` pass; portMAX_DELAY waits forever
+template <typename Pred>
+inline bool host_wait(std::condition_variable& cv, std::unique_lock<std::mutex>& lock, TickType_t ticks, Pred ready) {
+    if (ticks == portMAX_DELAY) {
+        cv.wait(lock, ready);
+        return true;
+    }
+    return cv.wait_for(lock, std::chrono::milliseconds(ticks), ready);
+}
+
+#endif // HOST_IDF_FREERTOS_H
@@ -0,0 +1,50 @@
+#ifndef HOST_IDF_EVENT_GROUPS_H
+#define HOST_IDF_EVENT_GROUPS_H
+
+#include "freertos/FreeRTOS.h"
+
+typedef uint32_t EventBits_t;
+
+struct HostEventGroup {
+    std::mutex mutex;
+    std::condition_variable cv;
+    EventBits_t bits = 0;
+};
+typedef HostEventGroup* EventGroupHandle_t;
+
+inline EventGroupHandle_t xEventGroupCreate() { return host_create_allowed() ? new HostEventGroup : nullptr; }
+
+inline void vEventGroupDelete(EventGroupHandle_t g) { delete g; }
+
+inline EventBits_t xEventGroupGetBits(EventGroupHandle_t g) {
+    std::lock_guard<std::mutex> lock(g->mutex);
+    return g->bits;
+}
+
+inline EventBits_t xEventGroupSetBits(EventGroupHandle_t g, EventBits_t bits) {
+    EventBits_t now;
+    {
+        std::lock_guard<std::mutex> lock(g->mutex);
+        now = g->bits |= bits;
+    }
+    g->cv.notify_all();
+    return now;
+}
+
+inline EventBits_t xEventGroupClearBits(EventGroupHandle_t g, EventBits_t bits) {
+    std::lock_guard<std::mutex> lock(g->mutex);
+    EventBits_t before = g->bits;
+    g->bits &= ~bits;
+    return before;
+}
+
+inline EventBits_t xEventGroupWaitBits(EventGroupHandle_t g, EventBits_t bits, BaseType_t clear, BaseType_t all, TickType_t ticks) {
+    std::unique_lock<std::mutex> lock(g->mutex);
+    auto ready = [&] { return all ? (g->bits & bits) == bits : (g->bits & bits) != 0; };
+    bool met = host_wait(g->cv, lock, ticks, ready);
+    EventBits_t value = g->bits;
+    if (met && clear) g->bits &= ~bits;
+    return value;
+}
+
+#endif // HOST_IDF_EVENT_GROUPS_H
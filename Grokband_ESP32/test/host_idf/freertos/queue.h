@@ -0,0 +1,55 @@
+#ifndef HOST_IDF_QUEUE_H
+#define HOST_IDF_QUEUE_H
+
+#include "freertos/FreeRTOS.h"
+#include <deque>
+#include <string.h>
+#include <vector>
+
+// Copy-by-value bounded queue, like a FreeRTOS queue
+struct HostQueue {
+    HostQueue(size_t len, size_t item_size) : length(len), item(item_size) {}
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::vector<uint8_t>> items;
+    size_t length;
+    size_t item;
+};
+typedef HostQueue* QueueHandle_t;
+
+inline QueueHandle_t xQueueCreate(size_t length, size_t item_size) {
+    return host_create_allowed() ? new HostQueue(length, item_size) : nullptr;
+}
+
+inline void vQueueDelete(QueueHandle_t q) { delete q; }
+
+inline BaseType_t xQueueSend(QueueHandle_t q, const void* item, TickType_t ticks) {
+    std::unique_lock<std::mutex> lock(q->mutex);
+    if (!host_wait(q->cv, lock, ticks, [q] { return q->items.size() < q->length; })) return pdFALSE;
+    const uint8_t* p = static_cast<const uint8_t*>(item);
+    q->items.emplace_back(p, p + q->item);
+    lock.unlock();
+    q->cv.notify_all();
+    return pdTRUE;
+}
+
+inline BaseType_t xQueueReceive(QueueHandle_t q, void* out, TickType_t ticks) {
+    std::unique_lock<std::mutex> lock(q->mutex);
+    if (!host_wait(q->cv, lock, ticks, [q] { return !q->items.empty(); })) return pdFALSE;
+    memcpy(out, q->items.front().data(), q->item);
+    q->items.pop_front();
+    lock.unlock();
+    q->cv.notify_all();
+    return pdTRUE;
+}
+
+inline BaseType_t xQueueReset(QueueHandle_t q) {
+    {
+        std::lock_guard<std::mutex> lock(q->mutex);
+        q->items.clear();
+    }
+    q->cv.notify_all();
+    return pdPASS;
+}
+
+#endif // HOST_IDF_QUEUE_H
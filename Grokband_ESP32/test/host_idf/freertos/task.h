@@ -0,0 +1,62 @@
+#ifndef HOST_IDF_TASK_H
+#define HOST_IDF_TASK_H
+
+#include "freertos/FreeRTOS.h"
+#include <thread>
+
+// A task is a detached std::thread plus its notification value. A thread can't be killed from
+// outside, so vTaskDelete() on another task only counts it; the pipeline deletes tasks that are
+// parked on an event group, which then simply stay parked.
+struct HostTask {
+    std::mutex mutex;
+    std::condition_variable cv;
+    uint32_t notify = 0;
+};
+typedef HostTask* TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+inline std::atomic<int> host_tasks_created{0};
+inline std::atomic<int> host_tasks_deleted{0};
+inline thread_local HostTask* host_current_task = nullptr;
+
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char*, uint32_t, void* arg, UBaseType_t,
+                                          TaskHandle_t* handle, BaseType_t) {
+    if (!host_create_allowed()) return pdFAIL;
+    HostTask* task = new HostTask;
+    host_tasks_created++;
+    if (handle) *handle = task;
+    std::thread([task, fn, arg] {
+        host_current_task = task;
+        fn(arg);
+    }).detach();
+    return pdPASS;
+}
+
+inline void vTaskDelete(TaskHandle_t) { host_tasks_deleted++; }
+
+inline void vTaskDelay(TickType_t ticks) { std::this_thread::sleep_for(std::chrono::milliseconds(ticks)); }
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle() {
+    if (!host_current_task) host_current_task = new HostTask; // The main thread, or a std::thread of the test's
+    return host_current_task;
+}
+
+inline BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    {
+        std::lock_guard<std::mutex> lock(task->mutex);
+        task->notify++;
+    }
+    task->cv.notify_all();
+    return pdPASS;
+}
+
+inline uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks) {
+    HostTask* task = xTaskGetCurrentTaskHandle();
+    std::unique_lock<std::mutex> lock(task->mutex);
+    host_wait(task->cv, lock, ticks, [task] { return task->notify > 0; });
+    uint32_t value = task->notify;
+    if (value) task->notify = clear ? 0 : value - 1;
+    return value;
+}
+
+#endif // HOST_IDF_TASK_H
@@ -0,0 +1,249 @@
+// Host replay of a signing session through the cascade (hand detector gating the classifier)
+// and through the classifier-only path, on the same frames. Both run the real portable front
+// end (thumbnail, motion gate, hand ROI tracker, crop preprocessing) and count the Invoke()s
+// each would make; the detector answers from the scene's ground truth. Reports average compute
+// per frame for each path.
+//
+// Each Invoke() is charged at the time it takes on the band, measured there: signing_pipeline
+// logs "cascade: detector N x U us, classifier N x U us" for the model pair it runs. Point
+// BENCH_CASCADE_LOG at a monitor log holding that line (the last one with both counts non-zero is
+// used), or pass the two times as build flags. With neither, the compute comparison fails rather
+// than report a ratio of made-up numbers; the invoke counts are checked either way.
+//   pio test -e native_bench -f test_bench_cascade -v
+//   BENCH_CASCADE_LOG=device.log pio test -e native_bench -f test_bench_cascade -v
+//   PLATFORMIO_BUILD_FLAGS="-DBENCH_DETECTOR_INVOKE_US=5200 -DBENCH_CLASSIFIER_INVOKE_US=84000" pio test ...
+#include <unity.h>
+#include "config.h"
+#include "frame_preprocess.h"
+#include "hand_roi.h"
+#include "motion_gate.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#ifndef BENCH_DETECTOR_INVOKE_US
+#define BENCH_DETECTOR_INVOKE_US 0      // Unset: taken from BENCH_CASCADE_LOG
+#endif
+#ifndef BENCH_CLASSIFIER_INVOKE_US
+#define BENCH_CLASSIFIER_INVOKE_US 0
+#endif
+
+namespace {
+    constexpr int kSrc = 240;        // Camera frame, grayscale
+    constexpr int kDetIn = 32;       // Detector input
+    constexpr int kClsIn = TFLITE_MODEL_INPUT_WIDTH;
+
+    // One cycle of the scripted session, in frames. Only the "hand" segment has a hand in view
+    enum class Segment { STILL, PASSER_BY, HAND, AFTER };
+    constexpr int kStill = 45, kPasserBy = 45, kHand = 60, kAfter = 30;
+    constexpr int kCycle = kStill + kPasserBy + kHand + kAfter;
+    constexpr int kCycles = 8;
+
+    struct Blob { int x, y, w, h; }; // Source pixels
+
+    Segment segment_of(int f) {
+        f %= kCycle;
+        if (f < kStill) return Segment::STILL;
+        if (f < kStill + kPasserBy) return Segment::PASSER_BY;
+        if (f < kStill + kPasserBy + kHand) return Segment::HAND;
+        return Segment::AFTER;
+    }
+
+    // Textured static background, sensor noise, and a moving object per segment: someone
+    // crossing the far side of the frame, or a hand signing in front of the band
+    bool render(int f, uint8_t* frame, Blob* hand) {
+        uint32_t noise = 2166136261u ^ (uint32_t)f;
+        for (int y = 0; y < kSrc; ++y) {
+            for (int x = 0; x < kSrc; ++x) {
+                noise = noise * 1664525u + 1013904223u;
+                frame[y * kSrc + x] = (uint8_t)(70 + ((x / 12 + y / 12) & 1) * 40 + (noise >> 29));
+            }
+        }
+        const int t = f % kCycle;
+        Blob blob;
+        const Segment seg = segment_of(f);
+        if (seg == Segment::PASSER_BY) {
+            blob = { (t - kStill) * (kSrc - 60) / kPasserBy, 20, 60, 200 };
+        } else if (seg == Segment::HAND) {
+            const int phase = (t - kStill - kPasserBy) % 12;
+            blob = { 90 + (phase < 6 ? phase : 12 - phase) * 6, 80 + (phase % 4) * 5, 56, 72 };
+        } else {
+            return false;
+        }
+        for (int y = blob.y; y < blob.y + blob.h; ++y) memset(frame + y * kSrc + blob.x, 200, blob.w);
+        *hand = blob;
+        return seg == Segment::HAND;
+    }
+
+    double now_us() {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Device time of one Invoke() of each model, and where it came from
+    struct InvokeCost {
+        uint32_t detector_us = 0;
+        uint32_t classifier_us = 0;
+        char source[96] = "";
+    };
+
+    // Build flags win over the log; false if neither gives both times
+    bool invoke_cost(InvokeCost* cost) {
+        if (BENCH_DETECTOR_INVOKE_US > 0 && BENCH_CLASSIFIER_INVOKE_US > 0) {
+            cost->detector_us = BENCH_DETECTOR_INVOKE_US;
+            cost->classifier_us = BENCH_CLASSIFIER_INVOKE_US;
+            snprintf(cost->source, sizeof(cost->source), "build flags");
+            return true;
+        }
+        const char* path = getenv("BENCH_CASCADE_LOG");
+        FILE* f = path ? fopen(path, "r") : nullptr;
+        if (!f) return false;
+        char line[512];
+        while (fgets(line, sizeof(line), f)) {
+            const char* at = strstr(line, "cascade: detector ");
+            unsigned det_n, det_us, cls_n, cls_us;
+            if (at && sscanf(at, "cascade: detector %u x %u us, classifier %u x %u us", &det_n, &det_us, &cls_n, &cls_us) == 4 &&
+                det_n > 0 && cls_n > 0 && det_us > 0 && cls_us > 0) {
+                cost->detector_us = det_us;
+                cost->classifier_us = cls_us;
+                snprintf(cost->source, sizeof(cost->source), "%.80s", path);
+            }
+        }
+        fclose(f);
+        return cost->detector_us > 0;
+    }
+
+    struct PathStats {
+        uint32_t detector_invokes = 0;
+        uint32_t classifier_invokes = 0;
+        uint32_t hand_frames_classified = 0;
+        double front_end_us = 0;    // Host time of the path's own preprocessing
+        uint64_t invoke_us(const InvokeCost& cost) const {
+            return (uint64_t)detector_invokes * cost.detector_us + (uint64_t)classifier_invokes * cost.classifier_us;
+        }
+    };
+
+    struct Replay {
+        uint32_t frames = 0;
+        uint32_t gated = 0;         // Frames the motion gate passed (both paths see the same ones)
+        uint32_t gated_hand = 0;
+        double shared_us = 0;       // Thumbnail, gate and tracker, paid by both paths
+        PathStats single, cascade;
+    };
+
+    Replay run_replay() {
+        static uint8_t lut[256];
+        for (int i = 0; i < 256; ++i) lut[i] = (uint8_t)i;
+        std::vector<uint8_t> frame(kSrc * kSrc), det_data(kDetIn * kDetIn), cls_data(kClsIn * kClsIn);
+        const ModelInput det_in = { det_data.data(), ModelInputType::UINT8, kDetIn, kDetIn, 1, 1, 1, lut };
+        const ModelInput cls_in = { cls_data.data(), ModelInputType::UINT8, kClsIn, kClsIn, 1, 1, 1, lut };
+
+        static MotionGate gate(MOTION_GATE_MIN_CHANGED_Q8, MOTION_GATE_HANGOVER_FRAMES, MOTION_GATE_MAX_HOLD_FRAMES);
+        static HandRoiTracker tracker;
+        static LumaThumb thumb;
+        gate.reset();
+        tracker.reset();
+
+        Replay r;
+        for (int f = 0; f < kCycles * kCycle; ++f) {
+            Blob blob = {};
+            const bool hand = render(f, frame.data(), &blob);
+            r.frames++;
+
+            // camera_analyze_frame()
+            double t0 = now_us();
+            thumb_from_gray(frame.data(), kSrc, kSrc, &thumb);
+            tracker.configure(kSrc, kSrc, kClsIn, kClsIn, false);
+            const bool moved = gate.update(thumb, tracker.gate_region());
+            tracker.update(thumb, gate.motion_mask());
+            HandRois rois;
+            tracker.get(&rois);
+            r.shared_us += now_us() - t0;
+            if (!moved) continue;
+            r.gated++;
+            r.gated_hand += hand;
+
+            // Classifier alone: every gated frame is cropped and classified
+            t0 = now_us();
+            TEST_ASSERT_TRUE(luma_resize_gray(frame.data(), kSrc, kSrc, rois.crop[0], cls_in));
+            r.single.front_end_us += now_us() - t0;
+            r.single.classifier_invokes++;
+            r.single.hand_frames_classified += hand;
+
+            // Cascade: camera_thumb_to_input(), detector, then the classifier on its box
+            t0 = now_us();
+            CropRect det_crop = preprocess_center_crop(thumb.w, thumb.h, kDetIn, kDetIn);
+            TEST_ASSERT_TRUE(luma_resize_gray(thumb.luma, thumb.w, thumb.h, det_crop, det_in));
+            const int s = thumb.scale;
+            const CropRect region = { det_crop.x * s, det_crop.y * s, det_crop.w * s, det_crop.h * s };
+            r.cascade.detector_invokes++;
+            if (hand) {
+                const CropRect crop = hand_box_to_crop(
+                    (blob.x + blob.w * 0.5f - region.x) / region.w, (blob.y + blob.h * 0.5f - region.y) / region.h,
+                    (float)blob.w / region.w, (float)blob.h / region.h, region, kSrc, kSrc, kClsIn, kClsIn,
+                    HAND_DETECTOR_BOX_MARGIN_Q8);
+                TEST_ASSERT_TRUE(crop.x <= blob.x && crop.y <= blob.y && crop.x + crop.w >= blob.x + blob.w &&
+                                 crop.y + crop.h >= blob.y + blob.h);
+                TEST_ASSERT_TRUE(luma_resize_gray(frame.data(), kSrc, kSrc, crop, cls_in));
+                r.cascade.classifier_invokes++;
+                r.cascade.hand_frames_classified++;
+            }
+            r.cascade.front_end_us += now_us() - t0;
+        }
+        return r;
+    }
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_cascade_skips_only_handless_frames() {
+    const Replay r = run_replay();
+    TEST_ASSERT_GREATER_THAN(0, r.gated_hand);
+    TEST_ASSERT_GREATER_THAN(r.gated_hand, r.gated);    // The passer-by opens the gate too
+    TEST_ASSERT_LESS_THAN(r.frames, r.gated);           // Still scenes are skipped by both paths
+    TEST_ASSERT_EQUAL_UINT32(r.gated, r.single.classifier_invokes);
+    TEST_ASSERT_EQUAL_UINT32(r.gated, r.cascade.detector_invokes);
+    TEST_ASSERT_EQUAL_UINT32(r.gated_hand, r.cascade.classifier_invokes);
+    // No hand frame the classifier-only path classified is lost to the detector
+    TEST_ASSERT_EQUAL_UINT32(r.single.hand_frames_classified, r.cascade.hand_frames_classified);
+}
+
+void test_compute_per_frame() {
+    InvokeCost cost;
+    if (!invoke_cost(&cost)) {
+        TEST_FAIL_MESSAGE("no device invoke times: set BENCH_CASCADE_LOG to a monitor log with the signing_pipeline "
+                          "\"cascade:\" line, or -DBENCH_DETECTOR_INVOKE_US/-DBENCH_CLASSIFIER_INVOKE_US");
+    }
+    const Replay r = run_replay();
+    char line[200];
+    snprintf(line, sizeof(line), "%u frames, %u passed the motion gate, %u of them with a hand; invoke cost detector %u us, classifier %u us (%s)",
+             (unsigned)r.frames, (unsigned)r.gated, (unsigned)r.gated_hand, (unsigned)cost.detector_us,
+             (unsigned)cost.classifier_us, cost.source);
+    TEST_MESSAGE(line);
+    TEST_MESSAGE("path             det_invokes  cls_invokes  front_end_us/frame(host)  invoke_us/frame(device)");
+    const struct { const char* name; const PathStats* s; } paths[] = { { "classifier-only", &r.single }, { "cascade", &r.cascade } };
+    for (const auto& p : paths) {
+        snprintf(line, sizeof(line), "%-15s  %11u  %11u  %24.2f  %23.0f", p.name, (unsigned)p.s->detector_invokes,
+                 (unsigned)p.s->classifier_invokes, (r.shared_us + p.s->front_end_us) / r.frames,
+                 (double)p.s->invoke_us(cost) / r.frames);
+        TEST_MESSAGE(line);
+    }
+    const double ratio = (double)r.cascade.invoke_us(cost) / r.single.invoke_us(cost);
+    const double break_even = (double)cost.detector_us / cost.classifier_us;
+    snprintf(line, sizeof(line), "cascade/classifier-only compute: %.2f (the cascade wins while more than %.0f%% of gated frames have no hand; here %.0f%%)",
+             ratio, 100.0 * break_even, 100.0 * (r.gated - r.gated_hand) / r.gated);
+    TEST_MESSAGE(line);
+    if ((double)(r.gated - r.gated_hand) / r.gated > break_even) {
+        TEST_ASSERT_LESS_THAN(r.single.invoke_us(cost), r.cascade.invoke_us(cost));
+    }
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_cascade_skips_only_handless_frames);
+    RUN_TEST(test_compute_per_frame);
+    return UNITY_END();
+}
@@ -0,0 +1,242 @@
+// Host replay of scripted signing sessions through the motion gate, the way
+// camera_analyze_frame() runs it (thumbnail, MotionGate on the hand tracker's region, tracker
+// update), with the frames it passes scored by a stand-in classifier and fed to the
+// SignStreamClassifier as infer_stage() does. Skipped frames reach neither, like on the device.
+// Reports the skip rate over the session and over its idle stretches, and asserts that every
+// gesture in the script is still emitted: moving signs, static hand shapes held still (bright
+// and low-contrast hands, with and without tremor) and a shape changed in place.
+//   pio test -e native_bench -f test_bench_motion_gate -v
+#include <unity.h>
+#include "config.h"
+#include "frame_preprocess.h"
+#include "hand_roi.h"
+#include "motion_gate.h"
+#include "sign_stream.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+namespace {
+    constexpr int kSrc = 240;               // Camera frame, grayscale
+    constexpr int kClasses = 8;
+    constexpr int kSettleFrames = 2;        // A static shape scores once the hand has been still this long
+
+    enum class Phase { IDLE, ENTER, MOVE, HOLD, RESHAPE, LEAVE, PASSER_BY };
+
+    struct Step {
+        Phase phase;
+        int frames;
+        int gesture;            // Class the step belongs to, -1 for none
+        uint8_t hand_luma;      // Hand brightness (background is 70..110)
+        bool tremor;            // +-1 px jitter while holding
+    };
+
+    // One session; gestures are numbered by class
+    const Step kScript[] = {
+        { Phase::IDLE, 60, -1, 0, false },
+        // 0: a moving sign
+        { Phase::ENTER, 4, 0, 200, false }, { Phase::MOVE, 20, 0, 200, false }, { Phase::LEAVE, 4, 0, 200, false },
+        { Phase::IDLE, 45, -1, 0, false },
+        // 1: static shape, bright hand, held 3 s at 15 fps
+        { Phase::ENTER, 4, 1, 200, false }, { Phase::HOLD, 45, 1, 200, false }, { Phase::LEAVE, 4, 1, 200, false },
+        { Phase::IDLE, 45, -1, 0, false },
+        // 2: static shape, hand barely brighter than the background
+        { Phase::ENTER, 6, 2, 128, false }, { Phase::HOLD, 45, 2, 128, false }, { Phase::LEAVE, 4, 2, 128, false },
+        { Phase::IDLE, 30, -1, 0, false },
+        { Phase::PASSER_BY, 30, -1, 0, false },
+        { Phase::IDLE, 45, -1, 0, false },
+        // 3: held for 8 s with tremor; 4: then reshaped in place (fingers only) and held again
+        { Phase::ENTER, 4, 3, 180, true }, { Phase::HOLD, 120, 3, 180, true },
+        { Phase::RESHAPE, 2, 4, 180, true }, { Phase::HOLD, 45, 4, 180, true }, { Phase::LEAVE, 4, 4, 180, true },
+        { Phase::IDLE, 60, -1, 0, false },
+        // 5: quick static shape, held 1.5 s
+        { Phase::ENTER, 3, 5, 160, false }, { Phase::HOLD, 22, 5, 160, false }, { Phase::LEAVE, 3, 5, 160, false },
+        { Phase::IDLE, 60, -1, 0, false },
+    };
+    constexpr int kGestures = 6;
+
+    struct Frame {
+        Phase phase;
+        int gesture;
+        int still_frames;       // Frames the hand has held its current shape
+        bool reshaped;          // Second shape of an in-place change
+    };
+
+    // Textured static background with sensor noise, then the hand: a palm block with finger
+    // columns whose pattern is the shape. `reshaped` folds two fingers down.
+    void render(int f, const Step& step, int step_frame, const Frame& fr, uint8_t* frame) {
+        uint32_t noise = 2166136261u ^ (uint32_t)f;
+        for (int y = 0; y < kSrc; ++y) {
+            for (int x = 0; x < kSrc; ++x) {
+                noise = noise * 1664525u + 1013904223u;
+                frame[y * kSrc + x] = (uint8_t)(70 + ((x / 12 + y / 12) & 1) * 40 + (noise >> 29));
+            }
+        }
+        if (step.phase == Phase::IDLE) return;
+        if (step.phase == Phase::PASSER_BY) {
+            const int x = step_frame * (kSrc - 60) / step.frames;
+            for (int y = 20; y < 220; ++y) memset(frame + y * kSrc + x, 150, 60);
+            return;
+        }
+        // Hand position: slides in from the right, waves while moving, rests at (90, 80)
+        int hx = 90, hy = 80;
+        if (step.phase == Phase::ENTER) hx = 90 + (step.frames - step_frame) * 25;
+        if (step.phase == Phase::LEAVE) hx = 90 + (step_frame + 1) * 25;
+        if (step.phase == Phase::MOVE) {
+            const int p = step_frame % 12;
+            hx = 90 + (p < 6 ? p : 12 - p) * 6;
+            hy = 80 + (p % 4) * 5;
+        }
+        if (step.tremor && (step.phase == Phase::HOLD || step.phase == Phase::RESHAPE)) {
+            hx += (int)((f * 2654435761u) >> 30) % 3 - 1;
+            hy += (int)((f * 40503u) >> 14) % 3 - 1;
+        }
+        const uint8_t v = step.hand_luma;
+        for (int y = hy + 36; y < hy + 80 && y < kSrc; ++y) {       // Palm
+            for (int x = hx; x < hx + 56 && x < kSrc; ++x) frame[y * kSrc + x] = v;
+        }
+        for (int finger = 0; finger < 4; ++finger) {                 // Fingers
+            const bool down = fr.reshaped && (finger == 1 || finger == 2);
+            const int top = down ? hy + 26 : hy + (finger == 0 || finger == 3 ? 10 : 0);
+            for (int y = top; y < hy + 36; ++y) {
+                for (int x = hx + 2 + finger * 14; x < hx + 12 + finger * 14 && x < kSrc; ++x) frame[y * kSrc + x] = v;
+            }
+        }
+    }
+
+    // Stand-in classifier: a moving sign scores while it moves, a static shape once the hand has
+    // settled on it; anything else is a low spread
+    void classify(const Frame& fr, float* scores) {
+        for (int c = 0; c < kClasses; ++c) scores[c] = 0.05f;
+        if (fr.gesture < 0) return;
+        if (fr.phase == Phase::MOVE) {
+            scores[fr.gesture] = 0.85f;
+        } else if (fr.phase == Phase::HOLD && fr.still_frames >= kSettleFrames) {
+            scores[fr.gesture] = 0.9f;
+        } else if (fr.phase != Phase::LEAVE) {
+            scores[fr.gesture] = 0.3f;  // Motion blur / transition
+        }
+    }
+
+    struct Replay {
+        uint32_t frames = 0, passed = 0;
+        uint32_t idle_frames = 0, idle_passed = 0;
+        uint32_t hold_frames = 0, hold_passed = 0;
+        int emitted[kGestures] = {};
+        int wrong = 0;
+        int gesture_passed[kGestures] = {};     // Frames of each gesture the gate let through
+    };
+
+    Replay run_replay() {
+        std::vector<uint8_t> frame(kSrc * kSrc);
+        static MotionGate gate(MOTION_GATE_MIN_CHANGED_Q8, MOTION_GATE_HANGOVER_FRAMES, MOTION_GATE_MAX_HOLD_FRAMES);
+        static HandRoiTracker tracker;
+        static LumaThumb thumb;
+        gate.reset();
+        tracker.reset();
+        SignStreamClassifier stream({ kClasses, SIGN_STREAM_WINDOW, SIGN_STREAM_ENTER, SIGN_STREAM_EXIT,
+                                      SIGN_STREAM_MIN_FRAMES, SIGN_STREAM_RELEASE_FRAMES });
+
+        Replay r;
+        Frame fr = { Phase::IDLE, -1, 0, false };
+        int f = 0;
+        float scores[kClasses];
+        for (const Step& step : kScript) {
+            for (int i = 0; i < step.frames; ++i, ++f) {
+                const bool still = step.phase == Phase::HOLD;
+                fr.still_frames = still && fr.phase == Phase::HOLD && fr.gesture == step.gesture ? fr.still_frames + 1 : 0;
+                if (step.phase == Phase::RESHAPE) fr.reshaped = true;
+                if (step.phase == Phase::ENTER || step.phase == Phase::IDLE) fr.reshaped = false;
+                fr.phase = step.phase;
+                fr.gesture = step.gesture;
+                render(f, step, i, fr, frame.data());
+
+                thumb_from_gray(frame.data(), kSrc, kSrc, &thumb);
+                tracker.configure(kSrc, kSrc, TFLITE_MODEL_INPUT_WIDTH, TFLITE_MODEL_INPUT_HEIGHT, false);
+                const bool pass = gate.update(thumb, tracker.gate_region());
+                tracker.update(thumb, gate.motion_mask());
+
+                r.frames++;
+                r.passed += pass;
+                if (step.phase == Phase::IDLE) {
+                    r.idle_frames++;
+                    r.idle_passed += pass;
+                }
+                if (still) {
+                    r.hold_frames++;
+                    r.hold_passed += pass;
+                }
+                if (step.gesture >= 0) r.gesture_passed[step.gesture] += pass;
+                if (!pass) continue;
+                classify(fr, scores);
+                SignEmission e;
+                if (stream.update(scores, &e)) {
+                    if (e.class_idx == step.gesture) r.emitted[e.class_idx]++;
+                    else r.wrong++;
+                }
+            }
+        }
+        return r;
+    }
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_no_gesture_missed() {
+    const Replay r = run_replay();
+    char line[160];
+    TEST_MESSAGE("gesture  frames_passed  emitted");
+    for (int g = 0; g < kGestures; ++g) {
+        snprintf(line, sizeof(line), "%7d  %13d  %7d", g, r.gesture_passed[g], r.emitted[g]);
+        TEST_MESSAGE(line);
+    }
+    snprintf(line, sizeof(line), "skipped %u of %u frames (%.0f%%); idle %.0f%% skipped; held shapes %u of %u frames passed",
+             (unsigned)(r.frames - r.passed), (unsigned)r.frames, 100.0 * (r.frames - r.passed) / r.frames,
+             100.0 * (r.idle_frames - r.idle_passed) / r.idle_frames, (unsigned)r.hold_passed, (unsigned)r.hold_frames);
+    TEST_MESSAGE(line);
+    for (int g = 0; g < kGestures; ++g) TEST_ASSERT_EQUAL_MESSAGE(1, r.emitted[g], "gesture missed or repeated");
+    TEST_ASSERT_EQUAL(0, r.wrong);
+    // A held shape is inferred on every frame it is held, not just until the background absorbs it
+    TEST_ASSERT_EQUAL(r.hold_frames, r.hold_passed);
+    // The gate still earns its keep: most idle frames are skipped
+    TEST_ASSERT_GREATER_THAN(r.idle_frames * 2 / 3, r.idle_frames - r.idle_passed);
+}
+
+// Something set down in the region and left there keeps the gate open for at most
+// MOTION_GATE_MAX_HOLD_FRAMES; then it becomes part of the scene and the gate closes
+void test_parked_object_times_out() {
+    static MotionGate gate(MOTION_GATE_MIN_CHANGED_Q8, MOTION_GATE_HANGOVER_FRAMES, MOTION_GATE_MAX_HOLD_FRAMES);
+    static LumaThumb thumb;
+    thumb.w = thumb.h = kSrc / 4;
+    thumb.scale = 4;
+    thumb.has_skin = false;
+    const CropRect region = { 0, 0, thumb.w, thumb.h };
+    const int n = thumb.w * thumb.h;
+    uint32_t noise = 99;
+    auto frame = [&](bool object) {
+        for (int i = 0; i < n; ++i) {
+            noise = noise * 1664525u + 1013904223u;
+            thumb.luma[i] = (uint8_t)(90 + (noise >> 30));
+            if (object && (i % thumb.w) >= 10 && (i % thumb.w) < 40 && i / thumb.w >= 20 && i / thumb.w < 50) thumb.luma[i] = 200;
+        }
+        return gate.update(thumb, region);
+    };
+    for (int f = 0; f < 30; ++f) frame(false);
+    TEST_ASSERT_FALSE(frame(false));
+
+    int passed = 0;
+    for (int f = 0; f < 3 * MOTION_GATE_MAX_HOLD_FRAMES; ++f) passed += frame(true);
+    // Plus the frames the background takes to absorb it (a dozen at alpha 1/4) and the hangover
+    TEST_ASSERT_LESS_OR_EQUAL(MOTION_GATE_MAX_HOLD_FRAMES + 12 + MOTION_GATE_HANGOVER_FRAMES, passed);
+    TEST_ASSERT_GREATER_OR_EQUAL(MOTION_GATE_MAX_HOLD_FRAMES, passed);
+    TEST_ASSERT_FALSE(frame(true));
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_no_gesture_missed);
+    RUN_TEST(test_parked_object_times_out);
+    return UNITY_END();
+}
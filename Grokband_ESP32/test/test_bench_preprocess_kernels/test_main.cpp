@@ -0,0 +1,161 @@
+// Generic vs specialized (preprocess_kernels.h) resize of a 240x240 camera frame into the model
+// input: both pixel formats, every tensor type, the centered crop and a hand-sized ROI. Reports
+// host time per frame and cycles per output pixel for each and checks the outputs are identical.
+// Also times the JPEG path's area downscaler over decoded 16x16 MCUs, per source pixel since it
+// reads all of them. Cycles come from the TSC on x86 hosts (0 elsewhere), so they compare kernels;
+// the ESP32's own figure is the PREPROCESS trace stage on target.
+//   pio test -e native_bench -f test_bench_preprocess_kernels -v
+#include <unity.h>
+#include "config.h"
+#include "frame_preprocess.h"
+#include "preprocess_kernels.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace {
+    constexpr int kSrc = 240;
+    constexpr int kW = TFLITE_MODEL_INPUT_WIDTH;
+    constexpr int kH = TFLITE_MODEL_INPUT_HEIGHT;
+    constexpr int kRuns = 400;
+
+    double now_us() {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    uint64_t cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return 0;
+#endif
+    }
+
+    struct Timing {
+        double us;
+        double cycles;
+    };
+
+    // Best of kRuns, in both units
+    template <typename Fn>
+    Timing best_of(Fn fn) {
+        Timing best = { 1e30, 1e30 };
+        for (int r = 0; r < kRuns; ++r) {
+            const double t0 = now_us();
+            const uint64_t c0 = cycles();
+            fn();
+            const double c = (double)(cycles() - c0);
+            const double t = now_us() - t0;
+            best.us = t < best.us ? t : best.us;
+            best.cycles = c < best.cycles ? c : best.cycles;
+        }
+        return best;
+    }
+
+    Timing time_resize(LumaResizeFn fn, const uint8_t* frame, CropRect crop, const ModelInput& dst) {
+        return best_of([&] { TEST_ASSERT_TRUE(fn(frame, kSrc, kSrc, crop, dst)); });
+    }
+
+    struct Case {
+        const char* name;
+        ModelInputType type;
+        const void* lut;
+        size_t elem;
+    };
+
+    template <typename Pixel>
+    void bench_format(const char* format, LumaResizeFn generic) {
+        static uint8_t lut_u8[256];
+        static int8_t lut_i8[256];
+        static float lut_f32[256];
+        for (int i = 0; i < 256; ++i) {
+            lut_u8[i] = (uint8_t)i;
+            lut_i8[i] = (int8_t)(i - 128);
+            lut_f32[i] = i / 255.0f;
+        }
+        std::vector<uint8_t> frame(kSrc * kSrc * Pixel::kBytes);
+        uint32_t noise = 12345;
+        for (uint8_t& b : frame) b = (uint8_t)((noise = noise * 1664525u + 1013904223u) >> 24);
+        std::vector<uint8_t> a(kW * kH * 4), b(kW * kH * 4);
+
+        const Case cases[] = { { "uint8", ModelInputType::UINT8, lut_u8, 1 },
+                               { "int8", ModelInputType::INT8, lut_i8, 1 },
+                               { "float32", ModelInputType::FLOAT32, lut_f32, 4 } };
+        const struct { const char* name; CropRect crop; } crops[] = {
+            { "center", preprocess_center_crop(kSrc, kSrc, kW, kH) },
+            { "hand ROI", { 70, 52, 112, 112 } },
+        };
+        char line[160];
+        for (const Case& c : cases) {
+            for (const auto& crop : crops) {
+                ModelInput dst = { a.data(), c.type, kW, kH, 1, 1, 1, c.lut };
+                const LumaResizeFn fixed = pick_luma_resize<Pixel, kW, kH>(dst, generic);
+                TEST_ASSERT_TRUE(fixed != generic);
+                const Timing generic_t = time_resize(generic, frame.data(), crop.crop, dst);
+                dst.data = b.data();
+                const Timing fixed_t = time_resize(fixed, frame.data(), crop.crop, dst);
+                TEST_ASSERT_EQUAL_MEMORY(a.data(), b.data(), (size_t)kW * kH * c.elem);
+                snprintf(line, sizeof(line), "%-7s  %-7s  %-8s  %10.1f  %14.1f  %7.2fx  %8.1f  %8.1f", format, c.name,
+                         crop.name, generic_t.us, fixed_t.us, generic_t.us / fixed_t.us,
+                         generic_t.cycles / (kW * kH), fixed_t.cycles / (kW * kH));
+                TEST_MESSAGE(line);
+            }
+        }
+    }
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_bench_generic_vs_specialized() {
+    char line[160];
+    snprintf(line, sizeof(line), "%dx%d source -> %dx%d model input, best of %d runs (host)", kSrc, kSrc, kW, kH, kRuns);
+    TEST_MESSAGE(line);
+    TEST_MESSAGE("pixels   tensor   crop      generic_us  specialized_us  speedup  gen_cyc/px  spec_cyc/px");
+    bench_format<PixelGray>("gray", luma_resize_gray);
+    bench_format<PixelRgb565>("rgb565", luma_resize_rgb565);
+}
+
+void test_bench_area_downscaler() {
+    std::vector<uint8_t> rgb(kSrc * kSrc * 3), out(kW * kH);
+    uint32_t noise = 777;
+    for (uint8_t& b : rgb) b = (uint8_t)((noise = noise * 1664525u + 1013904223u) >> 24);
+    // Decoded MCUs, copied out up front so the timing is the downscaler's alone
+    std::vector<std::vector<uint8_t>> mcus;
+    for (int by = 0; by < kSrc; by += 16) {
+        for (int bx = 0; bx < kSrc; bx += 16) {
+            std::vector<uint8_t> block(16 * 16 * 3);
+            for (int y = 0; y < 16; ++y) memcpy(&block[y * 16 * 3], &rgb[((by + y) * kSrc + bx) * 3], 16 * 3);
+            mcus.push_back(block);
+        }
+    }
+    static uint8_t lut[256];
+    for (int i = 0; i < 256; ++i) lut[i] = (uint8_t)i;
+    const ModelInput dst = { out.data(), ModelInputType::UINT8, kW, kH, 1, 1, 1, lut };
+    const CropRect crop = preprocess_center_crop(kSrc, kSrc, kW, kH);
+    static LumaAreaDownscaler area;
+    const Timing t = best_of([&] {
+        TEST_ASSERT_TRUE(area.begin(kSrc, kSrc, crop, dst));
+        size_t i = 0;
+        for (int by = 0; by < kSrc; by += 16) {
+            for (int bx = 0; bx < kSrc; bx += 16) area.push_block(bx, by, 16, 16, mcus[i++].data());
+        }
+        area.finish();
+    });
+    char line[160];
+    snprintf(line, sizeof(line), "area downscaler (JPEG MCUs, rgb888 -> uint8): %.1f us per frame, %.1f cycles per source pixel",
+             t.us, t.cycles / (kSrc * kSrc));
+    TEST_MESSAGE(line);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_bench_generic_vs_specialized);
+    RUN_TEST(test_bench_area_downscaler);
+    return UNITY_END();
+}
@@ -0,0 +1,332 @@
+// ScorePostprocessor over a labelled score corpus, against the float loop the band used to
+// publish from (dequantize every class, take the argmax). Checks that its top-k and verdicts
+// match a float reference on every frame, then reports per-class precision/recall of both and
+// their per-frame cost; the post-processor's cost includes building the window vector
+// push_hand_result() feeds to SignStreamClassifier.
+//
+// The corpus is synthetic by default: an int8 softmax output (scale 1/256, zero point -128)
+// that is right on most sign frames and confidently wrong on some, plus "no sign" frames. For a
+// recorded corpus, pass the file calibrate_thresholds.py reads (label,q0,q1,... with the raw
+// int8 outputs) and optionally the table it wrote:
+//   pio test -e native_bench -f test_bench_score_postprocess -v
+//   PLATFORMIO_BUILD_FLAGS='-DBENCH_SCORE_CORPUS=\"corpus.csv\" -DBENCH_SCORE_CALIB=\"data/sign_model.calib\"' pio test ...
+#include <unity.h>
+#include "config.h"
+#include "score_postprocess.h"
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#ifndef BENCH_SCORE_OUTPUT_SCALE
+#define BENCH_SCORE_OUTPUT_SCALE (1.0f / 256.0f)
+#endif
+#ifndef BENCH_SCORE_ZERO_POINT
+#define BENCH_SCORE_ZERO_POINT (-128)
+#endif
+
+namespace {
+    constexpr int kSyntheticClasses = TFLITE_NUM_CLASSES;
+    constexpr int kSyntheticFrames = 20000;
+    constexpr int kRepeats = 20;          // Corpus passes per timing
+
+    struct Corpus {
+        int num_classes = 0;
+        std::vector<int> labels;          // -1: no sign
+        std::vector<int8_t> outputs;      // num_classes per frame
+        size_t frames() const { return labels.size(); }
+        const int8_t* frame(size_t i) const { return outputs.data() + i * num_classes; }
+    };
+
+    int8_t quantize(float p) {
+        long q = lroundf(p / BENCH_SCORE_OUTPUT_SCALE) + BENCH_SCORE_ZERO_POINT;
+        return (int8_t)(q < -128 ? -128 : (q > 127 ? 127 : q));
+    }
+
+    // 60% sign frames, right 85% of the time; the rest are someone moving with no sign in view
+    Corpus synthetic_corpus() {
+        Corpus c;
+        c.num_classes = kSyntheticClasses;
+        std::mt19937 rng(24);
+        std::uniform_real_distribution<float> u(0.0f, 1.0f);
+        std::uniform_int_distribution<int> cls(0, kSyntheticClasses - 1);
+        std::vector<float> p(kSyntheticClasses);
+        for (int f = 0; f < kSyntheticFrames; ++f) {
+            int label = u(rng) < 0.6f ? cls(rng) : -1;
+            int winner;
+            float top;
+            if (label < 0) {
+                winner = cls(rng);
+                top = 0.2f + 0.55f * u(rng);
+            } else if (u(rng) < 0.85f) {
+                winner = label;
+                top = 0.55f + 0.44f * u(rng);
+            } else {
+                winner = (label + 1 + cls(rng) % (kSyntheticClasses - 1)) % kSyntheticClasses;
+                top = 0.35f + 0.45f * u(rng);
+            }
+            float rest = 0.0f;
+            for (int k = 0; k < kSyntheticClasses; ++k) rest += p[k] = k == winner ? 0.0f : u(rng) * u(rng);
+            for (int k = 0; k < kSyntheticClasses; ++k) {
+                if (k != winner) p[k] *= (1.0f - top) / rest;
+            }
+            p[winner] = top;
+            c.labels.push_back(label);
+            for (int k = 0; k < kSyntheticClasses; ++k) c.outputs.push_back(quantize(p[k]));
+        }
+        return c;
+    }
+
+#ifdef BENCH_SCORE_CORPUS
+    Corpus recorded_corpus(const char* path) {
+        Corpus c;
+        FILE* f = fopen(path, "r");
+        TEST_ASSERT_NOT_NULL_MESSAGE(f, path);
+        char line[1024];
+        while (fgets(line, sizeof(line), f)) {
+            if (char* hash = strchr(line, '#')) *hash = '\0';
+            if (line[0] == '\0' || line[0] == '\n' || line[0] == '\r' || strncmp(line, "label", 5) == 0) continue;
+            char* p = line;
+            c.labels.push_back((int)strtol(p, &p, 10));
+            int n = 0;
+            while (*p == ',') {
+                c.outputs.push_back((int8_t)strtol(p + 1, &p, 10));
+                ++n;
+            }
+            if (c.num_classes == 0) c.num_classes = n;
+            TEST_ASSERT_EQUAL_MESSAGE(c.num_classes, n, "rows with different class counts");
+        }
+        fclose(f);
+        TEST_ASSERT_GREATER_THAN(0, (int)c.frames());
+        return c;
+    }
+#endif
+
+    const Corpus& corpus() {
+#ifdef BENCH_SCORE_CORPUS
+        static const Corpus c = recorded_corpus(BENCH_SCORE_CORPUS);
+#else
+        static const Corpus c = synthetic_corpus();
+#endif
+        return c;
+    }
+
+    void setup_postprocessor(ScorePostprocessor* pp, int num_classes) {
+        const ClassCalibration defaults = { SCORE_DEFAULT_THRESHOLD, SCORE_DEFAULT_MARGIN, 1.0f, 0.0f };
+        TEST_ASSERT_TRUE(pp->begin(num_classes, ScoreType::INT8, BENCH_SCORE_OUTPUT_SCALE, BENCH_SCORE_ZERO_POINT, defaults));
+#ifdef BENCH_SCORE_CALIB
+        FILE* f = fopen(BENCH_SCORE_CALIB, "r");
+        TEST_ASSERT_NOT_NULL_MESSAGE(f, BENCH_SCORE_CALIB);
+        std::string text;
+        char buf[256];
+        while (fgets(buf, sizeof(buf), f)) text += buf;
+        fclose(f);
+        TEST_ASSERT_GREATER_OR_EQUAL(0, pp->load_calibration(text.c_str()));
+#endif
+    }
+
+    float dequantize(int8_t q) { return BENCH_SCORE_OUTPUT_SCALE * ((float)q - BENCH_SCORE_ZERO_POINT); }
+
+    // The old tflite_read_output(): every class dequantized, argmax
+    int float_loop(const int8_t* q, int num_classes, float* scores) {
+        int best = -1;
+        float best_score = -1e30f;
+        for (int i = 0; i < num_classes; ++i) {
+            scores[i] = dequantize(q[i]);
+            if (scores[i] > best_score) {
+                best_score = scores[i];
+                best = i;
+            }
+        }
+        return best;
+    }
+
+    // push_hand_result(): calibrated winners, zero elsewhere
+    int topk_window(const ScorePostprocessor& pp, const int8_t* q, float* window, int num_classes) {
+        TopKResult top;
+        pp.process(q, SCORE_TOPK, &top);
+        for (int i = 0; i < num_classes; ++i) window[i] = 0.0f;
+        if (top.verdict == ScoreVerdict::ACCEPTED) {
+            for (int i = 0; i < top.count; ++i) window[top.top[i].class_idx] = top.top[i].prob;
+        }
+        return top.class_idx();
+    }
+
+    double now_us() {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    struct PR { double precision, recall; };
+
+    std::vector<PR> precision_recall(const Corpus& c, const std::vector<int>& predicted) {
+        std::vector<PR> out;
+        for (int k = 0; k < c.num_classes; ++k) {
+            uint32_t tp = 0, fp = 0, fn = 0;
+            for (size_t i = 0; i < c.frames(); ++i) {
+                tp += predicted[i] == k && c.labels[i] == k;
+                fp += predicted[i] == k && c.labels[i] != k;
+                fn += predicted[i] != k && c.labels[i] == k;
+            }
+            out.push_back({ tp + fp ? (double)tp / (tp + fp) : 1.0, tp + fn ? (double)tp / (tp + fn) : 1.0 });
+        }
+        return out;
+    }
+
+    double mean_precision(const std::vector<PR>& pr) {
+        double sum = 0;
+        for (const PR& x : pr) sum += x.precision;
+        return sum / pr.size();
+    }
+}
+
+void setUp() {}
+void tearDown() {}
+
+// Every frame: top-k ranked as a stable sort of the outputs, probabilities and verdict as the
+// float definition in score_postprocess.h gives them
+void test_matches_float_reference() {
+    const Corpus& c = corpus();
+    ScorePostprocessor pp;
+    setup_postprocessor(&pp, c.num_classes);
+    const int k = std::min(SCORE_TOPK, c.num_classes);
+    std::vector<int> order(c.num_classes);
+    for (size_t f = 0; f < c.frames(); ++f) {
+        const int8_t* q = c.frame(f);
+        for (int i = 0; i < c.num_classes; ++i) order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [q](int a, int b) { return q[a] > q[b]; });
+        auto prob = [&](int cls) {
+            const ClassCalibration& cal = pp.calibration(cls);
+            return std::min(1.0f, std::max(0.0f, cal.scale * dequantize(q[cls]) + cal.offset));
+        };
+
+        TopKResult top;
+        pp.process(q, k, &top);
+        TEST_ASSERT_EQUAL(order[0], top.top[0].class_idx);
+        TEST_ASSERT_FLOAT_WITHIN(1e-6f, prob(order[0]), top.top[0].prob);
+        const float p1 = prob(order[0]);
+        const float threshold = pp.calibration(order[0]).threshold;
+        if (fabsf(p1 - threshold) < 1e-5f) continue; // Raw-domain limit vs float compare at the boundary
+        if (p1 < threshold) {
+            TEST_ASSERT_EQUAL(ScoreVerdict::BELOW_THRESHOLD, top.verdict);
+            continue;
+        }
+        TEST_ASSERT_EQUAL(k, top.count);
+        for (int i = 1; i < k; ++i) {
+            TEST_ASSERT_EQUAL(order[i], top.top[i].class_idx);
+            TEST_ASSERT_FLOAT_WITHIN(1e-6f, prob(order[i]), top.top[i].prob);
+        }
+        const float lead = p1 - (c.num_classes > 1 ? prob(order[1]) : 0.0f);
+        const float margin = pp.calibration(order[0]).margin;
+        if (fabsf(lead - margin) < 1e-5f) continue;
+        TEST_ASSERT_EQUAL(lead >= margin ? ScoreVerdict::ACCEPTED : ScoreVerdict::LOW_MARGIN, top.verdict);
+    }
+}
+
+// The same outputs as uint8 (zero point shifted by 128) and float (dequantized) give the same
+// decisions, ties included
+void test_output_types_agree() {
+    const Corpus& c = corpus();
+    const ClassCalibration defaults = { SCORE_DEFAULT_THRESHOLD, SCORE_DEFAULT_MARGIN, 1.0f, 0.0f };
+    ScorePostprocessor s8, u8, f32;
+    setup_postprocessor(&s8, c.num_classes);
+    TEST_ASSERT_TRUE(u8.begin(c.num_classes, ScoreType::UINT8, BENCH_SCORE_OUTPUT_SCALE, BENCH_SCORE_ZERO_POINT + 128, defaults));
+    TEST_ASSERT_TRUE(f32.begin(c.num_classes, ScoreType::FLOAT32, 0.0f, 0, defaults));
+    for (int k = 0; k < c.num_classes; ++k) {
+        u8.set_class(k, s8.calibration(k));
+        f32.set_class(k, s8.calibration(k));
+    }
+    std::vector<uint8_t> as_u8(c.num_classes);
+    std::vector<float> as_f32(c.num_classes);
+    for (size_t f = 0; f < c.frames(); ++f) {
+        const int8_t* q = c.frame(f);
+        for (int k = 0; k < c.num_classes; ++k) {
+            as_u8[k] = (uint8_t)(q[k] + 128);
+            as_f32[k] = dequantize(q[k]);
+        }
+        TopKResult a, b, d;
+        s8.process(q, SCORE_TOPK, &a);
+        u8.process(as_u8.data(), SCORE_TOPK, &b);
+        f32.process(as_f32.data(), SCORE_TOPK, &d);
+        for (const TopKResult* other : { &b, &d }) {
+            TEST_ASSERT_EQUAL(a.count, other->count);
+            for (int i = 0; i < a.count; ++i) TEST_ASSERT_EQUAL(a.top[i].class_idx, other->top[i].class_idx);
+        }
+        TEST_ASSERT_EQUAL(a.verdict, b.verdict);
+        const float p1 = a.top[0].prob, threshold = s8.calibration(a.top[0].class_idx).threshold;
+        if (fabsf(p1 - threshold) >= 1e-5f) TEST_ASSERT_EQUAL(a.verdict, d.verdict); // Float outputs compare in float
+    }
+}
+
+void test_precision_recall() {
+    const Corpus& c = corpus();
+    ScorePostprocessor pp;
+    setup_postprocessor(&pp, c.num_classes);
+    std::vector<float> scores(c.num_classes);
+    std::vector<int> argmax, thresholded;
+    uint32_t accepted = 0;
+    for (size_t f = 0; f < c.frames(); ++f) {
+        argmax.push_back(float_loop(c.frame(f), c.num_classes, scores.data()));
+        thresholded.push_back(topk_window(pp, c.frame(f), scores.data(), c.num_classes));
+        accepted += thresholded.back() >= 0;
+    }
+    const std::vector<PR> before = precision_recall(c, argmax), after = precision_recall(c, thresholded);
+
+    char line[160];
+    snprintf(line, sizeof(line), "%u frames, %d classes; the post-processor accepted %u", (unsigned)c.frames(),
+             c.num_classes, (unsigned)accepted);
+    TEST_MESSAGE(line);
+    TEST_MESSAGE("class  argmax_P  argmax_R  topk_P  topk_R");
+    for (int k = 0; k < c.num_classes; ++k) {
+        snprintf(line, sizeof(line), "%5d  %8.3f  %8.3f  %6.3f  %6.3f", k, before[k].precision, before[k].recall,
+                 after[k].precision, after[k].recall);
+        TEST_MESSAGE(line);
+    }
+    snprintf(line, sizeof(line), "mean precision: argmax %.3f, post-processor %.3f", mean_precision(before), mean_precision(after));
+    TEST_MESSAGE(line);
+    TEST_ASSERT_TRUE(mean_precision(after) >= mean_precision(before));
+#ifndef BENCH_SCORE_CORPUS
+    // Argmax publishes every "no sign" frame; the synthetic corpus has plenty of them
+    TEST_ASSERT_TRUE(mean_precision(after) > mean_precision(before) + 0.1);
+#endif
+}
+
+void test_bench_cost_per_frame() {
+    const Corpus& c = corpus();
+    ScorePostprocessor pp;
+    setup_postprocessor(&pp, c.num_classes);
+    std::vector<float> scores(c.num_classes);
+    int64_t sink = 0;
+
+    double t0 = now_us();
+    for (int r = 0; r < kRepeats; ++r) {
+        for (size_t f = 0; f < c.frames(); ++f) sink += float_loop(c.frame(f), c.num_classes, scores.data());
+    }
+    const double float_ns = (now_us() - t0) * 1000.0 / (kRepeats * c.frames());
+
+    t0 = now_us();
+    for (int r = 0; r < kRepeats; ++r) {
+        for (size_t f = 0; f < c.frames(); ++f) sink += topk_window(pp, c.frame(f), scores.data(), c.num_classes);
+    }
+    const double topk_ns = (now_us() - t0) * 1000.0 / (kRepeats * c.frames());
+
+    char line[160];
+    snprintf(line, sizeof(line), "per frame (host): float loop %.1f ns, top-%d post-processor + window vector %.1f ns (checksum %lld)",
+             float_ns, SCORE_TOPK, topk_ns, (long long)sink);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_TRUE(float_ns > 0 && topk_ns > 0);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_matches_float_reference);
+    RUN_TEST(test_output_types_agree);
+    RUN_TEST(test_precision_recall);
+    RUN_TEST(test_bench_cost_per_frame);
+    return UNITY_END();
+}
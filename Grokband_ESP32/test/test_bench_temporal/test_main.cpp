@@ -0,0 +1,137 @@
+// Host replay of the temporal path for each window depth N: frames go through a FrameHistory
+// ring into an input tensor the way infer_stage() feeds a temporal model, and per-inference
+// scores through a SignStreamClassifier. Reports the per-frame cost and throughput of that
+// plumbing (preprocessing and Invoke() excluded) and the memory it costs per N.
+//   pio test -e native_bench -f test_bench_temporal
+#include <unity.h>
+#include "config.h"
+#include "frame_history.h"
+#include "sign_stream.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+namespace {
+    constexpr size_t kFrameBytes = 96 * 96 * 1; // 96x96 int8 grayscale, the shipped model's frame
+    constexpr int kHands = 2;                   // HAND_ROI_MAX_HANDS: one ring per hand
+    constexpr int kClasses = 24;
+    constexpr int kFrames = 20000;
+    const int kDepths[] = { 1, 2, 4, 8, 12, 16 };
+
+    double now_us() {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    SignStreamParams stream_params() {
+        return { kClasses, SIGN_STREAM_WINDOW, SIGN_STREAM_ENTER, SIGN_STREAM_EXIT,
+                 SIGN_STREAM_MIN_FRAMES, SIGN_STREAM_RELEASE_FRAMES };
+    }
+
+    // Scripted per-frame scores: idle, then a gesture of `cls` held for 12 frames with a
+    // one-frame dip in the middle, then idle again. 40 frames per gesture.
+    void scripted_scores(int frame, float* scores) {
+        const int phase = frame % 40;
+        const int cls = (frame / 40) % kClasses;
+        for (int c = 0; c < kClasses; ++c) scores[c] = 0.02f;
+        if (phase >= 10 && phase < 22) scores[cls] = phase == 16 ? 0.5f : 0.9f;
+    }
+
+    // Frame f as the preprocessor would leave it: every byte identifies its frame
+    void fill_frame(uint8_t* slot, int frame) { memset(slot, (uint8_t)(frame * 7 + 1), kFrameBytes); }
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_window_is_oldest_first() {
+    for (int depth : kDepths) {
+        std::vector<uint8_t> storage(FrameHistory::bytes_needed(kFrameBytes, depth));
+        std::vector<uint8_t> tensor(depth * kFrameBytes);
+        FrameHistory history;
+        TEST_ASSERT_TRUE(history.begin(storage.data(), kFrameBytes, depth));
+        for (int f = 0; f < 3 * depth + 1; ++f) {
+            fill_frame(history.head(), f);
+            history.commit(f * 66000u);
+            TEST_ASSERT_EQUAL(f + 1 >= depth, history.full());
+            if (!history.full()) continue;
+            history.copy_window(tensor.data());
+            for (int i = 0; i < depth; ++i) {
+                const uint8_t want = (uint8_t)((f - depth + 1 + i) * 7 + 1);
+                TEST_ASSERT_EQUAL_UINT8(want, tensor[i * kFrameBytes]);
+                TEST_ASSERT_EQUAL_UINT8(want, tensor[(i + 1) * kFrameBytes - 1]);
+            }
+        }
+        history.reset();
+        TEST_ASSERT_FALSE(history.full());
+    }
+}
+
+void test_one_emission_per_gesture() {
+    SignStreamClassifier stream(stream_params());
+    float scores[kClasses];
+    SignEmission e;
+    for (int f = 0; f < 40 * kClasses; ++f) {
+        scripted_scores(f, scores);
+        if (stream.update(scores, &e)) TEST_ASSERT_EQUAL((f / 40) % kClasses, e.class_idx);
+    }
+    TEST_ASSERT_EQUAL_UINT32(kClasses, stream.emitted()); // The dip mid-gesture doesn't re-emit
+}
+
+// Throughput and memory per N, replaying kFrames frames per hand
+void test_replay_per_depth() {
+    char line[160];
+    TEST_MESSAGE("    N  history_B/hand  tensor_input_B  total_B(2 hands)  frame_us  frames/s  emitted");
+    for (int depth : kDepths) {
+        const size_t per_hand = FrameHistory::bytes_needed(kFrameBytes, depth);
+        std::vector<uint8_t> storage(per_hand * kHands);
+        std::vector<uint8_t> tensor(depth * kFrameBytes);
+        FrameHistory history[kHands];
+        SignStreamClassifier* streams[kHands];
+        for (int h = 0; h < kHands; ++h) {
+            TEST_ASSERT_TRUE(history[h].begin(storage.data() + h * per_hand, kFrameBytes, depth));
+            streams[h] = new SignStreamClassifier(stream_params());
+        }
+
+        float scores[kClasses];
+        SignEmission e;
+        uint32_t checksum = 0;
+        double elapsed = 0;
+        for (int f = 0; f < kFrames; ++f) {
+            for (int h = 0; h < kHands; ++h) {
+                fill_frame(history[h].head(), f); // Stands in for preprocessing, not timed
+                const double t0 = now_us();
+                history[h].commit(f * 66000u);
+                if (history[h].full()) {
+                    history[h].copy_window(tensor.data());
+                    checksum += tensor[(f % depth) * kFrameBytes];
+                    scripted_scores(f - depth + 1, scores); // Invoke() would run here
+                    streams[h]->update(scores, &e);
+                }
+                elapsed += now_us() - t0;
+            }
+        }
+        const double frame_us = elapsed / (kFrames * kHands);
+        // Every full gesture in the replay is recognized once, whatever the depth
+        const uint32_t gestures = (kFrames - depth + 1) / 40;
+        TEST_ASSERT_UINT32_WITHIN(1, gestures, streams[0]->emitted());
+        TEST_ASSERT_NOT_EQUAL(0, checksum);
+
+        const size_t total = kHands * (per_hand + sizeof(SignStreamClassifier)) + tensor.size();
+        snprintf(line, sizeof(line), "%5d  %14u  %14u  %16u  %8.2f  %8.0f  %7u", depth, (unsigned)per_hand,
+                 (unsigned)tensor.size(), (unsigned)total, frame_us, 1e6 / frame_us, (unsigned)streams[0]->emitted());
+        TEST_MESSAGE(line);
+        for (int h = 0; h < kHands; ++h) delete streams[h];
+    }
+    snprintf(line, sizeof(line), "SignStreamClassifier: %u B per hand, independent of N", (unsigned)sizeof(SignStreamClassifier));
+    TEST_MESSAGE(line);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_window_is_oldest_first);
+    RUN_TEST(test_one_emission_per_gesture);
+    RUN_TEST(test_replay_per_depth);
+    return UNITY_END();
+}
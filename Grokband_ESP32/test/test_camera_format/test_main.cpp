@@ -0,0 +1,111 @@
+// camera_select_format() against the OV2640 frame sizes camera_init() offers: frame size from
+// the model input and oversample, then RGB565 / gray / JPEG from the raw buffer budget.
+#include <unity.h>
+#include "camera_format.h"
+#include "config.h"
+
+namespace {
+    // camera_handler.cpp's kFrameSizes, with the framesize_t ids replaced by their order
+    enum { F96X96, QQVGA, QCIF, HQVGA, F240X240, QVGA, CIF, HVGA, VGA };
+    const CameraFrameSize kSizes[] = {
+        { F96X96, 96, 96 },     { QQVGA, 160, 120 },  { QCIF, 176, 144 },
+        { HQVGA, 240, 176 },    { F240X240, 240, 240 }, { QVGA, 320, 240 },
+        { CIF, 400, 296 },      { HVGA, 480, 320 },   { VGA, 640, 480 },
+    };
+    constexpr int kCount = sizeof(kSizes) / sizeof(kSizes[0]);
+
+    CameraNeeds needs(int model_w, int model_h, int oversample, bool colour, size_t budget = CAMERA_RAW_FB_MAX_BYTES) {
+        CameraNeeds n;
+        n.model_w = model_w;
+        n.model_h = model_h;
+        n.oversample = oversample;
+        n.want_colour = colour;
+        n.max_raw_bytes = budget;
+        return n;
+    }
+
+    CameraFormat select(const CameraNeeds& n) {
+        CameraFormat f = {};
+        TEST_ASSERT_TRUE(camera_select_format(kSizes, kCount, n, &f));
+        return f;
+    }
+}
+
+void setUp() {}
+void tearDown() {}
+
+// The shipped configuration: 96x96 model, hand ROI on (oversample 2, colour wanted)
+void test_default_config_is_gray_240() {
+    CameraFormat f = select(needs(TFLITE_MODEL_INPUT_WIDTH, TFLITE_MODEL_INPUT_HEIGHT, CAMERA_ROI_OVERSAMPLE, true));
+    TEST_ASSERT_EQUAL(F240X240, f.id);
+    TEST_ASSERT_EQUAL(CameraPixels::GRAY, f.pixels); // 115200 bytes of RGB565 exceed the budget (config.h)
+    TEST_ASSERT_EQUAL_UINT32(240 * 240, f.frame_bytes);
+}
+
+void test_colour_when_it_fits() {
+    CameraFormat f = select(needs(96, 96, 2, true, 120 * 1024));
+    TEST_ASSERT_EQUAL(F240X240, f.id);
+    TEST_ASSERT_EQUAL(CameraPixels::RGB565, f.pixels);
+    TEST_ASSERT_EQUAL_UINT32(240 * 240 * 2, f.frame_bytes);
+
+    f = select(needs(96, 96, 1, true));
+    TEST_ASSERT_EQUAL(F96X96, f.id);
+    TEST_ASSERT_EQUAL(CameraPixels::RGB565, f.pixels);
+}
+
+void test_gray_when_colour_not_wanted() {
+    CameraFormat f = select(needs(96, 96, 1, false, 1024 * 1024));
+    TEST_ASSERT_EQUAL(F96X96, f.id);
+    TEST_ASSERT_EQUAL(CameraPixels::GRAY, f.pixels);
+    TEST_ASSERT_EQUAL_UINT32(96 * 96, f.frame_bytes);
+}
+
+// Smallest size whose centered model-aspect crop covers model * oversample
+void test_smallest_covering_size() {
+    TEST_ASSERT_EQUAL(F96X96, select(needs(96, 96, 1, false)).id);  // An exact fit is enough
+    TEST_ASSERT_EQUAL(QCIF, select(needs(64, 64, 2, false)).id);    // 128: QQVGA's crop is 120x120
+    TEST_ASSERT_EQUAL(HQVGA, select(needs(96, 64, 2, false)).id);   // 3:2 crop of 240x176 is 240x160
+    TEST_ASSERT_EQUAL(F240X240, select(needs(120, 120, 2, false)).id); // Smaller than QVGA, same crop
+    TEST_ASSERT_EQUAL(CIF, select(needs(128, 96, 3, false)).id);    // 384x288
+}
+
+void test_too_large_falls_back_to_largest_jpeg() {
+    CameraFormat f = select(needs(128, 128, 4, true));
+    TEST_ASSERT_EQUAL(VGA, f.id);
+    TEST_ASSERT_EQUAL(CameraPixels::JPEG, f.pixels);
+    TEST_ASSERT_EQUAL_UINT32(0, f.frame_bytes);
+
+    f = select(needs(96, 96, 4, false)); // 384x384: only VGA's 480x480 crop covers it
+    TEST_ASSERT_EQUAL(VGA, f.id);
+    TEST_ASSERT_EQUAL(CameraPixels::JPEG, f.pixels);
+}
+
+void test_order_does_not_matter() {
+    CameraFrameSize reversed[kCount];
+    for (int i = 0; i < kCount; ++i) reversed[i] = kSizes[kCount - 1 - i];
+    const CameraNeeds cases[] = { needs(96, 96, 2, true), needs(96, 64, 2, false), needs(128, 128, 4, true) };
+    for (const CameraNeeds& n : cases) {
+        CameraFormat a = select(n), b = {};
+        TEST_ASSERT_TRUE(camera_select_format(reversed, kCount, n, &b));
+        TEST_ASSERT_EQUAL(a.id, b.id);
+        TEST_ASSERT_EQUAL(a.pixels, b.pixels);
+    }
+}
+
+void test_rejects_empty_list() {
+    CameraFormat f;
+    TEST_ASSERT_FALSE(camera_select_format(kSizes, 0, needs(96, 96, 1, false), &f));
+    TEST_ASSERT_FALSE(camera_select_format(nullptr, kCount, needs(96, 96, 1, false), &f));
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_default_config_is_gray_240);
+    RUN_TEST(test_colour_when_it_fits);
+    RUN_TEST(test_gray_when_colour_not_wanted);
+    RUN_TEST(test_smallest_covering_size);
+    RUN_TEST(test_too_large_falls_back_to_largest_jpeg);
+    RUN_TEST(test_order_does_not_matter);
+    RUN_TEST(test_rejects_empty_list);
+    return UNITY_END();
+}
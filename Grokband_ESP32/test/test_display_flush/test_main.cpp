@@ -0,0 +1,181 @@
+// FlushPlanner against a host panel: LVGL-style flushes go through plan() and the pushed
+// regions land in a framebuffer, the way my_disp_flush() hands them to SPI DMA. Checks that
+// every visible pixel arrives intact, and pins the redraw volume of typical flush sequences so
+// a change in clipping or buffer sizing shows up as a diff in pushed pixels.
+#include <unity.h>
+#include "display_flush.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+namespace {
+    constexpr int kW = 240, kH = 240;
+    constexpr int kBufLines = 24; // DISPLAY_BUF_LINES
+
+    // Redraw volume with the current clipping; update deliberately when it improves
+    constexpr uint64_t kFullScreenPushed = 49344;  // of 57600 rendered
+    constexpr uint64_t kFocusMovePushed = 10168;    // of 11200 rendered
+    const FlushRegion kFullScreenRegions[] = {
+        { 49, 0, 142, 24 }, { 24, 24, 192, 24 }, { 10, 48, 220, 24 }, { 3, 72, 234, 24 }, { 0, 96, 240, 24 },
+        { 0, 120, 240, 24 }, { 3, 144, 234, 24 }, { 10, 168, 220, 24 }, { 24, 192, 192, 24 }, { 49, 216, 142, 24 },
+    };
+
+    bool visible(int x, int y) {
+        int dx = 2 * x + 1 - kW, dy = 2 * y + 1 - kH;
+        return dx * dx + dy * dy <= kW * kW;
+    }
+
+    uint16_t scene(int x, int y) { return (uint16_t)(x * 31 + y * 1021 + 7); }
+
+    // Records what reached the glass; pixels outside every pushed region stay 0
+    struct HostPanel {
+        std::vector<uint16_t> fb = std::vector<uint16_t>(kW * kH, 0);
+        uint64_t pushed = 0;
+
+        void push(const FlushRegion& r, const uint16_t* pixels) {
+            for (int y = 0; y < r.h; ++y) {
+                memcpy(&fb[(r.y + y) * kW + r.x], pixels + y * r.w, r.w * sizeof(uint16_t));
+            }
+            pushed += (uint32_t)r.w * r.h;
+        }
+    };
+
+    // One LVGL flush of `area` filled from the scene
+    void flush(FlushPlanner& planner, HostPanel& panel, const FlushRegion& area) {
+        std::vector<uint16_t> buf(area.w * area.h);
+        for (int y = 0; y < area.h; ++y) {
+            for (int x = 0; x < area.w; ++x) buf[y * area.w + x] = scene(area.x + x, area.y + y);
+        }
+        FlushRegion push;
+        if (planner.plan(buf.data(), area, &push)) panel.push(push, buf.data());
+    }
+
+    // LVGL splits an invalidated area into strips of at most kBufLines full-width lines
+    void redraw(FlushPlanner& planner, HostPanel& panel, const FlushRegion& area) {
+        for (int y = area.y; y < area.y + area.h; y += kBufLines) {
+            int h = area.y + area.h - y < kBufLines ? area.y + area.h - y : kBufLines;
+            flush(planner, panel, { area.x, (int16_t)y, area.w, (int16_t)h });
+        }
+    }
+
+    uint32_t lcg = 12345;
+    int rnd(int n) {
+        lcg = lcg * 1103515245u + 12345u;
+        return (int)((lcg >> 8) % (uint32_t)n);
+    }
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_full_screen_redraw_reaches_every_visible_pixel() {
+    FlushPlanner planner(kW, kH, true);
+    HostPanel panel;
+    redraw(planner, panel, { 0, 0, kW, kH });
+    for (int y = 0; y < kH; ++y) {
+        for (int x = 0; x < kW; ++x) {
+            if (visible(x, y)) TEST_ASSERT_EQUAL_UINT16(scene(x, y), panel.fb[y * kW + x]);
+        }
+    }
+    const DisplayFlushStats& s = planner.stats();
+    TEST_ASSERT_EQUAL(10, s.flushes);
+    TEST_ASSERT_EQUAL(0, s.skipped);
+    TEST_ASSERT_EQUAL(kW * kH, s.pixels_rendered);
+    TEST_ASSERT_EQUAL(s.pixels_pushed, panel.pushed);
+    TEST_ASSERT_EQUAL(kFullScreenPushed, s.pixels_pushed);
+}
+
+void test_recorded_regions_of_a_full_redraw() {
+    FlushPlanner planner(kW, kH, true);
+    HostPanel panel;
+    redraw(planner, panel, { 0, 0, kW, kH });
+    const FlushRegion* expected = kFullScreenRegions;
+    TEST_ASSERT_EQUAL(10, planner.recorded_count());
+    for (int i = 0; i < 10; ++i) {
+        const FlushRegion& r = planner.recorded()[i];
+        char what[48];
+        snprintf(what, sizeof(what), "strip %d: %d,%d %dx%d", i, r.x, r.y, r.w, r.h);
+        TEST_ASSERT_TRUE_MESSAGE(r.x == expected[i].x && r.y == expected[i].y &&
+                                 r.w == expected[i].w && r.h == expected[i].h, what);
+    }
+}
+
+void test_corner_areas_are_skipped() {
+    FlushPlanner planner(kW, kH, true);
+    HostPanel panel;
+    flush(planner, panel, { 0, 0, 30, 30 });
+    flush(planner, panel, { kW - 30, kH - 30, 30, 30 });
+    TEST_ASSERT_EQUAL(2, planner.stats().skipped);
+    TEST_ASSERT_EQUAL(0, planner.recorded_count());
+    TEST_ASSERT_EQUAL(0, panel.pushed);
+}
+
+void test_clip_is_the_tight_box_of_visible_pixels() {
+    for (int i = 0; i < 2000; ++i) {
+        FlushRegion area;
+        area.x = (int16_t)rnd(kW);
+        area.y = (int16_t)rnd(kH);
+        area.w = (int16_t)(1 + rnd(kW - area.x));
+        area.h = (int16_t)(1 + rnd(kH - area.y));
+        int x0 = kW, y0 = kH, x1 = -1, y1 = -1;
+        for (int y = area.y; y < area.y + area.h; ++y) {
+            for (int x = area.x; x < area.x + area.w; ++x) {
+                if (!visible(x, y)) continue;
+                if (x < x0) x0 = x;
+                if (x > x1) x1 = x;
+                if (y < y0) y0 = y;
+                if (y > y1) y1 = y;
+            }
+        }
+        FlushRegion clip;
+        bool any = flush_clip_round(kW, kH, area, &clip);
+        TEST_ASSERT_EQUAL(x1 >= 0, any);
+        if (!any) continue;
+        TEST_ASSERT_EQUAL(x0, clip.x);
+        TEST_ASSERT_EQUAL(y0, clip.y);
+        TEST_ASSERT_EQUAL(x1 - x0 + 1, clip.w);
+        TEST_ASSERT_EQUAL(y1 - y0 + 1, clip.h);
+    }
+}
+
+void test_focus_move_redraw_volume() {
+    // Moving focus between two quick-response rows (screen_manager.cpp) invalidates both
+    // rows; near the top of the glass their ends are clipped off
+    FlushPlanner planner(kW, kH, true);
+    HostPanel panel;
+    redraw(planner, panel, { 20, 8, 200, 28 });
+    redraw(planner, panel, { 20, 36, 200, 28 });
+    TEST_ASSERT_EQUAL(4, planner.stats().flushes);
+    TEST_ASSERT_EQUAL(2 * 200 * 28, planner.stats().pixels_rendered);
+    TEST_ASSERT_EQUAL(kFocusMovePushed, planner.stats().pixels_pushed);
+}
+
+void test_square_panel_pushes_everything() {
+    FlushPlanner planner(kW, kH, false);
+    HostPanel panel;
+    redraw(planner, panel, { 0, 0, kW, kH });
+    TEST_ASSERT_EQUAL(kW * kH, planner.stats().pixels_pushed);
+    for (int i = 0; i < kW * kH; ++i) TEST_ASSERT_EQUAL_UINT16(scene(i % kW, i / kW), panel.fb[i]);
+}
+
+void test_recording_caps_but_keeps_counting() {
+    FlushPlanner planner(kW, kH, true);
+    HostPanel panel;
+    for (int i = 0; i < FlushPlanner::kMaxRecorded + 6; ++i) flush(planner, panel, { 100, 100, 8, 8 });
+    TEST_ASSERT_EQUAL(FlushPlanner::kMaxRecorded + 6, planner.recorded_count());
+    planner.reset_recorded();
+    TEST_ASSERT_EQUAL(0, planner.recorded_count());
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_full_screen_redraw_reaches_every_visible_pixel);
+    RUN_TEST(test_recorded_regions_of_a_full_redraw);
+    RUN_TEST(test_corner_areas_are_skipped);
+    RUN_TEST(test_clip_is_the_tight_box_of_visible_pixels);
+    RUN_TEST(test_focus_move_redraw_volume);
+    RUN_TEST(test_square_panel_pushes_everything);
+    RUN_TEST(test_recording_caps_but_keeps_counting);
+    return UNITY_END();
+}
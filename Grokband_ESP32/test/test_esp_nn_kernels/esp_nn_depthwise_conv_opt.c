@@ -0,0 +1,2 @@
+// ESP-NN source, built here rather than as a library: its ESP32-S3 assembly does not build on the host
+#include "convolution/esp_nn_depthwise_conv_opt.c"
@@ -0,0 +1,474 @@
+// ESP-NN's C kernels against TFLM's reference integer kernels, on randomized shapes: conv,
+// depthwise conv, fully connected, average and max pooling, int8 with per-channel requantization.
+// Outputs must match bit for bit. Built the way a plain ESP32 dispatches them (CONFIG_NN_OPTIMIZED
+// without the S3 assembly: the generic _opt conv/depthwise kernels, _ansi for the rest), so this
+// is the arithmetic the band runs with TFLITE_ESP_NN. Both sides are the upstream sources at the
+// tags pinned in platformio.ini: esp-nn's kernels are compiled from its tree by the .c files here,
+// and the reference side is reference_integer_ops from esp-tflite-micro, the same TFLM the
+// esp32pico_esp_nn build links (scripts/check_esp_nn_deps.py stops the build if either is missing
+// or at another tag). The last test times both on fixed shapes like the shipped model's; on the
+// host the ratios only show the C kernels' algorithmic gain, not the Xtensa one.
+//   pio test -e native_esp_nn -v
+//   PLATFORMIO_BUILD_FLAGS="-DESP_NN_SUITE_CASES=5000 -DESP_NN_SUITE_SEED=7" pio test -e native_esp_nn
+#include <unity.h>
+extern "C" {
+#include "esp_nn.h"
+}
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/conv.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/depthwise_conv.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/fully_connected.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/pooling.h"
+
+#include <chrono>
+#include <random>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#ifndef ESP_NN_SUITE_CASES
+#define ESP_NN_SUITE_CASES 300  // Per kernel
+#endif
+#ifndef ESP_NN_SUITE_SEED
+#define ESP_NN_SUITE_SEED 1
+#endif
+
+namespace ref {
+    using tflite::RuntimeShape;
+
+    struct Geometry {
+        int in_w, in_h, in_ch;
+        int filter_w, filter_h;
+        int stride_w, stride_h, pad_w, pad_h;
+        int out_w, out_h, out_ch;
+    };
+
+    // Adapters from the suite's shapes to TFLM's kernels: NHWC input, batch 1, no dilation.
+    // padding_values, not padding_type, is what the kernels read.
+    void conv(const Geometry& g, const int8_t* in, const int8_t* filter, const int32_t* bias, int8_t* out,
+              int32_t in_offset, int32_t out_offset, const int32_t* mult, const int32_t* shift, int32_t act_min, int32_t act_max) {
+        tflite::ConvParams p = {};
+        p.padding_type = tflite::PaddingType::kSame;
+        p.padding_values.width = g.pad_w;
+        p.padding_values.height = g.pad_h;
+        p.stride_width = g.stride_w;
+        p.stride_height = g.stride_h;
+        p.dilation_width_factor = p.dilation_height_factor = 1;
+        p.input_offset = in_offset;
+        p.output_offset = out_offset;
+        p.quantized_activation_min = act_min;
+        p.quantized_activation_max = act_max;
+        tflite::reference_integer_ops::ConvPerChannel(
+            p, mult, shift, RuntimeShape({ 1, g.in_h, g.in_w, g.in_ch }), in,
+            RuntimeShape({ g.out_ch, g.filter_h, g.filter_w, g.in_ch }), filter, RuntimeShape({ g.out_ch }), bias,
+            RuntimeShape({ 1, g.out_h, g.out_w, g.out_ch }), out);
+    }
+
+    // Filter [1, H, W, in_ch * ch_mult]
+    void depthwise(const Geometry& g, int ch_mult, const int8_t* in, const int8_t* filter, const int32_t* bias, int8_t* out,
+                   int32_t in_offset, int32_t out_offset, const int32_t* mult, const int32_t* shift, int32_t act_min, int32_t act_max) {
+        const int out_ch = g.in_ch * ch_mult;
+        tflite::DepthwiseParams p = {};
+        p.padding_type = tflite::PaddingType::kSame;
+        p.padding_values.width = g.pad_w;
+        p.padding_values.height = g.pad_h;
+        p.stride_width = g.stride_w;
+        p.stride_height = g.stride_h;
+        p.dilation_width_factor = p.dilation_height_factor = 1;
+        p.depth_multiplier = ch_mult;
+        p.input_offset = in_offset;
+        p.output_offset = out_offset;
+        p.quantized_activation_min = act_min;
+        p.quantized_activation_max = act_max;
+        tflite::reference_integer_ops::DepthwiseConvPerChannel(
+            p, mult, shift, RuntimeShape({ 1, g.in_h, g.in_w, g.in_ch }), in,
+            RuntimeShape({ 1, g.filter_h, g.filter_w, out_ch }), filter, RuntimeShape({ out_ch }), bias,
+            RuntimeShape({ 1, g.out_h, g.out_w, out_ch }), out);
+    }
+
+    // Per-tensor quantization, as the FULLY_CONNECTED op calls it
+    void fully_connected(const int8_t* in, int32_t in_offset, int row_len, const int8_t* filter, int32_t filter_offset,
+                         const int32_t* bias, int8_t* out, int out_ch, int32_t out_offset, int32_t shift, int32_t mult,
+                         int32_t act_min, int32_t act_max) {
+        tflite::FullyConnectedParams p = {};
+        p.input_offset = in_offset;
+        p.weights_offset = filter_offset;
+        p.output_offset = out_offset;
+        p.output_multiplier = mult;
+        p.output_shift = shift;
+        p.quantized_activation_min = act_min;
+        p.quantized_activation_max = act_max;
+        tflite::reference_integer_ops::FullyConnected(p, RuntimeShape({ 1, row_len }), in, RuntimeShape({ out_ch, row_len }), filter,
+                                                      RuntimeShape({ out_ch }), bias, RuntimeShape({ 1, out_ch }), out);
+    }
+
+    void pool(bool average, const Geometry& g, const int8_t* in, int8_t* out, int32_t act_min, int32_t act_max) {
+        tflite::PoolParams p = {};
+        p.padding_type = tflite::PaddingType::kSame;
+        p.padding_values.width = g.pad_w;
+        p.padding_values.height = g.pad_h;
+        p.stride_width = g.stride_w;
+        p.stride_height = g.stride_h;
+        p.filter_width = g.filter_w;
+        p.filter_height = g.filter_h;
+        p.quantized_activation_min = act_min;
+        p.quantized_activation_max = act_max;
+        const RuntimeShape in_shape({ 1, g.in_h, g.in_w, g.in_ch });
+        const RuntimeShape out_shape({ 1, g.out_h, g.out_w, g.in_ch });
+        if (average) {
+            // Returns false only for an empty window, which plan_spatial never produces
+            (void)tflite::reference_integer_ops::AveragePool(p, in_shape, in, out_shape, out);
+        } else {
+            tflite::reference_integer_ops::MaxPool(p, in_shape, in, out_shape, out);
+        }
+    }
+}
+
+namespace {
+    std::mt19937 rng(ESP_NN_SUITE_SEED);
+
+    int uniform(int lo, int hi) { return std::uniform_int_distribution<int>(lo, hi)(rng); }
+    bool chance(int percent) { return uniform(1, 100) <= percent; }
+
+    // Channel counts around the optimized kernels' special cases (multiples of 4/8/16, odd, 1)
+    int channels(int max) {
+        static const int kInteresting[] = { 1, 2, 3, 4, 7, 8, 12, 15, 16, 24, 31, 32 };
+        if (chance(60)) {
+            int c;
+            do { c = kInteresting[uniform(0, sizeof(kInteresting) / sizeof(kInteresting[0]) - 1)]; } while (c > max);
+            return c;
+        }
+        return uniform(1, max);
+    }
+
+    std::vector<int8_t> random_s8(size_t n, int lo = -128, int hi = 127) {
+        std::vector<int8_t> v(n);
+        for (auto& x : v) x = (int8_t)uniform(lo, hi);
+        return v;
+    }
+
+    // Output size and leading padding for SAME or VALID, as TFLM computes them
+    void plan_spatial(ref::Geometry* g, bool same) {
+        if (same) {
+            g->out_w = (g->in_w + g->stride_w - 1) / g->stride_w;
+            g->out_h = (g->in_h + g->stride_h - 1) / g->stride_h;
+            const int total_w = (g->out_w - 1) * g->stride_w + g->filter_w - g->in_w;
+            const int total_h = (g->out_h - 1) * g->stride_h + g->filter_h - g->in_h;
+            g->pad_w = total_w > 0 ? total_w / 2 : 0;
+            g->pad_h = total_h > 0 ? total_h / 2 : 0;
+        } else {
+            g->out_w = (g->in_w - g->filter_w) / g->stride_w + 1;
+            g->out_h = (g->in_h - g->filter_h) / g->stride_h + 1;
+            g->pad_w = g->pad_h = 0;
+        }
+    }
+
+    ref::Geometry random_geometry(int max_filter, int max_ch) {
+        ref::Geometry g = {};
+        g.filter_w = chance(30) ? 1 : uniform(1, max_filter);
+        g.filter_h = chance(70) ? g.filter_w : uniform(1, max_filter);
+        g.in_w = uniform(g.filter_w, 20);
+        g.in_h = uniform(g.filter_h, 20);
+        g.in_ch = channels(max_ch);
+        g.stride_w = uniform(1, 3);
+        g.stride_h = chance(70) ? g.stride_w : uniform(1, 3);
+        plan_spatial(&g, chance(50));
+        return g;
+    }
+
+    struct Requant {
+        std::vector<int32_t> mult, shift;
+        int32_t in_offset, out_offset, act_min, act_max;
+    };
+
+    // Scales that keep outputs of a `depth`-term dot product mostly inside int8 rather than
+    // saturated, so the rounding of every requantization step is exercised
+    Requant random_requant(int channels, int depth) {
+        int base = -9;
+        while (depth > 1) {
+            depth >>= 2;
+            --base;
+        }
+        Requant q;
+        for (int c = 0; c < channels; ++c) {
+            q.mult.push_back(std::uniform_int_distribution<int32_t>(1 << 30, INT32_MAX)(rng));
+            q.shift.push_back(base + uniform(-2, 2));
+        }
+        q.in_offset = uniform(-127, 128);   // -input zero point
+        q.out_offset = uniform(-128, 127);
+        q.act_min = chance(80) ? -128 : uniform(-128, 0);    // Sometimes a fused ReLU-like clamp
+        q.act_max = chance(80) ? 127 : uniform(q.act_min, 127);
+        return q;
+    }
+
+    data_dims_t dims(int w, int h, int ch, int extra = 1) {
+        data_dims_t d;
+        d.width = w;
+        d.height = h;
+        d.channels = ch;
+        d.extra = extra;
+        return d;
+    }
+
+    void expect_same(const std::vector<int8_t>& want, const std::vector<int8_t>& got, const char* what, int c, const ref::Geometry& g) {
+        for (size_t i = 0; i < want.size(); ++i) {
+            if (want[i] == got[i]) continue;
+            char msg[200];
+            snprintf(msg, sizeof(msg), "%s case %d: in %dx%dx%d filter %dx%d stride %d,%d pad %d,%d out %dx%dx%d: [%u] ref %d esp-nn %d",
+                     what, c, g.in_w, g.in_h, g.in_ch, g.filter_w, g.filter_h, g.stride_w, g.stride_h, g.pad_w, g.pad_h,
+                     g.out_w, g.out_h, g.out_ch, (unsigned)i, want[i], got[i]);
+            TEST_FAIL_MESSAGE(msg);
+        }
+    }
+
+    // The esp-nn side of each kernel, shared by the equivalence and the timing tests
+    struct ConvCase {
+        ref::Geometry g;
+        std::vector<int8_t> in, filter;
+        std::vector<int32_t> bias;
+        Requant q;
+        int ch_mult = 1;            // Depthwise only
+        std::vector<int8_t> scratch;
+
+        void run_reference(bool depthwise, int8_t* out) const {
+            if (depthwise) {
+                ref::depthwise(g, ch_mult, in.data(), filter.data(), bias.data(), out, q.in_offset, q.out_offset,
+                               q.mult.data(), q.shift.data(), q.act_min, q.act_max);
+            } else {
+                ref::conv(g, in.data(), filter.data(), bias.data(), out, q.in_offset, q.out_offset,
+                          q.mult.data(), q.shift.data(), q.act_min, q.act_max);
+            }
+        }
+
+        void run_esp_nn(bool depthwise, int8_t* out) {
+            data_dims_t in_dims = dims(g.in_w, g.in_h, g.in_ch);
+            data_dims_t out_dims = dims(g.out_w, g.out_h, g.out_ch);
+            quant_data_t quant;
+            quant.mult = const_cast<int32_t*>(q.mult.data());
+            quant.shift = const_cast<int32_t*>(q.shift.data());
+            if (depthwise) {
+                data_dims_t filter_dims = dims(g.filter_w, g.filter_h, g.out_ch);
+                dw_conv_params_t p;
+                p.in_offset = q.in_offset;
+                p.out_offset = q.out_offset;
+                p.ch_mult = ch_mult;
+                p.stride.width = g.stride_w;
+                p.stride.height = g.stride_h;
+                p.padding.width = g.pad_w;
+                p.padding.height = g.pad_h;
+                p.dilation.width = p.dilation.height = 1;
+                p.activation.min = q.act_min;
+                p.activation.max = q.act_max;
+                scratch.resize(esp_nn_get_depthwise_conv_scratch_size(&in_dims, &filter_dims, &out_dims, &p) + 16);
+                esp_nn_set_depthwise_conv_scratch_buf(scratch.data());
+                esp_nn_depthwise_conv_s8(&in_dims, in.data(), &filter_dims, filter.data(), bias.data(), &out_dims, out, &p, &quant);
+            } else {
+                data_dims_t filter_dims = dims(g.filter_w, g.filter_h, g.in_ch, g.out_ch);
+                conv_params_t p;
+                p.in_offset = q.in_offset;
+                p.out_offset = q.out_offset;
+                p.stride.width = g.stride_w;
+                p.stride.height = g.stride_h;
+                p.padding.width = g.pad_w;
+                p.padding.height = g.pad_h;
+                p.dilation.width = p.dilation.height = 1;
+                p.activation.min = q.act_min;
+                p.activation.max = q.act_max;
+                scratch.resize(esp_nn_get_conv_scratch_size(&in_dims, &filter_dims, &out_dims, &p) + 16);
+                esp_nn_set_conv_scratch_buf(scratch.data());
+                esp_nn_conv_s8(&in_dims, in.data(), &filter_dims, filter.data(), bias.data(), &out_dims, out, &p, &quant);
+            }
+        }
+    };
+
+    ConvCase make_conv(const ref::Geometry& shape, bool depthwise, int ch_mult) {
+        ConvCase c;
+        c.g = shape;
+        c.ch_mult = depthwise ? ch_mult : 1;
+        if (depthwise) c.g.out_ch = c.g.in_ch * c.ch_mult;
+        c.in = random_s8((size_t)c.g.in_w * c.g.in_h * c.g.in_ch);
+        c.filter = random_s8((size_t)c.g.filter_w * c.g.filter_h * (depthwise ? c.g.out_ch : c.g.in_ch * c.g.out_ch), -127, 127);
+        for (int oc = 0; oc < c.g.out_ch; ++oc) c.bias.push_back(uniform(-40000, 40000));
+        c.q = random_requant(c.g.out_ch, c.g.filter_w * c.g.filter_h * (depthwise ? 1 : c.g.in_ch));
+        return c;
+    }
+
+    struct FcCase {
+        int row_len, out_ch;
+        std::vector<int8_t> in, filter;
+        std::vector<int32_t> bias;
+        int32_t in_offset, out_offset, mult, shift, act_min, act_max;
+
+        void run_reference(int8_t* out) const {
+            ref::fully_connected(in.data(), in_offset, row_len, filter.data(), 0, bias.data(), out, out_ch, out_offset,
+                                 shift, mult, act_min, act_max);
+        }
+        void run_esp_nn(int8_t* out) const {
+            esp_nn_fully_connected_s8(in.data(), in_offset, row_len, filter.data(), 0, bias.data(), out, out_ch, out_offset,
+                                      shift, mult, act_min, act_max);
+        }
+    };
+
+    FcCase make_fc(int row_len, int out_ch) {
+        FcCase c;
+        c.row_len = row_len;
+        c.out_ch = out_ch;
+        c.in = random_s8(row_len);
+        c.filter = random_s8((size_t)row_len * out_ch, -127, 127);
+        for (int oc = 0; oc < out_ch; ++oc) c.bias.push_back(uniform(-40000, 40000));
+        Requant q = random_requant(1, row_len);
+        c.in_offset = q.in_offset;
+        c.out_offset = q.out_offset;
+        c.mult = q.mult[0];
+        c.shift = q.shift[0];
+        c.act_min = q.act_min;
+        c.act_max = q.act_max;
+        return c;
+    }
+
+    struct PoolCase {
+        ref::Geometry g;
+        std::vector<int8_t> in;
+        int32_t act_min, act_max;
+
+        void run_reference(bool average, int8_t* out) const { ref::pool(average, g, in.data(), out, act_min, act_max); }
+        void run_esp_nn(bool average, int8_t* out) const {
+            if (average) {
+                esp_nn_avg_pool_s8(in.data(), g.in_w, g.in_h, out, g.out_w, g.out_h, g.stride_w, g.stride_h,
+                                   g.filter_w, g.filter_h, g.pad_w, g.pad_h, act_min, act_max, g.in_ch);
+            } else {
+                esp_nn_max_pool_s8(in.data(), g.in_w, g.in_h, out, g.out_w, g.out_h, g.stride_w, g.stride_h,
+                                   g.filter_w, g.filter_h, g.pad_w, g.pad_h, act_min, act_max, g.in_ch);
+            }
+        }
+    };
+
+    PoolCase make_pool(const ref::Geometry& shape) {
+        PoolCase c;
+        c.g = shape;
+        c.g.out_ch = c.g.in_ch;
+        c.in = random_s8((size_t)c.g.in_w * c.g.in_h * c.g.in_ch);
+        c.act_min = chance(70) ? -128 : uniform(-128, 0);
+        c.act_max = chance(70) ? 127 : uniform(c.act_min, 127);
+        return c;
+    }
+
+    double now_us() {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    template <typename F> double time_us(F&& f) {
+        f(); // Warm-up, and the scratch buffer for conv
+        int reps = 0;
+        const double start = now_us();
+        double elapsed;
+        do {
+            f();
+            ++reps;
+        } while ((elapsed = now_us() - start) < 20000.0);
+        return elapsed / reps;
+    }
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_conv_matches_reference() {
+    for (int c = 0; c < ESP_NN_SUITE_CASES; ++c) {
+        ref::Geometry g = random_geometry(5, 32);
+        g.out_ch = channels(32);
+        ConvCase cc = make_conv(g, false, 1);
+        std::vector<int8_t> want(g.out_w * g.out_h * g.out_ch), got(want.size(), 0x5a);
+        cc.run_reference(false, want.data());
+        cc.run_esp_nn(false, got.data());
+        expect_same(want, got, "conv", c, cc.g);
+    }
+}
+
+void test_depthwise_matches_reference() {
+    for (int c = 0; c < ESP_NN_SUITE_CASES; ++c) {
+        const ref::Geometry g = random_geometry(5, 32);
+        ConvCase cc = make_conv(g, true, chance(70) ? 1 : uniform(2, 4));
+        std::vector<int8_t> want(cc.g.out_w * cc.g.out_h * cc.g.out_ch), got(want.size(), 0x5a);
+        cc.run_reference(true, want.data());
+        cc.run_esp_nn(true, got.data());
+        expect_same(want, got, "depthwise", c, cc.g);
+    }
+}
+
+void test_fully_connected_matches_reference() {
+    for (int c = 0; c < ESP_NN_SUITE_CASES; ++c) {
+        FcCase fc = make_fc(chance(50) ? channels(32) * uniform(1, 16) : uniform(1, 600), uniform(1, 64));
+        std::vector<int8_t> want(fc.out_ch), got(fc.out_ch, 0x5a);
+        fc.run_reference(want.data());
+        fc.run_esp_nn(got.data());
+        const ref::Geometry g = { fc.row_len, 1, 1, 1, 1, 1, 1, 0, 0, 1, 1, fc.out_ch };
+        expect_same(want, got, "fully_connected", c, g);
+    }
+}
+
+void test_pooling_matches_reference() {
+    for (int c = 0; c < ESP_NN_SUITE_CASES; ++c) {
+        for (bool average : { true, false }) {
+            PoolCase pc = make_pool(random_geometry(4, 48));
+            std::vector<int8_t> want(pc.g.out_w * pc.g.out_h * pc.g.in_ch), got(want.size(), 0x5a);
+            pc.run_reference(average, want.data());
+            pc.run_esp_nn(average, got.data());
+            expect_same(want, got, average ? "avg_pool" : "max_pool", c, pc.g);
+        }
+    }
+}
+
+// Reference vs esp-nn time on the kinds of layers the shipped 96x96 model has
+void test_speed_ratios() {
+    char line[160];
+    TEST_MESSAGE("kernel                          reference_us   esp_nn_us   speedup");
+    auto report = [&](const char* name, double ref_us, double nn_us) {
+        snprintf(line, sizeof(line), "%-30s  %12.1f  %10.1f  %7.2fx", name, ref_us, nn_us, ref_us / nn_us);
+        TEST_MESSAGE(line);
+    };
+
+    struct ConvShape { const char* name; ref::Geometry g; bool depthwise; };
+    const ConvShape convs[] = {
+        { "conv 3x3/2 96x96x1 -> 8",     { 96, 96, 1, 3, 3, 2, 2, 0, 0, 0, 0, 8 }, false },
+        { "depthwise 3x3 48x48x8",       { 48, 48, 8, 3, 3, 1, 1, 0, 0, 0, 0, 8 }, true },
+        { "conv 1x1 48x48x8 -> 16",      { 48, 48, 8, 1, 1, 1, 1, 0, 0, 0, 0, 16 }, false },
+        { "depthwise 3x3/2 24x24x32",    { 24, 24, 32, 3, 3, 2, 2, 0, 0, 0, 0, 32 }, true },
+        { "conv 1x1 12x12x32 -> 64",     { 12, 12, 32, 1, 1, 1, 1, 0, 0, 0, 0, 64 }, false },
+    };
+    for (const ConvShape& s : convs) {
+        ref::Geometry g = s.g;
+        plan_spatial(&g, true);
+        ConvCase cc = make_conv(g, s.depthwise, 1);
+        std::vector<int8_t> want(cc.g.out_w * cc.g.out_h * cc.g.out_ch), got(want.size());
+        const double ref_us = time_us([&] { cc.run_reference(s.depthwise, want.data()); });
+        const double nn_us = time_us([&] { cc.run_esp_nn(s.depthwise, got.data()); });
+        expect_same(want, got, s.name, 0, cc.g);
+        report(s.name, ref_us, nn_us);
+    }
+
+    ref::Geometry pool_g = { 6, 6, 64, 6, 6, 1, 1, 0, 0, 0, 0, 64 };
+    plan_spatial(&pool_g, false);
+    PoolCase pc = make_pool(pool_g);
+    pc.act_min = -128;
+    pc.act_max = 127;
+    std::vector<int8_t> want(64), got(64);
+    report("avg_pool 6x6x64 (global)", time_us([&] { pc.run_reference(true, want.data()); }),
+           time_us([&] { pc.run_esp_nn(true, got.data()); }));
+    expect_same(want, got, "avg_pool", 0, pc.g);
+
+    FcCase fc = make_fc(64, 24);
+    std::vector<int8_t> fc_want(24), fc_got(24);
+    report("fully_connected 64 -> 24", time_us([&] { fc.run_reference(fc_want.data()); }),
+           time_us([&] { fc.run_esp_nn(fc_got.data()); }));
+    TEST_ASSERT_EQUAL_INT8_ARRAY(fc_want.data(), fc_got.data(), 24);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_conv_matches_reference);
+    RUN_TEST(test_depthwise_matches_reference);
+    RUN_TEST(test_fully_connected_matches_reference);
+    RUN_TEST(test_pooling_matches_reference);
+    RUN_TEST(test_speed_ratios);
+    return UNITY_END();
+}
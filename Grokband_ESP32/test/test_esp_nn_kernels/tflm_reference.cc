@@ -0,0 +1,9 @@
+// TFLM source the reference kernels call into (MultiplyByQuantizedMultiplier, RuntimeShape),
+// built here like the esp-nn files rather than as the whole esp-tflite-micro library. Which of
+// these are out of line differs between TFLM releases, hence the __has_include.
+#if __has_include("tensorflow/lite/kernels/internal/common.cc")
+#include "tensorflow/lite/kernels/internal/common.cc"
+#endif
+#if __has_include("tensorflow/lite/kernels/internal/runtime_shape.cc")
+#include "tensorflow/lite/kernels/internal/runtime_shape.cc"
+#endif
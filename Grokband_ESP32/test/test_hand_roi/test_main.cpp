@@ -0,0 +1,210 @@
+// HandRoiTracker on synthetic motion masks (a 240x240 gray frame, 60x60 thumbnail): following one
+// hand, holding and then recentring when it is lost, splitting two hands, and hand_box_to_crop()
+// on the detector's output, including the NaN/inf a broken model can produce.
+//   pio test -e native -f test_hand_roi
+#include <unity.h>
+#include "hand_roi.h"
+
+#include <math.h>
+#include <string.h>
+
+namespace {
+    constexpr int kSrc = 240;
+    constexpr int kDst = 96;
+
+    LumaThumb thumb;
+    uint8_t motion[THUMB_BITS_BYTES];
+
+    struct Blob {
+        int x0, y0, x1, y1; // Thumbnail pixels, exclusive end
+    };
+
+    void set_motion(const Blob* blobs, int count) {
+        memset(motion, 0, sizeof(motion));
+        for (int b = 0; b < count; ++b) {
+            for (int y = blobs[b].y0; y < blobs[b].y1; ++y) {
+                for (int x = blobs[b].x0; x < blobs[b].x1; ++x) thumb_set_bit(motion, y * thumb.w + x);
+            }
+        }
+    }
+
+    void run(HandRoiTracker& tracker, const Blob* blobs, int count, int frames) {
+        set_motion(blobs, count);
+        for (int i = 0; i < frames; ++i) tracker.update(thumb, motion);
+    }
+
+    // The crop holds the blob (in source pixels) and is centred on it within a thumbnail pixel or two
+    void assert_frames(const CropRect& c, const Blob& b) {
+        const int scale = thumb.scale;
+        TEST_ASSERT_TRUE(c.x <= b.x0 * scale && c.y <= b.y0 * scale);
+        TEST_ASSERT_TRUE(c.x + c.w >= b.x1 * scale && c.y + c.h >= b.y1 * scale);
+        TEST_ASSERT_INT_WITHIN(2 * scale, (b.x0 + b.x1) * scale / 2, c.x + c.w / 2);
+        TEST_ASSERT_INT_WITHIN(2 * scale, (b.y0 + b.y1) * scale / 2, c.y + c.h / 2);
+    }
+
+    void assert_in_frame(const CropRect& c) {
+        TEST_ASSERT_TRUE(c.w >= kDst && c.h >= kDst);
+        TEST_ASSERT_TRUE(c.x >= 0 && c.y >= 0 && c.x + c.w <= kSrc && c.y + c.h <= kSrc);
+    }
+}
+
+void setUp() {
+    thumb_begin(&thumb, kSrc, kSrc);
+    memset(motion, 0, sizeof(motion));
+}
+void tearDown() {}
+
+void test_starts_on_center_crop() {
+    HandRoiTracker tracker;
+    tracker.configure(kSrc, kSrc, kDst, kDst, false);
+    HandRois rois;
+    tracker.get(&rois);
+    TEST_ASSERT_EQUAL_INT(1, rois.count);
+    TEST_ASSERT_EQUAL_INT(0, rois.crop[0].x);
+    TEST_ASSERT_EQUAL_INT(0, rois.crop[0].y);
+    TEST_ASSERT_EQUAL_INT(kSrc, rois.crop[0].w);
+    TEST_ASSERT_EQUAL_INT(kSrc, rois.crop[0].h);
+}
+
+void test_follows_a_moving_hand() {
+    HandRoiTracker tracker;
+    tracker.configure(kSrc, kSrc, kDst, kDst, false);
+    HandRois rois;
+
+    const Blob hand = { 34, 18, 46, 32 };
+    run(tracker, &hand, 1, 40);
+    tracker.get(&rois);
+    TEST_ASSERT_EQUAL_INT(1, rois.count);
+    assert_frames(rois.crop[0], hand);
+    assert_in_frame(rois.crop[0]);
+    TEST_ASSERT_EQUAL_INT(rois.crop[0].w, rois.crop[0].h); // Model aspect
+    TEST_ASSERT_TRUE(rois.crop[0].w < kSrc);               // Zoomed in on the hand
+
+    // Eased, not snapped: one frame after a jump the box is between the old and new place
+    const Blob moved = { 10, 30, 22, 44 };
+    const int before = rois.crop[0].x;
+    run(tracker, &moved, 1, 1);
+    tracker.get(&rois);
+    TEST_ASSERT_TRUE(rois.crop[0].x < before && rois.crop[0].x > moved.x0 * thumb.scale - kDst);
+    run(tracker, &moved, 1, 40);
+    tracker.get(&rois);
+    assert_frames(rois.crop[0], moved);
+    assert_in_frame(rois.crop[0]);
+}
+
+void test_holds_then_recenters_when_the_hand_is_lost() {
+    HandRoiTracker tracker;
+    tracker.configure(kSrc, kSrc, kDst, kDst, false);
+    HandRois rois;
+    const Blob hand = { 34, 18, 46, 32 };
+    run(tracker, &hand, 1, 40);
+    tracker.get(&rois);
+    const CropRect tracked = rois.crop[0];
+
+    // Hands stop moving: the box holds for a while...
+    run(tracker, nullptr, 0, 30);
+    tracker.get(&rois);
+    TEST_ASSERT_EQUAL_INT(tracked.x, rois.crop[0].x);
+    TEST_ASSERT_EQUAL_INT(tracked.y, rois.crop[0].y);
+    TEST_ASSERT_EQUAL_INT(tracked.w, rois.crop[0].w);
+
+    // ...then drifts back to the center crop
+    run(tracker, nullptr, 0, 200);
+    tracker.get(&rois);
+    TEST_ASSERT_EQUAL_INT(1, rois.count);
+    TEST_ASSERT_INT_WITHIN(2 * thumb.scale, kSrc, rois.crop[0].w);
+    assert_in_frame(rois.crop[0]);
+
+    // A hand showing up again is picked up
+    run(tracker, &hand, 1, 40);
+    tracker.get(&rois);
+    assert_frames(rois.crop[0], hand);
+}
+
+void test_splits_two_hands() {
+    HandRoiTracker tracker;
+    tracker.configure(kSrc, kSrc, kDst, kDst, true);
+    HandRois rois;
+    const Blob hands[2] = { { 6, 20, 18, 34 }, { 42, 24, 54, 38 } };
+    run(tracker, hands, 2, 40);
+    tracker.get(&rois);
+    TEST_ASSERT_EQUAL_INT(2, rois.count);
+    assert_frames(rois.crop[0], hands[0]); // Left hand first
+    assert_frames(rois.crop[1], hands[1]);
+    assert_in_frame(rois.crop[0]);
+    assert_in_frame(rois.crop[1]);
+
+    // The motion gate looks at both
+    CropRect gate = tracker.gate_region();
+    TEST_ASSERT_TRUE(gate.x <= hands[0].x0 && gate.x + gate.w >= hands[1].x1);
+
+    // The left hand drops out: the right one keeps its track
+    const CropRect right = rois.crop[1];
+    run(tracker, &hands[1], 1, 1);
+    tracker.get(&rois);
+    TEST_ASSERT_EQUAL_INT(1, rois.count);
+    TEST_ASSERT_INT_WITHIN(thumb.scale, right.x, rois.crop[0].x);
+    TEST_ASSERT_INT_WITHIN(thumb.scale, right.y, rois.crop[0].y);
+}
+
+void test_one_hand_mode_frames_both_hands_together() {
+    HandRoiTracker tracker;
+    tracker.configure(kSrc, kSrc, kDst, kDst, false);
+    HandRois rois;
+    const Blob hands[2] = { { 6, 20, 18, 34 }, { 42, 24, 54, 38 } };
+    run(tracker, hands, 2, 40);
+    tracker.get(&rois);
+    TEST_ASSERT_EQUAL_INT(1, rois.count);
+    const Blob both = { hands[0].x0, hands[0].y0, hands[1].x1, hands[1].y1 };
+    assert_frames(rois.crop[0], both);
+}
+
+void test_box_to_crop() {
+    const CropRect frame = { 0, 0, kSrc, kSrc };
+    // Quarter-frame box in the middle: padded 25% a side, then grown to the 96 px minimum
+    CropRect c = hand_box_to_crop(0.5f, 0.5f, 0.25f, 0.25f, frame, kSrc, kSrc, kDst, kDst, 64);
+    TEST_ASSERT_EQUAL_INT(72, c.x);
+    TEST_ASSERT_EQUAL_INT(72, c.y);
+    TEST_ASSERT_EQUAL_INT(kDst, c.w);
+    TEST_ASSERT_EQUAL_INT(kDst, c.h);
+
+    // Box in a sub-region (the detector saw the tracker's crop), wide box grown to square
+    const CropRect region = { 120, 60, 120, 120 };
+    c = hand_box_to_crop(0.5f, 0.5f, 1.0f, 0.5f, region, kSrc, kSrc, kDst, kDst, 0);
+    TEST_ASSERT_EQUAL_INT(120, c.w);
+    TEST_ASSERT_EQUAL_INT(120, c.h);
+    TEST_ASSERT_EQUAL_INT(120, c.x);
+    TEST_ASSERT_EQUAL_INT(60, c.y);
+}
+
+void test_box_to_crop_non_finite() {
+    const CropRect frame = { 0, 0, kSrc, kSrc };
+    const float bad[] = { NAN, -NAN, INFINITY, -INFINITY, 1e30f, -1e30f, 3.0f, -0.5f };
+    for (float v : bad) {
+        assert_in_frame(hand_box_to_crop(v, 0.5f, 0.2f, 0.2f, frame, kSrc, kSrc, kDst, kDst, 64));
+        assert_in_frame(hand_box_to_crop(0.5f, v, 0.2f, 0.2f, frame, kSrc, kSrc, kDst, kDst, 64));
+        assert_in_frame(hand_box_to_crop(0.5f, 0.5f, v, v, frame, kSrc, kSrc, kDst, kDst, 64));
+        assert_in_frame(hand_box_to_crop(v, v, v, v, frame, kSrc, kSrc, kDst, kDst, 64));
+    }
+    // NaN center: middle of the region. NaN size: the smallest crop
+    CropRect c = hand_box_to_crop(NAN, NAN, NAN, NAN, frame, kSrc, kSrc, kDst, kDst, 64);
+    TEST_ASSERT_EQUAL_INT(72, c.x);
+    TEST_ASSERT_EQUAL_INT(72, c.y);
+    TEST_ASSERT_EQUAL_INT(kDst, c.w);
+    // Infinite size: the whole frame
+    c = hand_box_to_crop(0.5f, 0.5f, INFINITY, INFINITY, frame, kSrc, kSrc, kDst, kDst, 64);
+    TEST_ASSERT_EQUAL_INT(kSrc, c.w);
+    TEST_ASSERT_EQUAL_INT(kSrc, c.h);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_starts_on_center_crop);
+    RUN_TEST(test_follows_a_moving_hand);
+    RUN_TEST(test_holds_then_recenters_when_the_hand_is_lost);
+    RUN_TEST(test_splits_two_hands);
+    RUN_TEST(test_one_hand_mode_frames_both_hands_together);
+    RUN_TEST(test_box_to_crop);
+    RUN_TEST(test_box_to_crop_non_finite);
+    return UNITY_END();
+}
@@ -0,0 +1,251 @@
+// The encoder/button decoding cores on synthetic edge sequences, the way input_handler.cpp
+// drives them from its ISRs: bounce trains, presses either side of the long-press time, the
+// knob turning while the button is held through a mode change, and the ISR -> loop() ring
+// running full.
+//   pio test -e native -f test_input_decoder
+#include <unity.h>
+#include "config.h"
+#include "input_decoder.h"
+
+#include <thread>
+#include <vector>
+
+namespace {
+    constexpr uint32_t kMs = 1000;
+    constexpr uint32_t kDebounce = BUTTON_DEBOUNCE_MS * kMs;
+    constexpr uint32_t kLong = BUTTON_LONG_PRESS_MS * kMs;
+    constexpr uint32_t kDouble = BUTTON_DOUBLE_CLICK_MS * kMs;
+
+    ButtonClassifier make_button() { return ButtonClassifier(kDebounce, kLong, kDouble); }
+
+    // Contact bounce: `count` alternating edges 0.4 ms apart, ending on `level`
+    void bounce(ButtonClassifier* b, uint32_t t_us, uint8_t level, int count = 5) {
+        for (int i = 0; i < count; ++i) {
+            const uint8_t l = (uint8_t)(((count - 1 - i) & 1) ? !level : level);
+            b->feed({ t_us + i * 400u, l });
+        }
+    }
+
+    // Everything poll() has to say by `now_us`
+    std::vector<ButtonEvent> drain(ButtonClassifier* b, uint32_t now_us) {
+        std::vector<ButtonEvent> out;
+        for (ButtonEvent e = b->poll(now_us); e.action != ButtonAction::NONE; e = b->poll(now_us)) out.push_back(e);
+        return out;
+    }
+
+    // One detent of full quadrature, forward (00 -> 01 -> 11 -> 10 -> 00) or back
+    void turn(QuadratureDecoder* q, bool forward) {
+        static const uint8_t kSeq[4][2] = { { 0, 1 }, { 1, 1 }, { 1, 0 }, { 0, 0 } };
+        for (int i = 0; i < 4; ++i) {
+            const int s = forward ? i : (2 - i) & 3;
+            q->feed(kSeq[s][0], kSeq[s][1]);
+        }
+    }
+}
+
+void setUp() {}
+void tearDown() {}
+
+// A press and a release that each bounce make exactly one click, stamped with the first edge
+void test_bounce_trains_make_one_click() {
+    ButtonClassifier b = make_button();
+    bounce(&b, 10 * kMs, 0);
+    TEST_ASSERT_TRUE(b.pressed());
+    TEST_ASSERT_EQUAL(0, (int)drain(&b, 20 * kMs).size());
+    bounce(&b, 150 * kMs, 1, 7);
+    TEST_ASSERT_FALSE(b.pressed());
+    std::vector<ButtonEvent> events = drain(&b, 200 * kMs);
+    TEST_ASSERT_EQUAL(1, (int)events.size());
+    TEST_ASSERT_EQUAL(ButtonAction::CLICK, events[0].action);
+    TEST_ASSERT_EQUAL_UINT32(150 * kMs, events[0].t_us);
+}
+
+// A train that ends on the opposite level settles there once the bounce window is over
+void test_bounce_ending_released_is_a_tap() {
+    ButtonClassifier b = make_button();
+    bounce(&b, 10 * kMs, 1, 4); // 0,1,0,1: pressed first, released by the end
+    TEST_ASSERT_TRUE(b.pressed());
+    uint32_t deadline = 0;
+    TEST_ASSERT_TRUE(b.next_deadline_us(&deadline));
+    TEST_ASSERT_EQUAL_UINT32(10 * kMs + kDebounce, deadline);
+    std::vector<ButtonEvent> events = drain(&b, deadline);
+    TEST_ASSERT_FALSE(b.pressed());
+    TEST_ASSERT_EQUAL(1, (int)events.size());
+    TEST_ASSERT_EQUAL(ButtonAction::CLICK, events[0].action);
+}
+
+// Released 1 us before the long-press time: a click. Held to it: a long press, fired while
+// still held, and no click on release
+void test_short_vs_long_at_threshold() {
+    ButtonClassifier b = make_button();
+    b.feed({ 100 * kMs, 0 });
+    TEST_ASSERT_EQUAL(0, (int)drain(&b, 100 * kMs + kLong - 1).size());
+    b.feed({ 100 * kMs + kLong - 1, 1 });
+    std::vector<ButtonEvent> events = drain(&b, 100 * kMs + kLong + 50 * kMs);
+    TEST_ASSERT_EQUAL(1, (int)events.size());
+    TEST_ASSERT_EQUAL(ButtonAction::CLICK, events[0].action);
+
+    ButtonClassifier l = make_button();
+    l.feed({ 100 * kMs, 0 });
+    uint32_t deadline = 0;
+    TEST_ASSERT_TRUE(l.next_deadline_us(&deadline));
+    TEST_ASSERT_EQUAL_UINT32(100 * kMs + kLong, deadline);
+    events = drain(&l, deadline);
+    TEST_ASSERT_EQUAL(1, (int)events.size());
+    TEST_ASSERT_EQUAL(ButtonAction::LONG_PRESS, events[0].action);
+    TEST_ASSERT_EQUAL_UINT32(100 * kMs + kLong, events[0].t_us);
+    TEST_ASSERT_TRUE(l.pressed());
+    TEST_ASSERT_FALSE(l.next_deadline_us(&deadline)); // Nothing left to wait for while held
+    bounce(&l, 2000 * kMs, 1);
+    TEST_ASSERT_EQUAL(0, (int)drain(&l, 2100 * kMs).size());
+}
+
+// loop() stalled past the long-press time: the release still reports a long press, at the deadline
+void test_long_press_without_timely_poll() {
+    ButtonClassifier b = make_button();
+    b.feed({ 0, 0 });
+    b.feed({ kLong + 300 * kMs, 1 });
+    std::vector<ButtonEvent> events = drain(&b, kLong + 400 * kMs);
+    TEST_ASSERT_EQUAL(1, (int)events.size());
+    TEST_ASSERT_EQUAL(ButtonAction::LONG_PRESS, events[0].action);
+    TEST_ASSERT_EQUAL_UINT32(kLong, events[0].t_us);
+}
+
+// The long press switches mode while the knob is being turned: detents keep counting, the long
+// press fires once, its release is not a click, and the next click doesn't pair with the one
+// before the long press
+void test_mode_edge_during_long_press() {
+    ButtonClassifier b = make_button();
+    QuadratureDecoder q;
+    DetentAccumulator detents(ENCODER_COUNTS_PER_DETENT, 0);
+    q.feed(0, 0);
+
+    b.feed({ 0, 0 });
+    b.feed({ 80 * kMs, 1 });
+    TEST_ASSERT_EQUAL(ButtonAction::CLICK, b.poll(100 * kMs).action);
+
+    b.feed({ 200 * kMs, 0 });
+    int moved = 0, longs = 0;
+    for (uint32_t t = 210 * kMs; t < 200 * kMs + 2 * kLong; t += 25 * kMs) {
+        turn(&q, true);
+        moved += detents.update(q.count());
+        for (const ButtonEvent& e : drain(&b, t)) {
+            TEST_ASSERT_EQUAL(ButtonAction::LONG_PRESS, e.action);
+            TEST_ASSERT_EQUAL_UINT32(200 * kMs + kLong, e.t_us);
+            longs++;
+        }
+    }
+    TEST_ASSERT_EQUAL(1, longs);
+    TEST_ASSERT_EQUAL(56, moved);
+    TEST_ASSERT_EQUAL_UINT32(0, q.invalid_transitions());
+
+    bounce(&b, 200 * kMs + 2 * kLong, 1);
+    TEST_ASSERT_EQUAL(0, (int)drain(&b, 250 * kMs + 2 * kLong).size());
+    b.feed({ 300 * kMs + 2 * kLong, 0 });
+    b.feed({ 350 * kMs + 2 * kLong, 1 });
+    std::vector<ButtonEvent> events = drain(&b, 400 * kMs + 2 * kLong);
+    TEST_ASSERT_EQUAL(1, (int)events.size());
+    TEST_ASSERT_EQUAL(ButtonAction::CLICK, events[0].action);
+}
+
+void test_double_click_window() {
+    ButtonClassifier b = make_button();
+    b.feed({ 0, 0 });
+    b.feed({ 50 * kMs, 1 });
+    b.feed({ 100 * kMs, 0 });
+    b.feed({ 50 * kMs + kDouble, 1 });
+    std::vector<ButtonEvent> events = drain(&b, 500 * kMs);
+    TEST_ASSERT_EQUAL(3, (int)events.size());
+    TEST_ASSERT_EQUAL(ButtonAction::CLICK, events[0].action);
+    TEST_ASSERT_EQUAL(ButtonAction::CLICK, events[1].action);
+    TEST_ASSERT_EQUAL(ButtonAction::DOUBLE_CLICK, events[2].action);
+
+    b.feed({ 1000 * kMs, 0 });
+    b.feed({ 1050 * kMs, 1 });
+    b.feed({ 1100 * kMs, 0 });
+    b.feed({ 1051 * kMs + kDouble, 1 }); // 1 us late
+    events = drain(&b, 1600 * kMs);
+    TEST_ASSERT_EQUAL(2, (int)events.size());
+    TEST_ASSERT_EQUAL(ButtonAction::CLICK, events[1].action);
+}
+
+// The 16-edge ring input_handler.cpp uses: the 17th edge is refused and counted, nothing queued
+// is overwritten, and the ring is usable again once drained
+void test_ring_overflow() {
+    SpscRing<InputEdge, 16> ring;
+    for (uint32_t i = 0; i < 16; ++i) TEST_ASSERT_TRUE(ring.push({ i, (uint8_t)(i & 1) }));
+    TEST_ASSERT_FALSE(ring.push({ 99, 0 }));
+    TEST_ASSERT_FALSE(ring.push({ 100, 1 }));
+    TEST_ASSERT_EQUAL_UINT32(2, ring.overflows());
+    InputEdge e;
+    for (uint32_t i = 0; i < 16; ++i) {
+        TEST_ASSERT_TRUE(ring.pop(&e));
+        TEST_ASSERT_EQUAL_UINT32(i, e.t_us);
+    }
+    TEST_ASSERT_FALSE(ring.pop(&e));
+    TEST_ASSERT_TRUE(ring.push({ 200, 0 }));
+    TEST_ASSERT_TRUE(ring.pop(&e));
+    TEST_ASSERT_EQUAL_UINT32(200, e.t_us);
+}
+
+// Dropped edges leave the classifier on a stale level; the next edge resyncs it
+void test_classifier_resyncs_after_overflow() {
+    ButtonClassifier b = make_button();
+    b.feed({ 0, 0 });
+    // The release at 100 ms and the press at 200 ms were dropped; the release at 300 ms arrives
+    b.feed({ 300 * kMs, 1 });
+    std::vector<ButtonEvent> events = drain(&b, 400 * kMs);
+    TEST_ASSERT_EQUAL(1, (int)events.size());
+    TEST_ASSERT_EQUAL(ButtonAction::CLICK, events[0].action);
+    TEST_ASSERT_FALSE(b.pressed());
+    b.feed({ 500 * kMs, 0 });
+    TEST_ASSERT_TRUE(b.pressed());
+}
+
+// One producer thread (the ISR) and one consumer (loop()) through the same ring: every edge the
+// producer got in arrives once, in order
+void test_ring_spsc_threads() {
+    static SpscRing<InputEdge, 16> ring;
+    constexpr uint32_t kEdges = 200000;
+    uint32_t refused = 0;
+    std::thread producer([&] {
+        for (uint32_t i = 1; i <= kEdges; ++i) {
+            while (!ring.push({ i, (uint8_t)(i & 1) })) refused++;
+        }
+    });
+    uint32_t expect = 1;
+    InputEdge e;
+    while (expect <= kEdges) {
+        if (!ring.pop(&e)) continue;
+        TEST_ASSERT_EQUAL_UINT32(expect, e.t_us);
+        TEST_ASSERT_EQUAL_UINT8(expect & 1, e.level);
+        expect++;
+    }
+    producer.join();
+    TEST_ASSERT_EQUAL_UINT32(refused, ring.overflows());
+}
+
+void test_detents_across_pcnt_wrap() {
+    DetentAccumulator d(4, 32000);
+    d.reset(31990);
+    TEST_ASSERT_EQUAL(2, d.update(31998));
+    TEST_ASSERT_EQUAL(1, d.update(2));      // Counter wrapped to 0 at +32000
+    TEST_ASSERT_EQUAL(-1, d.update(-2));
+    TEST_ASSERT_EQUAL(0, d.update(-3));     // Remainder kept for the next update
+    TEST_ASSERT_EQUAL(-1, d.update(-6));
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_bounce_trains_make_one_click);
+    RUN_TEST(test_bounce_ending_released_is_a_tap);
+    RUN_TEST(test_short_vs_long_at_threshold);
+    RUN_TEST(test_long_press_without_timely_poll);
+    RUN_TEST(test_mode_edge_during_long_press);
+    RUN_TEST(test_double_click_window);
+    RUN_TEST(test_ring_overflow);
+    RUN_TEST(test_classifier_resyncs_after_overflow);
+    RUN_TEST(test_ring_spsc_threads);
+    RUN_TEST(test_detents_across_pcnt_wrap);
+    return UNITY_END();
+}
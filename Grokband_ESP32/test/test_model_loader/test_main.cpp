@@ -0,0 +1,166 @@
+// model_loader on the host: image validation (header and CRC, as scripts/pack_model.py writes
+// them) and the partition stand-in, which maps the file named by $GROKBAND_<LABEL>_PARTITION.
+//   pio test -e native -f test_model_loader
+#include <unity.h>
+#include "model_loader.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+    constexpr uint16_t kSchema = 3;
+
+    // zlib's CRC-32, written out here so the test doesn't share model_loader's copy
+    uint32_t zlib_crc32(const uint8_t* data, size_t len) {
+        uint32_t crc = 0xFFFFFFFFu;
+        for (size_t i = 0; i < len; ++i) {
+            crc ^= data[i];
+            for (int k = 0; k < 8; ++k) crc = (crc & 1u) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+        }
+        return ~crc;
+    }
+
+    std::vector<uint8_t> payload(size_t len) {
+        std::vector<uint8_t> p(len);
+        for (size_t i = 0; i < len; ++i) p[i] = (uint8_t)(i * 31 + 7);
+        return p;
+    }
+
+    // pack_model.py's layout: 32-byte header, then the flatbuffer
+    std::vector<uint8_t> pack(const std::vector<uint8_t>& model, uint16_t schema = kSchema) {
+        ModelImageHeader h = {};
+        h.magic = MODEL_IMAGE_MAGIC;
+        h.header_version = MODEL_IMAGE_HEADER_VERSION;
+        h.schema_version = schema;
+        h.model_size = (uint32_t)model.size();
+        h.model_crc32 = zlib_crc32(model.data(), model.size());
+        std::vector<uint8_t> image(sizeof(h) + model.size());
+        memcpy(image.data(), &h, sizeof(h));
+        memcpy(image.data() + sizeof(h), model.data(), model.size());
+        return image;
+    }
+
+    ModelImageStatus validate(const std::vector<uint8_t>& image) {
+        return model_image_validate(image.data(), image.size(), kSchema, nullptr, nullptr);
+    }
+
+    char image_path[64];
+
+    void write_image(const std::vector<uint8_t>& image, size_t len) {
+        FILE* f = fopen(image_path, "wb");
+        TEST_ASSERT_NOT_NULL(f);
+        TEST_ASSERT_EQUAL_UINT32(len, fwrite(image.data(), 1, len, f));
+        fclose(f);
+    }
+}
+
+void setUp() {
+    snprintf(image_path, sizeof(image_path), "/tmp/grokband_model_XXXXXX");
+    const int fd = mkstemp(image_path);
+    TEST_ASSERT_TRUE(fd >= 0);
+    close(fd);
+    unsetenv("GROKBAND_MODEL_PARTITION");
+    unsetenv("GROKBAND_HAND_DET_PARTITION");
+}
+
+void tearDown() {
+    unlink(image_path);
+}
+
+void test_crc_matches_zlib() {
+    const uint8_t check[] = "123456789";
+    TEST_ASSERT_EQUAL_HEX32(0xCBF43926u, zlib_crc32(check, 9)); // The standard CRC-32 check value
+    const std::vector<uint8_t> model = payload(1000);
+    const std::vector<uint8_t> image = pack(model);
+    const uint8_t* data = nullptr;
+    size_t len = 0;
+    TEST_ASSERT_EQUAL(ModelImageStatus::OK, model_image_validate(image.data(), image.size(), kSchema, &data, &len));
+    TEST_ASSERT_TRUE(data == image.data() + sizeof(ModelImageHeader));
+    TEST_ASSERT_EQUAL_UINT32(1000, len);
+}
+
+void test_header_rejects() {
+    const std::vector<uint8_t> good = pack(payload(256));
+    std::vector<uint8_t> image = good;
+    image[0] ^= 0xFF;
+    TEST_ASSERT_EQUAL(ModelImageStatus::BAD_MAGIC, validate(image));
+
+    image = good;
+    image[4] = MODEL_IMAGE_HEADER_VERSION + 1;
+    TEST_ASSERT_EQUAL(ModelImageStatus::BAD_HEADER_VERSION, validate(image));
+
+    TEST_ASSERT_EQUAL(ModelImageStatus::BAD_SCHEMA_VERSION, validate(pack(payload(256), kSchema + 1)));
+
+    image = good;
+    image[sizeof(ModelImageHeader) + 100] ^= 0x01; // One flipped bit in the model
+    TEST_ASSERT_EQUAL(ModelImageStatus::BAD_CRC, validate(image));
+
+    image = good;
+    image[12] ^= 0x01;                             // Stored CRC itself damaged
+    TEST_ASSERT_EQUAL(ModelImageStatus::BAD_CRC, validate(image));
+
+    image = good;
+    memset(&image[8], 0, 4);                       // model_size 0
+    TEST_ASSERT_EQUAL(ModelImageStatus::BAD_SIZE, validate(image));
+
+    TEST_ASSERT_EQUAL(ModelImageStatus::TOO_SMALL, model_image_validate(nullptr, 0, kSchema, nullptr, nullptr));
+}
+
+void test_truncated_image() {
+    const std::vector<uint8_t> image = pack(payload(512));
+    // Cut inside the model: the header promises more than is there
+    TEST_ASSERT_EQUAL(ModelImageStatus::BAD_SIZE, model_image_validate(image.data(), image.size() - 1, kSchema, nullptr, nullptr));
+    // Cut inside the header
+    TEST_ASSERT_EQUAL(ModelImageStatus::TOO_SMALL,
+                      model_image_validate(image.data(), sizeof(ModelImageHeader) - 1, kSchema, nullptr, nullptr));
+
+    // Same through the partition stand-in: a partial write of the image file
+    write_image(image, image.size() - 100);
+    setenv("GROKBAND_MODEL_PARTITION", image_path, 1);
+    const uint8_t* data = nullptr;
+    size_t len = 0;
+    TEST_ASSERT_FALSE(model_map_from_partition(MODEL_PARTITION_LABEL, kSchema, &data, &len));
+    TEST_ASSERT_NULL(data);
+    TEST_ASSERT_EQUAL_UINT32(0, len);
+    write_image(image, 0);
+    TEST_ASSERT_FALSE(model_map_from_partition(MODEL_PARTITION_LABEL, kSchema, &data, &len));
+}
+
+void test_map_from_partition_file() {
+    const std::vector<uint8_t> model = payload(3000);
+    write_image(pack(model), pack(model).size());
+    setenv("GROKBAND_MODEL_PARTITION", image_path, 1);
+    const uint8_t* data = nullptr;
+    size_t len = 0;
+    TEST_ASSERT_TRUE(model_map_from_partition(MODEL_PARTITION_LABEL, kSchema, &data, &len));
+    TEST_ASSERT_EQUAL_UINT32(model.size(), len);
+    TEST_ASSERT_EQUAL_MEMORY(model.data(), data, model.size());
+    // The length is optional
+    TEST_ASSERT_TRUE(model_map_from_partition(MODEL_PARTITION_LABEL, kSchema, &data, nullptr));
+    // Wrong schema is still rejected after mapping
+    TEST_ASSERT_FALSE(model_map_from_partition(MODEL_PARTITION_LABEL, kSchema + 1, &data, &len));
+}
+
+void test_label_selects_env_var() {
+    write_image(pack(payload(64)), pack(payload(64)).size());
+    // Set for the detector only: the classifier's variable is missing
+    setenv("GROKBAND_HAND_DET_PARTITION", image_path, 1);
+    TEST_ASSERT_FALSE(model_map_from_partition(MODEL_PARTITION_LABEL, kSchema, nullptr, nullptr));
+    TEST_ASSERT_TRUE(model_map_from_partition(HAND_DETECTOR_PARTITION_LABEL, kSchema, nullptr, nullptr));
+    // Set, but pointing nowhere
+    setenv("GROKBAND_MODEL_PARTITION", "/nonexistent/grokband_model.bin", 1);
+    TEST_ASSERT_FALSE(model_map_from_partition(MODEL_PARTITION_LABEL, kSchema, nullptr, nullptr));
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_crc_matches_zlib);
+    RUN_TEST(test_header_rejects);
+    RUN_TEST(test_truncated_image);
+    RUN_TEST(test_map_from_partition_file);
+    RUN_TEST(test_label_selects_env_var);
+    return UNITY_END();
+}
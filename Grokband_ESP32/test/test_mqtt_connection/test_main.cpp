@@ -0,0 +1,263 @@
+// MqttConnection and MqttOutbox on the host. The restart test runs the connect on a thread of
+// its own against an in-process fake broker, the way mqtt_handler.cpp runs it on a task, and
+// measures how long the loop ever stalls while the broker goes away and comes back.
+#include <unity.h>
+#include "mqtt_outbox.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdio.h>
+#include <thread>
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+    uint32_t ms_since(Clock::time_point t0) {
+        return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - t0).count();
+    }
+
+    // Accepts sessions while up. A restart drops every session; while down, a connect blocks
+    // for the whole timeout like a TCP connect to a host that doesn't answer.
+    class FakeBroker {
+    public:
+        explicit FakeBroker(uint32_t connect_timeout_ms) : timeout_ms_(connect_timeout_ms) {}
+        void set_up(bool up) {
+            if (!up) epoch_++;
+            up_ = up;
+        }
+        // Blocking, like PubSubClient::connect()
+        bool connect(uint32_t* session) {
+            if (!up_) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms_));
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(2)); // CONNECT/CONNACK round trip
+            *session = epoch_;
+            return up_.load();
+        }
+        bool session_alive(uint32_t session) const { return up_ && session == epoch_; }
+        void deliver() { delivered++; }
+
+        uint32_t delivered = 0;
+
+    private:
+        uint32_t timeout_ms_;
+        std::atomic<bool> up_{true};
+        std::atomic<uint32_t> epoch_{0};
+    };
+
+    // The connect task of mqtt_handler.cpp: one attempt per request, result behind a flag
+    class ConnectThread {
+    public:
+        explicit ConnectThread(FakeBroker& broker) : broker_(broker), thread_([this] { run(); }) {}
+        ~ConnectThread() {
+            {
+                std::lock_guard<std::mutex> lock(m_);
+                quit_ = true;
+            }
+            cv_.notify_one();
+            thread_.join();
+        }
+        void start() {
+            done.store(false);
+            {
+                std::lock_guard<std::mutex> lock(m_);
+                requested_ = true;
+            }
+            cv_.notify_one();
+        }
+
+        std::atomic<bool> done{false};
+        bool ok = false;
+        uint32_t session = 0;
+
+    private:
+        void run() {
+            std::unique_lock<std::mutex> lock(m_);
+            for (;;) {
+                cv_.wait(lock, [this] { return requested_ || quit_; });
+                if (quit_) return;
+                requested_ = false;
+                lock.unlock();
+                ok = broker_.connect(&session);
+                done.store(true);
+                lock.lock();
+            }
+        }
+
+        FakeBroker& broker_;
+        std::mutex m_;
+        std::condition_variable cv_;
+        bool requested_ = false;
+        bool quit_ = false;
+        std::thread thread_;
+    };
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_backoff_doubles_with_jitter_and_caps() {
+    ReconnectBackoff backoff(500, 4000, 1);
+    const uint32_t ceiling[] = { 500, 1000, 2000, 4000, 4000, 4000 };
+    for (uint32_t d : ceiling) {
+        uint32_t delay = backoff.next_delay_ms();
+        TEST_ASSERT_GREATER_OR_EQUAL(d / 2, delay);
+        TEST_ASSERT_LESS_OR_EQUAL(d, delay);
+    }
+    backoff.reset();
+    TEST_ASSERT_LESS_OR_EQUAL(500, backoff.next_delay_ms());
+}
+
+void test_connect_is_asynchronous() {
+    MqttConnection c(ReconnectBackoff(500, 30000, 1));
+    TEST_ASSERT_EQUAL(MqttAction::NONE, c.step(0, false, false));
+    TEST_ASSERT_EQUAL(MqttState::WIFI_DOWN, c.state());
+    // Link up: attempt right away, then nothing until the attempt reports back
+    TEST_ASSERT_EQUAL(MqttAction::CONNECT, c.step(10, true, false));
+    TEST_ASSERT_EQUAL(MqttState::CONNECTING, c.state());
+    TEST_ASSERT_EQUAL(MqttAction::NONE, c.step(5000, true, false));
+    TEST_ASSERT_EQUAL(MqttAction::NONE, c.step(6000, false, false)); // Not even a dropped link aborts it
+    TEST_ASSERT_EQUAL(MqttState::CONNECTING, c.state());
+
+    c.connect_finished(false, 6000);
+    TEST_ASSERT_EQUAL(MqttState::BACKOFF, c.state());
+    uint32_t wait = c.next_attempt_in_ms(6000);
+    TEST_ASSERT_GREATER_OR_EQUAL(250, wait);
+    TEST_ASSERT_LESS_OR_EQUAL(500, wait);
+    TEST_ASSERT_EQUAL(MqttAction::NONE, c.step(6000 + wait - 1, true, false));
+    TEST_ASSERT_EQUAL(MqttAction::CONNECT, c.step(6000 + wait, true, false));
+    c.connect_finished(true, 6100 + wait);
+    TEST_ASSERT_EQUAL(MqttState::CONNECTED, c.state());
+    TEST_ASSERT_EQUAL(2, c.connect_attempts());
+    TEST_ASSERT_EQUAL(1, c.connects());
+}
+
+void test_lost_session_and_link() {
+    MqttConnection c(ReconnectBackoff(500, 30000, 1));
+    c.step(0, true, false);
+    c.connect_finished(true, 0);
+    TEST_ASSERT_EQUAL(MqttAction::NONE, c.step(100, true, true));
+    TEST_ASSERT_EQUAL(MqttState::CONNECTED, c.state());
+    // Broker went away: back off (the backoff was reset by the connect)
+    TEST_ASSERT_EQUAL(MqttAction::NONE, c.step(200, true, false));
+    TEST_ASSERT_EQUAL(MqttState::BACKOFF, c.state());
+    TEST_ASSERT_LESS_OR_EQUAL(500, c.next_attempt_in_ms(200));
+    // WiFi went away under a live session: close it, then wait for the link
+    c.step(1000, true, false);
+    c.connect_finished(true, 1000);
+    TEST_ASSERT_EQUAL(MqttAction::DISCONNECT, c.step(1100, false, true));
+    TEST_ASSERT_EQUAL(MqttState::WIFI_DOWN, c.state());
+    TEST_ASSERT_EQUAL(MqttAction::NONE, c.step(1200, false, false));
+    TEST_ASSERT_EQUAL(MqttAction::CONNECT, c.step(1300, true, false));
+}
+
+void test_outbox_policies() {
+    MqttOutbox<2, 8> oldest(OutboxPolicy::DROP_OLDEST);
+    MqttOutbox<2, 8> newest(OutboxPolicy::DROP_NEWEST);
+    const uint8_t a[] = "a", b[] = "b", c[] = "c";
+    for (auto* box : { &oldest, &newest }) {
+        TEST_ASSERT_TRUE(box->push("t", a, 1));
+        TEST_ASSERT_TRUE(box->push("t", b, 1));
+    }
+    TEST_ASSERT_TRUE(oldest.push("t", c, 1));
+    TEST_ASSERT_FALSE(newest.push("t", c, 1));
+    TEST_ASSERT_FALSE(oldest.push("t", a, 9)); // Larger than a slot
+
+    const char* topic;
+    const uint8_t* payload;
+    size_t len;
+    TEST_ASSERT_TRUE(oldest.peek(&topic, &payload, &len));
+    TEST_ASSERT_EQUAL('b', payload[0]);
+    TEST_ASSERT_TRUE(newest.peek(&topic, &payload, &len));
+    TEST_ASSERT_EQUAL('a', payload[0]);
+    TEST_ASSERT_EQUAL(1, oldest.stats().dropped);
+    TEST_ASSERT_EQUAL(1, oldest.stats().rejected);
+    TEST_ASSERT_EQUAL(1, newest.stats().dropped);
+}
+
+// loop() of main.cpp reduced to its MQTT part: step the connection, publish now and then,
+// drain the outbox while connected, sleep until the next service time
+void test_broker_restart_does_not_stall_loop() {
+    constexpr uint32_t kConnectTimeoutMs = 300;
+    constexpr uint32_t kLoopIdleMs = 2;
+    constexpr uint32_t kPublishEveryMs = 25;
+    constexpr uint32_t kDownAtMs = 400, kUpAtMs = 1400, kEndMs = 2600;
+
+    FakeBroker broker(kConnectTimeoutMs);
+    ConnectThread connector(broker);
+    MqttConnection connection(ReconnectBackoff(50, 400, 7));
+    MqttOutbox<8, 32> outbox(OutboxPolicy::DROP_OLDEST);
+
+    const Clock::time_point t0 = Clock::now();
+    uint32_t max_stall_us = 0, iterations = 0, published = 0, next_publish_ms = 0;
+    uint32_t down_at = 0, reconnected_ms = 0;
+    bool restarted = false;
+    for (uint32_t now = 0; now < kEndMs; now = ms_since(t0)) {
+        if (!restarted && now >= kDownAtMs && now < kUpAtMs && down_at == 0) {
+            broker.set_up(false);
+            down_at = now;
+        } else if (down_at && !restarted && now >= kUpAtMs) {
+            broker.set_up(true);
+            restarted = true;
+        }
+
+        const Clock::time_point it0 = Clock::now();
+        if (connection.state() == MqttState::CONNECTING && connector.done.load()) {
+            connection.connect_finished(connector.ok, now);
+            if (restarted && connector.ok && !reconnected_ms) reconnected_ms = now;
+        }
+        bool session_up = connection.state() == MqttState::CONNECTED && broker.session_alive(connector.session);
+        if (connection.step(now, true, session_up) == MqttAction::CONNECT) connector.start();
+        if (now >= next_publish_ms) {
+            const uint8_t payload[] = "sign";
+            if (connection.state() == MqttState::CONNECTED && outbox.empty() && broker.session_alive(connector.session)) {
+                broker.deliver();
+            } else {
+                outbox.push("grokware/test", payload, sizeof(payload));
+            }
+            published++;
+            next_publish_ms = now + kPublishEveryMs;
+        }
+        if (connection.state() == MqttState::CONNECTED) {
+            for (int i = 0; i < 4 && !outbox.empty() && broker.session_alive(connector.session); ++i) {
+                broker.deliver();
+                outbox.pop();
+            }
+        }
+        uint32_t stall_us = (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - it0).count();
+        if (stall_us > max_stall_us) max_stall_us = stall_us;
+        iterations++;
+        std::this_thread::sleep_for(std::chrono::milliseconds(kLoopIdleMs));
+    }
+    // Let an attempt still in flight finish before the connector goes away
+    while (connection.state() == MqttState::CONNECTING && !connector.done.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    char line[200];
+    snprintf(line, sizeof(line), "%u loop iterations, max stall %u us (connect timeout %u ms); %u attempts, "
+             "reconnected %u ms after restart; %u published, %u delivered, %u dropped",
+             (unsigned)iterations, (unsigned)max_stall_us, (unsigned)kConnectTimeoutMs,
+             (unsigned)connection.connect_attempts(), (unsigned)(reconnected_ms - kUpAtMs),
+             (unsigned)published, (unsigned)broker.delivered, (unsigned)outbox.stats().dropped);
+    TEST_MESSAGE(line);
+
+    TEST_ASSERT_LESS_THAN(20 * 1000u, max_stall_us); // A blocking connect would show up as >= 300 ms
+    TEST_ASSERT_GREATER_THAN(1, connection.connect_attempts());
+    TEST_ASSERT_EQUAL(MqttState::CONNECTED, connection.state());
+    TEST_ASSERT_TRUE(outbox.empty());
+    TEST_ASSERT_EQUAL(published, broker.delivered + outbox.stats().dropped);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_backoff_doubles_with_jitter_and_caps);
+    RUN_TEST(test_connect_is_asynchronous);
+    RUN_TEST(test_lost_session_and_link);
+    RUN_TEST(test_outbox_policies);
+    RUN_TEST(test_broker_restart_does_not_stall_loop);
+    return UNITY_END();
+}
@@ -0,0 +1,155 @@
+// PatternEngine on a virtual clock: step timing, ramps, repeats, preemption and coalescing
+#include <unity.h>
+#include "pattern_engine.h"
+
+namespace {
+    const PatternStep kBlinkSteps[] = { {100, 255, 0, false}, {50, 0, 0, false} };
+    const PatternStep kBuzzSteps[] = { {200, 0, 200, false}, {20, 0, 0, false} };
+    const PatternStep kFadeSteps[] = { {100, 200, 0, true}, {100, 0, 0, true} };
+
+    const Pattern kBlink = { "blink", kBlinkSteps, 2, 1, 1 };   // Plays twice
+    const Pattern kBuzz = { "buzz", kBuzzSteps, 2, 0, 2 };
+    const Pattern kFade = { "fade", kFadeSteps, 2, 0, 1 };
+    const Pattern kLow = { "low", kBuzzSteps, 2, 0, 0 };
+
+    PatternEngine engine;
+}
+
+void setUp() {
+    engine = PatternEngine();
+}
+
+void tearDown() {}
+
+void test_steps_follow_the_clock() {
+    engine.play(&kBlink, 1000);
+    TEST_ASSERT_EQUAL(255, engine.tick(1000).led);
+    TEST_ASSERT_EQUAL(1100, engine.next_deadline_ms(1000));
+    TEST_ASSERT_EQUAL(255, engine.tick(1099).led);
+    TEST_ASSERT_EQUAL(0, engine.tick(1100).led);
+    TEST_ASSERT_EQUAL(1150, engine.next_deadline_ms(1100));
+    // Repeat starts where the first play was scheduled to end, not when tick() ran
+    TEST_ASSERT_EQUAL(255, engine.tick(1160).led);
+    TEST_ASSERT_EQUAL(1250, engine.next_deadline_ms(1160));
+    engine.tick(1300);
+    TEST_ASSERT_FALSE(engine.busy());
+    TEST_ASSERT_EQUAL(PatternEngine::kIdle, engine.next_deadline_ms(1300));
+    TEST_ASSERT_EQUAL(1, engine.stats().played);
+}
+
+void test_late_tick_catches_up_over_whole_plays() {
+    engine.play(&kBlink, 0);
+    engine.play(&kBuzz, 0); // Preempts: blink is gone
+    engine.play(&kBlink, 0); // Queued behind buzz
+    // One tick long after buzz (220 ms) and half of blink's first play (100 ms) ended
+    PatternOutput out = engine.tick(330);
+    TEST_ASSERT_EQUAL_PTR(&kBlink, engine.current());
+    TEST_ASSERT_EQUAL(0, out.led); // Blink started at 220: its off step runs 320..370
+    TEST_ASSERT_EQUAL(370, engine.next_deadline_ms(330));
+}
+
+void test_ramp_interpolates_and_polls() {
+    engine.play(&kFade, 0);
+    TEST_ASSERT_EQUAL(0, engine.tick(0).led);
+    TEST_ASSERT_EQUAL(100, engine.tick(50).led);
+    TEST_ASSERT_EQUAL(50 + PatternEngine::kRampStepMs, engine.next_deadline_ms(50));
+    TEST_ASSERT_EQUAL(100, engine.next_deadline_ms(95)); // Last poll lands on the step end
+    TEST_ASSERT_EQUAL(200, engine.tick(100).led);
+    TEST_ASSERT_EQUAL(150, engine.tick(125).led);
+    engine.tick(200);
+    TEST_ASSERT_FALSE(engine.busy());
+}
+
+void test_idle_levels_between_patterns() {
+    engine.set_idle({ 10, 0 });
+    TEST_ASSERT_EQUAL(10, engine.tick(0).led);
+    engine.play(&kBuzz, 0);
+    TEST_ASSERT_EQUAL(0, engine.tick(0).led);
+    TEST_ASSERT_EQUAL(10, engine.tick(220).led);
+}
+
+void test_higher_priority_preempts_lower_queues() {
+    engine.play(&kBlink, 0);
+    engine.play(&kBuzz, 40);
+    TEST_ASSERT_EQUAL_PTR(&kBuzz, engine.current());
+    TEST_ASSERT_EQUAL(1, engine.stats().preempted);
+    TEST_ASSERT_EQUAL(200, engine.tick(40).motor);
+    // Lower priority waits its turn and starts when buzz is scheduled to end
+    engine.play(&kLow, 50);
+    TEST_ASSERT_EQUAL_PTR(&kBuzz, engine.current());
+    engine.tick(260);
+    TEST_ASSERT_EQUAL_PTR(&kLow, engine.current());
+    TEST_ASSERT_EQUAL(460, engine.next_deadline_ms(260));
+    // Equal priority never preempts
+    const Pattern kOtherLow = { "other_low", kBlinkSteps, 2, 0, 0 };
+    engine.play(&kOtherLow, 270);
+    TEST_ASSERT_EQUAL_PTR(&kLow, engine.current());
+}
+
+void test_queue_orders_by_priority_and_drops_lowest() {
+    const Pattern kTop = { "top", kBuzzSteps, 2, 0, 9 };
+    const Pattern kA = { "a", kBlinkSteps, 2, 0, 1 };
+    const Pattern kB = { "b", kBlinkSteps, 2, 0, 2 };
+    const Pattern kC = { "c", kBlinkSteps, 2, 0, 1 };
+    const Pattern kD = { "d", kBlinkSteps, 2, 0, 0 };
+    const Pattern kE = { "e", kBlinkSteps, 2, 0, 3 };
+    engine.play(&kTop, 0);
+    engine.play(&kA, 0);
+    engine.play(&kB, 0);
+    engine.play(&kC, 0);
+    engine.play(&kD, 0);  // Queue full: b, a, c, d
+    engine.play(&kE, 0);  // Pushes d out
+    engine.play(&kLow, 0); // Lower than everything queued: rejected
+    TEST_ASSERT_EQUAL(2, engine.stats().dropped);
+
+    const Pattern* order[] = { &kTop, &kE, &kB, &kA, &kC };
+    uint32_t now = 0;
+    for (const Pattern* p : order) {
+        engine.tick(now);
+        TEST_ASSERT_EQUAL_PTR(p, engine.current());
+        now = engine.next_deadline_ms(now);
+        engine.tick(now);
+        now = engine.next_deadline_ms(now);
+    }
+    engine.tick(now);
+    TEST_ASSERT_FALSE(engine.busy());
+}
+
+void test_burst_of_alerts_coalesces() {
+    for (uint32_t t = 0; t < 100; t += 10) engine.play(&kBlink, t); // Ten messages in 100 ms
+    TEST_ASSERT_EQUAL(1, engine.stats().played);
+    TEST_ASSERT_EQUAL(9, engine.stats().coalesced);
+
+    engine.play(&kBuzz, 100);
+    engine.play(&kBlink, 110); // Preempted blink is gone: this one queues
+    engine.play(&kBlink, 120); // ...and absorbs the next
+    TEST_ASSERT_EQUAL(10, engine.stats().coalesced);
+    engine.tick(320);
+    TEST_ASSERT_EQUAL_PTR(&kBlink, engine.current());
+    engine.tick(620);
+    TEST_ASSERT_FALSE(engine.busy());
+    TEST_ASSERT_EQUAL(3, engine.stats().played);
+}
+
+void test_stop_clears_everything() {
+    engine.set_idle({ 0, 0 });
+    engine.play(&kBlink, 0);
+    engine.play(&kLow, 0);
+    engine.stop(10);
+    TEST_ASSERT_FALSE(engine.busy());
+    TEST_ASSERT_EQUAL(0, engine.tick(10).led);
+    TEST_ASSERT_EQUAL(PatternEngine::kIdle, engine.next_deadline_ms(10));
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_steps_follow_the_clock);
+    RUN_TEST(test_late_tick_catches_up_over_whole_plays);
+    RUN_TEST(test_ramp_interpolates_and_polls);
+    RUN_TEST(test_idle_levels_between_patterns);
+    RUN_TEST(test_higher_priority_preempts_lower_queues);
+    RUN_TEST(test_queue_orders_by_priority_and_drops_lowest);
+    RUN_TEST(test_burst_of_alerts_coalesces);
+    RUN_TEST(test_stop_clears_everything);
+    return UNITY_END();
+}
@@ -0,0 +1,316 @@
+// signing_pipeline.cpp on the host: its tasks, queues and event group run on std::thread through
+// the stand-ins in test/host_idf, against a fake camera driver (a sensor thread exposing a frame
+// every period into CAMERA_FB_COUNT buffers, grab-latest) and a fake model whose preprocess and
+// Invoke() take a fixed time. Compared with the loop it replaced (capture, preprocess, Invoke()
+// back to back on the loop task with one frame buffer and a 10 ms loop delay), it reports frames/s
+// and sensor-to-result latency, and how long a finished sign waits before loop() picks it up.
+// Also checks that a failed signing_pipeline_init() leaves nothing behind and can be retried.
+//   pio test -e native_pipeline -v
+//   PLATFORMIO_BUILD_FLAGS="-DPIPELINE_INVOKE_US=120000" pio test -e native_pipeline -v
+#include <unity.h>
+#include "config.h"
+#include "camera_handler.h"
+#include "input_handler.h"
+#include "sign_language_model.h"
+#include "signing_pipeline.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+#ifndef PIPELINE_FRAME_PERIOD_US
+#define PIPELINE_FRAME_PERIOD_US 40000   // Sensor at 25 fps
+#endif
+#ifndef PIPELINE_ANALYZE_US
+#define PIPELINE_ANALYZE_US 2000         // Thumbnail, motion gate, tracker
+#endif
+#ifndef PIPELINE_PREPROCESS_US
+#define PIPELINE_PREPROCESS_US 4000
+#endif
+#ifndef PIPELINE_INVOKE_US
+#define PIPELINE_INVOKE_US 60000
+#endif
+#ifndef PIPELINE_RUN_MS
+#define PIPELINE_RUN_MS 3000
+#endif
+
+namespace {
+    constexpr int kSrc = 240;
+    constexpr int kOldLoopDelayMs = 10;   // delay(10) at the end of the old loop()
+
+    void sleep_us(uint32_t us) { std::this_thread::sleep_for(std::chrono::microseconds(us)); }
+    uint32_t now_us() { return (uint32_t)esp_timer_get_time(); }
+
+    // Fake esp32-camera driver in CAMERA_GRAB_LATEST mode: each period the sensor fills a free
+    // buffer, or overwrites the oldest frame nobody has taken yet; with neither, the frame is lost
+    class FakeCamera {
+    public:
+        void start(int fb_count) {
+            buffers_.assign(fb_count, camera_fb_t{});
+            pixels_.assign((size_t)fb_count * kSrc * kSrc, 0);
+            free_.clear();
+            ready_.clear();
+            for (int i = 0; i < fb_count; ++i) {
+                buffers_[i] = { pixels_.data() + (size_t)i * kSrc * kSrc, (size_t)kSrc * kSrc, kSrc, kSrc, PIXFORMAT_GRAYSCALE, {} };
+                free_.push_back(&buffers_[i]);
+            }
+            running_ = true;
+            sensor_ = std::thread([this] { run(); });
+        }
+        void stop() {
+            running_ = false;
+            sensor_.join();
+        }
+        camera_fb_t* get() {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (!cv_.wait_for(lock, std::chrono::seconds(1), [this] { return !ready_.empty(); })) return nullptr;
+            camera_fb_t* fb = ready_.back();  // Latest; any older ones go back to the sensor
+            ready_.pop_back();
+            free_.insert(free_.end(), ready_.begin(), ready_.end());
+            ready_.clear();
+            return fb;
+        }
+        void put(camera_fb_t* fb) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            free_.push_back(fb);
+        }
+        // Sensor time of the end of exposure, in the frame like esp32-camera's timestamp
+        static uint32_t stamp_us(const camera_fb_t* fb) { return (uint32_t)(fb->timestamp.tv_sec * 1000000 + fb->timestamp.tv_usec); }
+
+    private:
+        void run() {
+            uint32_t next = now_us() + PIPELINE_FRAME_PERIOD_US;
+            while (running_) {
+                sleep_us(next - now_us());
+                next += PIPELINE_FRAME_PERIOD_US;
+                std::lock_guard<std::mutex> lock(mutex_);
+                camera_fb_t* fb = nullptr;
+                if (!free_.empty()) {
+                    fb = free_.back();
+                    free_.pop_back();
+                } else if (!ready_.empty()) {
+                    fb = ready_.front();
+                    ready_.erase(ready_.begin());
+                }
+                if (!fb) continue;
+                const uint32_t t = now_us();
+                fb->timestamp.tv_sec = t / 1000000;
+                fb->timestamp.tv_usec = t % 1000000;
+                ready_.push_back(fb);
+                cv_.notify_all();
+            }
+        }
+
+        std::vector<camera_fb_t> buffers_;
+        std::vector<uint8_t> pixels_;
+        std::vector<camera_fb_t*> free_, ready_;
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        std::atomic<bool> running_{false};
+        std::thread sensor_;
+    };
+
+    FakeCamera camera;
+    int8_t tensor[2 * TFLITE_MODEL_INPUT_WIDTH * TFLITE_MODEL_INPUT_HEIGHT];
+    int model_frames = 1;                       // > 1 makes the pipeline allocate frame history
+
+    // What the fake model is working on, for latency; written and read by the inferring thread
+    uint32_t staged_capture_us = 0;
+    uint32_t inferences = 0;
+    uint64_t latency_sum_us = 0;
+    uint32_t latency_max_us = 0;
+
+    TaskHandle_t loop_task = nullptr;
+    std::atomic<uint32_t> wakes{0};
+
+    struct RunStats {
+        double fps;
+        double avg_latency_ms;
+        double max_latency_ms;
+    };
+
+    void reset_counters() {
+        inferences = 0;
+        latency_sum_us = 0;
+        latency_max_us = 0;
+    }
+
+    RunStats stats_since(uint32_t t0_us) {
+        const double s = (now_us() - t0_us) / 1e6;
+        return { inferences / s, inferences ? latency_sum_us / 1000.0 / inferences : 0.0, latency_max_us / 1000.0 };
+    }
+
+    void report(const char* name, const RunStats& s) {
+        char line[160];
+        snprintf(line, sizeof(line), "%-10s  %6.1f  %14.1f  %14.1f", name, s.fps, s.avg_latency_ms, s.max_latency_ms);
+        TEST_MESSAGE(line);
+    }
+}
+
+// --- Fakes of the firmware the pipeline calls --------------------------------------------------
+
+camera_fb_t* camera_capture_frame() { return camera.get(); }
+void camera_return_frame(camera_fb_t* fb) { camera.put(fb); }
+
+bool camera_analyze_frame(camera_fb_t* fb, const ModelInput&, HandRois* rois) {
+    sleep_us(PIPELINE_ANALYZE_US);
+    rois->count = 1;
+    rois->crop[0] = { 0, 0, (int)fb->width, (int)fb->height };
+    return true;
+}
+bool camera_thumb_to_input(const ModelInput&, CropRect*) { return false; }
+void camera_analyze_reset() {}
+void camera_motion_gate_stats(MotionGateStats* out) { *out = {}; }
+
+bool preprocess_camera_frame(camera_fb_t* fb, const ModelInput&, CropRect) {
+    sleep_us(PIPELINE_PREPROCESS_US);
+    staged_capture_us = FakeCamera::stamp_us(fb);
+    return true;
+}
+
+bool tflite_get_input(ModelInput* input) {
+    *input = { tensor, ModelInputType::INT8, TFLITE_MODEL_INPUT_WIDTH, TFLITE_MODEL_INPUT_HEIGHT, 1, 1, model_frames, nullptr };
+    return true;
+}
+
+bool tflite_invoke() {
+    sleep_us(PIPELINE_INVOKE_US);
+    const uint32_t latency = now_us() - staged_capture_us;
+    inferences++;
+    latency_sum_us += latency;
+    latency_max_us = std::max(latency_max_us, latency);
+    return true;
+}
+
+// Six frames of a sign, four of nothing: one gesture per ten inferred frames
+bool tflite_read_topk(int, int, TopKResult* out) {
+    const uint32_t n = inferences;
+    out->count = 1;
+    out->top[0] = { (int)(n / 10 % TFLITE_NUM_CLASSES), 0.9f };
+    out->verdict = n % 10 < 6 ? ScoreVerdict::ACCEPTED : ScoreVerdict::BELOW_THRESHOLD;
+    return true;
+}
+
+bool hand_detector_available() { return false; }
+bool hand_detector_get_input(ModelInput*) { return false; }
+bool hand_detector_run(HandDetection*) { return false; }
+void tflite_get_stage_stats(ModelStageStats* detector, ModelStageStats* classifier) {
+    *detector = {};
+    *classifier = {};
+}
+
+void input_wake() {
+    wakes++;
+    if (loop_task) xTaskNotifyGive(loop_task);
+}
+
+// -----------------------------------------------------------------------------------------------
+
+void setUp() {}
+void tearDown() {}
+
+// Every failure before the tasks run leaves no task, queue or buffer behind, and the next call
+// starts over instead of reporting the half-built pipeline as ready. (A failure of the second
+// task, after the first one started, deletes that task; std::thread can't be killed, so that
+// case is left to the device.)
+void test_failed_init_leaves_nothing_behind() {
+    host_fail_create_after = 2;             // Event group and frame queue, then the result queue fails
+    TEST_ASSERT_FALSE(signing_pipeline_init());
+    host_fail_create_after = 3;             // ...then the capture task fails
+    TEST_ASSERT_FALSE(signing_pipeline_init());
+    host_fail_create_after = -1;
+    model_frames = 2;
+    host_fail_alloc_after = 0;              // Frame history, internal and then external RAM
+    TEST_ASSERT_FALSE(signing_pipeline_init());
+    TEST_ASSERT_EQUAL(0, host_tasks_created.load());
+    TEST_ASSERT_FALSE(signing_pipeline_is_running());
+
+    host_fail_alloc_after = -1;
+    model_frames = 1;
+    TEST_ASSERT_TRUE(signing_pipeline_init());
+    TEST_ASSERT_EQUAL(2, host_tasks_created.load());
+    TEST_ASSERT_TRUE(signing_pipeline_init()); // Already up: no second set of tasks
+    TEST_ASSERT_EQUAL(2, host_tasks_created.load());
+}
+
+void test_throughput_vs_loop() {
+    char line[160];
+    snprintf(line, sizeof(line), "sensor %.1f fps, analyze %.1f ms, preprocess %.1f ms, Invoke() %.1f ms, %d ms per run",
+             1e6 / PIPELINE_FRAME_PERIOD_US, PIPELINE_ANALYZE_US / 1000.0, PIPELINE_PREPROCESS_US / 1000.0,
+             PIPELINE_INVOKE_US / 1000.0, PIPELINE_RUN_MS);
+    TEST_MESSAGE(line);
+    TEST_MESSAGE("            frames/s  avg_latency_ms  max_latency_ms");
+
+    // The old SIGNING case of loop(): one frame buffer, everything on the loop task
+    camera.start(1);
+    reset_counters();
+    uint32_t t0 = now_us();
+    while (now_us() - t0 < PIPELINE_RUN_MS * 1000u) {
+        camera_fb_t* fb = camera_capture_frame();
+        TEST_ASSERT_NOT_NULL(fb);
+        ModelInput input;
+        tflite_get_input(&input);
+        preprocess_camera_frame(fb, input, { 0, 0, kSrc, kSrc });
+        tflite_invoke();
+        camera_return_frame(fb);
+        std::this_thread::sleep_for(std::chrono::milliseconds(kOldLoopDelayMs));
+    }
+    const RunStats loop = stats_since(t0);
+    camera.stop();
+    report("loop", loop);
+
+    // The pipeline, drained the way loop() does: sleep in the input wait, then read every result
+    TEST_ASSERT_TRUE(signing_pipeline_init());
+    camera.start(CAMERA_FB_COUNT);
+    loop_task = xTaskGetCurrentTaskHandle();
+    wakes = 0;
+    reset_counters();
+    signing_pipeline_start();
+    t0 = now_us();
+    uint32_t signs = 0, wait_max_us = 0;
+    uint64_t wait_sum_us = 0;
+    while (now_us() - t0 < PIPELINE_RUN_MS * 1000u) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(LOOP_MAX_IDLE_MS));
+        SignResult r;
+        while (signing_pipeline_get_result(&r)) {
+            TEST_ASSERT_TRUE(r.ok);
+            const uint32_t wait = now_us() - (r.capture_us + r.latency_us);
+            wait_sum_us += wait;
+            wait_max_us = std::max(wait_max_us, wait);
+            signs++;
+        }
+    }
+    const RunStats pipe = stats_since(t0);
+    signing_pipeline_stop();
+    camera.stop();
+    report("pipeline", pipe);
+
+    SignPipelineStats stats;
+    signing_pipeline_get_stats(&stats);
+    snprintf(line, sizeof(line), "pipeline: %u signs, result -> loop() %.2f ms avg, %.2f ms max; %u captured, %u dropped; %.2fx the loop's frames/s",
+             (unsigned)signs, signs ? wait_sum_us / 1000.0 / signs : 0.0, wait_max_us / 1000.0,
+             (unsigned)stats.frames_captured, (unsigned)stats.frames_dropped, pipe.fps / loop.fps);
+    TEST_MESSAGE(line);
+
+    // Inference never waits on the sensor: the pipeline runs within 10% of back-to-back stages
+    const double bound_fps = 1e6 / (PIPELINE_ANALYZE_US + PIPELINE_PREPROCESS_US + PIPELINE_INVOKE_US);
+    TEST_ASSERT_GREATER_THAN(0.9 * bound_fps * 100, pipe.fps * 100);
+    TEST_ASSERT_GREATER_THAN(loop.fps * 100, pipe.fps * 100);
+    // Every sign reached loop() and woke it, instead of waiting out LOOP_MAX_IDLE_MS
+    TEST_ASSERT_GREATER_THAN(0, signs);
+    TEST_ASSERT_EQUAL(signs, wakes.load());
+    TEST_ASSERT_LESS_THAN(LOOP_MAX_IDLE_MS * 1000 / 4, wait_sum_us / signs);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_failed_init_leaves_nothing_behind);
+    RUN_TEST(test_throughput_vs_loop);
+    return UNITY_END();
+}
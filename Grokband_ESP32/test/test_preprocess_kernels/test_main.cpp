@@ -0,0 +1,282 @@
+// luma_resize_fixed() against the generic luma_resize_gray()/luma_resize_rgb565() it replaces
+// for the model input: randomized sources, crops and LUTs, every tensor type, and output sizes
+// from the shipped model's down to 1x1. The outputs must be bit-identical. Both bilinear kernels
+// and the JPEG area downscaler are also held against a float reference of the whole chain, which
+// reports how many outputs are bit-exact. Also covers which kernel pick_luma_resize() hands out.
+//   pio test -e native -f test_preprocess_kernels
+//   PLATFORMIO_BUILD_FLAGS="-DPREPROCESS_KERNEL_CASES=20000 -DPREPROCESS_KERNEL_SEED=7" pio test ...
+#include <unity.h>
+#include "config.h"
+#include "frame_preprocess.h"
+#include "preprocess_kernels.h"
+
+#include <random>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#ifndef PREPROCESS_KERNEL_CASES
+#define PREPROCESS_KERNEL_CASES 3000  // Per pixel format and output size
+#endif
+#ifndef PREPROCESS_KERNEL_SEED
+#define PREPROCESS_KERNEL_SEED 1
+#endif
+
+namespace {
+    std::mt19937 rng(PREPROCESS_KERNEL_SEED);
+
+    int uniform(int lo, int hi) { return std::uniform_int_distribution<int>(lo, hi)(rng); }
+
+    struct Luts {
+        uint8_t u8[256];
+        int8_t i8[256];
+        float f32[256];
+    };
+
+    // Random, so a wrong index can't land on an equal entry by symmetry
+    void random_luts(Luts* l) {
+        for (int i = 0; i < 256; ++i) {
+            l->u8[i] = (uint8_t)uniform(0, 255);
+            l->i8[i] = (int8_t)uniform(-128, 127);
+            l->f32[i] = (float)uniform(-1000, 1000) / 997.0f;
+        }
+    }
+
+    const void* lut_for(const Luts& l, ModelInputType type) {
+        switch (type) {
+            case ModelInputType::UINT8: return l.u8;
+            case ModelInputType::INT8:  return l.i8;
+            default:                    return l.f32;
+        }
+    }
+
+    size_t element_bytes(ModelInputType type) { return type == ModelInputType::FLOAT32 ? 4 : 1; }
+
+    // Smooth gradients, hard edges and noise in one frame
+    void random_frame(std::vector<uint8_t>* frame) {
+        const int mode = uniform(0, 2);
+        for (size_t i = 0; i < frame->size(); ++i) {
+            (*frame)[i] = mode == 0 ? (uint8_t)uniform(0, 255) : mode == 1 ? (uint8_t)(i * 7 + (i >> 9)) : (uint8_t)((i / 13) & 1 ? 255 : 0);
+        }
+    }
+
+    CropRect random_crop(int src_w, int src_h) {
+        if (uniform(0, 3) == 0) return { 0, 0, src_w, src_h };
+        CropRect c;
+        c.w = uniform(1, src_w);
+        c.h = uniform(1, src_h);
+        c.x = uniform(0, src_w - c.w);
+        c.y = uniform(0, src_h - c.h);
+        return c;
+    }
+
+    template <typename Pixel, int W, int H>
+    void check_random_cases(LumaResizeFn generic) {
+        static const ModelInputType kTypes[] = { ModelInputType::UINT8, ModelInputType::INT8, ModelInputType::FLOAT32 };
+        Luts luts;
+        std::vector<uint8_t> frame, want(W * H * 4), got(W * H * 4);
+        for (int n = 0; n < PREPROCESS_KERNEL_CASES; ++n) {
+            const int src_w = uniform(1, 320), src_h = uniform(1, 240);
+            frame.resize((size_t)src_w * src_h * Pixel::kBytes);
+            random_frame(&frame);
+            random_luts(&luts);
+            const CropRect crop = random_crop(src_w, src_h);
+            const ModelInputType type = kTypes[n % 3];
+
+            ModelInput dst = { want.data(), type, W, H, 1, 1, 1, lut_for(luts, type) };
+            const LumaResizeFn fixed = pick_luma_resize<Pixel, W, H>(dst, generic);
+            TEST_ASSERT_TRUE(fixed != generic);
+            memset(want.data(), 0xA5, want.size());
+            memset(got.data(), 0x5A, got.size());
+            TEST_ASSERT_TRUE(generic(frame.data(), src_w, src_h, crop, dst));
+            dst.data = got.data();
+            TEST_ASSERT_TRUE(fixed(frame.data(), src_w, src_h, crop, dst));
+            TEST_ASSERT_EQUAL_MEMORY(want.data(), got.data(), (size_t)W * H * element_bytes(type));
+        }
+    }
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_gray_matches_generic() {
+    check_random_cases<PixelGray, TFLITE_MODEL_INPUT_WIDTH, TFLITE_MODEL_INPUT_HEIGHT>(luma_resize_gray);
+    check_random_cases<PixelGray, 32, 24>(luma_resize_gray);
+    check_random_cases<PixelGray, 1, 1>(luma_resize_gray);
+}
+
+void test_rgb565_matches_generic() {
+    check_random_cases<PixelRgb565, TFLITE_MODEL_INPUT_WIDTH, TFLITE_MODEL_INPUT_HEIGHT>(luma_resize_rgb565);
+    check_random_cases<PixelRgb565, 24, 32>(luma_resize_rgb565);
+    check_random_cases<PixelRgb565, 1, 1>(luma_resize_rgb565);
+}
+
+namespace {
+    // Float reference for the whole chain: BT.601 luma (0.299, 0.587, 0.114) of the 8-bit
+    // expansion, bilinear at pixel-centre aligned source coordinates (area average for
+    // LumaAreaDownscaler), no intermediate rounding, rounded to the nearest level once at the end
+    template <typename Pixel>
+    double ref_luma(const uint8_t* p) {
+        if (!Pixel::kColor) return *p;
+        uint32_t r, g, b;
+        rgb565_to_rgb888(p, &r, &g, &b);
+        return 0.299 * r + 0.587 * g + 0.114 * b;
+    }
+
+    template <typename Pixel>
+    double ref_bilinear(const uint8_t* src, int src_w, CropRect c, int w, int h, int ox, int oy) {
+        auto coord = [](int o, int lo, int extent, int dst) {
+            double s = lo + (o + 0.5) * extent / dst - 0.5;
+            return s < lo ? lo : s > lo + extent - 1 ? lo + extent - 1 : s;
+        };
+        const double sx = coord(ox, c.x, c.w, w), sy = coord(oy, c.y, c.h, h);
+        const int x0 = (int)sx, y0 = (int)sy;
+        const int x1 = x0 < c.x + c.w - 1 ? x0 + 1 : x0, y1 = y0 < c.y + c.h - 1 ? y0 + 1 : y0;
+        const double fx = sx - x0, fy = sy - y0;
+        auto at = [&](int x, int y) { return ref_luma<Pixel>(src + ((size_t)y * src_w + x) * Pixel::kBytes); };
+        return (at(x0, y0) * (1 - fx) + at(x1, y0) * fx) * (1 - fy) + (at(x0, y1) * (1 - fx) + at(x1, y1) * fx) * fy;
+    }
+
+    struct RefError {
+        uint32_t pixels = 0, exact = 0;
+        int max_err = 0;
+        void add(int got, double want) {
+            int e = got - (int)(want + 0.5);
+            e = e < 0 ? -e : e;
+            pixels++;
+            exact += e == 0;
+            max_err = e > max_err ? e : max_err;
+        }
+        void report(const char* name) const {
+            char line[128];
+            snprintf(line, sizeof(line), "%s vs float reference: %u pixels, %.2f%% bit-exact, max error %d",
+                     name, (unsigned)pixels, 100.0 * exact / pixels, max_err);
+            TEST_MESSAGE(line);
+        }
+    };
+
+    template <typename Pixel, int W, int H>
+    RefError check_float_reference(LumaResizeFn generic) {
+        static uint8_t identity[256];
+        for (int i = 0; i < 256; ++i) identity[i] = (uint8_t)i;
+        RefError err;
+        std::vector<uint8_t> frame, got(W * H);
+        for (int n = 0; n < PREPROCESS_KERNEL_CASES / 10; ++n) {
+            const int src_w = uniform(1, 320), src_h = uniform(1, 240);
+            frame.resize((size_t)src_w * src_h * Pixel::kBytes);
+            random_frame(&frame);
+            const CropRect crop = random_crop(src_w, src_h);
+            const ModelInput dst = { got.data(), ModelInputType::UINT8, W, H, 1, 1, 1, identity };
+            const LumaResizeFn fn = pick_luma_resize<Pixel, W, H>(dst, generic);
+            TEST_ASSERT_TRUE(fn(frame.data(), src_w, src_h, crop, dst));
+            for (int oy = 0; oy < H; ++oy) {
+                for (int ox = 0; ox < W; ++ox) err.add(got[oy * W + ox], ref_bilinear<Pixel>(frame.data(), src_w, crop, W, H, ox, oy));
+            }
+        }
+        return err;
+    }
+}
+
+// The integer kernels round each tap's luma (and RGB565 uses 8-bit BT.601 weights) and quantize
+// the bilinear weights to Q12, so they can't be bit-exact with float everywhere: they must never
+// be off by more than one level, and the exact fraction must not drop below what they reach today
+void test_bilinear_matches_float_reference() {
+    const RefError gray = check_float_reference<PixelGray, TFLITE_MODEL_INPUT_WIDTH, TFLITE_MODEL_INPUT_HEIGHT>(luma_resize_gray);
+    gray.report("gray bilinear");
+    const RefError rgb = check_float_reference<PixelRgb565, TFLITE_MODEL_INPUT_WIDTH, TFLITE_MODEL_INPUT_HEIGHT>(luma_resize_rgb565);
+    rgb.report("rgb565 bilinear");
+    TEST_ASSERT_LESS_OR_EQUAL(1, gray.max_err);
+    TEST_ASSERT_LESS_OR_EQUAL(1, rgb.max_err);
+    TEST_ASSERT_GREATER_THAN(gray.pixels / 100 * 95, gray.exact);
+    TEST_ASSERT_GREATER_THAN(rgb.pixels / 100 * 80, rgb.exact);
+}
+
+// JPEG path: the area downscaler over decoded RGB888 blocks against the float mean of each bin.
+// It sums luma already rounded per pixel, so fewer outputs are exact; still within one level
+void test_area_matches_float_reference() {
+    static uint8_t identity[256];
+    for (int i = 0; i < 256; ++i) identity[i] = (uint8_t)i;
+    constexpr int W = TFLITE_MODEL_INPUT_WIDTH, H = TFLITE_MODEL_INPUT_HEIGHT;
+    RefError err;
+    std::vector<uint8_t> rgb, block, got(W * H);
+    for (int n = 0; n < PREPROCESS_KERNEL_CASES / 10; ++n) {
+        const int src_w = uniform(W, 320), src_h = uniform(H, 240);
+        rgb.resize((size_t)src_w * src_h * 3);
+        random_frame(&rgb);
+        CropRect crop = random_crop(src_w, src_h);
+        if (crop.w < W || crop.h < H) crop = { 0, 0, src_w, src_h };
+        const ModelInput dst = { got.data(), ModelInputType::UINT8, W, H, 1, 1, 1, identity };
+        LumaAreaDownscaler area;
+        if (!area.begin(src_w, src_h, crop, dst)) continue; // Bins too large for the uint16 accumulators
+        for (int by = 0; by < src_h; by += 16) {               // 16x16 MCUs in raster order
+            for (int bx = 0; bx < src_w; bx += 16) {
+                const int bw = src_w - bx < 16 ? src_w - bx : 16, bh = src_h - by < 16 ? src_h - by : 16;
+                block.resize((size_t)bw * bh * 3);
+                for (int y = 0; y < bh; ++y) memcpy(&block[(size_t)y * bw * 3], &rgb[((size_t)(by + y) * src_w + bx) * 3], (size_t)bw * 3);
+                area.push_block(bx, by, bw, bh, block.data());
+            }
+        }
+        area.finish();
+        std::vector<double> sum(W * H, 0.0);
+        std::vector<int> count(W * H, 0);
+        for (int sy = crop.y; sy < crop.y + crop.h; ++sy) {
+            for (int sx = crop.x; sx < crop.x + crop.w; ++sx) {
+                const int i = (int)((int64_t)(sy - crop.y) * H / crop.h) * W + (int)((int64_t)(sx - crop.x) * W / crop.w);
+                const uint8_t* p = &rgb[((size_t)sy * src_w + sx) * 3];
+                sum[i] += 0.299 * p[0] + 0.587 * p[1] + 0.114 * p[2];
+                count[i]++;
+            }
+        }
+        for (int i = 0; i < W * H; ++i) err.add(got[i], sum[i] / count[i]);
+    }
+    err.report("area (JPEG)");
+    TEST_ASSERT_GREATER_THAN(0, err.pixels);
+    TEST_ASSERT_LESS_OR_EQUAL(1, err.max_err);
+    TEST_ASSERT_GREATER_THAN(err.pixels / 100 * 70, err.exact);
+}
+
+// Only the compiled size, one channel, gets a specialized kernel; the rest keep the generic one
+void test_pick_falls_back_to_generic() {
+    uint8_t lut[256] = {};
+    uint8_t out[96 * 96 * 3];
+    ModelInput dst = { out, ModelInputType::UINT8, 96, 96, 1, 1, 1, lut };
+    TEST_ASSERT_TRUE((pick_luma_resize<PixelGray, 96, 96>(dst, luma_resize_gray)) == (&luma_resize_fixed<PixelGray, 96, 96, uint8_t>));
+    dst.type = ModelInputType::INT8;
+    TEST_ASSERT_TRUE((pick_luma_resize<PixelGray, 96, 96>(dst, luma_resize_gray)) == (&luma_resize_fixed<PixelGray, 96, 96, int8_t>));
+
+    dst.width = 32; // The hand detector's input
+    TEST_ASSERT_TRUE((pick_luma_resize<PixelGray, 96, 96>(dst, luma_resize_gray)) == &luma_resize_gray);
+    dst.width = 96;
+    dst.channels = 3;
+    TEST_ASSERT_TRUE((pick_luma_resize<PixelRgb565, 96, 96>(dst, luma_resize_rgb565)) == &luma_resize_rgb565);
+}
+
+// Both reject the same bad inputs, without writing
+void test_rejects_like_generic() {
+    uint8_t lut[256] = {};
+    uint8_t frame[64 * 48] = {};
+    uint8_t out[32 * 32];
+    const CropRect bad[] = { { -1, 0, 10, 10 }, { 0, 0, 0, 10 }, { 60, 0, 10, 10 }, { 0, 40, 10, 10 } };
+    ModelInput dst = { out, ModelInputType::UINT8, 32, 32, 1, 1, 1, lut };
+    for (const CropRect& c : bad) {
+        memset(out, 0x77, sizeof(out));
+        TEST_ASSERT_FALSE(luma_resize_gray(frame, 64, 48, c, dst));
+        TEST_ASSERT_FALSE((luma_resize_fixed<PixelGray, 32, 32, uint8_t>(frame, 64, 48, c, dst)));
+        TEST_ASSERT_EQUAL_UINT8(0x77, out[0]);
+    }
+    const CropRect ok = { 0, 0, 64, 48 };
+    TEST_ASSERT_FALSE((luma_resize_fixed<PixelGray, 32, 32, uint8_t>(nullptr, 64, 48, ok, dst)));
+    dst.height = 16; // Not the size it was compiled for
+    TEST_ASSERT_FALSE((luma_resize_fixed<PixelGray, 32, 32, uint8_t>(frame, 64, 48, ok, dst)));
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_gray_matches_generic);
+    RUN_TEST(test_rgb565_matches_generic);
+    RUN_TEST(test_bilinear_matches_float_reference);
+    RUN_TEST(test_area_matches_float_reference);
+    RUN_TEST(test_pick_falls_back_to_generic);
+    RUN_TEST(test_rejects_like_generic);
+    return UNITY_END();
+}
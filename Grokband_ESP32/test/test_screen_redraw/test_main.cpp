@@ -0,0 +1,149 @@
+// The screen manager in a host LVGL build: a 240x240 display with the firmware's draw
+// buffers, flushes going through FlushPlanner, and the encoder fed the way loop() feeds it.
+// Counts the pixels LVGL re-renders for each interaction, so the cost of a detent is measured
+// and held to DISPLAY_REDRAW_BUDGET_PX.
+#include <unity.h>
+#include "lvgl.h"
+#include "config.h"
+#include "display_flush.h"
+#include "screen_manager.h"
+
+#include <stdio.h>
+
+namespace {
+    constexpr int kW = 240, kH = 240;
+    const char* const kResponses[] = { "Yes", "No", "Thank you", "Please wait", "I need help", "Hello" };
+    constexpr int kCount = sizeof(kResponses) / sizeof(kResponses[0]);
+
+    lv_disp_draw_buf_t draw_buf;
+    lv_color_t buf_1[kW * DISPLAY_BUF_LINES];
+    lv_color_t buf_2[kW * DISPLAY_BUF_LINES];
+    FlushPlanner planner(kW, kH, DISPLAY_ROUND);
+    lv_indev_t* encoder = nullptr;
+    int16_t pending_enc_diff = 0;
+
+    void flush_cb(lv_disp_drv_t* drv, const lv_area_t* area, lv_color_t* color_p) {
+        FlushRegion rendered = { (int16_t)area->x1, (int16_t)area->y1,
+                                 (int16_t)lv_area_get_width(area), (int16_t)lv_area_get_height(area) };
+        FlushRegion push;
+        planner.plan((uint16_t*)color_p, rendered, &push);
+        lv_disp_flush_ready(drv);
+    }
+
+    void encoder_read(lv_indev_drv_t*, lv_indev_data_t* data) {
+        data->enc_diff = pending_enc_diff;
+        pending_enc_diff = 0;
+        data->state = LV_INDEV_STATE_RELEASED;
+    }
+
+    struct Redraw {
+        uint64_t rendered, pushed;
+    };
+
+    // Redraws what the last interaction invalidated, like display_refresh_now()
+    Redraw refresh() {
+        DisplayFlushStats before = planner.stats();
+        lv_refr_now(NULL);
+        return { planner.stats().pixels_rendered - before.pixels_rendered,
+                 planner.stats().pixels_pushed - before.pixels_pushed };
+    }
+
+    Redraw detent(int steps) {
+        pending_enc_diff += steps;
+        lv_indev_read_timer_cb(encoder->driver->read_timer); // display_encoder_feed()
+        return refresh();
+    }
+
+    void report(const char* what, const Redraw& r) {
+        char line[96];
+        snprintf(line, sizeof(line), "%-24s %6u px rendered, %6u px pushed", what, (unsigned)r.rendered, (unsigned)r.pushed);
+        TEST_MESSAGE(line);
+    }
+
+    void init_ui() {
+        lv_init();
+        lv_disp_draw_buf_init(&draw_buf, buf_1, buf_2, kW * DISPLAY_BUF_LINES);
+        static lv_disp_drv_t disp_drv;
+        lv_disp_drv_init(&disp_drv);
+        disp_drv.hor_res = kW;
+        disp_drv.ver_res = kH;
+        disp_drv.flush_cb = flush_cb;
+        disp_drv.draw_buf = &draw_buf;
+        lv_disp_drv_register(&disp_drv);
+
+        screen_build(lv_scr_act(), kW, kH);
+        screen_set_quick_responses(kResponses, kCount);
+
+        static lv_indev_drv_t indev_drv;
+        lv_indev_drv_init(&indev_drv);
+        indev_drv.type = LV_INDEV_TYPE_ENCODER;
+        indev_drv.read_cb = encoder_read;
+        encoder = lv_indev_drv_register(&indev_drv);
+        lv_indev_set_group(encoder, screen_quick_response_group());
+        refresh(); // First full draw
+    }
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_detents_redraw_two_items_within_budget() {
+    screen_show_quick_responses(0);
+    report("open quick responses", refresh());
+    uint64_t worst = 0;
+    for (int i = 1; i <= kCount; ++i) { // Last one wraps to the top
+        Redraw r = detent(1);
+        TEST_ASSERT_EQUAL(i % kCount, screen_quick_response_selected());
+        TEST_ASSERT_GREATER_THAN(0, r.rendered);
+        TEST_ASSERT_LESS_OR_EQUAL(DISPLAY_REDRAW_BUDGET_PX, r.rendered);
+        if (r.rendered > worst) worst = r.rendered;
+        char what[32];
+        snprintf(what, sizeof(what), "detent -> item %d", i % kCount);
+        report(what, r);
+    }
+    Redraw back = detent(-1);
+    TEST_ASSERT_EQUAL(kCount - 1, screen_quick_response_selected());
+    TEST_ASSERT_LESS_OR_EQUAL(DISPLAY_REDRAW_BUDGET_PX, back.rendered);
+    report("detent back", back);
+    char line[64];
+    snprintf(line, sizeof(line), "worst detent %u px, budget %u px", (unsigned)worst, (unsigned)DISPLAY_REDRAW_BUDGET_PX);
+    TEST_MESSAGE(line);
+}
+
+void test_unchanged_text_redraws_nothing() {
+    screen_show_status("Status: WiFi");
+    refresh();
+    Redraw r = (screen_show_status("Status: WiFi"), refresh());
+    TEST_ASSERT_EQUAL(0, r.rendered);
+    screen_show_message("Hello");
+    refresh();
+    r = (screen_show_message("Hello"), refresh());
+    TEST_ASSERT_EQUAL(0, r.rendered);
+}
+
+void test_status_change_redraws_only_the_status_bar() {
+    screen_show_message("Grokband Ready");
+    refresh();
+    Redraw r = (screen_show_status("MQTT Connected"), refresh());
+    report("status text", r);
+    TEST_ASSERT_GREATER_THAN(0, r.rendered);
+    TEST_ASSERT_LESS_OR_EQUAL(kW * 40, r.rendered);
+}
+
+void test_view_switches_are_reported() {
+    screen_show_message("Grokband Ready");
+    refresh();
+    report("message -> list", (screen_show_quick_responses(0), refresh()));
+    report("list -> message", (screen_show_message("Sent Quick Resp."), refresh()));
+    report("message text", (screen_show_message("Hello there"), refresh()));
+}
+
+int main(int, char**) {
+    init_ui();
+    UNITY_BEGIN();
+    RUN_TEST(test_detents_redraw_two_items_within_budget);
+    RUN_TEST(test_unchanged_text_redraws_nothing);
+    RUN_TEST(test_status_change_redraws_only_the_status_bar);
+    RUN_TEST(test_view_switches_are_reported);
+    return UNITY_END();
+}
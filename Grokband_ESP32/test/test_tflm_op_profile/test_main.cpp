@@ -0,0 +1,130 @@
+// The shipped model on TFLM built for the host (scripts/build_tflm_host.py), with the op resolver
+// the firmware generates for it and OpTimingProfiler attached the way TFLITE_OP_PROFILE attaches it
+// on the band. Prints the same OPPROF report, labelled "host", so the two can be diffed per layer:
+//   pio test -e native_tflm -v | tee host.log
+//   python scripts/op_profile_diff.py device.log host.log --label-a reference --label-b host
+// Ticks are nanoseconds here and CPU cycles on the band; compare the us column.
+// Also times resolver setup plus AllocateTensors() with the generated resolver against one with
+// every known op, the host side of scripts/resolver_size_check.py.
+#include <unity.h>
+#include "sign_model_ops.h" // Generated by scripts/gen_op_resolver.py from custom_sign_model
+#include "tflite_profiler.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "tensorflow/lite/version.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <vector>
+
+#ifndef TFLM_HOST_MODEL
+#define TFLM_HOST_MODEL "data/sign_model.tflite"
+#endif
+#ifndef TFLM_HOST_ARENA_BYTES
+#define TFLM_HOST_ARENA_BYTES (1024 * 1024) // Host pointers and structs are wider than on the band
+#endif
+#ifndef TFLM_HOST_RUNS
+#define TFLM_HOST_RUNS 3                    // Last one is reported, as in the TFLITE_ARENA_MEASURE runs
+#endif
+
+namespace {
+    std::vector<uint8_t> model_bytes;
+    alignas(16) uint8_t arena[TFLM_HOST_ARENA_BYTES];
+
+    double now_us() {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    bool read_model(const char* path, std::vector<uint8_t>* out) {
+        FILE* f = fopen(path, "rb");
+        if (!f) return false;
+        fseek(f, 0, SEEK_END);
+        const long len = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        out->resize(len > 0 ? (size_t)len : 0);
+        const bool ok = len > 0 && fread(out->data(), 1, out->size(), f) == out->size();
+        fclose(f);
+        return ok;
+    }
+
+    // Deterministic input, so host runs are comparable; per-op time doesn't depend on the values
+    void fill_input(TfLiteTensor* t) {
+        uint32_t noise = 12345;
+        auto next = [&noise] { return (uint8_t)((noise = noise * 1664525u + 1013904223u) >> 24); };
+        if (t->type == kTfLiteFloat32) {
+            for (size_t i = 0; i < t->bytes / sizeof(float); ++i) t->data.f[i] = next() / 255.0f;
+        } else {
+            for (size_t i = 0; i < t->bytes; ++i) t->data.uint8[i] = next();
+        }
+    }
+
+    const tflite::Model* load_model() {
+        if (model_bytes.empty() && !read_model(TFLM_HOST_MODEL, &model_bytes)) {
+            TEST_FAIL_MESSAGE("can't read " TFLM_HOST_MODEL " (custom_sign_model in platformio.ini)");
+        }
+        return tflite::GetModel(model_bytes.data());
+    }
+
+    // Best of a few runs of registration plus AllocateTensors() on a fresh interpreter, as tflite_init() does it
+    template <typename Resolver, typename Register>
+    double setup_us(const tflite::Model* model, Register register_ops) {
+        double best = 1e30;
+        for (int run = 0; run < 20; ++run) {
+            const double t0 = now_us();
+            Resolver resolver;
+            TEST_ASSERT_TRUE(register_ops(resolver));
+            tflite::MicroInterpreter interpreter(model, resolver, arena, sizeof(arena));
+            TEST_ASSERT_EQUAL_INT(kTfLiteOk, interpreter.AllocateTensors());
+            const double t = now_us() - t0;
+            best = t < best ? t : best;
+        }
+        return best;
+    }
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_host_op_profile() {
+    const tflite::Model* model = load_model();
+    TEST_ASSERT_EQUAL_INT(TFLITE_SCHEMA_VERSION, model->version());
+
+    static SignModelOpResolver resolver;
+    TEST_ASSERT_TRUE(sign_model_register_ops(resolver));
+    static OpTimingProfiler profiler;
+    tflite::MicroInterpreter interpreter(model, resolver, arena, sizeof(arena), nullptr, &profiler);
+    TEST_ASSERT_EQUAL_INT(kTfLiteOk, interpreter.AllocateTensors());
+
+    for (int run = 0; run < TFLM_HOST_RUNS; ++run) {
+        fill_input(interpreter.input(0));
+        profiler.reset();
+        TEST_ASSERT_EQUAL_INT(kTfLiteOk, interpreter.Invoke());
+    }
+    // One event per operator, in order, is what lets log_report() attach the shapes
+    TEST_ASSERT_EQUAL_INT((int)model->subgraphs()->Get(0)->operators()->size(), profiler.num_events());
+
+    char line[160];
+    snprintf(line, sizeof(line), "%s: %d ops, arena %u bytes used", TFLM_HOST_MODEL, profiler.num_events(),
+             (unsigned)interpreter.arena_used_bytes());
+    TEST_MESSAGE(line);
+    profiler.log_report("host", model);
+}
+
+void test_resolver_setup_time() {
+    const tflite::Model* model = load_model();
+    const double model_us = setup_us<SignModelOpResolver>(model, sign_model_register_ops);
+    const double all_us = setup_us<SignModelAllOpsResolver>(model, sign_model_register_all_ops);
+    TEST_ASSERT_TRUE(kSignModelOpCount <= kSignModelAllOpsCount);
+    char line[160];
+    snprintf(line, sizeof(line), "resolver + AllocateTensors() (host): %d model ops %.1f us, all %d ops %.1f us%s",
+             kSignModelOpCount, model_us, kSignModelAllOpsCount, all_us,
+             SIGN_MODEL_OPS_FROM_MODEL ? "" : " (built without the model: both register every op)");
+    TEST_MESSAGE(line);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_host_op_profile);
+    RUN_TEST(test_resolver_setup_time);
+    return UNITY_END();
+}
@@ -0,0 +1,152 @@
+// trace.cpp on the host: the CLOCK_MONOTONIC stand-in for the cycle counter, the histogram
+// summary, the ring wrapping before trace_collect() runs, and producers on several threads
+// racing the collector the way the pipeline tasks race loop() on target.
+//   pio test -e native -f test_trace
+#include <unity.h>
+#include "trace.h"
+
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+#include <time.h>
+#include <vector>
+
+namespace {
+    constexpr uint32_t kRing = 256;     // trace.cpp's kRingSize
+
+    // Drops whatever earlier tests left and starts an empty window
+    void new_window() {
+        char buf[512];
+        trace_format_summary(buf, sizeof(buf), "test", 0);
+    }
+
+    TraceStageSummary summary(TraceStage stage) {
+        TraceStageSummary s;
+        trace_get_summary(stage, &s);
+        return s;
+    }
+}
+
+void setUp() { new_window(); }
+void tearDown() {}
+
+void test_host_clock_counts_monotonic_ns() {
+    TEST_ASSERT_EQUAL_UINT32(1000, trace_ticks_per_us());
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    const uint32_t mono = (uint32_t)((uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec);
+    const uint32_t t0 = trace_begin();
+    TEST_ASSERT_LESS_THAN(1000000u, t0 - mono); // Same clock, read within a millisecond
+
+    uint32_t prev = t0;
+    for (int i = 0; i < 1000; ++i) {
+        const uint32_t t = trace_now();
+        TEST_ASSERT_TRUE((int32_t)(t - prev) >= 0);
+        prev = t;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    trace_end(TraceStage::INVOKE, t0);
+    trace_collect();
+    const TraceStageSummary s = summary(TraceStage::INVOKE);
+    TEST_ASSERT_EQUAL_UINT32(1, s.count);
+    TEST_ASSERT_GREATER_OR_EQUAL(5000, s.min_us);
+    TEST_ASSERT_LESS_THAN(200000, s.max_us);
+}
+
+void test_summary_percentiles_and_json() {
+    for (uint32_t us = 1; us <= 1000; ++us) {
+        trace_record_us(TraceStage::PREPROCESS, us);
+        if (us % 200 == 0) trace_collect();
+    }
+    trace_record_us(TraceStage::CAPTURE, 40000);
+    trace_collect();
+    const TraceStageSummary s = summary(TraceStage::PREPROCESS);
+    TEST_ASSERT_EQUAL_UINT32(1000, s.count);
+    TEST_ASSERT_EQUAL_UINT32(1, s.min_us);
+    TEST_ASSERT_EQUAL_UINT32(1000, s.max_us);
+    TEST_ASSERT_TRUE(s.total_us == 500500);
+    // Buckets are at most 25% wide
+    TEST_ASSERT_UINT32_WITHIN(125, 500, s.p50_us);
+    TEST_ASSERT_UINT32_WITHIN(250, 990, s.p99_us);
+
+    char buf[512];
+    TEST_ASSERT_GREATER_THAN(0, trace_format_summary(buf, sizeof(buf), "dev1", 5000));
+    TEST_ASSERT_NOT_NULL(strstr(buf, "\"dev\":\"dev1\""));
+    TEST_ASSERT_NOT_NULL(strstr(buf, "\"preprocess\":[1000,1,"));
+    TEST_ASSERT_NOT_NULL(strstr(buf, "\"capture\":[1,40000,"));
+    TEST_ASSERT_NULL(strstr(buf, "\"invoke\""));    // Stages without events are left out
+    TEST_ASSERT_EQUAL_UINT32(0, summary(TraceStage::PREPROCESS).count); // New window
+    TEST_ASSERT_EQUAL(0, (int)trace_format_summary(buf, 16, "dev1", 6000)); // Doesn't fit
+}
+
+// More events than the ring holds between two collects: the newest kRing are kept, the rest
+// are counted as dropped, and the ring keeps working across its wrap
+void test_ring_wrap_drops_oldest() {
+    for (uint32_t i = 0; i < kRing + 100; ++i) trace_record_us(TraceStage::FRAME, i < 100 ? 1 : 7);
+    trace_collect();
+    TraceStageSummary s = summary(TraceStage::FRAME);
+    TEST_ASSERT_EQUAL_UINT32(kRing, s.count);
+    TEST_ASSERT_EQUAL_UINT32(100, trace_dropped());
+    TEST_ASSERT_EQUAL_UINT32(7, s.min_us);   // Only the overwritten ones were lost
+
+    for (int lap = 0; lap < 5; ++lap) {
+        for (uint32_t i = 0; i < kRing - 1; ++i) trace_record_us(TraceStage::FRAME, 3);
+        trace_collect();
+    }
+    s = summary(TraceStage::FRAME);
+    TEST_ASSERT_EQUAL_UINT32(kRing + 5 * (kRing - 1), s.count);
+    TEST_ASSERT_EQUAL_UINT32(100, trace_dropped());
+}
+
+// Producers on two threads, the collector on a third: every event is either recorded intact
+// or counted as dropped, never torn or recorded twice. The producers pause every 64 events, as
+// the pipeline stages do between frames; flat out they lap the collector and nearly all drop.
+void test_concurrent_producers_and_collector() {
+    constexpr uint32_t kPerWriter = 200000;
+    std::atomic<bool> done{false};
+    auto writer = [](TraceStage stage, uint32_t lo) {
+        for (uint32_t i = 0; i < kPerWriter; ++i) {
+            trace_record_us(stage, lo + (i & 63));
+            if ((i & 63) == 63) std::this_thread::sleep_for(std::chrono::microseconds(20));
+        }
+    };
+    std::thread collector([&] {
+        while (!done) trace_collect();
+    });
+    std::thread a(writer, TraceStage::CAPTURE, 1000);
+    std::thread b(writer, TraceStage::INVOKE, 5000);
+    a.join();
+    b.join();
+    done = true;
+    collector.join();
+    trace_collect();
+
+    const TraceStageSummary capture = summary(TraceStage::CAPTURE);
+    const TraceStageSummary invoke = summary(TraceStage::INVOKE);
+    char line[128];
+    snprintf(line, sizeof(line), "%u + %u recorded, %u dropped of %u", (unsigned)capture.count, (unsigned)invoke.count,
+             (unsigned)trace_dropped(), (unsigned)(2 * kPerWriter));
+    TEST_MESSAGE(line);
+    TEST_ASSERT_EQUAL_UINT32(2 * kPerWriter, capture.count + invoke.count + trace_dropped());
+    TEST_ASSERT_GREATER_THAN(kPerWriter / 2, capture.count);
+    TEST_ASSERT_GREATER_THAN(kPerWriter / 2, invoke.count);
+    // A torn slot would mix one writer's stage with the other's duration
+    TEST_ASSERT_GREATER_OR_EQUAL(1000, capture.min_us);
+    TEST_ASSERT_LESS_OR_EQUAL(1063, capture.max_us);
+    TEST_ASSERT_GREATER_OR_EQUAL(5000, invoke.min_us);
+    TEST_ASSERT_LESS_OR_EQUAL(5063, invoke.max_us);
+    for (int i = 0; i < (int)TraceStage::COUNT; ++i) {
+        if (i != (int)TraceStage::CAPTURE && i != (int)TraceStage::INVOKE) TEST_ASSERT_EQUAL_UINT32(0, summary((TraceStage)i).count);
+    }
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_host_clock_counts_monotonic_ns);
+    RUN_TEST(test_summary_percentiles_and_json);
+    RUN_TEST(test_ring_wrap_drops_oldest);
+    RUN_TEST(test_concurrent_producers_and_collector);
+    return UNITY_END();
+}
@@ -0,0 +1,242 @@
+"""Persistent phrase audio cache for text-to-speech.
+
+Grokcom speaks from a closed vocabulary (sign labels and quick responses, see config.py), so
+each phrase is synthesized once and kept on disk as raw 16-bit mono PCM at config.AUDIO_RATE.
+Entries are content-addressed: the file name is a hash of everything that changes the audio
+(text, language, voice, sample rate), so a voice change never serves stale audio and nothing
+needs invalidating. Hits are served from memory-mapped files; only misses reach the synthesizer.
+
+    <cache dir>/ab/ab12...ef.pcm    16-byte header (magic, PCM length, CRC-32), then the PCM
+
+The header is checked when an entry is first mapped; an entry that fails (bit rot, a file
+from an older format, truncation outside our own atomic writes) is deleted and counts as a
+miss, so it is synthesized again. With max_bytes set, storing an entry evicts the least
+recently used ones (by file mtime, refreshed when an entry is mapped) until the cache fits.
+"""
+import hashlib
+import logging
+import math
+import mmap
+import os
+import struct
+import tempfile
+import threading
+import time
+import zlib
+
+logger = logging.getLogger(__name__)
+
+SAMPLE_WIDTH = 2  # Bytes per sample, int16 little-endian mono
+HEADER = struct.Struct("<4sQI")  # magic, PCM bytes, CRC-32 of the PCM
+MAGIC = b"GPCM"
+
+
+def phrase_key(text, language, voice, rate):
+    ident = "\0".join((text, language or "", voice or "", str(rate)))
+    return hashlib.sha256(ident.encode("utf-8")).hexdigest()
+
+
+class StubSynthesizer:
+    """Local stand-in for the cloud synthesizer: a short tone per word, plus a fixed delay
+    so cache misses still cost something measurable. For testing without credentials."""
+
+    def __init__(self, rate, delay_ms=300):
+        self.rate = rate
+        self.delay_ms = delay_ms
+        self.calls = 0
+
+    def synthesize(self, text):
+        self.calls += 1
+        time.sleep(self.delay_ms / 1000.0)
+        out = bytearray()
+        for i, word in enumerate(text.split() or [""]):
+            freq = 300 + (sum(word.encode("utf-8")) % 40) * 10
+            n = self.rate // 8
+            out += b"".join(struct.pack("<h", int(8000 * math.sin(2 * math.pi * freq * t / self.rate)))
+                            for t in range(n))
+            out += bytes(SAMPLE_WIDTH * (self.rate // 40))  # Gap between words
+        return bytes(out)
+
+
+class PhraseAudioCache:
+    """Content-addressed PCM store. get() returns a read-only buffer of the phrase's samples.
+    max_bytes bounds the files on disk (None: unbounded)."""
+
+    def __init__(self, directory, language, voice, rate, max_bytes=None):
+        self.directory = directory
+        self.language = language
+        self.voice = voice
+        self.rate = rate
+        self.max_bytes = max_bytes
+        self.maps = {}      # key -> (mmap, PCM view), opened on first use and kept until evicted
+        self.lock = threading.Lock()
+        self.hits = 0
+        self.misses = 0
+        self.corrupt = 0
+        self.evicted = 0
+        self.synth_ms = 0.0
+        os.makedirs(directory, exist_ok=True)
+
+    def _path(self, key):
+        return os.path.join(self.directory, key[:2], key + ".pcm")
+
+    def _open(self, key):
+        # Caller holds the lock
+        entry = self.maps.get(key)
+        if entry is not None:
+            return entry[1]
+        path = self._path(key)
+        try:
+            with open(path, "rb") as f:
+                size = os.fstat(f.fileno()).st_size
+                mm = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ) if size else None
+        except FileNotFoundError:
+            return None
+        if mm is None or not self._valid(mm):
+            if mm is not None:
+                mm.close()
+            logger.warning(f"TTS cache: dropping corrupted entry {path}")
+            self.corrupt += 1
+            self._remove(path)
+            return None
+        os.utime(path)  # Recently used, for eviction
+        view = memoryview(mm)[HEADER.size:]
+        self.maps[key] = (mm, view)
+        return view
+
+    @staticmethod
+    def _valid(mm):
+        if len(mm) < HEADER.size:
+            return False
+        magic, length, crc = HEADER.unpack_from(mm, 0)
+        return (magic == MAGIC and length == len(mm) - HEADER.size and length % SAMPLE_WIDTH == 0
+                and zlib.crc32(memoryview(mm)[HEADER.size:]) == crc)
+
+    @staticmethod
+    def _remove(path):
+        try:
+            os.unlink(path)
+        except FileNotFoundError:
+            pass
+
+    def _store(self, key, pcm):
+        # Written to a temp file and renamed, so a crash never leaves a truncated entry
+        path = self._path(key)
+        os.makedirs(os.path.dirname(path), exist_ok=True)
+        fd, tmp = tempfile.mkstemp(dir=os.path.dirname(path), suffix=".tmp")
+        try:
+            with os.fdopen(fd, "wb") as f:
+                f.write(HEADER.pack(MAGIC, len(pcm), zlib.crc32(pcm)))
+                f.write(pcm)
+            os.replace(tmp, path)
+        except BaseException:
+            os.unlink(tmp)
+            raise
+        if self.max_bytes is not None:
+            with self.lock:
+                self._evict(keep=path)
+
+    def _evict(self, keep):
+        # Caller holds the lock. Oldest mtime first; a mapped entry that goes stays valid for
+        # whoever holds its buffer, it just isn't served from the map again.
+        entries = []
+        for sub in os.scandir(self.directory):
+            if not sub.is_dir():
+                continue
+            for e in os.scandir(sub.path):
+                if e.name.endswith(".pcm"):
+                    st = e.stat()
+                    entries.append((st.st_mtime_ns, st.st_size, e.path))
+        total = sum(size for _, size, _ in entries)
+        for _, size, path in sorted(entries):
+            if total <= self.max_bytes:
+                break
+            if path == keep:
+                continue
+            self._remove(path)
+            self.maps.pop(os.path.basename(path)[:-4], None)
+            self.evicted += 1
+            total -= size
+
+    def contains(self, text):
+        key = phrase_key(text, self.language, self.voice, self.rate)
+        with self.lock:
+            return self._open(key) is not None
+
+    def get(self, text, synthesize=None):
+        """PCM for text, or None on a miss when no synthesize(text) -> bytes is given.
+        On a miss with a synthesizer the result is stored before it is returned."""
+        key = phrase_key(text, self.language, self.voice, self.rate)
+        with self.lock:
+            mm = self._open(key)
+            if mm is not None:
+                self.hits += 1
+                return mm
+            self.misses += 1
+        if synthesize is None:
+            return None
+        start = time.monotonic()
+        pcm = synthesize(text)
+        with self.lock:
+            self.synth_ms += (time.monotonic() - start) * 1000.0
+        if not pcm:
+            return None
+        self._store(key, pcm)
+        with self.lock:
+            return self._open(key) or pcm
+
+    def warm(self, phrases, synthesize):
+        """Synthesizes every phrase not on disk yet. Returns how many were synthesized."""
+        added = 0
+        for text in phrases:
+            if self.contains(text):
+                continue
+            try:
+                start = time.monotonic()
+                pcm = synthesize(text)
+                with self.lock:
+                    self.synth_ms += (time.monotonic() - start) * 1000.0
+            except Exception as e:
+                logger.warning(f"Pre-warm failed for '{text}': {e}")
+                continue
+            if pcm:
+                self._store(phrase_key(text, self.language, self.voice, self.rate), pcm)
+                added += 1
+        return added
+
+    def stats(self):
+        with self.lock:
+            lookups = self.hits + self.misses
+            return {"hits": self.hits, "misses": self.misses,
+                    "hit_rate": self.hits / lookups if lookups else 0.0,
+                    "synth_ms": round(self.synth_ms, 1), "mapped": len(self.maps),
+                    "corrupt": self.corrupt, "evicted": self.evicted}
+
+    def close(self):
+        with self.lock:
+            for mm, view in self.maps.values():
+                view.release()
+                try:
+                    mm.close()
+                except BufferError:
+                    pass  # A caller still holds a slice of it; freed when that goes
+            self.maps.clear()
+
+
+if __name__ == '__main__':
+    # Self-check against the stub synthesizer: a cold miss, then hits from the mapped file
+    logging.basicConfig(level=logging.INFO)
+    with tempfile.TemporaryDirectory() as d:
+        synth = StubSynthesizer(16000, delay_ms=200)
+        cache = PhraseAudioCache(d, "en-US", None, 16000)
+        print(f"Pre-warmed {cache.warm(['Received sign: Hello', 'Quick response: Yes'], synth.synthesize)} phrases")
+        for text in ("Received sign: Hello", "Received sign: Hello", "Received sign: Goodbye", "Received sign: Goodbye"):
+            start = time.monotonic()
+            pcm = cache.get(text, synth.synthesize)
+            print(f"{text!r}: {len(pcm)} bytes in {(time.monotonic() - start) * 1000.0:.2f} ms")
+        cache.close()
+        reopened = PhraseAudioCache(d, "en-US", None, 16000)
+        assert reopened.get("Received sign: Goodbye") is not None, "entry did not persist"
+        assert PhraseAudioCache(d, "en-US", "en-US-Wavenet-D", 16000).get("Received sign: Goodbye") is None
+        print(f"Stats: {cache.stats()}, synthesizer calls: {synth.calls}")
+        reopened.close()
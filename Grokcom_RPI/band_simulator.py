@@ -0,0 +1,117 @@
+"""Host stand-in for a Grokband: publishes sign frames and latency stamps the way the firmware
+does, and answers time-sync pings, so the sign-to-speech path can be measured on one Linux box.
+
+Frames are encoded by wire.py, i.e. by the firmware's own codec when the native module is built.
+The band clock is this host's monotonic clock plus a fixed offset and a drift, so ClockSync has
+something real to estimate. Capture->inference and inference->publish delays are drawn from
+gamma distributions around the given means.
+
+    python3 band_simulator.py --count 100 --interval-ms 300
+"""
+import argparse
+import json
+import logging
+import random
+import threading
+import time
+
+import paho.mqtt.client as mqtt
+
+import wire
+from latency import now_ms
+
+try:
+    import config
+    DEFAULT_BROKER, DEFAULT_PORT = config.MQTT_BROKER_IP, config.MQTT_BROKER_PORT
+    TOPIC_SIGN, TOPIC_LATENCY = config.MQTT_TOPIC_SIGN_TO_TEXT, config.MQTT_TOPIC_LATENCY
+    TOPIC_PING, TOPIC_PONG = config.MQTT_TOPIC_TIMESYNC_PING, config.MQTT_TOPIC_TIMESYNC_PONG
+    NUM_CLASSES = len(config.SIGN_CLASS_LABELS)
+except Exception:  # config.py needs the audio stack; the simulator doesn't
+    DEFAULT_BROKER, DEFAULT_PORT = "localhost", 1883
+    TOPIC_SIGN, TOPIC_LATENCY = "grokware/grokband/sign_to_text", "grokware/grokband/latency"
+    TOPIC_PING, TOPIC_PONG = "grokware/grokcom/timesync", "grokware/grokband/timesync"
+    NUM_CLASSES = 10
+
+logger = logging.getLogger(__name__)
+
+
+class SimulatedBand:
+    def __init__(self, client, client_id, offset_ms, drift_ppm, rng):
+        self.client = client
+        self.dev = wire.device_id(client_id)
+        self.offset_ms = offset_ms
+        self.drift = drift_ppm * 1e-6
+        self.start = now_ms()
+        self.seq = 0
+        self.rng = rng
+        self.lock = threading.Lock()   # paho's network thread and the sign loop both publish
+
+    def band_ms(self):
+        # Whole milliseconds, like millis() on the band
+        t = now_ms()
+        return int(t + self.offset_ms + (t - self.start) * self.drift) & 0xFFFFFFFF
+
+    def on_ping(self, payload):
+        t1 = self.band_ms()
+        try:  # Like the firmware, echo only the parsed id and t0
+            ping = json.loads(payload)
+            ping_id, t0 = int(ping["id"]), float(ping["t0"])
+        except (ValueError, KeyError, TypeError):
+            return
+        reply = '{"dev_id":%u,"t1":%u,"ping":{"id":%u,"t0":%.3f}}' % (self.dev, t1, ping_id, t0)
+        with self.lock:
+            self.client.publish(TOPIC_PONG, reply)
+
+    def sign(self, infer_ms, publish_ms):
+        capture = self.band_ms()
+        time.sleep(self.rng.gammavariate(4.0, infer_ms / 4.0) / 1000.0)
+        infer = self.band_ms()
+        time.sleep(self.rng.gammavariate(2.0, publish_ms / 2.0) / 1000.0)
+        record = (self.rng.randrange(NUM_CLASSES), self.rng.uniform(0.6, 1.0), 0, capture)
+        with self.lock:
+            seq = self.seq
+            self.seq = (self.seq + 1) & 0xFFFF
+            frame = wire.encode(wire.TYPE_SIGN, seq, self.dev, [record])
+            self.client.publish(TOPIC_SIGN, frame)
+            publish = self.band_ms()
+            self.client.publish(TOPIC_LATENCY, json.dumps(
+                {"dev_id": self.dev, "seq": seq, "capture": capture, "infer": infer, "publish": publish}))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--broker", default=DEFAULT_BROKER)
+    parser.add_argument("--port", type=int, default=DEFAULT_PORT)
+    parser.add_argument("--client-id", default="grokband_sim")
+    parser.add_argument("--count", type=int, default=50, help="signs to publish")
+    parser.add_argument("--interval-ms", type=float, default=500)
+    parser.add_argument("--warmup-s", type=float, default=2.0, help="answer pings this long before the first sign")
+    parser.add_argument("--infer-ms", type=float, default=70, help="mean capture->inference time")
+    parser.add_argument("--publish-ms", type=float, default=3, help="mean inference->publish time")
+    parser.add_argument("--offset-ms", type=float, default=None, help="band clock offset (default: random)")
+    parser.add_argument("--drift-ppm", type=float, default=40)
+    parser.add_argument("--seed", type=int, default=None)
+    args = parser.parse_args()
+    logging.basicConfig(level=logging.INFO, format="%(asctime)s - %(name)s - %(levelname)s - %(message)s")
+
+    rng = random.Random(args.seed)
+    offset = args.offset_ms if args.offset_ms is not None else rng.uniform(-1e6, 1e6)
+    client = mqtt.Client(client_id=args.client_id)
+    band = SimulatedBand(client, args.client_id, offset, args.drift_ppm, rng)
+    client.on_connect = lambda c, u, f, rc: c.subscribe(TOPIC_PING)
+    client.on_message = lambda c, u, msg: band.on_ping(msg.payload)
+    client.connect(args.broker, args.port, 60)
+    client.loop_start()
+
+    logger.info(f"Simulated band {band.dev:08x}, clock offset {offset:.0f} ms, drift {args.drift_ppm} ppm")
+    time.sleep(args.warmup_s)
+    for _ in range(args.count):
+        band.sign(args.infer_ms, args.publish_ms)
+        time.sleep(args.interval_ms / 1000.0)
+    time.sleep(1.0)  # Let the last stamps out before disconnecting
+    client.loop_stop()
+    client.disconnect()
+
+
+if __name__ == "__main__":
+    main()
@@ -1,3 +1,5 @@
+import os
+
 # MQTT Configuration
 MQTT_BROKER_IP = "localhost"  # Or the IP of your RPi if broker is on another machine
 MQTT_BROKER_PORT = 1883
@@ -7,6 +9,20 @@ MQTT_CLIENT_ID_GROKCOM = "grokcom_rpi"
 MQTT_TOPIC_SIGN_TO_TEXT = "grokware/grokband/sign_to_text" # Grokcom subscribes
 MQTT_TOPIC_SPEECH_TO_TEXT = "grokware/grokcom/speech_to_text" # Grokcom publishes
 MQTT_TOPIC_QUICK_RESPONSE = "grokware/grokband/quick_response" # Grokcom subscribes
+MQTT_TOPIC_TELEMETRY = "grokware/grokband/telemetry" # Per-stage latency summaries, see telemetry_monitor.py
+MQTT_TOPIC_LATENCY = "grokware/grokband/latency" # Band-side stamps per sign frame, see latency.py
+MQTT_TOPIC_TIMESYNC_PING = "grokware/grokcom/timesync" # Grokcom publishes, bands echo with their clock
+MQTT_TOPIC_TIMESYNC_PONG = "grokware/grokband/timesync" # Grokcom subscribes
+TIMESYNC_INTERVAL_S = 5
+LATENCY_LOG = None # Path to append completed sign-to-speech latency records to (latency_report.py)
+
+# Binary frames from Grokband carry class IDs, not text (wire.py). These tables must match the
+# firmware: class_labels in sign_language_model.cpp and quick_responses in config.h.
+SIGN_CLASS_LABELS = ["Sign A", "Sign B", "Sign C", "Help", "Yes", "No", "Hello", "Goodbye", "Thank You", "Eat"]
+QUICK_RESPONSES = ["Yes", "No", "Okay", "Thank You", "Hello"]
+# What Grokcom says for each; with the tables above this is the phrase vocabulary the TTS cache pre-warms
+SIGN_SPEECH_TEMPLATE = "Received sign: {}"
+QUICK_RESPONSE_SPEECH_TEMPLATE = "Quick response: {}"
 
 # Google Cloud Credentials
 # IMPORTANT: Set the GOOGLE_APPLICATION_CREDENTIALS environment variable
@@ -15,6 +31,12 @@ MQTT_TOPIC_QUICK_RESPONSE = "grokware/grokband/quick_response" # Grokcom subscri
 GOOGLE_TTS_LANGUAGE_CODE = "en-US"
 GOOGLE_STT_LANGUAGE_CODE = "en-US"
 
+# Text-to-speech phrase cache (audio_cache.py)
+TTS_SYNTHESIZER = "google" # "stub" synthesizes local tones, for testing without cloud credentials
+TTS_CACHE_DIR = os.path.expanduser("~/.cache/grokcom/tts")
+TTS_CACHE_MAX_MB = 64 # Least recently used phrases are evicted past this; the vocabulary is a few MB
+TTS_PREWARM = True # Synthesize the whole sign/quick-response vocabulary at startup
+
 # Audio settings
 AUDIO_CHUNK_SIZE = 1024
 AUDIO_FORMAT = pyaudio.paInt16 # Corresponds to 16-bit samples
@@ -0,0 +1,122 @@
+"""End-to-end sign-to-speech latency accounting.
+
+Each recognized sign is stamped at six points, all converted to this host's monotonic clock (ms):
+    capture, infer, publish       on the band, sent on MQTT_TOPIC_LATENCY after the sign frame
+    receive, synth_start, playback_start   here, by handle_mqtt_message() and the TTS engine
+Band stamps are on the band's own millisecond clock. ClockSync estimates the offset with
+NTP-style pings: we publish {"id", "t0"} on MQTT_TOPIC_TIMESYNC_PING, the band echoes it with
+its clock reading t1, and the reply arrives at t2. offset = t1 - (t0 + t2) / 2, taken from the
+lowest-RTT recent sample, which is the one least skewed by queueing.
+
+LatencyRecorder joins the stamps by (device_id, seq) and appends one JSON object per completed
+sign to a log that latency_report.py turns into per-stage histograms. In memory it keeps only a
+count and the most recent records, so it can run for the life of the service.
+"""
+import collections
+import json
+import logging
+import threading
+import time
+
+logger = logging.getLogger(__name__)
+
+STAGES = ("capture", "infer", "publish", "receive", "synth_start", "playback_start")
+BAND_STAGES = STAGES[:3]
+
+
+def now_ms():
+    return time.monotonic() * 1000.0
+
+
+class ClockSync:
+    """Per-device band-clock offset from ping/pong exchanges."""
+
+    def __init__(self, window=8):
+        self.window = window
+        self.samples = {}  # device_id -> [(rtt_ms, offset_ms)]
+        self.next_id = 0
+        self.lock = threading.Lock()
+
+    def make_ping(self):
+        self.next_id += 1
+        return json.dumps({"id": self.next_id, "t0": now_ms()})
+
+    def on_reply(self, payload):
+        """Handles a band reply: {"dev_id": N, "t1": band_ms, "ping": <our ping>}"""
+        t2 = now_ms()
+        try:
+            msg = json.loads(payload)
+            dev, t1, t0 = int(msg["dev_id"]), float(msg["t1"]), float(msg["ping"]["t0"])
+        except (ValueError, KeyError, TypeError) as e:
+            logger.warning(f"Malformed timesync reply: {e}")
+            return
+        rtt = t2 - t0
+        with self.lock:
+            samples = self.samples.setdefault(dev, [])
+            samples.append((rtt, t1 - (t0 + t2) / 2.0))
+            del samples[:-self.window]
+
+    def offset(self, dev):
+        """(offset_ms, rtt_ms) of the best recent sample, or None before the first reply."""
+        with self.lock:
+            samples = self.samples.get(dev)
+            if not samples:
+                return None
+            rtt, offset = min(samples)
+            return offset, rtt
+
+    def to_host_ms(self, dev, band_ms):
+        best = self.offset(dev)
+        return None if best is None else band_ms - best[0]
+
+
+class LatencyRecorder:
+    """Joins band and host stamps per sign and logs the completed ones."""
+
+    def __init__(self, clock, path=None, max_pending=256, max_recent=256):
+        self.clock = clock
+        self.path = path
+        self.max_pending = max_pending
+        self.pending = {}   # (device_id, seq) -> {stage: host_ms}
+        self.recent = collections.deque(maxlen=max_recent)  # Latest completed records; the log has them all
+        self.completed_count = 0
+        self.lock = threading.Lock()
+
+    def mark(self, dev, seq, stage, t=None):
+        self._merge((dev, seq), {stage: now_ms() if t is None else t})
+
+    def on_band_stamps(self, payload):
+        """Handles {"dev_id": N, "seq": S, "capture": ms, "infer": ms, "publish": ms} from the band."""
+        try:
+            msg = json.loads(payload)
+            dev, seq = int(msg["dev_id"]), int(msg["seq"])
+            band = {stage: float(msg[stage]) for stage in BAND_STAGES}
+        except (ValueError, KeyError, TypeError) as e:
+            logger.warning(f"Malformed latency stamps: {e}")
+            return
+        offset = self.clock.offset(dev)
+        if offset is None:
+            logger.warning(f"No clock offset for device {dev:08x} yet; dropping stamps for seq {seq}")
+            return
+        self._merge((dev, seq), {stage: t - offset[0] for stage, t in band.items()}, rtt=offset[1])
+
+    def _merge(self, key, stamps, rtt=None):
+        with self.lock:
+            entry = self.pending.setdefault(key, {})
+            entry.update(stamps)
+            if rtt is not None:
+                entry["_rtt"] = rtt
+            if all(stage in entry for stage in STAGES):
+                del self.pending[key]
+                self._complete(key, entry)
+            elif len(self.pending) > self.max_pending:
+                self.pending.pop(next(iter(self.pending)))  # Oldest; its other half never came
+
+    def _complete(self, key, entry):
+        record = {"dev": key[0], "seq": key[1], "rtt_ms": round(entry.get("_rtt", 0.0), 3),
+                  "stamps": {stage: round(entry[stage], 3) for stage in STAGES}}
+        self.recent.append(record)
+        self.completed_count += 1
+        if self.path:
+            with open(self.path, "a") as f:
+                f.write(json.dumps(record) + "\n")
@@ -0,0 +1,129 @@
+"""Sign-to-speech latency run on one Linux box: local broker, simulated band, stubbed TTS.
+
+Starts band_simulator.py, receives its frames the way GrokcomApp.handle_mqtt_message() does
+(minus the Qt UI), "speaks" them with a TTS stub that only sleeps for the configured synthesis
+and audio-start times, logs every completed sign (latency.py), and ends with latency_report.py's
+report. With --gate-p95-ms the exit status is the release gate.
+
+    mosquitto -d
+    python3 latency_harness.py --count 200 --gate-p95-ms 600
+"""
+import argparse
+import logging
+import os
+import random
+import subprocess
+import sys
+import threading
+import time
+
+import paho.mqtt.client as mqtt
+
+import latency_report
+import wire
+from latency import ClockSync, LatencyRecorder, now_ms
+
+try:
+    import config
+    DEFAULT_BROKER, DEFAULT_PORT = config.MQTT_BROKER_IP, config.MQTT_BROKER_PORT
+    TOPIC_SIGN, TOPIC_LATENCY = config.MQTT_TOPIC_SIGN_TO_TEXT, config.MQTT_TOPIC_LATENCY
+    TOPIC_PING, TOPIC_PONG = config.MQTT_TOPIC_TIMESYNC_PING, config.MQTT_TOPIC_TIMESYNC_PONG
+except Exception:  # config.py needs the audio stack; the harness doesn't
+    DEFAULT_BROKER, DEFAULT_PORT = "localhost", 1883
+    TOPIC_SIGN, TOPIC_LATENCY = "grokware/grokband/sign_to_text", "grokware/grokband/latency"
+    TOPIC_PING, TOPIC_PONG = "grokware/grokcom/timesync", "grokware/grokband/timesync"
+
+logger = logging.getLogger(__name__)
+
+
+class StubTextToSpeechEngine:
+    """Same speak() contract as TextToSpeechEngine, without the cloud call or the audio device."""
+
+    def __init__(self, synth_ms, start_ms, rng):
+        self.synth_ms = synth_ms
+        self.start_ms = start_ms
+        self.rng = rng
+
+    def speak(self, text, stamp=None):
+        if stamp:
+            stamp("synth_start")
+        time.sleep(self.rng.gammavariate(4.0, self.synth_ms / 4.0) / 1000.0)
+        time.sleep(self.rng.gammavariate(2.0, self.start_ms / 2.0) / 1000.0)
+        if stamp:
+            stamp("playback_start")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--broker", default=DEFAULT_BROKER)
+    parser.add_argument("--port", type=int, default=DEFAULT_PORT)
+    parser.add_argument("--count", type=int, default=50)
+    parser.add_argument("--interval-ms", type=float, default=500)
+    parser.add_argument("--synth-ms", type=float, default=150, help="mean stub synthesis time")
+    parser.add_argument("--audio-start-ms", type=float, default=20, help="mean stub time from audio to playback start")
+    parser.add_argument("--log", default="latency.jsonl")
+    parser.add_argument("--gate-p95-ms", type=float)
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--no-simulator", action="store_true", help="measure a real band instead")
+    args, sim_args = parser.parse_known_args()
+    logging.basicConfig(level=logging.INFO, format="%(asctime)s - %(name)s - %(levelname)s - %(message)s")
+
+    if os.path.exists(args.log):
+        os.remove(args.log)
+    clock = ClockSync()
+    recorder = LatencyRecorder(clock, args.log)
+    tts = StubTextToSpeechEngine(args.synth_ms, args.audio_start_ms, random.Random(args.seed))
+
+    def on_message(client, userdata, msg):
+        received = now_ms()
+        if msg.topic == TOPIC_PONG:
+            clock.on_reply(msg.payload)
+        elif msg.topic == TOPIC_LATENCY:
+            recorder.on_band_stamps(msg.payload)
+        elif msg.topic == TOPIC_SIGN:
+            frame = wire.parse_payload(msg.payload)
+            if not isinstance(frame, wire.WireFrame):
+                return
+            recorder.mark(frame.device_id, frame.seq, "receive", received)
+            tts.speak("sign", stamp=lambda stage: recorder.mark(frame.device_id, frame.seq, stage))
+
+    client = mqtt.Client(client_id="grokcom_latency_harness")
+    client.on_connect = lambda c, u, f, rc: [c.subscribe(t) for t in (TOPIC_SIGN, TOPIC_LATENCY, TOPIC_PONG)]
+    client.on_message = on_message
+    client.connect(args.broker, args.port, 60)
+    client.loop_start()
+
+    stop = threading.Event()
+
+    def ping_loop():
+        while not stop.wait(0.5):
+            client.publish(TOPIC_PING, clock.make_ping())
+    threading.Thread(target=ping_loop, daemon=True).start()
+
+    sim = None
+    if not args.no_simulator:
+        here = os.path.dirname(os.path.abspath(__file__))
+        sim = subprocess.Popen([sys.executable, os.path.join(here, "band_simulator.py"), "--broker", args.broker,
+                                "--port", str(args.port), "--count", str(args.count),
+                                "--interval-ms", str(args.interval_ms), "--seed", str(args.seed)] + sim_args)
+
+    deadline = time.monotonic() + 10 + args.count * (args.interval_ms + args.synth_ms + 500) / 1000.0
+    while recorder.completed_count < args.count and time.monotonic() < deadline:
+        if sim and sim.poll() is not None and recorder.completed_count < args.count:
+            time.sleep(2.0)  # Simulator done; give the last signs time to complete
+            break
+        time.sleep(0.2)
+    stop.set()
+    client.loop_stop()
+    client.disconnect()
+    if sim:
+        sim.wait(timeout=10)
+
+    logger.info(f"{recorder.completed_count}/{args.count} signs completed, {len(recorder.pending)} incomplete")
+    report_args = [args.log] + (["--gate-p95-ms", str(args.gate_p95_ms)] if args.gate_p95_ms is not None else [])
+    sys.argv = ["latency_report.py"] + report_args
+    return latency_report.main()
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,100 @@
+"""Per-stage latency report from a LatencyRecorder log (latency.py), with an optional p95 gate.
+
+    python3 latency_report.py latency.jsonl
+    python3 latency_report.py latency.jsonl --gate-p95-ms 600   # exit 1 if end-to-end p95 is over
+"""
+import argparse
+import json
+import math
+import sys
+
+from latency import STAGES
+
+# Consecutive stage pairs, then the whole path
+SPANS = [(STAGES[i], STAGES[i + 1]) for i in range(len(STAGES) - 1)] + [(STAGES[0], STAGES[-1])]
+BUCKETS_MS = (5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000)
+
+
+def span_name(span):
+    return "end_to_end" if span == SPANS[-1] else f"{span[0]}->{span[1]}"
+
+
+def percentile(sorted_values, p):
+    if not sorted_values:
+        return float("nan")
+    k = max(0, min(len(sorted_values) - 1, math.ceil(p / 100.0 * len(sorted_values)) - 1))
+    return sorted_values[k]
+
+
+def load(path):
+    records = []
+    with open(path) as f:
+        for line in f:
+            line = line.strip()
+            if line:
+                records.append(json.loads(line))
+    return records
+
+
+def span_values(records):
+    values = {span: [] for span in SPANS}
+    for r in records:
+        s = r["stamps"]
+        for span in SPANS:
+            values[span].append(s[span[1]] - s[span[0]])
+    return {span: sorted(v) for span, v in values.items()}
+
+
+def histogram(values):
+    counts = [0] * (len(BUCKETS_MS) + 1)
+    for v in values:
+        i = 0
+        while i < len(BUCKETS_MS) and v > BUCKETS_MS[i]:
+            i += 1
+        counts[i] += 1
+    return counts
+
+
+def render(records, values, out=sys.stdout):
+    out.write(f"{len(records)} signs, median clock-sync RTT "
+              f"{percentile(sorted(r['rtt_ms'] for r in records), 50):.1f} ms\n\n")
+    out.write(f"{'span':<28}{'min':>8}{'p50':>8}{'p95':>8}{'p99':>8}{'max':>8}   (ms)\n")
+    for span in SPANS:
+        v = values[span]
+        out.write(f"{span_name(span):<28}{v[0]:>8.1f}{percentile(v, 50):>8.1f}{percentile(v, 95):>8.1f}"
+                  f"{percentile(v, 99):>8.1f}{v[-1]:>8.1f}\n")
+
+    labels = [f"<={b}" for b in BUCKETS_MS] + [f">{BUCKETS_MS[-1]}"]
+    for span in SPANS:
+        counts = histogram(values[span])
+        peak = max(counts) or 1
+        out.write(f"\n{span_name(span)}\n")
+        for label, n in zip(labels, counts):
+            if n:
+                out.write(f"  {label:>7} ms {n:>6}  {'#' * max(1, round(40 * n / peak))}\n")
+    out.flush()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("log", help="JSON lines written by LatencyRecorder")
+    parser.add_argument("--gate-p95-ms", type=float, help="fail if end-to-end p95 exceeds this")
+    args = parser.parse_args()
+
+    records = load(args.log)
+    if not records:
+        print("No completed signs in the log")
+        return 1
+    values = span_values(records)
+    render(records, values)
+
+    if args.gate_p95_ms is not None:
+        p95 = percentile(values[SPANS[-1]], 95)
+        verdict = "PASS" if p95 <= args.gate_p95_ms else "FAIL"
+        print(f"\nend-to-end p95 {p95:.1f} ms vs gate {args.gate_p95_ms:.1f} ms: {verdict}")
+        return 0 if verdict == "PASS" else 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
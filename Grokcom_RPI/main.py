@@ -8,6 +8,8 @@ from ui_grokcom import GrokcomUI
 from mqtt_client import MQTTClient
 from speech_to_text import SpeechToTextEngine
 from text_to_speech import TextToSpeechEngine
+import wire
+from latency import ClockSync, LatencyRecorder, now_ms
 
 # Configure logging
 logging.basicConfig(
@@ -48,11 +50,21 @@ class GrokcomApp(QObject):
         self.ui_clear_interim_transcript_signal.connect(self.ui.clear_interim_transcript)
         
         self.last_final_transcript = ""
+        self.wire_seq = wire.SequenceTracker()
+
+        # Sign-to-speech latency (latency.py): band clock offsets and per-sign stamps
+        self.clock_sync = ClockSync()
+        self.latency = LatencyRecorder(self.clock_sync, config.LATENCY_LOG)
+        self.timesync_timer = QTimer()
+        self.timesync_timer.timeout.connect(self.send_timesync_ping)
 
     def start(self):
         logger.info("Grokcom Application Starting...")
         self.ui_update_status_signal.emit("Initializing...")
         self.ui.show()
+        if config.TTS_PREWARM:
+            self.tts.prewarm([config.SIGN_SPEECH_TEMPLATE.format(label) for label in config.SIGN_CLASS_LABELS] +
+                             [config.QUICK_RESPONSE_SPEECH_TEMPLATE.format(text) for text in config.QUICK_RESPONSES])
 
         self.mqtt.connect()
         if self.mqtt.connected:
@@ -60,19 +72,64 @@ class GrokcomApp(QObject):
         else:
             self.ui_update_status_signal.emit("MQTT Connection Failed")
         
+        self.timesync_timer.start(config.TIMESYNC_INTERVAL_S * 1000)
+        self.send_timesync_ping()
+
         # Initial message
         self.ui_add_conversation_signal.emit("System", "Welcome to Grokcom!")
 
+    def send_timesync_ping(self):
+        if self.mqtt.connected:
+            self.mqtt.client.publish(config.MQTT_TOPIC_TIMESYNC_PING, self.clock_sync.make_ping())
+
     def handle_mqtt_message(self, topic, payload):
+        received_ms = now_ms()
+        if topic == config.MQTT_TOPIC_TIMESYNC_PONG:
+            self.clock_sync.on_reply(payload)
+            return
+        if topic == config.MQTT_TOPIC_LATENCY:
+            self.latency.on_band_stamps(payload)
+            return
         logger.info(f"MainApp: MQTT message received on topic '{topic}'")
+        message = wire.parse_payload(payload)
+        if message is None:
+            return
+        if isinstance(message, str):
+            self.handle_text_message(topic, message)
+            return
+
+        # Binary frame: the type says what it is, the records carry class IDs
+        lost = self.wire_seq.update(message.device_id, message.seq)
+        if lost:
+            logger.warning(f"{lost} frame(s) lost from device {message.device_id:08x}")
+        if message.type == wire.TYPE_SIGN:
+            dev, seq = message.device_id, message.seq
+            self.latency.mark(dev, seq, "receive", received_ms)
+            labels = [self.lookup(config.SIGN_CLASS_LABELS, r.class_id) for r in message.records]
+            for record, label in zip(message.records, labels):
+                self.ui_add_conversation_signal.emit("Grokband (Sign)", f"{label} ({record.confidence:.2f})")
+            self.tts.speak(config.SIGN_SPEECH_TEMPLATE.format(' '.join(labels)),
+                           stamp=lambda stage: self.latency.mark(dev, seq, stage))
+        elif message.type == wire.TYPE_QUICK_RESPONSE:
+            for record in message.records:
+                text = self.lookup(config.QUICK_RESPONSES, record.class_id)
+                self.ui_add_conversation_signal.emit("Grokband (Quick)", text)
+                self.tts.speak(config.QUICK_RESPONSE_SPEECH_TEMPLATE.format(text))
+
+    @staticmethod
+    def lookup(table, index):
+        return table[index] if 0 <= index < len(table) else f"#{index}"
+
+    def handle_text_message(self, topic, payload):
+        # Legacy firmware (WIRE_PROTOCOL_BINARY=0): the label text itself, told apart by topic
         processed = False
         if topic == config.MQTT_TOPIC_SIGN_TO_TEXT:
             self.ui_add_conversation_signal.emit("Grokband (Sign)", payload)
-            self.tts.speak(f"Received sign: {payload}")
+            self.tts.speak(config.SIGN_SPEECH_TEMPLATE.format(payload))
             processed = True
         elif topic == config.MQTT_TOPIC_QUICK_RESPONSE:
             self.ui_add_conversation_signal.emit("Grokband (Quick)", payload)
-            self.tts.speak(f"Quick response: {payload}")
+            self.tts.speak(config.QUICK_RESPONSE_SPEECH_TEMPLATE.format(payload))
             processed = True
         
         if not processed:
@@ -117,6 +174,7 @@ class GrokcomApp(QObject):
 
     def cleanup(self):
         logger.info("Grokcom Application Shutting Down...")
+        self.timesync_timer.stop()
         if self.stt:
             self.stt.close()
         if self.tts:
@@ -1,6 +1,7 @@
 import paho.mqtt.client as mqtt
 import config
 import logging
+import wire
 
 logger = logging.getLogger(__name__)
 
@@ -24,15 +25,23 @@ class MQTTClient:
             logger.info(f"Subscribed to {config.MQTT_TOPIC_SIGN_TO_TEXT}")
             client.subscribe(config.MQTT_TOPIC_QUICK_RESPONSE)
             logger.info(f"Subscribed to {config.MQTT_TOPIC_QUICK_RESPONSE}")
+            # Latency accounting (latency.py): band stamps and time-sync replies
+            client.subscribe(config.MQTT_TOPIC_LATENCY)
+            client.subscribe(config.MQTT_TOPIC_TIMESYNC_PONG)
         else:
             logger.error(f"Failed to connect to MQTT, return code {rc}")
             self.connected = False
 
     def on_message_internal(self, client, userdata, msg):
-        payload_str = msg.payload.decode('utf-8')
-        logger.info(f"MQTT Received on [{msg.topic}]: {payload_str}")
+        # Raw bytes: Grokband payloads may be binary frames (wire.py) or legacy text
+        if msg.topic in (config.MQTT_TOPIC_LATENCY, config.MQTT_TOPIC_TIMESYNC_PONG):
+            logger.debug(f"MQTT Received on [{msg.topic}]: {msg.payload!r}")
+        elif wire.is_binary(msg.payload):
+            logger.info(f"MQTT Received on [{msg.topic}]: {len(msg.payload)}-byte frame")
+        else:
+            logger.info(f"MQTT Received on [{msg.topic}]: {msg.payload.decode('utf-8', errors='replace')}")
         if self.on_message_callback:
-            self.on_message_callback(msg.topic, payload_str)
+            self.on_message_callback(msg.topic, msg.payload)
 
     def on_disconnect(self, client, userdata, rc):
         logger.warning(f"Disconnected from MQTT Broker with rc: {rc}")
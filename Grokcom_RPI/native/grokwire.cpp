@@ -0,0 +1,129 @@
+// CPython binding for the Grokband wire protocol. The encoder/decoder is the firmware's own
+// wire_protocol.cpp (built from Grokband_ESP32/src by setup.py), so both ends share one codec.
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include "wire_protocol.h"
+
+static PyObject* WireError = nullptr;
+
+// decode(bytes) -> (type, seq, device_id, [(class_id, confidence, flags, t_ms), ...])
+static PyObject* grokwire_decode(PyObject*, PyObject* args) {
+    Py_buffer view;
+    if (!PyArg_ParseTuple(args, "y*", &view)) return nullptr;
+    WireFrame frame;
+    WireStatus status = wire_decode((const uint8_t*)view.buf, (size_t)view.len, &frame);
+    PyBuffer_Release(&view);
+    if (status != WireStatus::OK) {
+        PyErr_SetString(WireError, wire_status_name(status));
+        return nullptr;
+    }
+
+    PyObject* records = PyList_New(frame.count);
+    if (!records) return nullptr;
+    for (int i = 0; i < frame.count; ++i) {
+        const WireRecord& r = frame.records[i];
+        PyObject* item = Py_BuildValue("(HdBk)", r.class_id, (double)wire_dequantize_confidence(r.confidence),
+                                       r.flags, (unsigned long)r.t_ms);
+        if (!item) {
+            Py_DECREF(records);
+            return nullptr;
+        }
+        PyList_SET_ITEM(records, i, item);
+    }
+    return Py_BuildValue("(BHkN)", (unsigned char)frame.type, frame.seq, (unsigned long)frame.device_id, records);
+}
+
+// Integer field that must fit in 0..max. Anything else is a WireError, as in wire.py's codec;
+// PyArg formats like "H" or "B" would wrap out-of-range values silently.
+static bool get_uint(PyObject* obj, unsigned long long max, const char* field, unsigned long long* out) {
+    if (PyLong_Check(obj)) {
+        int overflow = 0;
+        long long v = PyLong_AsLongLongAndOverflow(obj, &overflow);
+        if (v == -1 && PyErr_Occurred()) return false;
+        if (!overflow && v >= 0 && (unsigned long long)v <= max) {
+            *out = (unsigned long long)v;
+            return true;
+        }
+    }
+    PyErr_Format(WireError, "%s must be an integer in 0..%llu", field, max);
+    return false;
+}
+
+// encode(type, seq, device_id, [(class_id, confidence, flags, t_ms), ...]) -> bytes
+static PyObject* grokwire_encode(PyObject*, PyObject* args) {
+    PyObject *type_obj, *seq_obj, *device_obj, *records;
+    if (!PyArg_ParseTuple(args, "OOOO", &type_obj, &seq_obj, &device_obj, &records)) return nullptr;
+    unsigned long long type, seq, device_id;
+    if (!get_uint(type_obj, 0xFF, "type", &type) || !get_uint(seq_obj, 0xFFFF, "seq", &seq) ||
+        !get_uint(device_obj, 0xFFFFFFFF, "device_id", &device_id)) {
+        return nullptr;
+    }
+    PyObject* fast = PySequence_Fast(records, "records must be a sequence");
+    if (!fast) return nullptr;
+
+    WireFrame frame = {};
+    frame.type = (WireMsgType)type;
+    frame.seq = (uint16_t)seq;
+    frame.device_id = (uint32_t)device_id;
+    Py_ssize_t n = PySequence_Fast_GET_SIZE(fast);
+    if (n > WIRE_MAX_RECORDS) n = WIRE_MAX_RECORDS + 1; // Let the encoder report BAD_COUNT
+    frame.count = (uint8_t)n;
+    for (Py_ssize_t i = 0; i < n && i < WIRE_MAX_RECORDS; ++i) {
+        PyObject *class_obj, *flags_obj, *t_obj;
+        double confidence;
+        unsigned long long class_id, flags, t_ms;
+        if (!PyArg_ParseTuple(PySequence_Fast_GET_ITEM(fast, i), "OdOO", &class_obj, &confidence, &flags_obj, &t_obj) ||
+            !get_uint(class_obj, 0xFFFF, "class_id", &class_id) || !get_uint(flags_obj, 0xFF, "flags", &flags) ||
+            !get_uint(t_obj, 0xFFFFFFFF, "t_ms", &t_ms)) {
+            Py_DECREF(fast);
+            return nullptr;
+        }
+        frame.records[i] = { (uint16_t)class_id, wire_quantize_confidence((float)confidence), (uint8_t)flags, (uint32_t)t_ms };
+    }
+    Py_DECREF(fast);
+
+    uint8_t buf[WIRE_MAX_FRAME_SIZE];
+    WireStatus status;
+    size_t len = wire_encode(frame, buf, sizeof(buf), &status);
+    if (!len) {
+        PyErr_SetString(WireError, wire_status_name(status));
+        return nullptr;
+    }
+    return PyBytes_FromStringAndSize((const char*)buf, (Py_ssize_t)len);
+}
+
+static PyObject* grokwire_device_id(PyObject*, PyObject* args) {
+    const char* client_id;
+    if (!PyArg_ParseTuple(args, "s", &client_id)) return nullptr;
+    return PyLong_FromUnsignedLong(wire_device_id(client_id));
+}
+
+static PyMethodDef grokwire_methods[] = {
+    {"decode", grokwire_decode, METH_VARARGS, "Decode a binary frame into (type, seq, device_id, records)."},
+    {"encode", grokwire_encode, METH_VARARGS, "Encode (type, seq, device_id, records) into a binary frame."},
+    {"device_id", grokwire_device_id, METH_VARARGS, "32-bit device ID of a client ID string."},
+    {nullptr, nullptr, 0, nullptr}
+};
+
+static struct PyModuleDef grokwire_module = {
+    PyModuleDef_HEAD_INIT, "grokwire", "Grokband wire protocol codec (shared with the firmware).", -1, grokwire_methods
+};
+
+PyMODINIT_FUNC PyInit_grokwire(void) {
+    PyObject* m = PyModule_Create(&grokwire_module);
+    if (!m) return nullptr;
+    WireError = PyErr_NewException("grokwire.WireError", PyExc_ValueError, nullptr);
+    Py_XINCREF(WireError);
+    if (PyModule_AddObject(m, "WireError", WireError) < 0) {
+        Py_XDECREF(WireError);
+        Py_DECREF(m);
+        return nullptr;
+    }
+    PyModule_AddIntConstant(m, "MAGIC", WIRE_MAGIC);
+    PyModule_AddIntConstant(m, "VERSION", WIRE_VERSION);
+    PyModule_AddIntConstant(m, "MAX_RECORDS", WIRE_MAX_RECORDS);
+    PyModule_AddIntConstant(m, "TYPE_SIGN", (int)WireMsgType::SIGN);
+    PyModule_AddIntConstant(m, "TYPE_QUICK_RESPONSE", (int)WireMsgType::QUICK_RESPONSE);
+    PyModule_AddIntConstant(m, "FLAG_RIGHT_HAND", WIRE_FLAG_RIGHT_HAND);
+    return m;
+}
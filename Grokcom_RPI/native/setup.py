@@ -0,0 +1,20 @@
+# Builds the grokwire extension from the firmware's wire protocol sources:
+#   cd Grokcom_RPI/native && python3 setup.py build_ext --inplace
+# wire.py falls back to a pure-Python codec if the extension is not built.
+import os
+from setuptools import setup, Extension
+
+FIRMWARE_SRC = os.path.normpath(os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "..", "Grokband_ESP32", "src"))
+
+setup(
+    name="grokwire",
+    ext_modules=[
+        Extension(
+            "grokwire",
+            sources=["grokwire.cpp", os.path.join(FIRMWARE_SRC, "wire_protocol.cpp")],
+            include_dirs=[FIRMWARE_SRC],
+            extra_compile_args=["-std=c++17"],
+            language="c++",
+        )
+    ],
+)
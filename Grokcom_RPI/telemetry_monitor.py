@@ -0,0 +1,138 @@
+"""Decodes Grokband telemetry (per-stage latency summaries from trace.cpp).
+
+Each band publishes one JSON object per window on MQTT_TOPIC_TELEMETRY:
+    {"dev": "grokband_esp32", "t": <ms since boot>, "win_ms": <window>, "drop": <lost events>,
+     "stages": {"invoke": [count, min_us, p50_us, p99_us, max_us], ...}}
+and once per boot its milestones (ms since reset):
+    {"dev": "grokband_esp32", "build": "...", "boot_ms": {"display": 310, "model": 1450, ...}}
+
+Live, from the broker (every band on the topic):
+    python3 telemetry_monitor.py --broker 192.168.1.10
+From a capture, e.g. `mosquitto_sub -t grokware/grokband/telemetry > telemetry.log`:
+    python3 telemetry_monitor.py --file telemetry.log
+"""
+import argparse
+import json
+import logging
+import sys
+
+try:
+    import config
+    DEFAULT_BROKER = config.MQTT_BROKER_IP
+    DEFAULT_PORT = config.MQTT_BROKER_PORT
+    DEFAULT_TOPIC = config.MQTT_TOPIC_TELEMETRY
+except Exception:  # config.py needs the audio stack; the monitor doesn't
+    DEFAULT_BROKER = "localhost"
+    DEFAULT_PORT = 1883
+    DEFAULT_TOPIC = "grokware/grokband/telemetry"
+
+logger = logging.getLogger(__name__)
+
+FIELDS = ("count", "min_us", "p50_us", "p99_us", "max_us")
+
+
+def decode(payload):
+    """Returns (device, window dict) or None if the payload isn't a telemetry summary.
+    Boot milestone messages are logged and return None."""
+    try:
+        msg = json.loads(payload)
+        if "boot_ms" in msg:
+            steps = ", ".join(f"{name} {ms}" for name, ms in sorted(msg["boot_ms"].items(), key=lambda kv: kv[1]))
+            logger.info(f"{msg['dev']} booted build {msg.get('build', '?')}: {steps} (ms)")
+            return None
+        stages = {name: dict(zip(FIELDS, values)) for name, values in msg["stages"].items()}
+        return msg["dev"], {"t": msg["t"], "win_ms": msg["win_ms"], "drop": msg["drop"], "stages": stages}
+    except (ValueError, KeyError, TypeError, AttributeError) as e:
+        logger.warning(f"Skipping malformed telemetry: {e}")
+        return None
+
+
+class FleetView:
+    """Latest window per device, plus the worst case per stage across the fleet."""
+
+    def __init__(self):
+        self.devices = {}
+
+    def update(self, device, window):
+        self.devices[device] = window
+
+    def worst(self):
+        worst = {}
+        for device, window in self.devices.items():
+            for stage, s in window["stages"].items():
+                if stage not in worst or s["p99_us"] > worst[stage][1]["p99_us"]:
+                    worst[stage] = (device, s)
+        return worst
+
+    def render(self, out=sys.stdout):
+        for device in sorted(self.devices):
+            window = self.devices[device]
+            rate = window["win_ms"] / 1000.0 or 1.0
+            out.write(f"\n{device}  t={window['t'] / 1000.0:.1f}s  window={window['win_ms']}ms  dropped={window['drop']}\n")
+            out.write(f"  {'stage':<14}{'n':>7}{'/s':>7}{'min':>9}{'p50':>9}{'p99':>9}{'max':>9}   (us)\n")
+            for stage, s in window["stages"].items():
+                out.write(f"  {stage:<14}{s['count']:>7}{s['count'] / rate:>7.1f}{s['min_us']:>9}"
+                          f"{s['p50_us']:>9}{s['p99_us']:>9}{s['max_us']:>9}\n")
+        if len(self.devices) > 1:
+            out.write("\nfleet worst p99:\n")
+            for stage, (device, s) in sorted(self.worst().items()):
+                out.write(f"  {stage:<14}{s['p99_us']:>9} us  ({device})\n")
+        out.flush()
+
+
+def run_file(path, view):
+    with open(path) as f:
+        for line in f:
+            line = line.strip()
+            if not line:
+                continue
+            decoded = decode(line)
+            if decoded:
+                view.update(*decoded)
+    view.render()
+
+
+def run_live(broker, port, topic, view):
+    import paho.mqtt.client as mqtt
+
+    def on_connect(client, userdata, flags, rc):
+        if rc == 0:
+            client.subscribe(topic)
+            logger.info(f"Subscribed to {topic} on {broker}:{port}")
+        else:
+            logger.error(f"Failed to connect to MQTT, return code {rc}")
+
+    def on_message(client, userdata, msg):
+        decoded = decode(msg.payload.decode("utf-8", errors="replace"))
+        if decoded:
+            view.update(*decoded)
+            view.render()
+
+    client = mqtt.Client(client_id="grokcom_telemetry_monitor")
+    client.on_connect = on_connect
+    client.on_message = on_message
+    client.connect(broker, port, 60)
+    try:
+        client.loop_forever()
+    except KeyboardInterrupt:
+        client.disconnect()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--broker", default=DEFAULT_BROKER)
+    parser.add_argument("--port", type=int, default=DEFAULT_PORT)
+    parser.add_argument("--topic", default=DEFAULT_TOPIC)
+    parser.add_argument("--file", help="decode saved payloads, one JSON object per line, instead of subscribing")
+    args = parser.parse_args()
+    logging.basicConfig(level=logging.INFO, format="%(asctime)s - %(name)s - %(levelname)s - %(message)s")
+
+    view = FleetView()
+    if args.file:
+        run_file(args.file, view)
+    else:
+        run_live(args.broker, args.port, args.topic, view)
+
+
+if __name__ == "__main__":
+    main()
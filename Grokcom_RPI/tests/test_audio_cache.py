@@ -0,0 +1,173 @@
+"""
+Tests for the phrase audio cache (audio_cache.py): hits and misses, persistence and keying,
+pre-warming, LRU eviction under max_bytes, and corrupted entries being dropped and
+synthesized again.
+
+    cd Grokcom_RPI && python3 -m unittest discover -s tests
+"""
+import os
+import sys
+import tempfile
+import unittest
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+import audio_cache  # noqa: E402
+from audio_cache import HEADER, PhraseAudioCache, phrase_key  # noqa: E402
+
+RATE = 16000
+
+
+class FakeSynthesizer:
+    """Deterministic PCM per phrase, counting calls; no delay"""
+
+    def __init__(self):
+        self.calls = []
+
+    def synthesize(self, text):
+        self.calls.append(text)
+        seed = sum(text.encode("utf-8"))
+        return bytes((seed + i) & 0xFF for i in range(2 * (100 + len(text))))
+
+
+class AudioCacheTest(unittest.TestCase):
+    def setUp(self):
+        self.tmp = tempfile.TemporaryDirectory()
+        self.dir = self.tmp.name
+        self.synth = FakeSynthesizer()
+        self.caches = []
+
+    def tearDown(self):
+        for cache in self.caches:
+            cache.close()
+        self.tmp.cleanup()
+
+    def cache(self, voice=None, rate=RATE, max_bytes=None):
+        cache = PhraseAudioCache(self.dir, "en-US", voice, rate, max_bytes=max_bytes)
+        self.caches.append(cache)
+        return cache
+
+    def path(self, text, voice=None, rate=RATE):
+        key = phrase_key(text, "en-US", voice, rate)
+        return os.path.join(self.dir, key[:2], key + ".pcm")
+
+    def entry_bytes(self, text):
+        return HEADER.size + len(self.synth.synthesize(text))
+
+    def test_miss_then_hit(self):
+        cache = self.cache()
+        first = cache.get("Received sign: Hello", self.synth.synthesize)
+        second = cache.get("Received sign: Hello", self.synth.synthesize)
+        self.assertEqual(bytes(first), FakeSynthesizer().synthesize("Received sign: Hello"))
+        self.assertEqual(bytes(second), bytes(first))
+        self.assertEqual(self.synth.calls, ["Received sign: Hello"])
+        stats = cache.stats()
+        self.assertEqual((stats["hits"], stats["misses"]), (1, 1))
+        self.assertEqual(stats["hit_rate"], 0.5)
+
+    def test_miss_without_synthesizer(self):
+        cache = self.cache()
+        self.assertIsNone(cache.get("Quick response: Yes"))
+        self.assertFalse(cache.contains("Quick response: Yes"))
+        self.assertEqual(cache.stats()["misses"], 1)
+
+    def test_empty_synthesis_is_not_stored(self):
+        cache = self.cache()
+        self.assertIsNone(cache.get("silence", lambda text: b""))
+        self.assertFalse(os.path.exists(self.path("silence")))
+
+    def test_persists_and_keys_on_voice_and_rate(self):
+        self.cache().get("Received sign: Goodbye", self.synth.synthesize)
+        self.assertIsNotNone(self.cache().get("Received sign: Goodbye"))
+        self.assertIsNone(self.cache(voice="en-US-Wavenet-D").get("Received sign: Goodbye"))
+        self.assertIsNone(self.cache(rate=22050).get("Received sign: Goodbye"))
+
+    def test_warm_synthesizes_only_missing_phrases(self):
+        cache = self.cache()
+        cache.get("a", self.synth.synthesize)
+
+        def flaky(text):
+            if text == "c":
+                raise RuntimeError("cloud unavailable")
+            return self.synth.synthesize(text)
+        self.assertEqual(cache.warm(["a", "b", "c"], flaky), 1)
+        self.assertEqual(self.synth.calls, ["a", "b"])
+        self.assertTrue(cache.contains("b"))
+        self.assertFalse(cache.contains("c"))
+
+    def test_evicts_least_recently_used(self):
+        size = self.entry_bytes("one")
+        self.assertEqual(size, self.entry_bytes("two"))
+        cache = self.cache(max_bytes=2 * size + size // 2)
+        cache.get("one", self.synth.synthesize)
+        cache.get("two", self.synth.synthesize)
+        os.utime(self.path("one"), (1000, 1000))
+        os.utime(self.path("two"), (2000, 2000))
+
+        cache.get("six", self.synth.synthesize)  # Same length, so three don't fit
+        self.assertFalse(os.path.exists(self.path("one")))
+        self.assertTrue(os.path.exists(self.path("two")))
+        self.assertTrue(os.path.exists(self.path("six")))
+        self.assertEqual(cache.stats()["evicted"], 1)
+        self.assertIsNone(cache.get("one"))  # Not served from the map either
+
+        # Mapping an entry marks it used: "two" is read by a new process, so "six" goes next
+        os.utime(self.path("six"), (3000, 3000))
+        self.assertIsNotNone(self.cache().get("two"))
+        cache.get("ten", self.synth.synthesize)
+        self.assertTrue(os.path.exists(self.path("two")))
+        self.assertFalse(os.path.exists(self.path("six")))
+
+    def test_entry_larger_than_limit_is_kept(self):
+        cache = self.cache(max_bytes=1)
+        self.assertIsNotNone(cache.get("one", self.synth.synthesize))
+        self.assertTrue(os.path.exists(self.path("one")))
+
+    def test_corrupted_entries_are_synthesized_again(self):
+        good = self.synth.synthesize("Received sign: Thanks")
+        at = HEADER.size + 5
+        corruptions = {
+            "bit flip": lambda data: data[:at] + bytes([data[at] ^ 0x01]) + data[at + 1:],
+            "truncated": lambda data: data[:-3],
+            "empty": lambda data: b"",
+            "header only": lambda data: data[:HEADER.size],
+            "short header": lambda data: data[:HEADER.size - 1],
+            "old raw PCM format": lambda data: good,
+            "bad magic": lambda data: b"XPCM" + data[4:],
+            "odd length": lambda data: HEADER.pack(audio_cache.MAGIC, 3, 0) + b"abc",
+        }
+        for name, corrupt in corruptions.items():
+            with self.subTest(name):
+                self.synth.calls.clear()
+                self.cache().get("Received sign: Thanks", self.synth.synthesize)
+                path = self.path("Received sign: Thanks")
+                with open(path, "rb") as f:
+                    data = f.read()
+                with open(path, "wb") as f:
+                    f.write(corrupt(data))
+
+                cache = self.cache()
+                self.assertFalse(cache.contains("Received sign: Thanks"))
+                self.assertFalse(os.path.exists(path))
+                pcm = cache.get("Received sign: Thanks", self.synth.synthesize)
+                self.assertEqual(bytes(pcm), good)
+                self.assertEqual(len(self.synth.calls), 2)
+                self.assertEqual(cache.stats()["corrupt"], 1)
+                self.assertIsNotNone(self.cache().get("Received sign: Thanks"))  # Rewritten intact
+                os.unlink(path)
+
+    def test_no_temp_files_left(self):
+        cache = self.cache()
+        cache.warm(["a", "b"], self.synth.synthesize)
+        leftovers = [n for _, _, names in os.walk(self.dir) for n in names if not n.endswith(".pcm")]
+        self.assertEqual(leftovers, [])
+
+    def test_close_with_buffer_still_held(self):
+        cache = self.cache()
+        held = cache.get("a", self.synth.synthesize)[:10]
+        cache.close()
+        self.assertEqual(len(held), 10)
+        self.assertEqual(cache.stats()["mapped"], 0)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,161 @@
+"""
+Round-trip and fuzz tests for the wire protocol codecs (wire.py and the native grokwire module).
+
+    cd Grokcom_RPI && python3 -m unittest discover -s tests
+
+The native cases are skipped unless the extension is built (native/setup.py). The fuzz runs
+GROKWIRE_FUZZ_ITERATIONS cases per test (default 20000) from GROKWIRE_FUZZ_SEED (default 1).
+"""
+import os
+import random
+import struct
+import sys
+import unittest
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+import wire  # noqa: E402
+
+ITERATIONS = int(os.environ.get("GROKWIRE_FUZZ_ITERATIONS", "20000"))
+SEED = int(os.environ.get("GROKWIRE_FUZZ_SEED", "1"))
+
+CODECS = [("python", wire._py_encode, wire._py_decode)]
+if wire.NATIVE:
+    CODECS.append(("native", wire._native.encode, wire._native.decode))
+
+
+def outcome(fn, *args):
+    """Result of fn, or the fact that it raised WireError (messages differ between codecs)."""
+    try:
+        return fn(*args)
+    except (wire.WireError, *wire._NATIVE_ERRORS):
+        return wire.WireError
+
+
+def random_frame(rng):
+    msg_type = rng.choice((wire.TYPE_SIGN, wire.TYPE_QUICK_RESPONSE))
+    base = rng.randrange(1 << 32)
+    records = []
+    for i in range(rng.randint(1, wire.MAX_RECORDS)):  # Times are sent as offsets from the first record
+        records.append((rng.randrange(1 << 16), rng.randrange(256) / 255.0, rng.randrange(256),
+                        (base + (rng.randrange(1 << 16) if i else 0)) & 0xFFFFFFFF))
+    return msg_type, rng.randrange(1 << 16), rng.randrange(1 << 32), records
+
+
+def random_field(rng, limit):
+    """Mostly valid, sometimes just outside the range or not an integer at all."""
+    pick = rng.random()
+    if pick < 0.7:
+        return rng.randrange(limit + 1)
+    return rng.choice((-1, limit + 1, limit * 4 + 3, -(1 << 70), 1 << 70, 0.5, True))
+
+
+class RoundTripTest(unittest.TestCase):
+    def test_round_trip(self):
+        for name, encode, decode in CODECS:
+            rng = random.Random(SEED)
+            for _ in range(ITERATIONS // 4):
+                msg_type, seq, dev, records = random_frame(rng)
+                payload = encode(msg_type, seq, dev, records)
+                self.assertEqual(len(payload), 14 + 6 * len(records))
+                self.assertTrue(wire.is_binary(payload))
+                got_type, got_seq, got_dev, got = decode(payload)
+                self.assertEqual((got_type, got_seq, got_dev), (msg_type, seq, dev), name)
+                for want, have in zip(records, got):
+                    self.assertEqual((have[0], have[2], have[3]), (want[0], want[2], want[3]), name)
+                    self.assertEqual(round(have[1] * 255), round(want[1] * 255), name)
+
+    def test_wrapping_record_times(self):
+        for name, encode, decode in CODECS:
+            records = [(1, 0.5, 0, 0xFFFFFF00), (2, 0.5, 0, 0x00000010)]  # Device clock wrapped
+            _, _, _, got = decode(encode(wire.TYPE_SIGN, 0, 0, records))
+            self.assertEqual([r[3] for r in got], [0xFFFFFF00, 0x10], name)
+
+    def test_rejects_bad_frames(self):
+        good = wire._py_encode(wire.TYPE_SIGN, 1, 2, [(3, 0.5, 0, 100)])
+        bad = [
+            b"",
+            good[:13],
+            bytes([0x00]) + good[1:],                      # Magic
+            good[:1] + bytes([2]) + good[2:],              # Version
+            good[:2] + bytes([9]) + good[3:],              # Type
+            good[:3] + bytes([0]) + good[4:],              # Count
+            good[:3] + bytes([2]) + good[4:],              # Count vs length
+            good + b"\x00",
+        ]
+        for name, _, decode in CODECS:
+            for payload in bad:
+                self.assertIs(outcome(decode, payload), wire.WireError, f"{name}: {payload.hex()}")
+
+    def test_rejects_out_of_range_fields(self):
+        cases = [
+            (wire.TYPE_SIGN, 0, 0, [(65536, 0.5, 0, 0)]),
+            (wire.TYPE_SIGN, 0, 0, [(1, 0.5, 256, 0)]),
+            (wire.TYPE_SIGN, 0, 0, [(-1, 0.5, 0, 0)]),
+            (wire.TYPE_SIGN, 0, 0, [(1, 0.5, 0, 1 << 32)]),
+            (wire.TYPE_SIGN, 65536, 0, [(1, 0.5, 0, 0)]),
+            (wire.TYPE_SIGN, 0, 1 << 32, [(1, 0.5, 0, 0)]),
+            (256 + wire.TYPE_SIGN, 0, 0, [(1, 0.5, 0, 0)]),
+            (wire.TYPE_SIGN, 0, 0, [(1.0, 0.5, 0, 0)]),
+            (wire.TYPE_SIGN, 0, 0, []),
+            (wire.TYPE_SIGN, 0, 0, [(1, 0.5, 0, 0)] * (wire.MAX_RECORDS + 1)),
+            (wire.TYPE_SIGN, 0, 0, [(1, 0.5, 0, 0), (2, 0.5, 0, 70000)]),
+        ]
+        for name, encode, _ in CODECS:
+            for case in cases:
+                self.assertIs(outcome(encode, *case), wire.WireError, f"{name}: {case}")
+
+
+@unittest.skipUnless(wire.NATIVE, "native grokwire extension not built")
+class CodecEquivalenceFuzzTest(unittest.TestCase):
+    """The native and pure-Python codecs must agree on every input, valid or not."""
+
+    def test_encode_agrees(self):
+        rng = random.Random(SEED)
+        confidences = (0.0, 1.0, -0.5, 2.0, float("nan"), float("inf"), 1e-40, 0.999999999, 0.5 / 255)
+        for _ in range(ITERATIONS):
+            msg_type, seq, dev, records = random_frame(rng)
+            if rng.random() < 0.5:
+                msg_type = rng.choice((msg_type, random_field(rng, 0xFF)))
+                seq = random_field(rng, 0xFFFF)
+                dev = random_field(rng, 0xFFFFFFFF)
+                records = [(random_field(rng, 0xFFFF),
+                            rng.choice(confidences) if rng.random() < 0.3 else rng.random(),
+                            random_field(rng, 0xFF),
+                            random_field(rng, 0xFFFFFFFF) if rng.random() < 0.2 else r[3])
+                           for r in records[:rng.randint(0, wire.MAX_RECORDS + 1)]]
+            args = (msg_type, seq, dev, records)
+            self.assertEqual(outcome(wire._native.encode, *args), outcome(wire._py_encode, *args), args)
+
+    def test_decode_agrees(self):
+        rng = random.Random(SEED)
+        for _ in range(ITERATIONS):
+            payload = bytearray(wire._py_encode(*random_frame(rng)))
+            mutation = rng.randrange(4)
+            if mutation == 0:
+                payload[rng.randrange(len(payload))] = rng.randrange(256)
+            elif mutation == 1:
+                del payload[rng.randrange(len(payload)):]
+            elif mutation == 2:
+                payload += bytes(rng.randrange(256) for _ in range(rng.randint(1, 8)))
+            else:
+                payload = bytearray(rng.randrange(256) for _ in range(rng.randint(0, 70)))
+                if payload and rng.random() < 0.5:
+                    payload[0] = wire.MAGIC
+            payload = bytes(payload)
+            self.assertEqual(outcome(wire._native.decode, payload), outcome(wire._py_decode, payload), payload.hex())
+
+    def test_confidence_quantization_agrees(self):
+        rng = random.Random(SEED)
+        for _ in range(ITERATIONS):
+            c = rng.random()
+            native = wire._native.encode(wire.TYPE_SIGN, 0, 0, [(0, c, 0, 0)])
+            self.assertEqual(native, wire._py_encode(wire.TYPE_SIGN, 0, 0, [(0, c, 0, 0)]), repr(c))
+        for q in range(256):  # Every byte decodes to the same float and re-encodes to itself
+            payload = struct.pack("<BBBBHIIHBBH", wire.MAGIC, wire.VERSION, wire.TYPE_SIGN, 1, 0, 0, 0, 0, q, 0, 0)
+            self.assertEqual(wire._native.decode(payload), wire._py_decode(payload))
+            record = wire._py_decode(payload)[3][0]
+            self.assertEqual(wire._py_encode(wire.TYPE_SIGN, 0, 0, [record]), payload)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -1,13 +1,19 @@
-from google.cloud import texttospeech
 import pygame # For audio playback, simple alternative to mpg123
 import config
 import logging
 import io
+import threading
+import wave
+from audio_cache import PhraseAudioCache, StubSynthesizer
 
 logger = logging.getLogger(__name__)
 
-class TextToSpeechEngine:
-    def __init__(self, language_code=config.GOOGLE_TTS_LANGUAGE_CODE, voice_name=None):
+class GoogleSynthesizer:
+    """Cloud synthesis to raw 16-bit mono PCM at config.AUDIO_RATE (the cache's format)."""
+
+    def __init__(self, language_code, voice_name=None):
+        from google.cloud import texttospeech
+        self.texttospeech = texttospeech
         self.client = texttospeech.TextToSpeechClient()
         self.voice_config = texttospeech.VoiceSelectionParams(
             language_code=language_code
@@ -17,59 +23,91 @@ class TextToSpeechEngine:
         if voice_name: # e.g. 'en-US-Standard-C'
             self.voice_config.name = voice_name
 
+        # LINEAR16 rather than MP3: cached audio is played without decoding
         self.audio_config = texttospeech.AudioConfig(
-            audio_encoding=texttospeech.AudioEncoding.MP3 # Or LINEAR16 for wav
+            audio_encoding=texttospeech.AudioEncoding.LINEAR16,
+            sample_rate_hertz=config.AUDIO_RATE
         )
-        pygame.mixer.init(frequency=config.AUDIO_RATE) # Initialize mixer with sample rate
+
+    def synthesize(self, text):
+        response = self.client.synthesize_speech(
+            input=self.texttospeech.SynthesisInput(text=text), voice=self.voice_config, audio_config=self.audio_config
+        )
+        # LINEAR16 comes wrapped in a WAV header
+        with wave.open(io.BytesIO(response.audio_content)) as w:
+            if w.getframerate() != config.AUDIO_RATE or w.getnchannels() != 1 or w.getsampwidth() != 2:
+                raise ValueError(f"unexpected TTS format {w.getframerate()} Hz x{w.getnchannels()}")
+            return w.readframes(w.getnframes())
+
+
+class TextToSpeechEngine:
+    def __init__(self, language_code=config.GOOGLE_TTS_LANGUAGE_CODE, voice_name=None):
+        if config.TTS_SYNTHESIZER == "stub":
+            self.synthesizer = StubSynthesizer(config.AUDIO_RATE)
+        else:
+            self.synthesizer = GoogleSynthesizer(language_code, voice_name)
+        # Phrases are synthesized once and then played from disk (audio_cache.py)
+        self.cache = PhraseAudioCache(config.TTS_CACHE_DIR, language_code, voice_name, config.AUDIO_RATE,
+                                      max_bytes=config.TTS_CACHE_MAX_MB * 1024 * 1024)
+
+        pygame.mixer.init(frequency=config.AUDIO_RATE, size=-16, channels=1) # Same format as the cached PCM
+        self.channel = pygame.mixer.Channel(0)
         logger.info("TextToSpeechEngine Initialized. Pygame mixer ready.")
 
-    def speak(self, text):
+    def prewarm(self, phrases):
+        # In the background: startup doesn't wait on the cloud, and phrases already on disk cost nothing
+        def run():
+            added = self.cache.warm(phrases, self.synthesizer.synthesize)
+            logger.info(f"TTS cache pre-warmed: {added} of {len(phrases)} phrases synthesized")
+        threading.Thread(target=run, name="tts-prewarm", daemon=True).start()
+
+    def speak(self, text, stamp=None):
+        # stamp(stage), if given, is called at "synth_start" and "playback_start" (latency.py)
         if not text:
             logger.warning("TTS: No text provided to speak.")
             return
 
-        synthesis_input = texttospeech.SynthesisInput(text=text)
+        if stamp:
+            stamp("synth_start")
         try:
-            response = self.client.synthesize_speech(
-                input=synthesis_input, voice=self.voice_config, audio_config=self.audio_config
-            )
-            
-            # Play the audio using pygame
-            audio_fp = io.BytesIO(response.audio_content)
-            pygame.mixer.music.load(audio_fp)
-            pygame.mixer.music.play()
+            pcm = self.cache.get(text, self.synthesizer.synthesize)
+            if pcm is None:
+                logger.error(f"TTS produced no audio for: {text}")
+                return
+            self.channel.play(pygame.mixer.Sound(buffer=pcm))
+            if stamp:
+                stamp("playback_start")
             logger.info(f"Speaking: {text}")
-            # Wait for playback to finish (optional, can be blocking)
-            # while pygame.mixer.music.get_busy():
-            #     pygame.time.Clock().tick(10)
         except Exception as e:
             logger.error(f"Error during TTS synthesis or playback: {e}")
 
     def is_speaking(self):
-        return pygame.mixer.music.get_busy()
+        return self.channel.get_busy()
 
     def stop_speaking(self):
-        if pygame.mixer.music.get_busy():
-            pygame.mixer.music.stop()
+        if self.channel.get_busy():
+            self.channel.stop()
             logger.info("TTS playback stopped.")
-            
+
     def close(self):
+        logger.info(f"TTS cache: {self.cache.stats()}")
         pygame.mixer.quit()
+        self.cache.close()
         logger.info("TextToSpeechEngine closed, pygame mixer quit.")
 
 
 if __name__ == '__main__':
     logging.basicConfig(level=logging.INFO)
     tts = TextToSpeechEngine()
-    
+
     print("Testing TTS...")
     tts.speak("Hello, this is a test of the Grokcom text to speech system.")
     while tts.is_speaking():
         pygame.time.Clock().tick(10)
-    
+
     tts.speak("Speech synthesis is working correctly.")
     while tts.is_speaking():
         pygame.time.Clock().tick(10)
 
     tts.close()
-    print("TTS Test complete.")
\ No newline at end of file
+    print("TTS Test complete.")
@@ -0,0 +1,161 @@
+"""Grokband wire protocol (see Grokband_ESP32/src/wire_protocol.h).
+
+Uses the native `grokwire` extension built from the firmware's own codec
+(native/setup.py) when available, and an equivalent pure-Python codec otherwise.
+Payloads that do not start with the magic byte are legacy UTF-8 text.
+"""
+import logging
+import os
+import struct
+import sys
+from collections import namedtuple
+
+logger = logging.getLogger(__name__)
+
+MAGIC = 0xB7
+VERSION = 1
+MAX_RECORDS = 8
+TYPE_SIGN = 1
+TYPE_QUICK_RESPONSE = 2
+FLAG_RIGHT_HAND = 0x01
+
+_HEADER = struct.Struct("<BBBBHII")
+_RECORD = struct.Struct("<HBBH")
+
+WireRecord = namedtuple("WireRecord", "class_id confidence flags t_ms")
+WireFrame = namedtuple("WireFrame", "type seq device_id records")
+
+
+class WireError(ValueError):
+    pass
+
+
+def _f32(x):
+    return struct.unpack("<f", struct.pack("<f", x))[0]
+
+
+def _quantize(confidence):
+    # wire_quantize_confidence(), float arithmetic and all, so both codecs give the same byte
+    if not confidence > 0:
+        return 0
+    if confidence >= 1:
+        return 255
+    return int(_f32(_f32(_f32(confidence) * 255.0) + 0.5))
+
+
+def _check_uint(value, limit, field):
+    if not isinstance(value, int) or not 0 <= value <= limit:
+        raise WireError(f"{field} must be an integer in 0..{limit}")
+
+
+def _py_decode(payload):
+    if len(payload) < _HEADER.size:
+        raise WireError("frame too short")
+    magic, version, msg_type, count, seq, device_id, base_ms = _HEADER.unpack_from(payload)
+    if magic != MAGIC:
+        raise WireError("bad magic")
+    if version != VERSION:
+        raise WireError("unsupported version")
+    if msg_type not in (TYPE_SIGN, TYPE_QUICK_RESPONSE):
+        raise WireError("unknown message type")
+    if count == 0 or count > MAX_RECORDS:
+        raise WireError("bad record count")
+    if len(payload) != _HEADER.size + count * _RECORD.size:
+        raise WireError("length does not match record count")
+    records = []
+    for i in range(count):
+        class_id, confidence, flags, dt_ms = _RECORD.unpack_from(payload, _HEADER.size + i * _RECORD.size)
+        records.append((class_id, _f32(confidence / 255.0), flags, (base_ms + dt_ms) & 0xFFFFFFFF))
+    return msg_type, seq, device_id, records
+
+
+def _py_encode(msg_type, seq, device_id, records):
+    _check_uint(msg_type, 0xFF, "type")
+    _check_uint(seq, 0xFFFF, "seq")
+    _check_uint(device_id, 0xFFFFFFFF, "device_id")
+    for class_id, _, flags, t_ms in records[:MAX_RECORDS]:
+        _check_uint(class_id, 0xFFFF, "class_id")
+        _check_uint(flags, 0xFF, "flags")
+        _check_uint(t_ms, 0xFFFFFFFF, "t_ms")
+    if msg_type not in (TYPE_SIGN, TYPE_QUICK_RESPONSE):
+        raise WireError("unknown message type")
+    if not records or len(records) > MAX_RECORDS:
+        raise WireError("bad record count")
+    base_ms = records[0][3]
+    out = bytearray(_HEADER.pack(MAGIC, VERSION, msg_type, len(records), seq, device_id, base_ms))
+    for class_id, confidence, flags, t_ms in records:
+        dt_ms = (t_ms - base_ms) & 0xFFFFFFFF
+        if dt_ms > 0xFFFF:
+            raise WireError("records span more than 65535 ms")
+        out += _RECORD.pack(class_id, _quantize(confidence), flags, dt_ms)
+    return bytes(out)
+
+
+def _py_device_id(client_id):
+    h = 2166136261
+    for b in client_id.encode("utf-8"):
+        h = ((h ^ b) * 16777619) & 0xFFFFFFFF
+    return h
+
+
+try:
+    sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "native"))
+    import grokwire as _native
+    _decode, _encode, device_id = _native.decode, _native.encode, _native.device_id
+    _NATIVE_ERRORS = (_native.WireError,)
+    NATIVE = True
+except ImportError:
+    _decode, _encode, device_id = _py_decode, _py_encode, _py_device_id
+    _NATIVE_ERRORS = ()
+    NATIVE = False
+
+
+def is_binary(payload):
+    return len(payload) > 0 and payload[0] == MAGIC
+
+
+def decode(payload):
+    """Decodes a binary frame into a WireFrame. Raises WireError if it is malformed."""
+    try:
+        msg_type, seq, dev, records = _decode(bytes(payload))
+    except _NATIVE_ERRORS as e:
+        raise WireError(str(e)) from None
+    return WireFrame(msg_type, seq, dev, [WireRecord(*r) for r in records])
+
+
+def encode(msg_type, seq, dev, records):
+    """Encodes (class_id, confidence, flags, t_ms) records into one frame."""
+    try:
+        return _encode(msg_type, seq, dev, [tuple(r) for r in records])
+    except _NATIVE_ERRORS as e:
+        raise WireError(str(e)) from None
+
+
+def parse_payload(payload):
+    """Returns a WireFrame for binary payloads or a str for legacy text ones; None if unusable."""
+    if is_binary(payload):
+        try:
+            return decode(payload)
+        except WireError as e:
+            logger.warning(f"Dropping malformed frame ({len(payload)} bytes): {e}")
+            return None
+    return payload.decode("utf-8", errors="replace")
+
+
+class SequenceTracker:
+    """Counts frames lost between a device's consecutive sequence numbers (u16, wrapping)."""
+
+    def __init__(self):
+        self.last_seq = {}
+        self.lost = 0
+
+    def update(self, dev, seq):
+        last = self.last_seq.get(dev)
+        self.last_seq[dev] = seq
+        if last is None:
+            return 0
+        gap = (seq - last - 1) & 0xFFFF
+        if gap > 0x8000:  # Duplicate or reordered; not a loss
+            return 0
+        self.lost += gap
+        return gap